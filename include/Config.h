@@ -8,6 +8,7 @@
 // BME280 Sensor
 #define BME_ADDRESS 0x76  // Default BME280 address. Try 0x77 if 0x76 doesn't work
 #define SEALEVELPRESSURE_HPA (1013.25)
+#define SENSOR_PROFILE SENSOR_PROFILE_HIGH_PRECISION  // LOW_POWER / BALANCED: forced mode, sensor sleeps between reads
 
 // Debug options for BME280
 #define BME280_DEBUG true  // Enable detailed BME280 debugging
@@ -16,6 +17,37 @@
 #define PIR_PIN 5 //Yellow wire
 #define PIR_WAKE_LEVEL HIGH  // HIGH for active-high PIR, LOW for active-low
 
+// Battery monitor (Heltec V3: VBAT divider on GPIO1, enabled through ADC_Ctrl on GPIO37)
+#define VBAT_ADC_PIN 1
+#define VBAT_ADC_CTRL_PIN 37
+#define BATTERY_LOW_SOC 20       // Uplink interval doubles below this state of charge (%)
+#define BATTERY_CRITICAL_SOC 5   // Uplink interval quadruples below this state of charge (%)
+#define BATTERY_SAMPLE_INTERVAL 60000  // Resting battery measurement period (ms)
+
+// ULP sampling during deep sleep (BME280 pins must be RTC GPIOs); only
+// goToSleep() starts it, and the main loop does not deep-sleep yet
+#define ULP_SAMPLING_ENABLED true
+#define ULP_SAMPLE_INTERVAL 60000      // ULP sampling period (ms), at most about 2 minutes
+#define ULP_THRESHOLD_TEMPERATURE 0.5F // Change that wakes the main cores (°C)
+#define ULP_THRESHOLD_HUMIDITY 3.0F    // (%RH)
+#define ULP_THRESHOLD_PRESSURE 1.0F    // (hPa)
+#define SERIES_PORT 3                  // Port of the compressed sleep-sample batches
+
+// On-device sample history in the "archive" flash partition (partitions.csv);
+// a range request downlink (02 03 from to) is replayed on its own port
+#define SAMPLE_ARCHIVE_ENABLED true
+#define ARCHIVE_PORT 4
+#define ARCHIVE_FRAMES_PER_REPORT 4    // Replayed frames per report cycle, to stay within the duty cycle
+#define ARCHIVE_MAX_PENDING_AGE 900    // Seconds of samples a reset can lose from the open frame
+
+// Vibration capture (analog accelerometer axis on an ADC1 pin); only the
+// spectral features are uplinked, on their own port
+#define VIBRATION_ENABLED false
+#define VIBRATION_ADC_PIN 7             // ADC1 channel 6
+#define VIBRATION_SAMPLE_RATE_HZ 3200   // 1024-sample blocks: 320 ms, 3.125 Hz bins
+#define VIBRATION_COUNTS_PER_G 400.0F   // e.g. ADXL335 at 3.3 V (330 mV/g) over the 11 dB range
+#define VIBRATION_PORT 2
+
 // Button for UI navigation
 #define BUTTON_PIN 0  // PRG button on Heltec board
 
@@ -53,9 +85,20 @@
 #define MAX_BACKOFF_DELAY 3600  // Maximum backoff delay in seconds (1 hour)
 #define DEBUG_SERIAL true  // Enable serial debug output
 
+// ===== Report-by-exception (applied in setup(), tunable by downlink) =====
+#define UPLINK_MAX_SILENCE_MS 3600000UL  // Heartbeat: uplink at least this often (ms)
+#define UPLINK_MIN_SPACING_MS (MINIMUM_DELAY * 1000UL)  // Minimum time between uplinks (ms)
+
+// ===== Adaptive check interval =====
+// Readings are checked more often while they change quickly or motion is
+// seen, and less often while stable or on a low battery
+#define INTERVAL_MIN_MS 30000UL   // Shortest interval between checks (ms)
+#define INTERVAL_MAX_MS 900000UL  // Longest interval between checks (ms)
+
 // ===== Display Configuration =====
 #define DISPLAY_ENABLED true
 #define DISPLAY_TIMEOUT 30000  // Turn off display after this many ms of inactivity
+#define DISPLAY_STATIC_TIMEOUT 120000  // Turn off display after this many ms without a changed pixel
 
 // ===== OLED Display Configuration =====
 #define OLED_SDA 17
@@ -63,12 +106,19 @@
 #define OLED_RST 21
 #define OLED_WIDTH 128
 #define OLED_HEIGHT 64
+#define DISPLAY_HW_I2C true    // Drive the OLED from I2C controller 1 instead of bit-banging
+#define DISPLAY_I2C_PORT 1     // The BME280 uses controller 0
 
 // ===== Heltec Board Configuration =====
 // Heltec board version
-// 0 = V3.0/V3.1 (normal VEXT)
-// 1 = V3.2 (inverted VEXT)
+// 0 = V3.0/V3.1 (ADC_Ctrl enables the battery divider when LOW)
+// 1 = V3.2 (inverted ADC_Ctrl, enables it when HIGH)
 #define HELTEC_BOARD_VERSION 1  // Set to 1 for V3.2 boards, 0 for V3.0/V3.1 boards
 
+// Level that switches VEXT on. VEXT is a P-channel high-side switch on every
+// V3.x board, so LOW powers the OLED and the sensors; only ADC_Ctrl changed
+// with V3.2. setup(), SensorManager and DisplayManager all use this.
+#define VEXT_ACTIVE_HIGH false
+
 // VEXT pin for controlling external devices
 #define VEXT_PIN 36  // GPIO36 is VEXT on Heltec WiFi LoRa 32 V3.x boards 
\ No newline at end of file
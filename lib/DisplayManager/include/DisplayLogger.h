@@ -1,13 +1,31 @@
 #pragma once
 
 #include <Arduino.h>
+#include <stdarg.h>
 #include "DisplayManager.h"
 
-// A simple logger class that works with DisplayManager
+// A simple logger class that works with DisplayManager. Lines are
+// formatted once, straight into the display's log ring, and the serial
+// echo prints the stored line.
 class DisplayLogger {
 private:
     DisplayManager& display;
     bool serialEcho;  // Whether to echo log messages to Serial
+    
+    void vwrite(const char* prefix, const char* format, va_list args) {
+        const char* line = display.vlogf(prefix, format, args);
+        
+        if (serialEcho) {
+            Serial.println(line);
+        }
+    }
+    
+    void write(const char* prefix, const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        vwrite(prefix, format, args);
+        va_end(args);
+    }
 
 public:
     /**
@@ -26,12 +44,17 @@ public:
      * @param message The message to log
      */
     void info(const String& message) {
-        String formattedMsg = "INFO: " + message;
-        display.log(formattedMsg);
-        
-        if (serialEcho) {
-            Serial.println(formattedMsg);
-        }
+        write("INFO: ", "%s", message.c_str());
+    }
+    
+    /**
+     * @brief Log an info message, printf-style and without heap work
+     */
+    void info(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vwrite("INFO: ", format, args);
+        va_end(args);
     }
     
     /**
@@ -40,12 +63,17 @@ public:
      * @param message The message to log
      */
     void warning(const String& message) {
-        String formattedMsg = "WARN: " + message;
-        display.log(formattedMsg);
-        
-        if (serialEcho) {
-            Serial.println(formattedMsg);
-        }
+        write("WARN: ", "%s", message.c_str());
+    }
+    
+    /**
+     * @brief Log a warning message, printf-style and without heap work
+     */
+    void warning(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vwrite("WARN: ", format, args);
+        va_end(args);
     }
     
     /**
@@ -54,12 +82,17 @@ public:
      * @param message The message to log
      */
     void error(const String& message) {
-        String formattedMsg = "ERROR: " + message;
-        display.log(formattedMsg);
-        
-        if (serialEcho) {
-            Serial.println(formattedMsg);
-        }
+        write("ERROR: ", "%s", message.c_str());
+    }
+    
+    /**
+     * @brief Log an error message, printf-style and without heap work
+     */
+    void error(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vwrite("ERROR: ", format, args);
+        va_end(args);
     }
     
     /**
@@ -68,12 +101,17 @@ public:
      * @param message The message to log
      */
     void debug(const String& message) {
-        String formattedMsg = "DEBUG: " + message;
-        display.log(formattedMsg);
-        
-        if (serialEcho) {
-            Serial.println(formattedMsg);
-        }
+        write("DEBUG: ", "%s", message.c_str());
+    }
+    
+    /**
+     * @brief Log a debug message, printf-style and without heap work
+     */
+    void debug(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vwrite("DEBUG: ", format, args);
+        va_end(args);
     }
     
     /**
@@ -3,12 +3,99 @@
 
 #include <Arduino.h>
 #include <U8g2lib.h>
+#include <I2CBus.h>
+#include "LogRing.h"
+#include "DisplayScreen.h"
+#include "TextLayoutCache.h"
+
+// Bytes an SSD1306 area transfer costs besides the pixels: I2C address,
+// control byte and the column/page address commands
+#ifndef DISPLAY_AREA_OVERHEAD_BYTES
+#define DISPLAY_AREA_OVERHEAD_BYTES 5
+#endif
+
+// Shortest time between two frames sent by the scheduler (0 = send every request)
+#ifndef DISPLAY_FRAME_INTERVAL_MS
+#define DISPLAY_FRAME_INTERVAL_MS 100
+#endif
+
+// Time without any page changing after which update() switches the panel
+// off (0 = never); the next changed page switches it on again
+#ifndef DISPLAY_STATIC_POWER_SAVE_MS
+#define DISPLAY_STATIC_POWER_SAVE_MS 0
+#endif
+
+// Render task: below the radio and sensor work, on the core the Arduino
+// loop does not use, so pushing a frame never delays them
+#ifndef DISPLAY_TASK_PRIORITY
+#define DISPLAY_TASK_PRIORITY 1
+#endif
+
+#ifndef DISPLAY_TASK_CORE
+#define DISPLAY_TASK_CORE 0
+#endif
+
+#ifndef DISPLAY_TASK_STACK_SIZE
+#define DISPLAY_TASK_STACK_SIZE 3072
+#endif
+
+// Clock of the hardware I2C backend (the SSD1306 is rated for 400 kHz)
+#ifndef DISPLAY_I2C_FREQUENCY
+#define DISPLAY_I2C_FREQUENCY 400000
+#endif
+
+// Longest one panel transfer may hold the hardware bus
+#ifndef DISPLAY_I2C_TIMEOUT_MS
+#define DISPLAY_I2C_TIMEOUT_MS 20
+#endif
+
+// Largest u8x8 transfer: control byte plus a full 128-column page,
+// or a batch of commands
+#ifndef DISPLAY_I2C_BUFFER_SIZE
+#define DISPLAY_I2C_BUFFER_SIZE 160
+#endif
+
+/**
+ * @brief Transfer counters of refresh()
+ */
+struct DisplayStats {
+    uint32_t frames;        // refresh() calls that sent something
+    uint32_t fullFrames;    // Frames that sent every tile
+    uint32_t skipped;       // refresh() calls with nothing dirty
+    uint32_t tiles;         // 8x8 tiles sent
+    uint32_t bytes;         // Pixel bytes plus area overhead
+    uint32_t lastFrameUs;
+    uint32_t totalUs;
+    uint32_t busErrors;     // Hardware I2C transfers that failed
+    uint32_t requests;      // Frame requests from drawing and update functions
+    uint32_t coalesced;     // Requests merged into a later frame instead of sent
+    uint32_t widgets;       // Screen widgets drawn, see DisplayScreen
+    uint32_t pagesSkipped;  // Dirty pages not sent because their content hash matched the panel
+    uint32_t powerSaves;    // Times the panel was switched off for a static frame
+    uint32_t swaps;         // Frames handed to the render task
+    uint32_t swapsDeferred; // Swaps retried later because the task was still pushing
+    uint32_t commands;      // Controller settings sent (contrast, flip, MUX, inversion)
+    uint32_t commandsSkipped; // Settings not sent because the panel already had them
+
+    float msPerFrame() const { return frames ? totalUs / 1000.0F / frames : 0.0F; }
+    float bytesPerFrame() const { return frames ? (float)bytes / frames : 0.0F; }
+};
 
 /**
  * @brief A class to manage OLED display functionality for ESP32 projects
  * 
  * This class provides a simplified interface for OLED display operations,
  * including rendering screens, logging messages, and display control.
+ *
+ * The panel is bit-banged by default. useHardwareI2C() moves it to an I2C
+ * controller: u8x8 transfers are collected and handed to the controller's
+ * command queue in one piece, and the calling task sleeps on the completion
+ * interrupt instead of toggling pins for the whole frame.
+ *
+ * With startRenderTask() the transfer leaves the caller's task entirely:
+ * drawing goes to the back buffer (the u8g2 framebuffer), refresh() copies
+ * the changed pages into a front buffer in microseconds, and a low-priority
+ * task pushes the front buffer to the panel.
  */
 class DisplayManager {
 public:
@@ -16,14 +103,13 @@ public:
     static const int SCREEN_WIDTH = 128;
     static const int SCREEN_HEIGHT = 64;
     static const int LINE_HEIGHT = 10;
-    static const int MAX_LOG_LINES = 10;
+    static const int MAX_LOG_LINES = LOG_RING_LINES;
+    static const uint8_t SCREEN_COUNT = 5;
+    
+    // The SSD1306 is written in 8x8 pixel tiles (one page byte per column)
+    static const int TILE_COLUMNS = SCREEN_WIDTH / 8;
+    static const int TILE_ROWS = SCREEN_HEIGHT / 8;
     
-    // Heltec board versions
-    enum BoardVersion {
-        V3_0, // V3.0 or V3.1
-        V3_2  // V3.2 (inverted VEXT)
-    };
-
     /**
      * @brief Constructor
      */
@@ -34,17 +120,42 @@ public:
      * 
      * @param sda SDA pin (pass -1 to use default)
      * @param scl SCL pin (pass -1 to use default)
-     * @param boardVersion Board version (V3_0 for V3.0/V3.1, V3_2 for V3.2)
      */
-    void begin(int sda = -1, int scl = -1, BoardVersion boardVersion = V3_0);
+    void begin(int sda = -1, int scl = -1);
+    
+    /**
+     * @brief Drive the panel through a hardware I2C bus instead of bit-banging
+     *
+     * Call before begin(), which configures the bus on the display pins.
+     * Pass an I2CArbiter to share the controller with other devices; each
+     * panel transfer is self-contained, so transfers of other devices may
+     * interleave with a frame.
+     *
+     * @param bus Hardware bus, or null to go back to software I2C
+     */
+    void useHardwareI2C(I2CBus* bus);
+    
+    /**
+     * @brief Whether the panel is driven through a hardware I2C bus
+     */
+    bool isHardwareI2C() const { return bus != nullptr; }
     
     /**
      * @brief Control VEXT power pin for display
      * 
+     * Switching VEXT resets the SSD1306 and its RAM, so the controller
+     * settings and the whole frame are sent again afterwards.
+     * 
      * @param state true to enable display power, false to disable
-     * @param inverted true for V3.2 boards where VEXT is inverted, false for other boards
      */
-    void controlDisplayPower(bool state, bool inverted = false);
+    void controlDisplayPower(bool state);
+    
+    /**
+     * @brief Set the level that switches VEXT on (defaults to VEXT_ACTIVE_HIGH)
+     * 
+     * @param activeHigh true if VEXT is on when HIGH
+     */
+    void setVextActiveHigh(bool activeHigh) { vextActiveHigh = activeHigh; }
     
     /**
      * @brief Clear the display
@@ -52,10 +163,124 @@ public:
     void clear();
     
     /**
-     * @brief Send buffer to display
+     * @brief Send the tiles changed since the last refresh to the display now
+     *
+     * The explicit commit of the frame scheduler: sends the pending frame
+     * regardless of the frame interval. Drawing functions mark the 8x8 tiles
+     * they touch; each tile row is sent as one area from its first to its
+     * last dirty tile. A row (page) whose content hashes the same as when it
+     * was last sent is skipped, so redrawing identical text costs no transfer.
+     * While the render task runs this is swapBuffers() and returns before
+     * the panel is written.
      */
     void refresh();
     
+    /**
+     * @brief Push frames from a FreeRTOS task instead of the caller (ESP32 only)
+     *
+     * Call after begin(). From then on refresh() only swaps buffers, and
+     * panel commands wait for a frame in progress.
+     *
+     * @param priority FreeRTOS task priority
+     * @param core Core to pin the task to
+     * @return true if the task is running
+     */
+    bool startRenderTask(uint8_t priority = DISPLAY_TASK_PRIORITY, int core = DISPLAY_TASK_CORE);
+    
+    /**
+     * @brief Stop the render task after the frame in progress
+     *
+     * Pages swapped but not pushed yet are marked dirty again.
+     */
+    void stopRenderTask();
+    
+    /**
+     * @brief Whether frames are pushed by the render task
+     */
+    bool hasRenderTask() const { return renderTask != nullptr; }
+    
+    /**
+     * @brief Hand the pages changed since the last swap to the render task
+     *
+     * Copies them from the back to the front buffer and wakes the task; never
+     * waits for the panel. refresh() calls this while the task runs.
+     *
+     * @return false if the task was still pushing the previous frame; the
+     * pages stay dirty and the next refresh() or update() hands them over
+     */
+    bool swapBuffers();
+    
+    /**
+     * @brief Get everything drawn onto the panel before returning
+     *
+     * Unlike refresh(), waits for the render task, e.g. before deep sleep.
+     * Without the task it is the same as refresh().
+     *
+     * @param timeoutMs Longest wait for a frame in progress
+     * @return false if the frame in progress did not finish in time
+     */
+    bool flush(uint32_t timeoutMs = 1000);
+    
+    /**
+     * @brief Ask for the drawn changes to be shown
+     *
+     * Sends right away if no frame went out within the frame interval.
+     * Otherwise the frame stays pending until update() or refresh(), and
+     * further requests until then are merged into it. The screen and update
+     * functions call this instead of refresh().
+     */
+    void requestFrame();
+    
+    /**
+     * @brief Send the pending frame once the frame interval has passed
+     *
+     * Call from loop(). Also switches the panel off once no page changed for
+     * the static power-save time (see setStaticPowerSave()).
+     *
+     * @return true if a frame was sent
+     */
+    bool update();
+    
+    /**
+     * @brief Set the shortest time between two scheduled frames
+     *
+     * @param intervalMs Milliseconds, 0 sends every request immediately
+     */
+    void setFrameInterval(uint32_t intervalMs) { frameIntervalMs = intervalMs; }
+    
+    uint32_t getFrameInterval() const { return frameIntervalMs; }
+    
+    /**
+     * @brief Whether a requested frame is waiting for the interval
+     */
+    bool isFramePending() const { return pendingRequests > 0; }
+    
+    /**
+     * @brief Switch the panel off while the frame does not change
+     *
+     * @param timeoutMs Milliseconds without a changed page, 0 disables it
+     */
+    void setStaticPowerSave(uint32_t timeoutMs) { staticPowerSaveMs = timeoutMs; }
+    
+    /**
+     * @brief Whether the panel is off because the frame is static
+     */
+    bool isStaticPowerSave() const { return staticOff; }
+    
+    /**
+     * @brief Mark the whole frame for the next refresh, e.g. after the panel lost power
+     *
+     * Also forgets the page hashes, so every page is sent even if unchanged.
+     */
+    void invalidate();
+    
+    /**
+     * @brief Transfer counters since begin() or resetStats()
+     */
+    const DisplayStats& getStats() const { return stats; }
+    
+    void resetStats();
+    
     /**
      * @brief Put display in power save mode
      */
@@ -63,21 +288,53 @@ public:
     
     /**
      * @brief Wake display from power save mode
+     *
+     * Does not end a static power save; the next changed page does.
      */
     void wakeup();
     
     /**
      * @brief Set display contrast
      * 
+     * Sent only if the panel has a different value.
+     * 
      * @param contrast Contrast value (0-255)
      */
     void setContrast(uint8_t contrast);
     
     /**
      * @brief Set display to normal mode (white text on black background)
+     *
+     * Flip mode, contrast, MUX ratio and inversion are compared with what
+     * was sent last, so calling this on every update costs no bus traffic
+     * once the panel is set up.
      */
     void setNormalMode();
     
+    /**
+     * @brief Send the controller settings again on their next use
+     *
+     * For a panel that may have lost them without begin() or
+     * controlDisplayPower(), e.g. after a brown-out.
+     */
+    void resyncController();
+    
+    /**
+     * @brief Bring the panel back after it lost power behind our back
+     *
+     * E.g. when a sensor recovery cycled VEXT: runs the controller init
+     * sequence again, resends the settings, switches the panel on unless
+     * it sleeps and sends the whole frame.
+     */
+    void restartController();
+    
+    /**
+     * @brief Resync the controller settings on every wakeup()
+     *
+     * Off by default; the SSD1306 keeps its settings in power save.
+     */
+    void setResyncOnWake(bool resync) { resyncOnWake = resync; }
+    
     /**
      * @brief Draw a string at a specific position
      * 
@@ -86,6 +343,7 @@ public:
      * @param text Text to draw
      */
     void drawString(int x, int y, const String& text);
+    void drawString(int x, int y, const char* text);
     
     /**
      * @brief Draw a centered string at a specific Y position
@@ -153,9 +411,27 @@ public:
      * 2 = LoRaWAN status screen
      * 3 = Sensor data screen
      * 4 = Log screen
-     * @param redraw If true, clear and redraw the screen; if false, just update the screen index
+     * @param redraw Draw every widget again even if the screen is already shown
+     *
+     * Switching to another screen draws it from its model; staying on the
+     * same one draws only what changed since.
      */
-    void setScreen(uint8_t screenIndex, bool redraw = true);
+    void setScreen(uint8_t screenIndex, bool redraw = false);
+    
+    /**
+     * @brief The retained model of a screen
+     *
+     * Screen 0 is empty and left to the application: add widgets once, set
+     * their content and call setScreen(0) or showScreen().
+     */
+    DisplayScreen& getScreenModel(uint8_t screenIndex);
+    
+    /**
+     * @brief Show a screen model, drawing only the widgets that changed
+     *
+     * A model that is not on the panel yet is drawn onto a cleared frame.
+     */
+    void showScreen(DisplayScreen& screen);
     
     /**
      * @brief Get the current screen index
@@ -167,9 +443,32 @@ public:
     /**
      * @brief Add a message to the log
      * 
+     * Messages are copied into the fixed slots of a LogRing; longer ones are
+     * cut (see LOG_RING_LINE_SIZE). The const char* and printf forms do no
+     * heap work.
+     * 
      * @param message Message to log
+     * @return The stored line
+     */
+    const char* log(const char* message);
+    const char* log(const String& message) { return log(message.c_str()); }
+    
+    /**
+     * @brief Add a printf-formatted message to the log
+     */
+    const char* logf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    
+    /**
+     * @brief Add a prefixed printf-formatted message to the log
+     *
+     * @param prefix Copied before the message, e.g. "INFO: " (may be null)
      */
-    void log(const String& message);
+    const char* vlogf(const char* prefix, const char* format, va_list args);
+    
+    /**
+     * @brief The log lines, oldest first
+     */
+    const LogRing& getLog() const { return logRing; }
     
     /**
      * @brief Clear the log
@@ -188,6 +487,16 @@ public:
      */
     void setFont(const uint8_t* font);
     
+    /**
+     * @brief Widths of drawn strings, with hit and miss counters
+     */
+    const TextLayoutCache& getLayoutCache() const { return layoutCache; }
+    
+    /**
+     * @brief Forget the cached string widths
+     */
+    void clearLayoutCache() { layoutCache.clear(); }
+    
     /**
      * @brief Draw the startup screen
      */
@@ -209,6 +518,9 @@ public:
     /**
      * @brief Update the LoRaWAN status screen
      * 
+     * The values are kept in the screen model and drawn when it is shown;
+     * only values that changed are redrawn.
+     * 
      * @param joined Whether device is joined to network
      * @param rssi Last RSSI value
      * @param uplinks Number of uplink messages
@@ -224,12 +536,16 @@ public:
     /**
      * @brief Update the sensor data screen
      * 
+     * The values are kept in the screen model and drawn when it is shown;
+     * only values whose text changed are redrawn.
+     * 
      * @param temperature Temperature in degrees C
      * @param humidity Humidity in percent
      * @param pressure Pressure in hPa
-     * @param battery Battery voltage
+     * @param battery Battery voltage (0 if no battery is connected)
+     * @param batteryPercent State of charge in percent, or -1 to omit it
      */
-    void updateSensorData(float temperature, float humidity, float pressure, float battery);
+    void updateSensorData(float temperature, float humidity, float pressure, float battery, int batteryPercent = -1);
     
     /**
      * @brief Show an error screen
@@ -252,15 +568,86 @@ public:
     void drawLogScreen();
     
 private:
-    // OLED display instance
-    U8G2_SSD1306_128X64_NONAME_F_SW_I2C u8g2;
+    // OLED display instance, set up for the selected I2C backend
+    U8G2 u8g2;
+    I2CBus* bus;
+    int sdaPin;
+    int sclPin;
     
-    // Log buffer
-    String logBuffer[MAX_LOG_LINES];
-    int currentLogLine;
+    // Log lines
+    LogRing logRing;
     
     // Current screen index
     uint8_t currentScreen;
+    
+    // Screen models and the one the panel shows (null after clear())
+    DisplayScreen screens[SCREEN_COUNT];
+    DisplayScreen errorScreen;
+    DisplayScreen* activeScreen;
+    
+    // Font set last and the widths measured in each font
+    const uint8_t* font;
+    TextLayoutCache layoutCache;
+    
+    // Dirty tiles, one bit per tile column in each tile row
+    uint16_t dirtyTiles[TILE_ROWS];
+    DisplayStats stats;
+    
+    // Frame scheduler
+    uint32_t frameIntervalMs;
+    uint32_t lastFrameMs;
+    uint32_t pendingRequests;
+    
+    // Hash of each page as last sent; a bit of hashedPages is set while the
+    // hash matches the panel RAM
+    uint32_t pageHash[TILE_ROWS];
+    uint8_t hashedPages;
+    
+    // Render task; the front buffer and frontTiles belong to whoever holds
+    // panelLock (a recursive mutex), as do u8x8 commands while the task runs
+    void* renderTask;
+    void* panelLock;
+    uint8_t frontBuffer[TILE_ROWS * SCREEN_WIDTH];
+    uint16_t frontTiles[TILE_ROWS];
+    
+    // Power save: by sleep() or because the frame stayed the same
+    uint32_t staticPowerSaveMs;
+    uint32_t lastChangeMs;
+    bool sleeping;
+    bool staticOff;
+    bool panelOff;
+    bool resyncOnWake;
+    bool vextActiveHigh;
+    
+    // SSD1306 settings as last sent, CONTROLLER_UNKNOWN until sent after
+    // begin() or resyncController()
+    int16_t panelContrast;
+    int16_t panelFlip;
+    int16_t panelMux;
+    int16_t panelInverted;
+    
+    void markAllDirty();
+    void markDirty(int x, int y, int width, int height);
+    uint32_t hashPage(int row);
+    bool takeChangedTiles(uint16_t* tiles);
+    void sendTiles(const uint8_t* buffer, const uint16_t* tiles);
+    bool lockPanel(uint32_t timeoutMs);
+    void unlockPanel();
+    static void renderTaskMain(void* param);
+    void applyPowerSave();
+    bool controllerChanged(int16_t& setting, uint8_t value);
+    void markTextDirty(int x, int y, const char* text);
+    int textWidth(const char* text);
+    static int measureText(const char* text, void* context);
+    void commitFrame();
+    
+    void buildScreens();
+    bool renderScreen(DisplayScreen& screen);
+    void drawWidget(Widget& widget);
+    WidgetBox textBox(int x, int y, int width);
+    
+    void setupBackend();
+    static uint8_t hardwareI2CByte(u8x8_t* u8x8, uint8_t msg, uint8_t argInt, void* argPtr);
 };
 
 #endif // DISPLAY_MANAGER_H 
\ No newline at end of file
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// Widgets per screen; the sensor and LoRaWAN screens use ten
+#ifndef DISPLAY_SCREEN_MAX_WIDGETS
+#define DISPLAY_SCREEN_MAX_WIDGETS 12
+#endif
+
+// Bytes of a text widget including the terminator (25 profont10 characters
+// fill the 128 px panel)
+#ifndef DISPLAY_WIDGET_TEXT_SIZE
+#define DISPLAY_WIDGET_TEXT_SIZE 26
+#endif
+
+enum WidgetType : uint8_t {
+    WIDGET_TEXT,        // Label or value at a baseline
+    WIDGET_BAR,         // Progress bar: frame plus filled part
+    WIDGET_LINE
+};
+
+enum WidgetAlign : uint8_t {
+    ALIGN_LEFT,         // x is the left edge
+    ALIGN_CENTER,       // Centered on the panel, x is ignored
+    ALIGN_RIGHT         // Right edge on the panel's, x is ignored
+};
+
+/**
+ * @brief Pixel box, empty when width or height is 0
+ */
+struct WidgetBox {
+    int16_t x;
+    int16_t y;
+    int16_t width;
+    int16_t height;
+
+    bool empty() const { return width <= 0 || height <= 0; }
+
+    bool intersects(const WidgetBox& other) const {
+        return !empty() && !other.empty() &&
+               x < other.x + other.width && other.x < x + width &&
+               y < other.y + other.height && other.y < y + height;
+    }
+};
+
+/**
+ * @brief One element of a screen with its content and where it was drawn
+ */
+struct Widget {
+    WidgetType type;
+    WidgetAlign align;
+    const uint8_t* font;        // Text widgets
+    int16_t x;                  // Text: baseline origin; bar: top-left; line: start
+    int16_t y;
+    int16_t width;              // Bar: size; line: end point
+    int16_t height;
+    uint8_t progress;           // Bar, 0-100
+    bool changed;               // Content differs from what the panel shows
+    char text[DISPLAY_WIDGET_TEXT_SIZE];
+    int16_t textWidth;          // Pixel width of text, -1 until measured
+    WidgetBox drawn;            // Pixels covered on the panel, empty if not drawn
+};
+
+/**
+ * @brief Retained description of one screen
+ *
+ * A screen is built once from labels, values, bars and lines. Afterwards
+ * only their content is set; a setter that receives what the widget already
+ * holds changes nothing. DisplayManager redraws just the widgets that
+ * changed (and those their old box overlapped), so drawing work follows
+ * what changed instead of the whole screen, and a screen can be updated
+ * while another one is shown.
+ */
+class DisplayScreen {
+public:
+    static const uint8_t MAX_WIDGETS = DISPLAY_SCREEN_MAX_WIDGETS;
+
+    DisplayScreen();
+
+    /**
+     * @brief Remove every widget
+     */
+    void reset();
+
+    /**
+     * @brief Whether widgets have been added since reset()
+     */
+    bool isBuilt() const { return count > 0; }
+
+    /**
+     * @brief Add a label or value
+     *
+     * @return Widget id, or -1 if the screen is full
+     */
+    int8_t addText(int16_t x, int16_t y, const uint8_t* font, WidgetAlign align = ALIGN_LEFT,
+                   const char* text = "");
+
+    /**
+     * @brief Add a progress bar
+     */
+    int8_t addBar(int16_t x, int16_t y, int16_t width, int16_t height, uint8_t progress = 0);
+
+    /**
+     * @brief Add a line from (x0, y0) to (x1, y1)
+     */
+    int8_t addLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+
+    /**
+     * @brief Set the text of a widget
+     *
+     * @return true if it differs from the current text
+     */
+    bool setText(int8_t id, const char* text);
+
+    bool setTextf(int8_t id, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+    /**
+     * @brief Set the progress of a bar (clamped to 100)
+     *
+     * @return true if it changed
+     */
+    bool setProgress(int8_t id, uint8_t progress);
+
+    /**
+     * @brief Whether any widget waits to be redrawn
+     */
+    bool hasChanges() const;
+
+    /**
+     * @brief Forget what the panel shows, so every widget is drawn again
+     */
+    void invalidate();
+
+    uint8_t size() const { return count; }
+    Widget& widget(uint8_t id) { return widgets[id]; }
+    const Widget& widget(uint8_t id) const { return widgets[id]; }
+
+private:
+    Widget widgets[MAX_WIDGETS];
+    uint8_t count;
+
+    Widget* add(WidgetType type);
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Lines kept for the log screen
+#ifndef LOG_RING_LINES
+#define LOG_RING_LINES 10
+#endif
+
+// Bytes per line including the terminator; 25 profont10 characters fit
+// the 128 px panel, the rest is kept for the serial echo
+#ifndef LOG_RING_LINE_SIZE
+#define LOG_RING_LINE_SIZE 48
+#endif
+
+// Replaces the end of a line that did not fit
+#define LOG_RING_TRUNCATION_MARK '~'
+
+/**
+ * @brief Fixed-capacity log of text lines
+ *
+ * Lines are formatted straight into preallocated slots of a circular
+ * buffer: appending is O(1), overwrites the oldest line when full and never
+ * touches the heap, so logging from hot paths cannot fragment it. A line
+ * longer than a slot is cut and ends in LOG_RING_TRUNCATION_MARK.
+ *
+ * Plain C++ without Arduino dependencies, so it also runs in host tests.
+ */
+class LogRing {
+public:
+    static const size_t LINES = LOG_RING_LINES;
+    static const size_t LINE_SIZE = LOG_RING_LINE_SIZE;
+
+    LogRing() { clear(); }
+
+    /**
+     * @brief Add a line
+     *
+     * @return The stored line, valid until LINES further appends
+     */
+    const char* append(const char* text) {
+        char* line = nextSlot();
+        size_t length = text ? strlen(text) : 0;
+        if (length >= LINE_SIZE) {
+            memcpy(line, text, LINE_SIZE - 1);
+            markTruncated(line);
+        } else {
+            memcpy(line, text ? text : "", length + 1);
+        }
+        return line;
+    }
+
+    /**
+     * @brief Add a printf-formatted line
+     */
+    const char* appendf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        const char* line = vappendf(nullptr, format, args);
+        va_end(args);
+        return line;
+    }
+
+    /**
+     * @brief Add a line made of a prefix and a printf-formatted message
+     *
+     * @param prefix Copied before the message, e.g. "INFO: " (may be null)
+     */
+    const char* vappendf(const char* prefix, const char* format, va_list args) {
+        char* line = nextSlot();
+        size_t used = prefix ? strlen(prefix) : 0;
+        if (used >= LINE_SIZE) {
+            memcpy(line, prefix, LINE_SIZE - 1);
+            markTruncated(line);
+            return line;
+        }
+        memcpy(line, prefix ? prefix : "", used);
+
+        int length = vsnprintf(line + used, LINE_SIZE - used, format, args);
+        if (length < 0) {
+            line[used] = '\0';
+        } else if ((size_t)length >= LINE_SIZE - used) {
+            markTruncated(line);
+        }
+        return line;
+    }
+
+    /**
+     * @brief Lines held, at most LINES
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief A held line, 0 = oldest
+     */
+    const char* line(size_t index) const {
+        if (index >= count) return "";
+        return slots[(head + LINES - count + index) % LINES];
+    }
+
+    /**
+     * @brief The line appended last ("" if empty)
+     */
+    const char* newest() const { return count ? line(count - 1) : ""; }
+
+    void clear() {
+        head = 0;
+        count = 0;
+        appended = 0;
+        truncated = 0;
+        for (size_t i = 0; i < LINES; i++) {
+            slots[i][0] = '\0';
+        }
+    }
+
+    /**
+     * @brief Lines appended since clear(), including overwritten ones
+     */
+    uint32_t getAppended() const { return appended; }
+
+    /**
+     * @brief Lines that were cut to fit a slot
+     */
+    uint32_t getTruncated() const { return truncated; }
+
+private:
+    char slots[LINES][LINE_SIZE];
+    size_t head;            // Slot the next line goes to
+    size_t count;
+    uint32_t appended;
+    uint32_t truncated;
+
+    char* nextSlot() {
+        char* line = slots[head];
+        head = (head + 1) % LINES;
+        if (count < LINES) count++;
+        appended++;
+        return line;
+    }
+
+    void markTruncated(char* line) {
+        line[LINE_SIZE - 2] = LOG_RING_TRUNCATION_MARK;
+        line[LINE_SIZE - 1] = '\0';
+        truncated++;
+    }
+};
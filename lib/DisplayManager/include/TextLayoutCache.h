@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Measured strings kept; the built-in screens use about a dozen per font
+#ifndef TEXT_LAYOUT_CACHE_ENTRIES
+#define TEXT_LAYOUT_CACHE_ENTRIES 24
+#endif
+
+// Measures text in the current font, e.g. through U8G2::getStrWidth()
+typedef int (*TextMeasure)(const char* text, void* context);
+
+/**
+ * @brief Pixel widths of recently drawn strings
+ *
+ * U8g2 finds every glyph in the font data to measure a string, which
+ * centering and right alignment do on every draw. The cache keys a width by
+ * font, length and an FNV-1a hash of the text, so a repeated string costs a
+ * hash and a few compares. Entries are replaced round-robin once full.
+ *
+ * Plain C++ without Arduino dependencies, so it also runs in host tests.
+ */
+class TextLayoutCache {
+public:
+    static const uint8_t ENTRIES = TEXT_LAYOUT_CACHE_ENTRIES;
+
+    TextLayoutCache() { clear(); }
+
+    /**
+     * @brief Width of text in font, measured only if not cached
+     */
+    int width(const uint8_t* font, const char* text, TextMeasure measure, void* context) {
+        if (!text || !text[0]) return 0;
+
+        size_t length = 0;
+        uint32_t hash = 2166136261UL;
+        for (const char* c = text; *c; c++, length++) {
+            hash = (hash ^ (uint8_t)*c) * 16777619UL;
+        }
+
+        for (uint8_t i = 0; i < used; i++) {
+            const Entry& entry = entries[i];
+            if (entry.hash == hash && entry.font == font && entry.length == length) {
+                hits++;
+                return entry.width;
+            }
+        }
+
+        misses++;
+        Entry& entry = entries[next];
+        entry.font = font;
+        entry.hash = hash;
+        entry.length = (uint16_t)length;
+        entry.width = (int16_t)measure(text, context);
+        next = (uint8_t)((next + 1) % ENTRIES);
+        if (used < ENTRIES) used++;
+        return entry.width;
+    }
+
+    /**
+     * @brief Forget every width, e.g. after a font's data changed
+     */
+    void clear() {
+        used = 0;
+        next = 0;
+        hits = 0;
+        misses = 0;
+    }
+
+    uint8_t size() const { return used; }
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+
+private:
+    struct Entry {
+        const uint8_t* font;
+        uint32_t hash;
+        uint16_t length;
+        int16_t width;
+    };
+
+    Entry entries[ENTRIES];
+    uint8_t used;
+    uint8_t next;           // Entry replaced by the next miss
+    uint32_t hits;
+    uint32_t misses;
+};
@@ -1,71 +1,203 @@
 #include "DisplayManager.h"
+#include "Config.h"
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
 
 // Default pins for OLED display
 #define DEFAULT_OLED_SDA 17
 #define DEFAULT_OLED_SCL 18
 #define DEFAULT_OLED_RST 21
-#define VEXT_PIN 36  // VEXT control pin on Heltec boards (GPIO36)
+
+// Level that switches VEXT on when Config.h does not set it
+#ifndef VEXT_ACTIVE_HIGH
+#define VEXT_ACTIVE_HIGH false
+#endif
+
+// Every tile of a row
+#define ALL_TILES ((uint16_t)((1UL << DisplayManager::TILE_COLUMNS) - 1))
+
+// lockPanel() timeout that waits as long as it takes
+#define DISPLAY_WAIT_FOREVER 0xFFFFFFFFUL
+
+// Shadowed controller setting that has to be sent on its next use
+#define CONTROLLER_UNKNOWN -1
+
+// Log lines on the log screen
+#define LOG_SCREEN_LINES 5
+
+// Widget ids of the built-in screens, in the order buildScreens() adds them
+enum { STARTUP_TITLE, STARTUP_SUBTITLE, STARTUP_STATUS, STARTUP_BAR };
+enum { STATUS_NETWORK = 3, STATUS_RSSI = 5, STATUS_UPLINKS = 7, STATUS_DOWNLINKS = 9 };
+enum { SENSOR_TEMPERATURE = 3, SENSOR_HUMIDITY = 5, SENSOR_PRESSURE = 7, SENSOR_BATTERY = 9 };
+enum { LOG_FIRST_LINE = 2 };
+enum { ERROR_TITLE, ERROR_SEPARATOR, ERROR_MESSAGE, ERROR_LINE1, ERROR_LINE2 };
+
+// The u8x8 byte callback has no user pointer, so the hardware backend
+// serves one panel: the display that called useHardwareI2C() last
+static DisplayManager* hardwareOwner = nullptr;
+static uint8_t transferBuffer[DISPLAY_I2C_BUFFER_SIZE];
+static size_t transferLength = 0;
+static bool transferOverflow = false;
 
 DisplayManager::DisplayManager() : 
-    u8g2(U8G2_R0, DEFAULT_OLED_SCL, DEFAULT_OLED_SDA, DEFAULT_OLED_RST),
-    currentLogLine(0),
-    currentScreen(0) {
-    
-    // Initialize log buffer
-    for (int i = 0; i < MAX_LOG_LINES; i++) {
-        logBuffer[i] = "";
+    bus(nullptr),
+    sdaPin(DEFAULT_OLED_SDA),
+    sclPin(DEFAULT_OLED_SCL),
+    currentScreen(0),
+    activeScreen(nullptr),
+    font(nullptr),
+    frameIntervalMs(DISPLAY_FRAME_INTERVAL_MS),
+    lastFrameMs(0),
+    pendingRequests(0),
+    hashedPages(0),
+    renderTask(nullptr),
+    panelLock(nullptr),
+    staticPowerSaveMs(DISPLAY_STATIC_POWER_SAVE_MS),
+    lastChangeMs(0),
+    sleeping(false),
+    staticOff(false),
+    panelOff(false),
+    resyncOnWake(false),
+    vextActiveHigh(VEXT_ACTIVE_HIGH),
+    panelContrast(CONTROLLER_UNKNOWN),
+    panelFlip(CONTROLLER_UNKNOWN),
+    panelMux(CONTROLLER_UNKNOWN),
+    panelInverted(CONTROLLER_UNKNOWN) {
+    
+    memset(frontTiles, 0, sizeof(frontTiles));
+    setupBackend();
+    buildScreens();
+    
+    invalidate();
+    resetStats();
+}
+
+void DisplayManager::useHardwareI2C(I2CBus* bus) {
+    this->bus = bus;
+    if (bus) {
+        hardwareOwner = this;
+    } else if (hardwareOwner == this) {
+        hardwareOwner = nullptr;
     }
+    setupBackend();
 }
 
-void DisplayManager::controlDisplayPower(bool state, bool inverted) {
-    pinMode(VEXT_PIN, OUTPUT);
-    
-    // For V3.2 boards, VEXT is inverted (LOW turns on the display, HIGH turns it off)
-    // For older boards, VEXT is normal (LOW turns off the display, HIGH turns it on)
-    if (inverted) {
-        digitalWrite(VEXT_PIN, state ? LOW : HIGH);
+void DisplayManager::setupBackend() {
+    // Same controller, buffer and display callbacks as the SW_I2C/HW_I2C
+    // constructors; only the byte transport differs
+    u8g2_Setup_ssd1306_i2c_128x64_noname_f(u8g2.getU8g2(), U8G2_R0,
+        bus ? hardwareI2CByte : u8x8_byte_arduino_sw_i2c, u8x8_gpio_and_delay_arduino);
+    
+    if (bus) {
+        // Only the reset pin is a GPIO; the bus owns SDA and SCL
+        u8x8_SetPin_HW_I2C(u8g2.getU8x8(), DEFAULT_OLED_RST, U8X8_PIN_NONE, U8X8_PIN_NONE);
     } else {
-        digitalWrite(VEXT_PIN, state ? HIGH : LOW);
+        u8x8_SetPin_SW_I2C(u8g2.getU8x8(), sclPin, sdaPin, DEFAULT_OLED_RST);
     }
+}
+
+uint8_t DisplayManager::hardwareI2CByte(u8x8_t* u8x8, uint8_t msg, uint8_t argInt, void* argPtr) {
+    DisplayManager* owner = hardwareOwner;
+    if (!owner || !owner->bus) return 0;
     
-    delay(10); // Small delay to ensure power stabilizes
+    switch (msg) {
+        case U8X8_MSG_BYTE_INIT:
+            return owner->bus->begin(owner->sdaPin, owner->sclPin, DISPLAY_I2C_FREQUENCY) ? 1 : 0;
+        
+        case U8X8_MSG_BYTE_SET_DC:
+            // The control byte in the data carries D/C on I2C
+            break;
+        
+        case U8X8_MSG_BYTE_START_TRANSFER:
+            transferLength = 0;
+            transferOverflow = false;
+            break;
+        
+        case U8X8_MSG_BYTE_SEND:
+            if (transferLength + argInt > sizeof(transferBuffer)) {
+                transferOverflow = true;
+                break;
+            }
+            memcpy(transferBuffer + transferLength, argPtr, argInt);
+            transferLength += argInt;
+            break;
+        
+        case U8X8_MSG_BYTE_END_TRANSFER: {
+            // One queued transaction per u8x8 transfer; a truncated one is
+            // not sent, the next full refresh repairs the panel
+            I2CStatus status = transferOverflow ? I2C_ERR_DATA_TOO_LONG :
+                owner->bus->transfer(u8x8_GetI2CAddress(u8x8) >> 1, transferBuffer, transferLength,
+                                     nullptr, 0, DISPLAY_I2C_TIMEOUT_MS);
+            if (status != I2C_OK) {
+                owner->stats.busErrors++;
+            }
+            break;
+        }
+        
+        default:
+            return 0;
+    }
+    return 1;
 }
 
-void DisplayManager::begin(int sda, int scl, BoardVersion boardVersion) {
-    // Control display power based on board version
-    controlDisplayPower(true, boardVersion == V3_2);
+void DisplayManager::controlDisplayPower(bool state) {
+    // The same level setup() and SensorManager use
+    pinMode(VEXT_PIN, OUTPUT);
+    digitalWrite(VEXT_PIN, state == vextActiveHigh ? HIGH : LOW);
     
-    // Initialize the OLED display
+    delay(10); // Small delay to ensure power stabilizes
+    
+    // The controller restarts from reset with an empty RAM
+    resyncController();
+    invalidate();
+}
+
+void DisplayManager::begin(int sda, int scl) {
+    // VEXT also powers the sensors, so this only confirms it is on
+    controlDisplayPower(true);
+    
+    // Initialize the OLED display on the requested pins
+    sdaPin = sda != -1 ? sda : DEFAULT_OLED_SDA;
+    sclPin = scl != -1 ? scl : DEFAULT_OLED_SCL;
+    setupBackend();
     if (sda != -1 && scl != -1) {
-        u8g2.setBusClock(400000);  // Set I2C clock speed to 400kHz
-        u8g2.begin();
-    } else {
-        u8g2.begin();
+        u8g2.setBusClock(DISPLAY_I2C_FREQUENCY);
     }
+    u8g2.begin();
     
     // Set initial font
-    u8g2.setFont(u8g2_font_profont12_tf);
+    setFont(u8g2_font_profont12_tf);
     
-    // Set normal display mode (white text on black background)
-    u8g2.setFlipMode(0);
-    u8g2.sendF("ca", 0x0A8, 0x03F); // Set MUX ratio
-    u8g2.setContrast(255);          // Maximum contrast
+    // Set normal display mode (white text on black background); the
+    // init sequence of u8g2.begin() leaves the settings unknown
+    resyncController();
+    setNormalMode();
     u8g2.setDisplayRotation(U8G2_R0); // Normal orientation
     
-    // Set drawing color to white (1)
-    u8g2.setDrawColor(1);           // White drawing color for text/lines
-    u8g2.setFontMode(0);            // Solid font (not transparent)
-    u8g2.setColorIndex(1);          // White pixels active
-    
     // Clear display and set screen to startup
     clear();
     currentScreen = 0; // Default screen
-    currentLogLine = 0;
     
     // Clear log buffer
-    for (int i = 0; i < MAX_LOG_LINES; i++) {
-        logBuffer[i] = "";
-    }
+    logRing.clear();
+    
+    // The panel RAM is undefined after power-up
+    invalidate();
+    resetStats();
+    
+    // The first request goes out without waiting
+    pendingRequests = 0;
+    lastFrameMs = millis() - frameIntervalMs;
+    
+    // u8g2.begin() leaves the panel on
+    lastChangeMs = millis();
+    sleeping = false;
+    staticOff = false;
+    panelOff = false;
     
     Serial.println(F("Display initialized"));
 }
@@ -82,50 +214,434 @@ void DisplayManager::clear() {
     
     // Restore the original color index (usually white/1)
     u8g2.setColorIndex(colorIndex);
+    
+    // No screen model matches the blank frame any more; pages that end up
+    // as before are still skipped by their hash
+    activeScreen = nullptr;
+    markAllDirty();
+}
+
+void DisplayManager::invalidate() {
+    markAllDirty();
+    hashedPages = 0;
+}
+
+void DisplayManager::markAllDirty() {
+    for (int row = 0; row < TILE_ROWS; row++) {
+        dirtyTiles[row] = ALL_TILES;
+    }
+}
+
+uint32_t DisplayManager::hashPage(int row) {
+    // FNV-1a over the 128 column bytes of the page
+    const uint8_t* page = u8g2.getBufferPtr() + row * SCREEN_WIDTH;
+    uint32_t hash = 2166136261UL;
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        hash = (hash ^ page[x]) * 16777619UL;
+    }
+    return hash;
+}
+
+void DisplayManager::applyPowerSave() {
+    bool off = sleeping || staticOff;
+    if (off != panelOff && lockPanel(DISPLAY_WAIT_FOREVER)) {
+        u8g2.setPowerSave(off ? 1 : 0);
+        panelOff = off;
+        unlockPanel();
+    }
+}
+
+bool DisplayManager::controllerChanged(int16_t& setting, uint8_t value) {
+    if (setting == value) {
+        stats.commandsSkipped++;
+        return false;
+    }
+    setting = value;
+    stats.commands++;
+    return true;
+}
+
+void DisplayManager::resyncController() {
+    panelContrast = CONTROLLER_UNKNOWN;
+    panelFlip = CONTROLLER_UNKNOWN;
+    panelMux = CONTROLLER_UNKNOWN;
+    panelInverted = CONTROLLER_UNKNOWN;
+}
+
+void DisplayManager::restartController() {
+    // The controller came back from reset: display off, settings and RAM lost
+    if (lockPanel(DISPLAY_WAIT_FOREVER)) {
+        u8g2.initDisplay();
+        panelOff = true;
+        unlockPanel();
+    }
+    resyncController();
+    setNormalMode();
+    applyPowerSave();
+    invalidate();
+    requestFrame();
+}
+
+void DisplayManager::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void DisplayManager::markDirty(int x, int y, int width, int height) {
+    // Clip to the panel, then set the bits of every tile the box touches
+    int x1 = x + width - 1;
+    int y1 = y + height - 1;
+    if (width <= 0 || height <= 0 || x1 < 0 || y1 < 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT) {
+        return;
+    }
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x1 >= SCREEN_WIDTH) x1 = SCREEN_WIDTH - 1;
+    if (y1 >= SCREEN_HEIGHT) y1 = SCREEN_HEIGHT - 1;
+    
+    uint16_t columns = (uint16_t)(((1UL << (x1 / 8 + 1)) - 1) & ~((1UL << (x / 8)) - 1));
+    for (int row = y / 8; row <= y1 / 8; row++) {
+        dirtyTiles[row] |= columns;
+    }
+}
+
+void DisplayManager::markTextDirty(int x, int y, const char* text) {
+    WidgetBox box = textBox(x, y, textWidth(text));
+    markDirty(box.x, box.y, box.width, box.height);
+}
+
+int DisplayManager::textWidth(const char* text) {
+    return layoutCache.width(font, text, measureText, this);
+}
+
+int DisplayManager::measureText(const char* text, void* context) {
+    return static_cast<DisplayManager*>(context)->u8g2.getStrWidth(text);
+}
+
+void DisplayManager::requestFrame() {
+    stats.requests++;
+    pendingRequests++;
+    
+    if (millis() - lastFrameMs >= frameIntervalMs) {
+        refresh();
+    }
+}
+
+void DisplayManager::commitFrame() {
+    stats.requests++;
+    pendingRequests++;
+    refresh();
+}
+
+bool DisplayManager::update() {
+    if (staticPowerSaveMs > 0 && !staticOff && millis() - lastChangeMs >= staticPowerSaveMs) {
+        // Nothing changed on the panel for a while
+        staticOff = true;
+        stats.powerSaves++;
+        applyPowerSave();
+    }
+    
+    if (pendingRequests == 0 || millis() - lastFrameMs < frameIntervalMs) {
+        return false;
+    }
+    
+    uint32_t frames = stats.frames;
+    refresh();
+    return stats.frames != frames;
 }
 
 void DisplayManager::refresh() {
-    u8g2.sendBuffer();
+    // Every request since the last frame is served by this one
+    if (pendingRequests > 1) {
+        stats.coalesced += pendingRequests - 1;
+    }
+    pendingRequests = 0;
+    lastFrameMs = millis();
+    
+    if (renderTask) {
+        if (!swapBuffers()) {
+            // Still pushing the last frame; update() tries again
+            pendingRequests = 1;
+        }
+        return;
+    }
+    
+    uint16_t tiles[TILE_ROWS];
+    if (takeChangedTiles(tiles)) {
+        sendTiles(u8g2.getBufferPtr(), tiles);
+    }
+}
+
+bool DisplayManager::takeChangedTiles(uint16_t* tiles) {
+    uint8_t rows = 0;
+    
+    for (int row = 0; row < TILE_ROWS; row++) {
+        tiles[row] = dirtyTiles[row];
+        if (tiles[row] == 0) continue;
+        dirtyTiles[row] = 0;
+        
+        // Drawn, but to the same pixels the panel already has
+        uint32_t hash = hashPage(row);
+        if ((hashedPages & (1 << row)) && pageHash[row] == hash) {
+            stats.pagesSkipped++;
+            tiles[row] = 0;
+            continue;
+        }
+        pageHash[row] = hash;
+        hashedPages |= 1 << row;
+        rows++;
+    }
+    
+    if (rows == 0) {
+        stats.skipped++;
+        return false;
+    }
+    
+    // The frame changed: end a static power save
+    lastChangeMs = millis();
+    if (staticOff) {
+        staticOff = false;
+        applyPowerSave();
+    }
+    return true;
+}
+
+void DisplayManager::sendTiles(const uint8_t* buffer, const uint16_t* tiles) {
+    uint32_t start = micros();
+    uint32_t sent = 0;
+    uint32_t bytes = 0;
+    
+    for (int row = 0; row < TILE_ROWS; row++) {
+        uint16_t dirty = tiles[row];
+        if (dirty == 0) continue;
+        
+        // One area per row, from the first to the last dirty tile: each
+        // extra area costs the address commands again, a clean tile in
+        // between only 8 bytes
+        int first = 0;
+        while (!(dirty & (1 << first))) first++;
+        int last = TILE_COLUMNS - 1;
+        while (!(dirty & (1 << last))) last--;
+        
+        // Page layout: a tile is 8 consecutive column bytes of its row
+        u8x8_DrawTile(u8g2.getU8x8(), first, row, last - first + 1,
+                      (uint8_t*)buffer + row * SCREEN_WIDTH + first * 8);
+        sent += last - first + 1;
+        bytes += (last - first + 1) * 8 + DISPLAY_AREA_OVERHEAD_BYTES;
+    }
+    
+    stats.lastFrameUs = micros() - start;
+    stats.totalUs += stats.lastFrameUs;
+    stats.frames++;
+    stats.tiles += sent;
+    stats.bytes += bytes;
+    if (sent == (uint32_t)(TILE_COLUMNS * TILE_ROWS)) {
+        stats.fullFrames++;
+    }
+}
+
+bool DisplayManager::swapBuffers() {
+    if (!renderTask) {
+        return false;
+    }
+    if (!lockPanel(0)) {
+        stats.swapsDeferred++;
+        return false;
+    }
+    
+    uint16_t tiles[TILE_ROWS];
+    bool changed = takeChangedTiles(tiles);
+    if (changed) {
+        // Whole pages: the task may not have pushed the last swap yet, and
+        // the row then holds tiles of both
+        const uint8_t* back = u8g2.getBufferPtr();
+        for (int row = 0; row < TILE_ROWS; row++) {
+            if (tiles[row] == 0) continue;
+            memcpy(frontBuffer + row * SCREEN_WIDTH, back + row * SCREEN_WIDTH, SCREEN_WIDTH);
+            frontTiles[row] |= tiles[row];
+        }
+        stats.swaps++;
+    }
+    unlockPanel();
+    
+#if defined(ESP_PLATFORM)
+    if (changed) {
+        xTaskNotifyGive((TaskHandle_t)renderTask);
+    }
+#endif
+    return true;
+}
+
+bool DisplayManager::flush(uint32_t timeoutMs) {
+    if (!renderTask) {
+        refresh();
+        return true;
+    }
+    
+    // Holding the lock, the task is idle: swap and push the rest here
+    if (!lockPanel(timeoutMs)) {
+        return false;
+    }
+    pendingRequests = 0;
+    lastFrameMs = millis();
+    swapBuffers();
+    
+    bool outstanding = false;
+    for (int row = 0; row < TILE_ROWS; row++) {
+        outstanding |= frontTiles[row] != 0;
+    }
+    if (outstanding) {
+        sendTiles(frontBuffer, frontTiles);
+        memset(frontTiles, 0, sizeof(frontTiles));
+    }
+    unlockPanel();
+    return true;
+}
+
+bool DisplayManager::startRenderTask(uint8_t priority, int core) {
+#if defined(ESP_PLATFORM)
+    if (renderTask) return true;
+    
+    panelLock = xSemaphoreCreateRecursiveMutex();
+    if (!panelLock) return false;
+    
+    TaskHandle_t handle = nullptr;
+    if (xTaskCreatePinnedToCore(renderTaskMain, "display", DISPLAY_TASK_STACK_SIZE, this, priority,
+                                &handle, core) != pdPASS) {
+        vSemaphoreDelete((SemaphoreHandle_t)panelLock);
+        panelLock = nullptr;
+        return false;
+    }
+    renderTask = handle;
+    return true;
+#else
+    (void)priority;
+    (void)core;
+    return false;
+#endif
+}
+
+void DisplayManager::stopRenderTask() {
+#if defined(ESP_PLATFORM)
+    if (!renderTask) return;
+    
+    lockPanel(DISPLAY_WAIT_FOREVER);
+    vTaskDelete((TaskHandle_t)renderTask);
+    renderTask = nullptr;
+    for (int row = 0; row < TILE_ROWS; row++) {
+        if (frontTiles[row] == 0) continue;
+        // The hash is of the swapped page, which never reached the panel
+        dirtyTiles[row] |= frontTiles[row];
+        frontTiles[row] = 0;
+        hashedPages &= ~(1 << row);
+    }
+    unlockPanel();
+    
+    vSemaphoreDelete((SemaphoreHandle_t)panelLock);
+    panelLock = nullptr;
+#endif
+}
+
+void DisplayManager::renderTaskMain(void* param) {
+#if defined(ESP_PLATFORM)
+    DisplayManager* display = static_cast<DisplayManager*>(param);
+    for (;;) {
+        // Sleep until a swap; swaps during the push are deferred by the lock
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!display->lockPanel(DISPLAY_WAIT_FOREVER)) continue;
+        
+        bool outstanding = false;
+        for (int row = 0; row < TILE_ROWS; row++) {
+            outstanding |= display->frontTiles[row] != 0;
+        }
+        if (outstanding) {
+            display->sendTiles(display->frontBuffer, display->frontTiles);
+            memset(display->frontTiles, 0, sizeof(display->frontTiles));
+        }
+        display->unlockPanel();
+    }
+#else
+    (void)param;
+#endif
+}
+
+bool DisplayManager::lockPanel(uint32_t timeoutMs) {
+#if defined(ESP_PLATFORM)
+    if (!panelLock) return true;
+    TickType_t ticks = timeoutMs == DISPLAY_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    return xSemaphoreTakeRecursive((SemaphoreHandle_t)panelLock, ticks) == pdTRUE;
+#else
+    (void)timeoutMs;
+    return true;
+#endif
+}
+
+void DisplayManager::unlockPanel() {
+#if defined(ESP_PLATFORM)
+    if (panelLock) xSemaphoreGiveRecursive((SemaphoreHandle_t)panelLock);
+#endif
 }
 
 void DisplayManager::sleep() {
-    u8g2.setPowerSave(1);
+    sleeping = true;
+    applyPowerSave();
 }
 
 void DisplayManager::wakeup() {
-    u8g2.setPowerSave(0);  // Wake up display
+    sleeping = false;
+    if (resyncOnWake) {
+        resyncController();
+    }
+    applyPowerSave();  // Wake up display unless the frame is static
 }
 
 void DisplayManager::setContrast(uint8_t contrast) {
-    // Set contrast value (0-255), higher values make display brighter
-    u8g2.setContrast(contrast);
-    refresh();  // Apply changes to display
+    // Set contrast value (0-255), higher values make display brighter;
+    // it is a command, so no frame needs to be sent
+    if (!lockPanel(DISPLAY_WAIT_FOREVER)) return;
+    if (controllerChanged(panelContrast, contrast)) {
+        u8g2.setContrast(contrast);
+    }
+    unlockPanel();
 }
 
 void DisplayManager::setNormalMode() {
     // Reset display to normal mode (white text on black background)
-    u8g2.setFlipMode(0);
-    u8g2.setContrast(255);  // Maximum contrast
-    
-    // These are SSD1306 specific commands
-    u8g2.sendF("ca", 0x0A8, 0x03F); // Set MUX ratio
-    u8g2.sendF("c", 0x0A6);         // Normal display (not inverted)
+    if (lockPanel(DISPLAY_WAIT_FOREVER)) {
+        // Only settings the panel does not have yet are sent
+        if (controllerChanged(panelFlip, 0)) {
+            u8g2.setFlipMode(0);
+        }
+        if (controllerChanged(panelContrast, 255)) {
+            u8g2.setContrast(255);  // Maximum contrast
+        }
+        
+        // These are SSD1306 specific commands
+        if (controllerChanged(panelMux, 0x3F)) {
+            u8g2.sendF("ca", 0x0A8, 0x03F); // Set MUX ratio
+        }
+        if (controllerChanged(panelInverted, 0)) {
+            u8g2.sendF("c", 0x0A6);         // Normal display (not inverted)
+        }
+        unlockPanel();
+    }
     
     // Set drawing color to white (1)
     u8g2.setDrawColor(1);           // White drawing color for text/lines
     u8g2.setFontMode(0);            // Solid font (not transparent)
     u8g2.setColorIndex(1);          // White pixels active
-    
-    // Force a display refresh
-    refresh();
 }
 
 void DisplayManager::drawString(int x, int y, const String& text) {
-    u8g2.drawStr(x, y, text.c_str());
+    drawString(x, y, text.c_str());
+}
+
+void DisplayManager::drawString(int x, int y, const char* text) {
+    u8g2.drawStr(x, y, text);
+    markTextDirty(x, y, text);
 }
 
 void DisplayManager::drawCenteredString(int y, const String& text) {
-    int width = u8g2.getStrWidth(text.c_str());
+    int width = textWidth(text.c_str());
     int x = (SCREEN_WIDTH - width) / 2;
     if (x < 0) x = 0;
     
@@ -133,7 +649,7 @@ void DisplayManager::drawCenteredString(int y, const String& text) {
 }
 
 void DisplayManager::drawRightAlignedString(int y, const String& text) {
-    int width = u8g2.getStrWidth(text.c_str());
+    int width = textWidth(text.c_str());
     int x = SCREEN_WIDTH - width;
     if (x < 0) x = 0;
     
@@ -151,79 +667,231 @@ void DisplayManager::drawProgressBar(int x, int y, int width, int height, uint8_
     if (progressWidth > 0) {
         u8g2.setDrawColor(1); // Ensure we're drawing in white
         u8g2.drawBox(x + 1, y + 1, progressWidth, height - 2);
+        markDirty(x + 1, y + 1, progressWidth, height - 2);
     }
 }
 
 void DisplayManager::drawRect(int x, int y, int width, int height) {
     u8g2.drawFrame(x, y, width, height);
+    markDirty(x, y, width, height);
 }
 
 void DisplayManager::fillRect(int x, int y, int width, int height) {
     u8g2.setDrawColor(0); // 0 for black, 1 for white
     u8g2.drawBox(x, y, width, height);
     u8g2.setDrawColor(1); // Reset to white for subsequent drawing
+    markDirty(x, y, width, height);
 }
 
 void DisplayManager::drawLine(int x0, int y0, int x1, int y1) {
     u8g2.drawLine(x0, y0, x1, y1);
+    markDirty(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, abs(x1 - x0) + 1, abs(y1 - y0) + 1);
 }
 
 void DisplayManager::setScreen(uint8_t screenIndex, bool redraw) {
-    // Update the screen index
+    if (screenIndex >= SCREEN_COUNT) {
+        // Default to main screen
+        screenIndex = 0;
+    }
     currentScreen = screenIndex;
     
-    // If redraw is false, just update the screen index without clearing or drawing
-    if (!redraw) {
-        return;
+    DisplayScreen& screen = screens[screenIndex];
+    if (screenIndex == 4) {
+        refreshLogScreen();
+    }
+    if (redraw && activeScreen == &screen) {
+        activeScreen = nullptr;
     }
     
-    // Otherwise, clear and draw the new screen
-    clear();
+    showScreen(screen);
+}
+
+DisplayScreen& DisplayManager::getScreenModel(uint8_t screenIndex) {
+    return screens[screenIndex < SCREEN_COUNT ? screenIndex : 0];
+}
+
+void DisplayManager::showScreen(DisplayScreen& screen) {
+    renderScreen(screen);
+    requestFrame();
+}
+
+bool DisplayManager::renderScreen(DisplayScreen& screen) {
+    if (activeScreen != &screen) {
+        // Another screen is on the panel: start from a blank frame
+        clear();
+        screen.invalidate();
+        activeScreen = &screen;
+    }
+    if (!screen.hasChanges()) {
+        return false;
+    }
     
-    switch (currentScreen) {
-        case 0: // Main info screen
-            // Empty, to be filled by main application
-            break;
-        case 1: // Startup screen
-            drawStartupScreen();
-            break;
-        case 2: // LoRaWAN status screen
-            drawLoRaWANStatusScreen();
-            break;
-        case 3: // Sensor data screen
-            drawSensorDataScreen();
+    // Erase what the changed widgets covered, then draw them and every
+    // widget that lost pixels to the erase
+    WidgetBox erased[DisplayScreen::MAX_WIDGETS];
+    uint8_t erasedCount = 0;
+    for (uint8_t i = 0; i < screen.size(); i++) {
+        Widget& widget = screen.widget(i);
+        if (!widget.changed || widget.drawn.empty()) continue;
+        
+        fillRect(widget.drawn.x, widget.drawn.y, widget.drawn.width, widget.drawn.height);
+        erased[erasedCount++] = widget.drawn;
+        widget.drawn = WidgetBox();
+    }
+    
+    for (uint8_t i = 0; i < screen.size(); i++) {
+        Widget& widget = screen.widget(i);
+        bool damaged = false;
+        for (uint8_t e = 0; e < erasedCount && !damaged; e++) {
+            damaged = erased[e].intersects(widget.drawn);
+        }
+        if (!widget.changed && !damaged) continue;
+        
+        drawWidget(widget);
+        widget.changed = false;
+        stats.widgets++;
+    }
+    return true;
+}
+
+void DisplayManager::drawWidget(Widget& widget) {
+    WidgetBox box = WidgetBox();
+    
+    switch (widget.type) {
+        case WIDGET_TEXT: {
+            if (widget.text[0] == '\0') break;
+            
+            // Measured once per text; labels never again
+            setFont(widget.font);
+            if (widget.textWidth < 0) {
+                widget.textWidth = (int16_t)textWidth(widget.text);
+            }
+            int width = widget.textWidth;
+            int x = widget.x;
+            if (widget.align == ALIGN_CENTER) {
+                x = (SCREEN_WIDTH - width) / 2;
+            } else if (widget.align == ALIGN_RIGHT) {
+                x = SCREEN_WIDTH - width;
+            }
+            if (x < 0) x = 0;
+            
+            u8g2.drawStr(x, widget.y, widget.text);
+            box = textBox(x, widget.y, width);
+            markDirty(box.x, box.y, box.width, box.height);
             break;
-        case 4: // Log screen
-            drawLogScreen();
+        }
+        
+        case WIDGET_BAR:
+            drawProgressBar(widget.x, widget.y, widget.width, widget.height, widget.progress);
+            box = { widget.x, widget.y, widget.width, widget.height };
             break;
-        default:
-            // Default to main screen
-            currentScreen = 0;
+        
+        case WIDGET_LINE: {
+            // width/height hold the end point
+            drawLine(widget.x, widget.y, widget.width, widget.height);
+            int16_t x0 = widget.x < widget.width ? widget.x : widget.width;
+            int16_t y0 = widget.y < widget.height ? widget.y : widget.height;
+            box = { x0, y0, (int16_t)(abs(widget.width - widget.x) + 1), (int16_t)(abs(widget.height - widget.y) + 1) };
             break;
+        }
     }
     
-    refresh();
+    widget.drawn = box;
+}
+
+WidgetBox DisplayManager::textBox(int x, int y, int width) {
+    // y is the baseline; the font box reaches maxCharHeight above it at most,
+    // and descenders (plus solid-mode background) stay within the same height
+    int height = u8g2.getMaxCharHeight();
+    WidgetBox box = { (int16_t)x, (int16_t)(y - height), (int16_t)width,
+                      (int16_t)(height + height - u8g2.getAscent()) };
+    return box;
 }
 
-void DisplayManager::log(const String& message) {
-    // Shift messages up
-    for (int i = 0; i < MAX_LOG_LINES - 1; i++) {
-        logBuffer[i] = logBuffer[i + 1];
+void DisplayManager::buildScreens() {
+    const uint8_t* title = u8g2_font_profont12_tf;
+    const uint8_t* body = u8g2_font_profont10_tf;
+    
+    // 0: main screen, left to the application
+    
+    // 1: startup
+    DisplayScreen& startup = screens[1];
+    startup.addText(0, 15, title, ALIGN_CENTER, "StructureSense");
+    startup.addText(0, 30, body, ALIGN_CENTER, "ESP32 LoRaWAN Node");
+    startup.addText(0, 45, body, ALIGN_CENTER, "Initializing...");
+    startup.addBar(20, 50, SCREEN_WIDTH - 40, 10);
+    
+    // 2: LoRaWAN status, values filled in by updateLoRaWANStatus()
+    DisplayScreen& lora = screens[2];
+    lora.addText(0, 12, title, ALIGN_CENTER, "LoRaWAN Status");
+    lora.addLine(0, 15, SCREEN_WIDTH, 15);
+    lora.addText(0, 25, body, ALIGN_LEFT, "Network:");
+    lora.addText(0, 25, body, ALIGN_RIGHT);
+    lora.addText(0, 35, body, ALIGN_LEFT, "RSSI:");
+    lora.addText(0, 35, body, ALIGN_RIGHT);
+    lora.addText(0, 45, body, ALIGN_LEFT, "Uplinks:");
+    lora.addText(0, 45, body, ALIGN_RIGHT);
+    lora.addText(0, 55, body, ALIGN_LEFT, "Downlinks:");
+    lora.addText(0, 55, body, ALIGN_RIGHT);
+    
+    // 3: sensor data, values filled in by updateSensorData()
+    DisplayScreen& sensor = screens[3];
+    sensor.addText(0, 12, title, ALIGN_CENTER, "Sensor Data");
+    sensor.addLine(0, 15, SCREEN_WIDTH, 15);
+    sensor.addText(0, 25, body, ALIGN_LEFT, "Temp:");
+    sensor.addText(0, 25, body, ALIGN_RIGHT);
+    sensor.addText(0, 35, body, ALIGN_LEFT, "Humidity:");
+    sensor.addText(0, 35, body, ALIGN_RIGHT);
+    sensor.addText(0, 45, body, ALIGN_LEFT, "Pressure:");
+    sensor.addText(0, 45, body, ALIGN_RIGHT);
+    sensor.addText(0, 55, body, ALIGN_LEFT, "Battery:");
+    sensor.addText(0, 55, body, ALIGN_RIGHT);
+    
+    // 4: log, the newest lines one below the other
+    DisplayScreen& log = screens[4];
+    log.addText(0, 12, title, ALIGN_CENTER, "System Log");
+    log.addLine(0, 15, SCREEN_WIDTH, 15);
+    for (int i = 0; i < LOG_SCREEN_LINES; i++) {
+        log.addText(0, 25 + i * LINE_HEIGHT, body);
     }
     
-    // Add new message to bottom
-    logBuffer[MAX_LOG_LINES - 1] = message;
+    // Error screen: one centered line, or two when the message is long
+    errorScreen.addText(0, 12, title, ALIGN_CENTER);
+    errorScreen.addLine(0, 15, SCREEN_WIDTH, 15);
+    errorScreen.addText(0, 35, body, ALIGN_CENTER);
+    errorScreen.addText(0, 30, body, ALIGN_CENTER);
+    errorScreen.addText(0, 42, body, ALIGN_CENTER);
+}
+
+const char* DisplayManager::log(const char* message) {
+    const char* line = logRing.append(message);
     
     // If we're on the log screen, refresh it
     if (currentScreen == 4) {
         refreshLogScreen();
     }
+    return line;
 }
 
-void DisplayManager::clearLog() {
-    for (int i = 0; i < MAX_LOG_LINES; i++) {
-        logBuffer[i] = "";
+const char* DisplayManager::logf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const char* line = vlogf(nullptr, format, args);
+    va_end(args);
+    return line;
+}
+
+const char* DisplayManager::vlogf(const char* prefix, const char* format, va_list args) {
+    const char* line = logRing.vappendf(prefix, format, args);
+    
+    if (currentScreen == 4) {
+        refreshLogScreen();
     }
+    return line;
+}
+
+void DisplayManager::clearLog() {
+    logRing.clear();
     
     if (currentScreen == 4) {
         refreshLogScreen();
@@ -231,154 +899,99 @@ void DisplayManager::clearLog() {
 }
 
 void DisplayManager::refreshLogScreen() {
-    if (currentScreen != 4) return;
-    
-    // Clear the log area
-    fillRect(0, 16, SCREEN_WIDTH, SCREEN_HEIGHT - 16);
-    
-    // Draw log entries
-    u8g2.setFont(u8g2_font_profont10_tf);
-    
-    int y = 25;
-    int startIdx = MAX_LOG_LINES - 5; // Show last 5 entries
-    if (startIdx < 0) startIdx = 0;
-    
-    for (int i = startIdx; i < MAX_LOG_LINES; i++) {
-        if (logBuffer[i].length() > 0) {
-            drawString(0, y, logBuffer[i]);
-            y += LINE_HEIGHT;
+    // The newest lines, skipping empty ones, from the top
+    DisplayScreen& screen = screens[4];
+    size_t count = logRing.size();
+    size_t start = count > LOG_SCREEN_LINES ? count - LOG_SCREEN_LINES : 0;
+    int8_t id = LOG_FIRST_LINE;
+    
+    for (size_t i = start; i < count; i++) {
+        const char* line = logRing.line(i);
+        if (line[0] != '\0') {
+            screen.setText(id++, line);
         }
     }
+    while (id < LOG_FIRST_LINE + LOG_SCREEN_LINES) {
+        screen.setText(id++, "");
+    }
     
-    refresh();
+    if (activeScreen == &screen && renderScreen(screen)) {
+        requestFrame();
+    }
 }
 
 void DisplayManager::setFont(const uint8_t* font) {
+    // Widths are cached per font
+    this->font = font;
     u8g2.setFont(font);
 }
 
 void DisplayManager::drawStartupScreen() {
-    clear();
-    
-    // Draw logo
-    u8g2.setFont(u8g2_font_profont12_tf);
-    drawCenteredString(15, "StructureSense");
-    
-    u8g2.setFont(u8g2_font_profont10_tf);
-    drawCenteredString(30, "ESP32 LoRaWAN Node");
-    drawCenteredString(45, "Initializing...");
-    
-    // Draw progress bar
-    drawProgressBar(20, 50, SCREEN_WIDTH - 40, 10, 0);
-    
-    refresh();
+    setScreen(1);
 }
 
 void DisplayManager::updateStartupProgress(uint8_t progress, const String& statusText) {
-    // Update progress bar
-    drawProgressBar(20, 50, SCREEN_WIDTH - 40, 10, progress);
-    
-    // Clear status area
-    fillRect(0, 35, SCREEN_WIDTH, 10);
-    
-    // Update status text
-    drawCenteredString(45, statusText);
+    DisplayScreen& screen = screens[1];
+    screen.setProgress(STARTUP_BAR, progress);
+    screen.setText(STARTUP_STATUS, statusText.c_str());
     
-    refresh();
+    if (activeScreen == &screen && renderScreen(screen)) {
+        // Startup steps block right after reporting progress; show it now
+        commitFrame();
+    }
 }
 
 void DisplayManager::drawLoRaWANStatusScreen() {
-    clear();
-    
-    u8g2.setFont(u8g2_font_profont12_tf);
-    drawCenteredString(12, "LoRaWAN Status");
-    
-    u8g2.setFont(u8g2_font_profont10_tf);
-    drawLine(0, 15, SCREEN_WIDTH, 15);
-    
-    // This screen will be updated with actual data by the main application
-    
-    refresh();
+    setScreen(2);
 }
 
 void DisplayManager::updateLoRaWANStatus(bool joined, int16_t rssi, uint32_t uplinks, uint32_t downlinks) {
-    if (currentScreen != 2) return;
-    
-    // Clear the data area
-    fillRect(0, 16, SCREEN_WIDTH, SCREEN_HEIGHT - 16);
-    
-    // Draw network status
-    drawString(0, 25, "Network:");
-    drawRightAlignedString(25, joined ? "JOINED" : "NOT JOINED");
-    
-    // Draw RSSI
-    drawString(0, 35, "RSSI:");
-    drawRightAlignedString(35, String(rssi) + " dBm");
-    
-    // Draw uplink/downlink counters
-    drawString(0, 45, "Uplinks:");
-    drawRightAlignedString(45, String(uplinks));
-    
-    drawString(0, 55, "Downlinks:");
-    drawRightAlignedString(55, String(downlinks));
-    
-    refresh();
+    // Kept in the screen model, drawn now if the screen is shown
+    DisplayScreen& screen = screens[2];
+    screen.setText(STATUS_NETWORK, joined ? "JOINED" : "NOT JOINED");
+    screen.setTextf(STATUS_RSSI, "%d dBm", rssi);
+    screen.setTextf(STATUS_UPLINKS, "%lu", (unsigned long)uplinks);
+    screen.setTextf(STATUS_DOWNLINKS, "%lu", (unsigned long)downlinks);
+    
+    if (activeScreen == &screen && renderScreen(screen)) {
+        requestFrame();
+    }
 }
 
 void DisplayManager::drawSensorDataScreen() {
-    clear();
-    
-    u8g2.setFont(u8g2_font_profont12_tf);
-    drawCenteredString(12, "Sensor Data");
-    
-    u8g2.setFont(u8g2_font_profont10_tf);
-    drawLine(0, 15, SCREEN_WIDTH, 15);
-    
-    // This screen will be updated with actual data by the main application
-    
-    refresh();
+    setScreen(3);
 }
 
-void DisplayManager::updateSensorData(float temperature, float humidity, float pressure, float battery) {
-    if (currentScreen != 3) return;
-    
-    // Clear the data area
-    fillRect(0, 16, SCREEN_WIDTH, SCREEN_HEIGHT - 16);
-    
-    // Draw temperature
-    drawString(0, 25, "Temp:");
-    drawRightAlignedString(25, String(temperature, 1) + " C");
-    
-    // Draw humidity
-    drawString(0, 35, "Humidity:");
-    drawRightAlignedString(35, String(humidity, 1) + " %");
-    
-    // Draw pressure
-    drawString(0, 45, "Pressure:");
-    drawRightAlignedString(45, String(pressure, 1) + " hPa");
-    
-    // Draw battery
-    drawString(0, 55, "Battery:");
-    drawRightAlignedString(55, String(battery, 1) + " V");
+void DisplayManager::updateSensorData(float temperature, float humidity, float pressure, float battery, int batteryPercent) {
+    // Kept in the screen model, drawn now if the screen is shown; values that
+    // print the same as before draw nothing
+    DisplayScreen& screen = screens[3];
+    screen.setTextf(SENSOR_TEMPERATURE, "%.1f C", temperature);
+    screen.setTextf(SENSOR_HUMIDITY, "%.1f %%", humidity);
+    screen.setTextf(SENSOR_PRESSURE, "%.1f hPa", pressure);
+    
+    // No voltage means the board runs without a cell
+    if (battery <= 0) {
+        screen.setText(SENSOR_BATTERY, "n/a");
+    } else if (batteryPercent >= 0) {
+        screen.setTextf(SENSOR_BATTERY, "%.2f V %d%%", battery, batteryPercent);
+    } else {
+        screen.setTextf(SENSOR_BATTERY, "%.2f V", battery);
+    }
     
-    // Always refresh the display immediately after updating sensor data
-    refresh();
+    if (activeScreen == &screen && renderScreen(screen)) {
+        requestFrame();
+    }
 }
 
 void DisplayManager::showErrorScreen(const String& title, const String& errorMsg) {
-    clear();
+    errorScreen.setText(ERROR_TITLE, title.c_str());
     
-    // Set title font and draw title
-    u8g2.setFont(u8g2_font_profont12_tf);
-    drawCenteredString(12, title);
-    
-    // Draw separation line
-    u8g2.setFont(u8g2_font_profont10_tf);
-    drawLine(0, 15, SCREEN_WIDTH, 15);
-    
-    // Draw error message - handle long messages by splitting across lines if needed
+    // Handle long messages by splitting across lines if needed
     if (errorMsg.length() <= 21) { // Fits on a single line
-        drawCenteredString(35, errorMsg);
+        errorScreen.setText(ERROR_MESSAGE, errorMsg.c_str());
+        errorScreen.setText(ERROR_LINE1, "");
+        errorScreen.setText(ERROR_LINE2, "");
     } else {
         // Simple word wrap for error message
         String line1 = errorMsg.substring(0, 21);
@@ -391,11 +1004,14 @@ void DisplayManager::showErrorScreen(const String& title, const String& errorMsg
             line1 = line1.substring(0, lastSpace);
         }
         
-        drawCenteredString(30, line1);
-        drawCenteredString(42, line2);
+        errorScreen.setText(ERROR_MESSAGE, "");
+        errorScreen.setText(ERROR_LINE1, line1.c_str());
+        errorScreen.setText(ERROR_LINE2, line2.c_str());
     }
     
-    refresh();
+    // Errors are shown now, the caller usually waits on them
+    renderScreen(errorScreen);
+    commitFrame();
     
     // Also log the error
     log("ERROR: " + errorMsg);
@@ -436,16 +1052,5 @@ void DisplayManager::showLoRaError(int errorCode) {
 }
 
 void DisplayManager::drawLogScreen() {
-    clear();
-    
-    // Set title font and draw title
-    u8g2.setFont(u8g2_font_profont12_tf);
-    drawCenteredString(12, "System Log");
-    
-    // Draw separation line
-    u8g2.setFont(u8g2_font_profont10_tf);
-    drawLine(0, 15, SCREEN_WIDTH, 15);
-    
-    // Refresh the log content
-    refreshLogScreen();
-} 
\ No newline at end of file
+    setScreen(4);
+}
@@ -0,0 +1,112 @@
+#include "DisplayScreen.h"
+#include <stdio.h>
+#include <string.h>
+
+DisplayScreen::DisplayScreen() {
+    reset();
+}
+
+void DisplayScreen::reset() {
+    memset(widgets, 0, sizeof(widgets));
+    count = 0;
+}
+
+Widget* DisplayScreen::add(WidgetType type) {
+    if (count >= MAX_WIDGETS) return nullptr;
+
+    Widget* widget = &widgets[count++];
+    memset(widget, 0, sizeof(*widget));
+    widget->type = type;
+    widget->changed = true;
+    widget->textWidth = -1;
+    return widget;
+}
+
+int8_t DisplayScreen::addText(int16_t x, int16_t y, const uint8_t* font, WidgetAlign align,
+                              const char* text) {
+    Widget* widget = add(WIDGET_TEXT);
+    if (!widget) return -1;
+
+    widget->x = x;
+    widget->y = y;
+    widget->font = font;
+    widget->align = align;
+    setText(count - 1, text);
+    return count - 1;
+}
+
+int8_t DisplayScreen::addBar(int16_t x, int16_t y, int16_t width, int16_t height, uint8_t progress) {
+    Widget* widget = add(WIDGET_BAR);
+    if (!widget) return -1;
+
+    widget->x = x;
+    widget->y = y;
+    widget->width = width;
+    widget->height = height;
+    widget->progress = progress > 100 ? 100 : progress;
+    return count - 1;
+}
+
+int8_t DisplayScreen::addLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1) {
+    Widget* widget = add(WIDGET_LINE);
+    if (!widget) return -1;
+
+    widget->x = x0;
+    widget->y = y0;
+    widget->width = x1;
+    widget->height = y1;
+    return count - 1;
+}
+
+bool DisplayScreen::setText(int8_t id, const char* text) {
+    if (id < 0 || id >= count) return false;
+
+    Widget& widget = widgets[id];
+    if (!text) text = "";
+    if (strncmp(widget.text, text, sizeof(widget.text) - 1) == 0) {
+        return false;
+    }
+
+    strncpy(widget.text, text, sizeof(widget.text) - 1);
+    widget.text[sizeof(widget.text) - 1] = '\0';
+    widget.textWidth = -1;
+    widget.changed = true;
+    return true;
+}
+
+bool DisplayScreen::setTextf(int8_t id, const char* format, ...) {
+    char text[DISPLAY_WIDGET_TEXT_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    return setText(id, text);
+}
+
+bool DisplayScreen::setProgress(int8_t id, uint8_t progress) {
+    if (id < 0 || id >= count) return false;
+
+    if (progress > 100) progress = 100;
+    Widget& widget = widgets[id];
+    if (widget.progress == progress) {
+        return false;
+    }
+
+    widget.progress = progress;
+    widget.changed = true;
+    return true;
+}
+
+bool DisplayScreen::hasChanges() const {
+    for (uint8_t i = 0; i < count; i++) {
+        if (widgets[i].changed) return true;
+    }
+    return false;
+}
+
+void DisplayScreen::invalidate() {
+    for (uint8_t i = 0; i < count; i++) {
+        widgets[i].changed = true;
+        widgets[i].drawn = WidgetBox();
+    }
+}
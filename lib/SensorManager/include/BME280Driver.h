@@ -0,0 +1,241 @@
+#pragma once
+
+#include <stdint.h>
+#include "I2CEngine.h"
+
+// BME280 register map (datasheet section 5.3)
+#define BME280_REG_CALIB_TP   0x88  // dig_T1..dig_H1, 26 bytes
+#define BME280_REG_CHIP_ID    0xD0
+#define BME280_REG_RESET      0xE0
+#define BME280_REG_CALIB_H    0xE1  // dig_H2..dig_H6, 7 bytes
+#define BME280_REG_CTRL_HUM   0xF2
+#define BME280_REG_STATUS     0xF3
+#define BME280_REG_CTRL_MEAS  0xF4
+#define BME280_REG_CONFIG     0xF5
+#define BME280_REG_DATA       0xF7  // press, temp, hum burst
+
+#define BME280_CHIP_ID        0x60
+#define BME280_RESET_COMMAND  0xB6
+#define BME280_CALIB_TP_LEN   26
+#define BME280_CALIB_H_LEN    7
+#define BME280_BURST_LEN      8
+
+/**
+ * @brief Factory trim values read from the sensor's NVM
+ */
+struct BME280Calibration {
+    uint16_t dig_T1;
+    int16_t dig_T2;
+    int16_t dig_T3;
+    uint16_t dig_P1;
+    int16_t dig_P2;
+    int16_t dig_P3;
+    int16_t dig_P4;
+    int16_t dig_P5;
+    int16_t dig_P6;
+    int16_t dig_P7;
+    int16_t dig_P8;
+    int16_t dig_P9;
+    uint8_t dig_H1;
+    int16_t dig_H2;
+    uint8_t dig_H3;
+    int16_t dig_H4;
+    int16_t dig_H5;
+    int8_t dig_H6;
+};
+
+/**
+ * @brief Uncompensated ADC values from one data burst
+ */
+struct BME280RawData {
+    int32_t adcT;
+    int32_t adcP;
+    int32_t adcH;
+};
+
+/**
+ * @brief Compensated values in the datasheet's fixed-point formats
+ */
+struct BME280Sample {
+    int32_t temperature;  // 0.01 °C
+    uint32_t pressure;    // Pa in Q24.8 (divide by 256)
+    uint32_t humidity;    // %RH in Q22.10 (divide by 1024)
+};
+
+/**
+ * @brief Register-level BME280 driver on top of the I2C transaction engine
+ *
+ * All measurement data is fetched with a single 8-byte burst, which can be
+ * issued synchronously or queued on the engine alongside transactions for
+ * other devices. Compensation uses the integer formulas from the Bosch
+ * datasheet so results match the reference implementation bit for bit.
+ */
+class BME280Driver {
+public:
+    enum sensor_mode {
+        MODE_SLEEP = 0x00,
+        MODE_FORCED = 0x01,
+        MODE_NORMAL = 0x03
+    };
+
+    enum sensor_sampling {
+        SAMPLING_NONE = 0x00,
+        SAMPLING_X1 = 0x01,
+        SAMPLING_X2 = 0x02,
+        SAMPLING_X4 = 0x03,
+        SAMPLING_X8 = 0x04,
+        SAMPLING_X16 = 0x05
+    };
+
+    enum sensor_filter {
+        FILTER_OFF = 0x00,
+        FILTER_X2 = 0x01,
+        FILTER_X4 = 0x02,
+        FILTER_X8 = 0x03,
+        FILTER_X16 = 0x04
+    };
+
+    enum standby_duration {
+        STANDBY_MS_0_5 = 0x00,
+        STANDBY_MS_62_5 = 0x01,
+        STANDBY_MS_125 = 0x02,
+        STANDBY_MS_250 = 0x03,
+        STANDBY_MS_500 = 0x04,
+        STANDBY_MS_1000 = 0x05,
+        STANDBY_MS_10 = 0x06,
+        STANDBY_MS_20 = 0x07
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param engine Transaction engine the sensor is attached to
+     */
+    explicit BME280Driver(I2CEngine& engine);
+
+    /**
+     * @brief Detect the sensor, soft-reset it and load its calibration
+     *
+     * @param address 7-bit I2C address (0x76 or 0x77)
+     * @return true if a BME280 answered with the expected chip ID
+     */
+    bool begin(uint8_t address);
+
+    /**
+     * @brief Attach to a known sensor without touching the bus
+     *
+     * Used after deep sleep with an address and calibration cached in RTC
+     * memory, skipping detection, soft reset and the calibration read.
+     *
+     * @param address 7-bit I2C address
+     * @param calibration Previously loaded trim values
+     */
+    void restore(uint8_t address, const BME280Calibration& calibration);
+
+    /**
+     * @brief Read the status register
+     *
+     * @param status Receives the register (bit 3 = measuring, bit 0 = NVM copy)
+     * @return true if the bus transaction succeeded
+     */
+    bool readStatus(uint8_t& status);
+
+    /**
+     * @brief Configure mode, oversampling, IIR filter and standby time
+     *
+     * @return true if all configuration registers were written
+     */
+    bool setSampling(sensor_mode mode, sensor_sampling tempSampling,
+                     sensor_sampling pressSampling, sensor_sampling humSampling,
+                     sensor_filter filter, standby_duration standby);
+
+    /**
+     * @brief Whether the sensor still runs with these settings
+     *
+     * One burst read of ctrl_hum through config, e.g. after a deep sleep the
+     * sensor may have spent powered. A forced profile matches any mode but
+     * normal, since the sensor drops back to sleep after each conversion.
+     * On a match startForced() uses these oversampling settings.
+     *
+     * @return true if the bus transaction succeeded and every setting matched
+     */
+    bool hasSampling(sensor_mode mode, sensor_sampling tempSampling,
+                     sensor_sampling pressSampling, sensor_sampling humSampling,
+                     sensor_filter filter, standby_duration standby);
+
+    /**
+     * @brief Start one forced-mode measurement
+     *
+     * Uses the oversampling last passed to setSampling(); the data
+     * registers keep the previous result until the conversion is done.
+     *
+     * @return true if ctrl_meas was written
+     */
+    bool startForced();
+
+    /**
+     * @brief Queue the forced-mode start on the engine, e.g. behind a data burst
+     *
+     * @return true if the write was queued
+     */
+    bool queueStartForced(I2CCallback callback, void* context);
+
+    /**
+     * @brief Read one data burst synchronously
+     *
+     * @param raw Receives the uncompensated ADC values
+     * @return true if the bus transaction succeeded
+     */
+    bool readRaw(BME280RawData& raw);
+
+    /**
+     * @brief Queue a data burst read on the engine
+     *
+     * @param burst Destination of BME280_BURST_LEN bytes, must outlive the callback
+     * @param callback Completion callback
+     * @param context Passed through to the callback
+     * @return true if the read was queued
+     */
+    bool queueRawRead(uint8_t* burst, I2CCallback callback, void* context);
+
+    /**
+     * @brief Convert an 8-byte data burst into ADC values
+     */
+    static BME280RawData decodeRaw(const uint8_t* burst);
+
+    /**
+     * @brief Apply the datasheet compensation formulas
+     *
+     * @param raw Uncompensated ADC values
+     * @param sample Receives the compensated values
+     * @return false if a channel was skipped or the data is invalid
+     */
+    bool compensate(const BME280RawData& raw, BME280Sample& sample) const;
+
+    /**
+     * @brief Decode calibration registers into trim values
+     *
+     * @param tp BME280_CALIB_TP_LEN bytes starting at 0x88
+     * @param h BME280_CALIB_H_LEN bytes starting at 0xE1
+     * @param calib Receives the decoded values
+     */
+    static void parseCalibration(const uint8_t* tp, const uint8_t* h, BME280Calibration& calib);
+
+    /**
+     * @brief Get the I2C address the driver talks to
+     */
+    uint8_t getAddress() const { return address; }
+
+    /**
+     * @brief Get the loaded calibration
+     */
+    const BME280Calibration& getCalibration() const { return calib; }
+
+private:
+    I2CEngine& engine;
+    uint8_t address;
+    BME280Calibration calib;
+    uint8_t ctrlMeas;  // Oversampling bits of the last setSampling(), mode cleared
+
+    bool readCalibration();
+};
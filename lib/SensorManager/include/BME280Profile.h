@@ -0,0 +1,169 @@
+#pragma once
+
+#include <stdint.h>
+#include "BME280Driver.h"
+
+// Measurement, noise and current model for BME280 settings, all constexpr so
+// a profile's cost is known at compile time. Timing follows datasheet
+// appendix B (9.1). Pressure noise is the datasheet's unfiltered RMS noise
+// per oversampling setting times the IIR filter's noise reduction
+// 1/sqrt(2c - 1), which reproduces the 0.2 Pa quoted for x16 with
+// coefficient 16; humidity noise scales 0.07 %RH at x1 by 1/sqrt(n).
+// Currents are the typical per-channel values of table 1.
+
+/**
+ * @brief Oversampling, filter and mode settings written by setSampling()
+ */
+struct BME280Profile {
+    BME280Driver::sensor_mode mode;
+    BME280Driver::sensor_sampling temperature;
+    BME280Driver::sensor_sampling pressure;
+    BME280Driver::sensor_sampling humidity;
+    BME280Driver::sensor_filter filter;
+    BME280Driver::standby_duration standby;  // Normal mode only
+};
+
+/**
+ * @brief Predefined profiles (datasheet 3.5 use cases)
+ */
+enum SensorProfile : uint8_t {
+    SENSOR_PROFILE_LOW_POWER = 0,   // Weather monitoring: forced, x1/x1/x1, no filter
+    SENSOR_PROFILE_BALANCED,        // Forced, x2/x4/x1, filter 4
+    SENSOR_PROFILE_HIGH_PRECISION,  // Normal, x2/x16/x1, filter 16, 500 ms standby
+    SENSOR_PROFILE_COUNT
+};
+
+constexpr BME280Profile BME280_PROFILE_LOW_POWER = {
+    BME280Driver::MODE_FORCED, BME280Driver::SAMPLING_X1, BME280Driver::SAMPLING_X1,
+    BME280Driver::SAMPLING_X1, BME280Driver::FILTER_OFF, BME280Driver::STANDBY_MS_1000
+};
+
+constexpr BME280Profile BME280_PROFILE_BALANCED = {
+    BME280Driver::MODE_FORCED, BME280Driver::SAMPLING_X2, BME280Driver::SAMPLING_X4,
+    BME280Driver::SAMPLING_X1, BME280Driver::FILTER_X4, BME280Driver::STANDBY_MS_1000
+};
+
+constexpr BME280Profile BME280_PROFILE_HIGH_PRECISION = {
+    BME280Driver::MODE_NORMAL, BME280Driver::SAMPLING_X2, BME280Driver::SAMPLING_X16,
+    BME280Driver::SAMPLING_X1, BME280Driver::FILTER_X16, BME280Driver::STANDBY_MS_500
+};
+
+constexpr BME280Profile bme280Profile(SensorProfile profile) {
+    return profile == SENSOR_PROFILE_LOW_POWER ? BME280_PROFILE_LOW_POWER :
+           profile == SENSOR_PROFILE_BALANCED ? BME280_PROFILE_BALANCED :
+           BME280_PROFILE_HIGH_PRECISION;
+}
+
+/**
+ * @brief Number of conversions averaged for an oversampling setting (0 if skipped)
+ */
+constexpr uint32_t bme280Oversampling(BME280Driver::sensor_sampling sampling) {
+    return sampling == BME280Driver::SAMPLING_NONE ? 0 : 1u << (sampling - 1);
+}
+
+/**
+ * @brief Filter coefficient c of the IIR stage (1 = off)
+ */
+constexpr uint32_t bme280FilterCoefficient(BME280Driver::sensor_filter filter) {
+    return 1u << filter;
+}
+
+/**
+ * @brief Typical duration of one measurement in microseconds
+ */
+constexpr uint32_t bme280MeasurementTypUs(const BME280Profile& profile) {
+    return 1000 + 2000 * bme280Oversampling(profile.temperature) +
+           (profile.pressure ? 2000 * bme280Oversampling(profile.pressure) + 500 : 0) +
+           (profile.humidity ? 2000 * bme280Oversampling(profile.humidity) + 500 : 0);
+}
+
+/**
+ * @brief Maximum duration of one measurement in microseconds; forced reads wait this long
+ */
+constexpr uint32_t bme280MeasurementMaxUs(const BME280Profile& profile) {
+    return 1250 + 2300 * bme280Oversampling(profile.temperature) +
+           (profile.pressure ? 2300 * bme280Oversampling(profile.pressure) + 575 : 0) +
+           (profile.humidity ? 2300 * bme280Oversampling(profile.humidity) + 575 : 0);
+}
+
+/**
+ * @brief Normal-mode standby time in microseconds
+ */
+constexpr uint32_t bme280StandbyUs(BME280Driver::standby_duration standby) {
+    return standby == BME280Driver::STANDBY_MS_0_5 ? 500 :
+           standby == BME280Driver::STANDBY_MS_10 ? 10000 :
+           standby == BME280Driver::STANDBY_MS_20 ? 20000 :
+           62500u << (standby - BME280Driver::STANDBY_MS_62_5);
+}
+
+/**
+ * @brief Time between normal-mode conversions (typical), i.e. 1 / ODR
+ */
+constexpr uint32_t bme280NormalPeriodUs(const BME280Profile& profile) {
+    return bme280MeasurementTypUs(profile) + bme280StandbyUs(profile.standby);
+}
+
+// Unfiltered pressure RMS noise in Pa for x1..x16, 1/sqrt(n) for the same
+// oversampling and 1/sqrt(2c - 1) for filter coefficients 1..16
+constexpr float BME280_PRESSURE_NOISE_PA[] = { 3.3F, 2.6F, 2.1F, 1.6F, 1.3F };
+constexpr float BME280_OVERSAMPLING_NOISE[] = { 1.0F, 0.7071F, 0.5F, 0.3536F, 0.25F };
+constexpr float BME280_FILTER_NOISE[] = { 1.0F, 0.5774F, 0.3780F, 0.2582F, 0.1796F };
+
+/**
+ * @brief Expected RMS pressure noise in Pa (0 if pressure is skipped)
+ */
+constexpr float bme280PressureNoisePa(const BME280Profile& profile) {
+    return profile.pressure == BME280Driver::SAMPLING_NONE ? 0.0F :
+           BME280_PRESSURE_NOISE_PA[profile.pressure - 1] * BME280_FILTER_NOISE[profile.filter];
+}
+
+/**
+ * @brief Expected RMS humidity noise in %RH (the IIR filter does not act on humidity)
+ */
+constexpr float bme280HumidityNoise(const BME280Profile& profile) {
+    return profile.humidity == BME280Driver::SAMPLING_NONE ? 0.0F :
+           0.07F * BME280_OVERSAMPLING_NOISE[profile.humidity - 1];
+}
+
+/**
+ * @brief Charge drawn by one measurement in µA·µs (350/714/340 µA while converting T/P/H)
+ */
+constexpr float bme280MeasurementCharge(const BME280Profile& profile) {
+    return 350.0F * (1000 + 2000 * bme280Oversampling(profile.temperature)) +
+           (profile.pressure ? 714.0F * (2000 * bme280Oversampling(profile.pressure) + 500) : 0.0F) +
+           (profile.humidity ? 340.0F * (2000 * bme280Oversampling(profile.humidity) + 500) : 0.0F);
+}
+
+/**
+ * @brief Average supply current in µA
+ *
+ * @param profile Settings
+ * @param periodUs Time between readings in forced mode (ignored in normal mode,
+ *                 where the standby time sets the rate)
+ */
+constexpr float bme280AverageCurrentUa(const BME280Profile& profile, uint32_t periodUs) {
+    return profile.mode == BME280Driver::MODE_NORMAL ?
+           (bme280MeasurementCharge(profile) +
+            0.2F * bme280StandbyUs(profile.standby)) / bme280NormalPeriodUs(profile) :
+           (bme280MeasurementCharge(profile) +
+            0.1F * (periodUs - bme280MeasurementTypUs(profile))) / periodUs;
+}
+
+/**
+ * @brief Short name of a predefined profile for logs
+ */
+inline const char* sensorProfileName(SensorProfile profile) {
+    switch (profile) {
+        case SENSOR_PROFILE_LOW_POWER:      return "low power";
+        case SENSOR_PROFILE_BALANCED:       return "balanced";
+        case SENSOR_PROFILE_HIGH_PRECISION: return "high precision";
+        default:                            return "custom";
+    }
+}
+
+// The model is checked against the datasheet at compile time
+static_assert(bme280MeasurementMaxUs(BME280_PROFILE_HIGH_PRECISION) == 46100,
+              "x2/x16/x1 takes at most 46.1 ms (datasheet 9.1)");
+static_assert(bme280MeasurementTypUs(BME280_PROFILE_LOW_POWER) == 8000,
+              "x1/x1/x1 takes 8 ms typically (datasheet 9.2)");
+static_assert(bme280StandbyUs(BME280Driver::STANDBY_MS_1000) == 1000000, "standby table");
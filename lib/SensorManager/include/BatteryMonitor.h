@@ -0,0 +1,200 @@
+#pragma once
+
+#include <stdint.h>
+
+// Heltec WiFi LoRa 32 V3: VBAT through a 390k/100k divider to GPIO1, enabled by ADC_Ctrl on GPIO37
+#ifndef VBAT_ADC_PIN
+#define VBAT_ADC_PIN 1
+#endif
+
+#ifndef VBAT_ADC_CTRL_PIN
+#define VBAT_ADC_CTRL_PIN 37
+#endif
+
+#ifndef BATTERY_DIVIDER_RATIO
+#define BATTERY_DIVIDER_RATIO 4.9f
+#endif
+
+// Per-board gain correction on top of the eFuse ADC calibration (measured / reported)
+#ifndef BATTERY_CALIBRATION_FACTOR
+#define BATTERY_CALIBRATION_FACTOR 1.0f
+#endif
+
+// Raw conversions summed into one measurement
+#ifndef BATTERY_OVERSAMPLING
+#define BATTERY_OVERSAMPLING 16
+#endif
+
+// Measurements in the moving average of the resting voltage
+#ifndef BATTERY_AVERAGE_WINDOW
+#define BATTERY_AVERAGE_WINDOW 8
+#endif
+
+// Time for the divider to settle after ADC_Ctrl switches it on
+#ifndef BATTERY_SETTLE_MS
+#define BATTERY_SETTLE_MS 10
+#endif
+
+// From beginLoadSample() to the measurement: the LoRaWAN stack builds the
+// frame first, and the shortest uplinks (SF7) are on air for about 60 ms
+#ifndef BATTERY_LOAD_SAMPLE_DELAY_MS
+#define BATTERY_LOAD_SAMPLE_DELAY_MS 25
+#endif
+
+// Below this the pin is floating: no cell connected, running from USB
+#ifndef BATTERY_PRESENT_MIN_MV
+#define BATTERY_PRESENT_MIN_MV 2500
+#endif
+
+#ifndef BATTERY_LOW_SOC
+#define BATTERY_LOW_SOC 20
+#endif
+
+#ifndef BATTERY_CRITICAL_SOC
+#define BATTERY_CRITICAL_SOC 5
+#endif
+
+// A loaded voltage below this risks a brownout on the next transmission
+#ifndef BATTERY_CRITICAL_LOADED_MV
+#define BATTERY_CRITICAL_LOADED_MV 3300
+#endif
+
+// Reported state of charge when no battery is connected
+#define BATTERY_SOC_UNKNOWN 0xFF
+
+/**
+ * @brief Battery voltage and state-of-charge monitor
+ *
+ * Each measurement switches the divider on, sums BATTERY_OVERSAMPLING raw
+ * ADC conversions, converts the mean once with the eFuse calibration and
+ * switches the divider off again. Resting measurements feed a fixed-size
+ * moving average used for the state of charge; a separate measurement taken
+ * by a timer while a transmission is on air captures the voltage sag under
+ * load. All state lives in the object, nothing is allocated.
+ */
+class BatteryMonitor {
+public:
+    BatteryMonitor();
+
+    /**
+     * @brief Configure the ADC channel and the divider control pin
+     *
+     * @param adcPin Pin connected to the divider output
+     * @param ctrlPin Pin that enables the divider (-1 if always on)
+     * @param ctrlActiveHigh true if ctrlPin enables the divider when HIGH (V3.2)
+     * @return true if the pin has an ADC1 channel
+     */
+    bool begin(int adcPin = VBAT_ADC_PIN, int ctrlPin = VBAT_ADC_CTRL_PIN, bool ctrlActiveHigh = true);
+
+    /**
+     * @brief Take a resting measurement and add it to the average
+     *
+     * @return true if a battery is connected
+     */
+    bool sample();
+
+    /**
+     * @brief Measure the cell while the next transmission is on air
+     *
+     * Call right before a blocking send. The divider is switched on now so
+     * it has settled, and a one-shot esp_timer measures
+     * BATTERY_LOAD_SAMPLE_DELAY_MS later, while the radio transmits.
+     *
+     * @return true if the timer was armed
+     */
+    bool beginLoadSample();
+
+    /**
+     * @brief Finish the measurement started by beginLoadSample()
+     *
+     * The value is kept apart from the resting average and used to estimate
+     * the sag under load. Call after the send returned; a LoRaWAN send
+     * blocks through its receive windows, long after the timer fired.
+     *
+     * @param transmitted false discards the value, e.g. when the send failed
+     * @return true if a battery is connected and a value was kept
+     */
+    bool endLoadSample(bool transmitted = true);
+
+    /**
+     * @brief Record a measurement taken during a transmission (used by the load timer)
+     */
+    void addLoadSample(uint16_t millivolts) { pendingLoadMv = millivolts; }
+
+    /**
+     * @brief Add a resting measurement in millivolts (also used by sample())
+     */
+    void addSample(uint16_t millivolts);
+
+    /**
+     * @brief Averaged resting voltage in millivolts, 0 before the first sample
+     */
+    uint16_t getMillivolts() const;
+
+    /**
+     * @brief Averaged resting voltage in volts
+     */
+    float getVoltage() const { return getMillivolts() / 1000.0f; }
+
+    /**
+     * @brief Voltage measured during the last transmission, 0 if none yet
+     */
+    uint16_t getLoadedMillivolts() const { return loadedMv; }
+
+    /**
+     * @brief Drop between the resting average and the last loaded measurement
+     */
+    uint16_t getSagMillivolts() const;
+
+    /**
+     * @brief State of charge from the resting voltage
+     *
+     * @return uint8_t 0-100 %, or BATTERY_SOC_UNKNOWN without a battery
+     */
+    uint8_t getStateOfCharge() const;
+
+    /**
+     * @brief Whether a battery is connected
+     */
+    bool isPresent() const { return count > 0 && getMillivolts() >= BATTERY_PRESENT_MIN_MV; }
+
+    /**
+     * @brief Whether the battery is below BATTERY_LOW_SOC
+     */
+    bool isLow() const;
+
+    /**
+     * @brief Whether the battery is nearly empty or sags into the brownout region under load
+     */
+    bool isCritical() const;
+
+    /**
+     * @brief Map a resting single-cell LiPo voltage to a state of charge
+     *
+     * @param millivolts Resting cell voltage
+     * @return uint8_t 0-100 %
+     */
+    static uint8_t estimateStateOfCharge(uint16_t millivolts);
+
+private:
+    int adcPin;
+    int ctrlPin;
+    bool ctrlActiveHigh;
+    int8_t channel;
+
+    // Moving average of resting measurements
+    uint16_t window[BATTERY_AVERAGE_WINDOW];
+    uint32_t sum;
+    uint8_t count;
+    uint8_t next;
+
+    uint16_t loadedMv;
+    volatile uint16_t pendingLoadMv;  // Written by the load timer
+    void* loadTimer;                  // esp_timer_handle_t
+
+    uint16_t measure();
+    uint16_t readMillivolts();
+    void setDivider(bool on);
+    void stopLoadTimer();
+    static void loadTimerCallback(void* arg);
+};
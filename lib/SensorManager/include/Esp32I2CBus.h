@@ -0,0 +1,45 @@
+#pragma once
+
+#include "I2CBus.h"
+
+#if defined(ESP_PLATFORM)
+
+#include <driver/i2c.h>
+
+// Command-link storage for the largest transaction we issue
+// (start, address, register, repeated start, address, read, stop)
+#ifndef ESP32_I2C_CMD_BUFFER_SIZE
+#define ESP32_I2C_CMD_BUFFER_SIZE I2C_LINK_RECOMMENDED_SIZE(8)
+#endif
+
+/**
+ * @brief I2C bus on an ESP32 hardware I2C controller
+ *
+ * Each transaction is built as an ESP-IDF command link and handed to the
+ * controller's command queue. The calling task then blocks on the driver's
+ * completion interrupt instead of spinning on the bus. The command link
+ * lives in a static buffer, so no heap allocation happens per transaction.
+ */
+class Esp32I2CBus : public I2CBus {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param port Hardware controller to use (I2C_NUM_0 or I2C_NUM_1)
+     */
+    explicit Esp32I2CBus(i2c_port_t port = I2C_NUM_0);
+
+    bool begin(int sda, int scl, uint32_t frequency) override;
+    void end() override;
+    I2CStatus transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                       uint8_t* rx, size_t rxLen, uint32_t timeoutMs) override;
+    uint32_t getFrequency() const override { return frequency; }
+
+private:
+    i2c_port_t port;
+    bool installed;
+    uint32_t frequency;
+    uint8_t cmdBuffer[ESP32_I2C_CMD_BUFFER_SIZE];
+};
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "FakeI2CBus.h"
+#include "BME280Driver.h"
+
+// Rows a replayed trace can hold
+#ifndef FAKE_BME280_TRACE_MAX
+#define FAKE_BME280_TRACE_MAX 1024
+#endif
+
+// Power-on and soft reset: NVM copy time (datasheet t_startup)
+#define FAKE_BME280_STARTUP_US 2000
+
+/**
+ * @brief One row of a recorded trace: raw ADC values at a point in time
+ */
+struct FakeBME280Row {
+    uint32_t timeMs;  // From the start of the replay
+    BME280RawData raw;
+};
+
+/**
+ * @brief Register-level BME280 emulator for FakeI2CBus
+ *
+ * Models what the driver can observe: chip ID, trim values (the datasheet
+ * example calibration unless replaced), soft reset with its NVM copy time,
+ * sleep/forced/normal mode and the maximum conversion time for the
+ * configured oversampling (datasheet 9.1), all on the FakeI2CBus clock.
+ * Skipped channels and data read before the first conversion return the
+ * reset values 0x80000/0x8000.
+ *
+ * The data registers replay a trace of raw ADC values, either set directly
+ * or loaded from CSV text with one "time_ms,adc_T,adc_P,adc_H" row per line
+ * (a header and '#' comments are skipped). Each conversion latches the row
+ * for its completion time; after the last row the trace holds. The IIR
+ * filter is not modelled, so traces should be recorded at the data registers.
+ *
+ * Faults: NACKs for the next transactions, data bursts reading all zeros,
+ * and power loss (NACKs everything; power-up resets the registers).
+ */
+class FakeBME280 : public FakeRegisterDevice {
+public:
+    FakeBME280() :
+        trace(), rows(0), origin(FakeI2CBus::now()), powered(true), nackNext(0), zeroNext(0),
+        conversions(0), resets(0), powerUps(0) {
+        // Datasheet example trim values
+        static const uint8_t calibTP[BME280_CALIB_TP_LEN] = {
+            0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC, 0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27,
+            0x0B, 0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6, 0x70, 0x17, 0x00, 0x4B
+        };
+        static const uint8_t calibH[BME280_CALIB_H_LEN] = { 0x6A, 0x01, 0x00, 0x13, 0x2A, 0x03, 0x1E };
+        setCalibration(calibTP, calibH);
+        powerOn();
+    }
+
+    /**
+     * @brief Replace the trim values held in NVM
+     */
+    void setCalibration(const uint8_t* tp, const uint8_t* h) {
+        memcpy(calibTP, tp, sizeof(calibTP));
+        memcpy(calibH, h, sizeof(calibH));
+        memcpy(&regs[BME280_REG_CALIB_TP], calibTP, sizeof(calibTP));
+        memcpy(&regs[BME280_REG_CALIB_H], calibH, sizeof(calibH));
+    }
+
+    /**
+     * @brief Replay a constant value from now on
+     */
+    void setRaw(const BME280RawData& raw) {
+        trace[0].timeMs = 0;
+        trace[0].raw = raw;
+        rows = 1;
+        origin = FakeI2CBus::now();
+    }
+
+    /**
+     * @brief Replay a trace from CSV text, starting now
+     *
+     * @return size_t Rows loaded, 0 if the text holds none or a row is malformed
+     */
+    size_t loadTrace(const char* csv) {
+        rows = 0;
+        origin = FakeI2CBus::now();
+        while (*csv) {
+            const char* end = strchr(csv, '\n');
+            size_t len = end ? (size_t)(end - csv) : strlen(csv);
+            if (!parseRow(csv, len)) {
+                rows = 0;
+                return 0;
+            }
+            csv += end ? len + 1 : len;
+        }
+        return rows;
+    }
+
+    /**
+     * @brief Replay a trace from a CSV file, starting now
+     *
+     * @return size_t Rows loaded, 0 if the file is missing or malformed
+     */
+    size_t loadTraceFile(const char* path) {
+        FILE* file = fopen(path, "r");
+        if (!file) return 0;
+        rows = 0;
+        origin = FakeI2CBus::now();
+        char line[96];
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), file)) {
+            ok = parseRow(line, strcspn(line, "\r\n"));
+        }
+        fclose(file);
+        if (!ok) rows = 0;
+        return rows;
+    }
+
+    size_t getTraceLength() const { return rows; }
+    const FakeBME280Row& getTraceRow(size_t index) const { return trace[index]; }
+
+    /**
+     * @brief Trace row a conversion finishing at the given replay time latches
+     */
+    const FakeBME280Row* rowAt(uint32_t timeMs) const {
+        if (rows == 0) return nullptr;
+        size_t i = 0;
+        while (i + 1 < rows && trace[i + 1].timeMs <= timeMs) i++;
+        return &trace[i];
+    }
+
+    /**
+     * @brief NACK the next transactions addressed to the sensor
+     */
+    void injectNack(uint32_t count) { nackNext = count; }
+
+    /**
+     * @brief Return all-zero data for the next data bursts
+     */
+    void injectZeros(uint32_t count) { zeroNext = count; }
+
+    /**
+     * @brief Switch the supply (VEXT); power-up resets all registers
+     */
+    void setPowered(bool on) {
+        if (on && !powered) powerOn();
+        powered = on;
+    }
+
+    bool isPowered() const { return powered; }
+    uint8_t getMode() const { return regs[BME280_REG_CTRL_MEAS] & 0x03; }
+    uint32_t getConversionCount() const { return conversions; }
+    uint32_t getResetCount() const { return resets; }
+    uint32_t getPowerUpCount() const { return powerUps; }
+
+    /**
+     * @brief Maximum measurement time for a ctrl_hum/ctrl_meas setting (datasheet 9.1)
+     */
+    static uint32_t measurementTimeUs(uint8_t ctrlHum, uint8_t ctrlMeas) {
+        uint32_t t = oversampling(ctrlMeas >> 5);
+        uint32_t p = oversampling(ctrlMeas >> 2);
+        uint32_t h = oversampling(ctrlHum);
+        return 1250 + 2300 * t + (p ? 2300 * p + 575 : 0) + (h ? 2300 * h + 575 : 0);
+    }
+
+    bool acknowledge() override {
+        if (!powered) return false;
+        if (nackNext > 0) {
+            nackNext--;
+            return false;
+        }
+        return true;
+    }
+
+    I2CStatus onRead(uint8_t* data, size_t len) override {
+        if (pointer == BME280_REG_DATA) {
+            latch();
+            if (zeroNext > 0) {
+                zeroNext--;
+                memset(data, 0, len);
+                pointer += len;
+                return I2C_OK;
+            }
+        }
+        return FakeRegisterDevice::onRead(data, len);
+    }
+
+protected:
+    void writeRegister(uint8_t reg, uint8_t value) override {
+        switch (reg) {
+        case BME280_REG_RESET:
+            if (value == BME280_RESET_COMMAND) {
+                resets++;
+                reset();
+            }
+            break;
+        case BME280_REG_CTRL_HUM:
+        case BME280_REG_CONFIG:
+            regs[reg] = value;
+            break;
+        case BME280_REG_CTRL_MEAS:
+            // ctrl_hum is applied here, as on the real part
+            regs[reg] = value;
+            activeHum = regs[BME280_REG_CTRL_HUM] & 0x07;
+            if ((value & 0x03) != BME280Driver::MODE_SLEEP) {
+                conversionDone = FakeI2CBus::now() + measurementTimeUs(activeHum, value);
+                converting = true;
+            } else {
+                converting = false;
+            }
+            break;
+        default:
+            break;  // Read-only
+        }
+    }
+
+    uint8_t readRegister(uint8_t reg) override {
+        if (reg == BME280_REG_STATUS) {
+            uint32_t now = FakeI2CBus::now();
+            bool measuring = converting && (int32_t)(now - conversionDone) < 0;
+            bool updating = (int32_t)(now - readyAt) < 0;
+            return (measuring ? 0x08 : 0) | (updating ? 0x01 : 0);
+        }
+        return regs[reg];
+    }
+
+private:
+    FakeBME280Row trace[FAKE_BME280_TRACE_MAX];
+    size_t rows;
+    uint32_t origin;
+    uint8_t calibTP[BME280_CALIB_TP_LEN];
+    uint8_t calibH[BME280_CALIB_H_LEN];
+    bool powered;
+    uint32_t nackNext;
+    uint32_t zeroNext;
+    uint32_t conversions;
+    uint32_t resets;
+    uint32_t powerUps;
+    uint32_t readyAt;
+    uint32_t conversionDone;
+    bool converting;
+    uint8_t activeHum;
+
+    static uint32_t oversampling(uint8_t setting) {
+        setting &= 0x07;
+        return setting == 0 ? 0 : (setting >= 5 ? 16 : 1u << (setting - 1));
+    }
+
+    bool parseRow(const char* line, size_t len) {
+        while (len > 0 && (*line == ' ' || *line == '\t')) {
+            line++;
+            len--;
+        }
+        if (len == 0 || *line == '#' || (*line < '0' || *line > '9')) {
+            return true;  // Blank, comment or header
+        }
+        if (rows >= FAKE_BME280_TRACE_MAX) return false;
+
+        char buffer[96];
+        if (len >= sizeof(buffer)) return false;
+        memcpy(buffer, line, len);
+        buffer[len] = '\0';
+
+        long values[4];
+        char* cursor = buffer;
+        for (int i = 0; i < 4; i++) {
+            char* next;
+            values[i] = strtol(cursor, &next, 10);
+            if (next == cursor || values[i] < 0) return false;
+            cursor = next;
+            while (*cursor == ' ') cursor++;
+            if (i < 3 && *cursor++ != ',') return false;
+        }
+
+        FakeBME280Row& row = trace[rows++];
+        row.timeMs = (uint32_t)values[0];
+        row.raw.adcT = (int32_t)values[1];
+        row.raw.adcP = (int32_t)values[2];
+        row.raw.adcH = (int32_t)values[3];
+        return true;
+    }
+
+    void powerOn() {
+        powerUps++;
+        reset();
+    }
+
+    // Registers return to their reset values; trim values are reloaded from NVM
+    void reset() {
+        memset(regs, 0, sizeof(regs));
+        regs[BME280_REG_CHIP_ID] = BME280_CHIP_ID;
+        memcpy(&regs[BME280_REG_CALIB_TP], calibTP, sizeof(calibTP));
+        memcpy(&regs[BME280_REG_CALIB_H], calibH, sizeof(calibH));
+        storeData(0x80000, 0x80000, 0x8000);
+        readyAt = FakeI2CBus::now() + FAKE_BME280_STARTUP_US;
+        conversionDone = 0;
+        converting = false;
+        activeHum = 0;
+    }
+
+    void storeData(uint32_t adcT, uint32_t adcP, uint32_t adcH) {
+        uint8_t* data = &regs[BME280_REG_DATA];
+        data[0] = (uint8_t)(adcP >> 12);
+        data[1] = (uint8_t)(adcP >> 4);
+        data[2] = (uint8_t)(adcP << 4);
+        data[3] = (uint8_t)(adcT >> 12);
+        data[4] = (uint8_t)(adcT >> 4);
+        data[5] = (uint8_t)(adcT << 4);
+        data[6] = (uint8_t)(adcH >> 8);
+        data[7] = (uint8_t)adcH;
+    }
+
+    // Bring the data registers up to date at the start of a burst read
+    void latch() {
+        uint32_t now = FakeI2CBus::now();
+        if (converting && (int32_t)(now - conversionDone) >= 0) {
+            uint8_t ctrlMeas = regs[BME280_REG_CTRL_MEAS];
+            const FakeBME280Row* row = rowAt((conversionDone - origin) / 1000);
+            if (row) {
+                storeData((ctrlMeas >> 5) ? (uint32_t)row->raw.adcT : 0x80000,
+                          ((ctrlMeas >> 2) & 0x07) ? (uint32_t)row->raw.adcP : 0x80000,
+                          activeHum ? (uint32_t)row->raw.adcH : 0x8000);
+            }
+            conversions++;
+
+            if ((ctrlMeas & 0x03) == BME280Driver::MODE_NORMAL) {
+                // Normal mode keeps converting; the registers hold the latest result
+                conversionDone = now;
+            } else {
+                regs[BME280_REG_CTRL_MEAS] = ctrlMeas & ~0x03;  // Forced: back to sleep
+                converting = false;
+            }
+        }
+    }
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string.h>
+#include "I2CBus.h"
+
+/**
+ * @brief A device attached to FakeI2CBus
+ */
+class FakeI2CDevice {
+public:
+    virtual ~FakeI2CDevice() {}
+
+    /**
+     * @brief Handle the write phase of a transaction
+     */
+    virtual I2CStatus onWrite(const uint8_t* data, size_t len) = 0;
+
+    /**
+     * @brief Handle the read phase of a transaction
+     */
+    virtual I2CStatus onRead(uint8_t* data, size_t len) = 0;
+
+    /**
+     * @brief Whether the device acknowledges its address for this transaction
+     */
+    virtual bool acknowledge() { return true; }
+};
+
+/**
+ * @brief Plain register file: first written byte selects the register,
+ * further bytes are written from there, reads auto-increment
+ */
+class FakeRegisterDevice : public FakeI2CDevice {
+public:
+    uint8_t regs[256];
+    uint8_t pointer;
+
+    FakeRegisterDevice() : pointer(0) {
+        memset(regs, 0, sizeof(regs));
+    }
+
+    I2CStatus onWrite(const uint8_t* data, size_t len) override {
+        if (len == 0) return I2C_OK;
+        pointer = data[0];
+        for (size_t i = 1; i < len; i++) {
+            writeRegister(pointer++, data[i]);
+        }
+        return I2C_OK;
+    }
+
+    I2CStatus onRead(uint8_t* data, size_t len) override {
+        for (size_t i = 0; i < len; i++) {
+            data[i] = readRegister(pointer++);
+        }
+        return I2C_OK;
+    }
+
+protected:
+    virtual void writeRegister(uint8_t reg, uint8_t value) { regs[reg] = value; }
+    virtual uint8_t readRegister(uint8_t reg) { return regs[reg]; }
+};
+
+/**
+ * @brief In-memory I2C bus for host tests
+ *
+ * Transactions are dispatched to attached FakeI2CDevice instances and a
+ * virtual clock advances by the time each transaction would occupy a real
+ * bus, so latency and occupancy figures are deterministic.
+ *
+ * A stuck bus (a slave holding SDA low after an interrupted transfer) makes
+ * every transaction run into its timeout until nine SCL clocks have been
+ * bit-banged; report those with clockScl().
+ */
+class FakeI2CBus : public I2CBus {
+public:
+    FakeI2CBus() :
+        frequency(100000), active(false), failNext(0), failStatus(I2C_OK), transfers(0),
+        stuck(false), sclLevel(1), stuckClocks(0) {
+        memset(devices, 0, sizeof(devices));
+    }
+
+    bool begin(int sda, int scl, uint32_t frequency) override {
+        (void)sda;
+        (void)scl;
+        this->frequency = frequency;
+        active = true;
+        return true;
+    }
+
+    void end() override {
+        active = false;
+    }
+
+    uint32_t getFrequency() const override { return frequency; }
+
+    I2CStatus transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                       uint8_t* rx, size_t rxLen, uint32_t timeoutMs) override {
+        transfers++;
+
+        // Start + address byte for each phase, 9 clocks per byte, plus stop
+        size_t frames = 1 + txLen + (rxLen > 0 ? 1 + rxLen : 0);
+        advance((uint32_t)((frames * 9 + 2) * 1000000ULL / frequency));
+
+        if (!active) return I2C_ERR_OTHER;
+        if (stuck) {
+            // The controller waits for SDA to be released until it gives up
+            advance(timeoutMs * 1000);
+            return I2C_ERR_TIMEOUT;
+        }
+        if (failNext > 0) {
+            failNext--;
+            return failStatus;
+        }
+
+        FakeI2CDevice* device = address < 128 ? devices[address] : nullptr;
+        if (!device || !device->acknowledge()) return I2C_ERR_NACK_ADDR;
+
+        if (txLen > 0) {
+            I2CStatus status = device->onWrite(tx, txLen);
+            if (status != I2C_OK) return status;
+        }
+        if (rxLen > 0) {
+            return device->onRead(rx, rxLen);
+        }
+        return I2C_OK;
+    }
+
+    /**
+     * @brief Attach a device at an address (null detaches)
+     */
+    void attach(uint8_t address, FakeI2CDevice* device) {
+        if (address < 128) devices[address] = device;
+    }
+
+    /**
+     * @brief Make the next transactions fail with the given status
+     */
+    void injectFailure(I2CStatus status, uint32_t count = 1) {
+        failStatus = status;
+        failNext = count;
+    }
+
+    /**
+     * @brief Leave a slave holding SDA low, as after a reset mid-transfer
+     */
+    void injectStuckBus() {
+        stuck = true;
+        stuckClocks = 0;
+    }
+
+    /**
+     * @brief Report a bit-banged SCL level; nine clocks release a stuck slave
+     */
+    void clockScl(uint8_t level) {
+        if (stuck && level && !sclLevel && ++stuckClocks >= 9) {
+            stuck = false;
+        }
+        sclLevel = level;
+    }
+
+    bool isStuck() const { return stuck; }
+
+    /**
+     * @brief Number of transactions seen by the bus
+     */
+    uint32_t getTransferCount() const { return transfers; }
+
+    /**
+     * @brief Virtual time in microseconds, usable as the I2CEngine clock
+     */
+    static uint32_t now() { return virtualTime(); }
+
+    /**
+     * @brief Advance the virtual clock
+     */
+    static void advance(uint32_t us) { virtualTime() += us; }
+
+private:
+    FakeI2CDevice* devices[128];
+    uint32_t frequency;
+    bool active;
+    uint32_t failNext;
+    I2CStatus failStatus;
+    uint32_t transfers;
+    bool stuck;
+    uint8_t sclLevel;
+    uint8_t stuckClocks;
+
+    static uint32_t& virtualTime() {
+        static uint32_t time = 0;
+        return time;
+    }
+};
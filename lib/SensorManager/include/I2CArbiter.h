@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "I2CBus.h"
+
+// Longest a client waits for another client's transaction or frame
+#ifndef I2C_ARBITER_TIMEOUT_MS
+#define I2C_ARBITER_TIMEOUT_MS 100
+#endif
+
+/**
+ * @brief Sharing counters
+ */
+struct I2CArbiterStats {
+    uint32_t transfers;
+    uint32_t contended;     // Acquisitions that had to wait for another task
+    uint32_t timeouts;      // Acquisitions that gave up
+    uint32_t maxWaitUs;
+};
+
+/**
+ * @brief One I2C controller shared by several clients
+ *
+ * Wraps a bus and serializes its users: every transfer holds a recursive
+ * FreeRTOS mutex, and acquire()/release() keep the bus over a sequence of
+ * transfers (e.g. a display frame), so the I2C engine worker and the
+ * display never interleave on the same controller. begin() and end() are
+ * reference counted: the first begin() configures the controller, later
+ * ones only join, and the last end() releases it, so a client reinitializing
+ * after an error cannot tear the bus down under another one.
+ *
+ * On the host there is one thread and no locking; the counters still work.
+ */
+class I2CArbiter : public I2CBus {
+public:
+    explicit I2CArbiter(I2CBus& bus);
+    ~I2CArbiter();
+
+    bool begin(int sda, int scl, uint32_t frequency) override;
+    void end() override;
+    I2CStatus transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                       uint8_t* rx, size_t rxLen, uint32_t timeoutMs) override;
+    uint32_t getFrequency() const override { return bus.getFrequency(); }
+
+    /**
+     * @brief Hold the bus for several transfers (nests on the same task)
+     *
+     * @return false if another task kept it longer than timeoutMs
+     */
+    bool acquire(uint32_t timeoutMs = I2C_ARBITER_TIMEOUT_MS);
+
+    void release();
+
+    /**
+     * @brief Clients that called begin() and not yet end()
+     */
+    uint8_t getUsers() const { return users; }
+
+    const I2CArbiterStats& getStats() const { return stats; }
+
+private:
+    I2CBus& bus;
+    void* mutex;
+    uint8_t users;
+    uint8_t depth;          // Nesting on the host, where there is no mutex
+    I2CArbiterStats stats;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Result of an I2C transaction
+ *
+ * The numeric values match TwoWire::endTransmission() so existing
+ * diagnostics (e.g. "error == 4" in the bus scan) keep their meaning.
+ */
+enum I2CStatus : uint8_t {
+    I2C_OK = 0,
+    I2C_ERR_DATA_TOO_LONG = 1,
+    I2C_ERR_NACK_ADDR = 2,
+    I2C_ERR_NACK_DATA = 3,
+    I2C_ERR_OTHER = 4,
+    I2C_ERR_TIMEOUT = 5
+};
+
+/**
+ * @brief Minimal I2C master interface used by the transaction engine
+ *
+ * Implementations execute one complete transaction per call. Keeping the
+ * interface this small lets the same engine run on the ESP32 peripheral
+ * and on a fake bus in host tests.
+ */
+class I2CBus {
+public:
+    virtual ~I2CBus() {}
+
+    /**
+     * @brief Configure the bus
+     *
+     * @param sda SDA pin
+     * @param scl SCL pin
+     * @param frequency Bus clock in Hz
+     * @return true if the bus is ready for transactions
+     */
+    virtual bool begin(int sda, int scl, uint32_t frequency) = 0;
+
+    /**
+     * @brief Release the bus and its pins
+     */
+    virtual void end() = 0;
+
+    /**
+     * @brief Execute a write followed by an optional read (repeated start)
+     *
+     * A transaction with txLen == 0 and rxLen == 0 is an address probe.
+     *
+     * @param address 7-bit device address
+     * @param tx Bytes to write (may be null when txLen is 0)
+     * @param txLen Number of bytes to write
+     * @param rx Destination for read bytes (may be null when rxLen is 0)
+     * @param rxLen Number of bytes to read
+     * @param timeoutMs Maximum time the transaction may hold the bus
+     * @return I2CStatus Result of the transaction
+     */
+    virtual I2CStatus transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                               uint8_t* rx, size_t rxLen, uint32_t timeoutMs) = 0;
+
+    /**
+     * @brief Bus clock in Hz, used to estimate bus occupancy
+     */
+    virtual uint32_t getFrequency() const = 0;
+};
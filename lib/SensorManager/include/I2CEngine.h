@@ -0,0 +1,264 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "I2CBus.h"
+#include "I2CHealth.h"
+
+#ifndef I2C_ENGINE_QUEUE_DEPTH
+#define I2C_ENGINE_QUEUE_DEPTH 16
+#endif
+
+#ifndef I2C_ENGINE_MAX_WRITE
+#define I2C_ENGINE_MAX_WRITE 8  // Register address plus a short payload
+#endif
+
+#ifndef I2C_ENGINE_TIMEOUT_MS
+#define I2C_ENGINE_TIMEOUT_MS 20
+#endif
+
+struct I2CTransaction;
+
+// Called once a queued transaction has finished (successfully or not)
+typedef void (*I2CCallback)(const I2CTransaction& txn, void* context);
+
+/**
+ * @brief One queued I2C transaction
+ *
+ * Write bytes are stored inline so callers don't have to keep them alive;
+ * read bytes go straight into the caller-owned rx buffer.
+ */
+struct I2CTransaction {
+    uint8_t address;
+    uint8_t txLen;
+    uint8_t tx[I2C_ENGINE_MAX_WRITE];
+    uint8_t* rx;
+    uint8_t rxLen;
+    I2CCallback callback;
+    void* context;
+
+    // Filled in by the engine
+    I2CStatus status;
+    uint32_t queuedUs;
+    uint32_t startUs;
+    uint32_t doneUs;
+};
+
+/**
+ * @brief Bus occupancy and latency counters
+ */
+struct I2CEngineStats {
+    uint32_t completed;       // Transactions finished with I2C_OK
+    uint32_t failed;          // Transactions finished with an error
+    uint32_t rejected;        // Submissions refused because the queue was full
+    uint32_t bytes;           // Payload bytes moved (write + read)
+    uint64_t busyUs;          // Time the bus was executing transactions
+    uint64_t totalLatencyUs;  // Sum of queue-to-completion latencies
+    uint32_t maxLatencyUs;    // Worst queue-to-completion latency
+    uint32_t windowStartUs;   // Start of the measurement window
+
+    /**
+     * @brief Fraction of the measurement window the bus was busy (0.0-1.0)
+     */
+    float occupancy(uint32_t nowUs) const {
+        uint32_t window = nowUs - windowStartUs;
+        return window == 0 ? 0.0f : (float)busyUs / (float)window;
+    }
+
+    /**
+     * @brief Mean queue-to-completion latency in microseconds
+     */
+    uint32_t averageLatencyUs() const {
+        uint32_t total = completed + failed;
+        return total == 0 ? 0 : (uint32_t)(totalLatencyUs / total);
+    }
+};
+
+/**
+ * @brief Queued, asynchronous I2C transaction engine
+ *
+ * Transactions are placed in a fixed-size ring and executed in order,
+ * either by poll() on the caller's thread or by a FreeRTOS worker task on
+ * the ESP32. With the worker running, the bus driver executes each
+ * transaction from the peripheral's hardware command list while the
+ * worker is blocked, so the application core does not busy-wait on the
+ * bus. Completion callbacks run on whichever thread executed the
+ * transaction.
+ */
+class I2CEngine {
+public:
+    static const uint8_t QUEUE_DEPTH = I2C_ENGINE_QUEUE_DEPTH;
+
+    /**
+     * @brief Constructor
+     *
+     * @param bus Bus implementation to drive (may be set later with setBus)
+     */
+    explicit I2CEngine(I2CBus* bus = nullptr);
+
+    ~I2CEngine();
+
+    /**
+     * @brief Attach the bus implementation
+     */
+    void setBus(I2CBus* bus) { this->bus = bus; }
+
+    /**
+     * @brief Get the attached bus implementation
+     */
+    I2CBus* getBus() const { return bus; }
+
+    /**
+     * @brief Report every finished transaction to a health monitor
+     *
+     * record() runs on whichever thread executed the transaction.
+     *
+     * @param monitor Monitor to feed, or null to stop
+     */
+    void setMonitor(I2CHealthMonitor* monitor) { this->monitor = monitor; }
+
+    /**
+     * @brief Queue a register read (write register address, then read)
+     *
+     * @param address 7-bit device address
+     * @param reg First register to read
+     * @param rx Destination buffer, must stay valid until the callback runs
+     * @param len Number of bytes to read
+     * @param callback Completion callback (may be null)
+     * @param context Passed through to the callback
+     * @return true if the transaction was queued
+     */
+    bool queueRead(uint8_t address, uint8_t reg, uint8_t* rx, uint8_t len,
+                   I2CCallback callback = nullptr, void* context = nullptr);
+
+    /**
+     * @brief Queue a register write
+     *
+     * @param address 7-bit device address
+     * @param reg Register to write
+     * @param data Bytes to write (copied into the transaction)
+     * @param len Number of bytes, at most I2C_ENGINE_MAX_WRITE - 1
+     * @param callback Completion callback (may be null)
+     * @param context Passed through to the callback
+     * @return true if the transaction was queued
+     */
+    bool queueWrite(uint8_t address, uint8_t reg, const uint8_t* data, uint8_t len,
+                    I2CCallback callback = nullptr, void* context = nullptr);
+
+    /**
+     * @brief Queue a prepared transaction
+     *
+     * @return true if the transaction was queued
+     */
+    bool submit(const I2CTransaction& txn);
+
+    /**
+     * @brief Queue several transactions back to back
+     *
+     * The batch is accepted only if every transaction fits, so register
+     * reads for several devices are either all scheduled or none are.
+     *
+     * @return true if the whole batch was queued
+     */
+    bool submitBatch(const I2CTransaction* txns, uint8_t count);
+
+    /**
+     * @brief Remove a queued transaction that has not started yet
+     *
+     * @param context Context the transaction was queued with
+     * @return true if it was removed; false if it already ran or is running
+     */
+    bool cancel(const void* context);
+
+    /**
+     * @brief Execute queued transactions on the calling thread
+     *
+     * Does nothing while the worker task is running.
+     *
+     * @param maxTransactions Upper bound on transactions to run in this call
+     * @return uint8_t Number of transactions executed
+     */
+    uint8_t poll(uint8_t maxTransactions = QUEUE_DEPTH);
+
+    /**
+     * @brief Start a background worker that drains the queue (ESP32 only)
+     *
+     * @param priority FreeRTOS task priority
+     * @param core Core to pin the worker to
+     * @return true if the worker is running
+     */
+    bool startWorker(uint8_t priority = 2, int core = 0);
+
+    /**
+     * @brief Whether the background worker is running
+     */
+    bool hasWorker() const { return workerHandle != nullptr; }
+
+    /**
+     * @brief Synchronous register read through the queue
+     *
+     * Waits for previously queued work so ordering is preserved. A call
+     * that times out takes its transaction back out of the queue, or waits
+     * for it to finish if the worker already started it, so rx is never
+     * written after the call returned.
+     */
+    I2CStatus readRegisters(uint8_t address, uint8_t reg, uint8_t* rx, uint8_t len);
+
+    /**
+     * @brief Synchronous register write through the queue
+     */
+    I2CStatus writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+    /**
+     * @brief Synchronous address probe
+     */
+    I2CStatus probe(uint8_t address);
+
+    /**
+     * @brief Number of transactions waiting to run
+     */
+    uint8_t pending() const;
+
+    /**
+     * @brief Get bus occupancy and latency counters
+     *
+     * A copy, taken under the queue lock while the worker runs.
+     */
+    I2CEngineStats getStats() const;
+
+    /**
+     * @brief Reset counters and start a new measurement window
+     */
+    void resetStats();
+
+    /**
+     * @brief Current time in microseconds from the engine clock
+     */
+    static uint32_t nowUs() { return clock(); }
+
+    /**
+     * @brief Replace the engine clock (host tests use a virtual clock)
+     */
+    static void setClock(uint32_t (*clockFn)()) { clock = clockFn; }
+
+private:
+    I2CBus* bus;
+    I2CHealthMonitor* monitor;
+    I2CTransaction queue[QUEUE_DEPTH];
+    volatile uint8_t head;   // Next slot to execute
+    volatile uint8_t count;  // Transactions waiting
+    I2CEngineStats stats;
+
+    void* workerHandle;  // TaskHandle_t on the ESP32
+    void* lock;          // Guards the queue and stats when the worker runs
+
+    static uint32_t (*clock)();
+
+    bool enqueue(const I2CTransaction* txns, uint8_t n);
+    bool dequeue(I2CTransaction& txn);
+    void execute(I2CTransaction& txn);
+    I2CStatus runSync(I2CTransaction& txn);
+
+    static void workerTask(void* param);
+    static void syncCallback(const I2CTransaction& txn, void* context);
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include "I2CBus.h"
+
+// Devices whose transfers are counted (the BME280 at both addresses, plus spares)
+#ifndef I2C_HEALTH_MAX_DEVICES
+#define I2C_HEALTH_MAX_DEVICES 4
+#endif
+
+// Plain retries before the bus itself is suspected
+#ifndef I2C_HEALTH_RETRY_LIMIT
+#define I2C_HEALTH_RETRY_LIMIT 2
+#endif
+
+/**
+ * @brief Recovery actions, from cheapest to most disruptive
+ */
+enum I2CRecoveryStep : uint8_t {
+    I2C_RECOVERY_NONE = 0,
+    I2C_RECOVERY_RETRY,         // Try again after a short pause
+    I2C_RECOVERY_CLOCK_OUT,     // Nine SCL clocks and a STOP to release a slave holding SDA
+    I2C_RECOVERY_REINIT,        // Tear down and reconfigure the I2C controller
+    I2C_RECOVERY_POWER_CYCLE,   // Switch VEXT off and on again
+    I2C_RECOVERY_STEP_COUNT
+};
+
+/**
+ * @brief Transfer outcomes of one device address
+ */
+struct I2CDeviceHealth {
+    uint8_t address;
+    I2CStatus lastStatus;
+    uint8_t escalation;              // Last recovery step taken (I2CRecoveryStep)
+    uint8_t retries;                 // Retries taken in the current escalation
+    uint32_t transfers;
+    uint32_t nacks;                  // Address or data NACKed
+    uint32_t timeouts;
+    uint32_t errors;                 // Other bus errors
+    uint32_t stuckDetections;        // SDA found held low after a failure
+    uint16_t consecutiveFailures;
+    uint16_t maxConsecutiveFailures;
+};
+
+/**
+ * @brief Recovery counters for the whole bus
+ */
+struct I2CBusHealth {
+    uint32_t steps[I2C_RECOVERY_STEP_COUNT];  // Recovery steps taken, by I2CRecoveryStep
+    uint32_t recovered;                       // Escalations that ended with the device answering
+    uint32_t abandoned;                       // Escalations that ran out of steps
+};
+
+/**
+ * @brief Everything the monitor counts, kept as plain data so it can live in RTC memory
+ */
+struct I2CHealthTable {
+    I2CDeviceHealth devices[I2C_HEALTH_MAX_DEVICES];
+    uint8_t deviceCount;
+    I2CBusHealth bus;
+};
+
+/**
+ * @brief Per-device I2C error counters and recovery escalation
+ *
+ * I2CEngine reports every finished transaction with record(). When a
+ * device stops answering, nextStep() hands out one recovery action at a
+ * time: a couple of plain retries for NACKs, then a clock-out, a
+ * controller reinit and finally a power cycle. A timeout means the bus
+ * itself is wedged, so retries are skipped. The caller performs the step
+ * and tries again; the ladder restarts once the device answers
+ * (recovered()) or the caller gives up (resetEscalation()).
+ *
+ * Counters accumulate until reset(), so a node with flaky wiring shows a
+ * steady NACK or timeout count while a clean one stays at zero.
+ */
+class I2CHealthMonitor {
+public:
+    I2CHealthMonitor();
+
+    /**
+     * @brief Clear all devices and counters
+     */
+    void reset();
+
+    /**
+     * @brief Start counting transfers to an address
+     *
+     * Unwatched addresses (e.g. bus scan probes) are ignored.
+     *
+     * @return true if the address is watched
+     */
+    bool watch(uint8_t address);
+
+    /**
+     * @brief Count one finished transaction
+     */
+    void record(uint8_t address, I2CStatus status);
+
+    /**
+     * @brief Count SDA found held low, i.e. a slave stuck mid-byte
+     */
+    void recordStuck(uint8_t address);
+
+    /**
+     * @brief Next recovery action for a device that just failed
+     *
+     * @return I2C_RECOVERY_NONE once every step has been tried, or if the
+     *         last transfer to the device succeeded
+     */
+    I2CRecoveryStep nextStep(uint8_t address);
+
+    /**
+     * @brief The device answered again; counts the escalation as recovered
+     */
+    void recovered(uint8_t address);
+
+    /**
+     * @brief Restart the ladder without counting a recovery
+     */
+    void resetEscalation(uint8_t address);
+
+    /**
+     * @brief Counters of one address, or null if it is not watched
+     */
+    const I2CDeviceHealth* getDevice(uint8_t address) const;
+
+    const I2CBusHealth& getBusHealth() const { return table.bus; }
+
+    /**
+     * @brief All counters, e.g. to carry them across deep sleep
+     */
+    const I2CHealthTable& getTable() const { return table; }
+
+    /**
+     * @brief Continue from counters saved earlier
+     */
+    void restore(const I2CHealthTable& saved);
+
+    /**
+     * @brief Short name of a recovery step for logs
+     */
+    static const char* stepName(I2CRecoveryStep step);
+
+private:
+    I2CHealthTable table;
+
+    I2CDeviceHealth* find(uint8_t address);
+};
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Edge timestamps buffered between ISR and loop (power of two)
+#ifndef MOTION_EVENT_QUEUE_SIZE
+#define MOTION_EVENT_QUEUE_SIZE 32
+#endif
+
+// A level has to hold this long to count; shorter pulses are contact bounce
+#ifndef MOTION_DEBOUNCE_MS
+#define MOTION_DEBOUNCE_MS 50
+#endif
+
+// Event age reported when the interval had no motion
+#define MOTION_NO_EVENT 0xFFFF
+
+/**
+ * @brief Motion activity over one reporting interval
+ */
+struct MotionSummary {
+    uint16_t count;          // Rising edges (motion starts)
+    uint32_t firstEventMs;   // millis() of the first rising edge
+    uint32_t lastEventMs;    // millis() of the last rising edge
+    uint32_t activeMs;       // Time the PIR output was active
+    uint32_t intervalMs;     // Length of the interval
+    uint16_t dropped;        // Edges lost to a full queue
+
+    /**
+     * @brief Share of the interval with the PIR active, 0-100 %
+     */
+    uint8_t occupancyPercent() const {
+        if (intervalMs == 0) return 0;
+        uint32_t percent = (uint32_t)(((uint64_t)activeMs * 100 + intervalMs / 2) / intervalMs);
+        return percent > 100 ? 100 : (uint8_t)percent;
+    }
+
+    /**
+     * @brief Seconds between an event and nowMs, saturated for the payload
+     */
+    static uint16_t ageSeconds(uint32_t eventMs, uint32_t nowMs) {
+        uint32_t age = (nowMs - eventMs) / 1000;
+        return age >= MOTION_NO_EVENT ? MOTION_NO_EVENT - 1 : (uint16_t)age;
+    }
+};
+
+/**
+ * @brief Interrupt-driven PIR capture
+ *
+ * A CHANGE interrupt pushes each level change with its timestamp into a
+ * single-producer/single-consumer ring; update() drains the ring from the
+ * loop and folds the edges into the current interval's MotionSummary.
+ *
+ * Debouncing happens on the consumer side: a level counts once it has held
+ * for MOTION_DEBOUNCE_MS, dated from the first edge of its bounce burst.
+ * A burst that settles back on the previous level is ignored, and the level
+ * the pin settles on is applied by update() even if no later edge arrives.
+ * No edge is lost between loop iterations, and no uplink is needed per edge.
+ */
+class MotionSensor {
+public:
+    MotionSensor();
+
+    /**
+     * @brief Configure the pin and attach the interrupt
+     *
+     * @param pin PIR output pin
+     * @param activeLevel Level the PIR drives while it sees motion
+     * @return true if the interrupt was attached
+     */
+    bool begin(int pin, int activeLevel);
+
+    /**
+     * @brief Start the first interval from the current PIR level
+     *
+     * begin() calls this with the level it reads; host tests call it directly.
+     * An active level is queued as a motion start.
+     *
+     * @param active true if the PIR output is active
+     * @param nowMs Current time
+     */
+    void start(bool active, uint32_t nowMs);
+
+    /**
+     * @brief Record an edge; called from the ISR (and by host tests)
+     *
+     * @param active true if the PIR output became active
+     * @param nowMs Edge timestamp
+     */
+    void onEdge(bool active, uint32_t nowMs);
+
+    /**
+     * @brief Drain queued edges into the current interval
+     *
+     * @param nowMs Current time
+     * @return uint16_t Number of new motion starts
+     */
+    uint16_t update(uint32_t nowMs);
+
+    /**
+     * @brief Count a motion start that happened before begin(), e.g. a PIR wake
+     *
+     * Call after begin(). A PIR that was still active then is already
+     * counted by begin(), so the wake adds nothing in that case.
+     */
+    void recordWakeEvent(uint32_t nowMs);
+
+    /**
+     * @brief Close the current interval and start the next one
+     *
+     * Queued edges are drained first. If the PIR is still active, the time
+     * up to nowMs is counted and the activity carries into the next interval.
+     *
+     * @param nowMs End of the interval
+     * @return MotionSummary Activity in the closed interval
+     */
+    MotionSummary takeSummary(uint32_t nowMs);
+
+    /**
+     * @brief Merge a taken summary back into the current interval
+     *
+     * For a summary whose uplink failed, so its activity goes out with the
+     * next one. Only valid for the summary of the last takeSummary() call.
+     */
+    void restoreSummary(const MotionSummary& taken);
+
+    /**
+     * @brief Whether the PIR output is currently active (as of the last update)
+     */
+    bool isActive() const { return active; }
+
+private:
+    struct Edge {
+        uint32_t timeMs;
+        bool active;
+    };
+
+    // Written by the ISR only
+    Edge queue[MOTION_EVENT_QUEUE_SIZE];
+    std::atomic<uint32_t> head;
+    bool lastEdgeActive;
+    bool edgeSeen;
+    std::atomic<uint16_t> dropped;
+
+    // Written by the consumer only
+    std::atomic<uint32_t> tail;
+    MotionSummary summary;
+    uint32_t intervalStartMs;
+    bool active;
+    uint32_t activeSinceMs;
+    bool startedActive;       // start() queued an active level
+
+    // Latest level not held for MOTION_DEBOUNCE_MS yet
+    bool pending;
+    bool pendingActive;
+    uint32_t pendingStartMs;  // First edge of the bounce burst
+    uint32_t pendingLastMs;   // Latest edge of the burst
+
+    int pin;
+    int activeLevel;
+
+    bool apply(bool level, uint32_t timeMs);
+    static void isr(void* arg);
+};
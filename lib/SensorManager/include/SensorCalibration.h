@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "BME280Driver.h"
+#include "SensorFilter.h"
+
+// Default sea-level reference for altitude
+#ifndef SEALEVELPRESSURE_HPA
+#define SEALEVELPRESSURE_HPA 1013.25
+#endif
+
+// Preferences namespace holding the calibration blob
+#ifndef SENSOR_CALIBRATION_NAMESPACE
+#define SENSOR_CALIBRATION_NAMESPACE "sensorcal"
+#endif
+
+#define SENSOR_CALIBRATION_VERSION 1
+
+// Gain of 1.0 (Q1.15)
+#define SENSOR_CALIBRATION_UNITY_GAIN 0x8000
+
+// Downlink layout (CONFIG type byte shared with ReportPolicy and the payload formatter)
+#define SENSOR_DOWNLINK_CONFIG          0x01
+#define SENSOR_CONFIG_CALIBRATION       0x05  // channel, offset (s16, 0.01 units), gain (u16, Q1.15)
+#define SENSOR_CONFIG_SEA_LEVEL         0x06  // Pa (u24), 0 restores the default
+
+/**
+ * @brief Per-channel correction in the units of BME280Sample
+ */
+struct SensorChannelCalibration {
+    int32_t offset;  // 0.01 °C, 1/1024 %RH or 1/256 Pa
+    uint16_t gain;   // Q1.15, SENSOR_CALIBRATION_UNITY_GAIN = 1.0
+};
+
+/**
+ * @brief Per-device offset/gain table and sea-level reference, kept in NVS
+ *
+ * Corrects the compensated BME280 sample in its own fixed-point units
+ * before it is converted to float: value * gain / 2^15 + offset. Offsets
+ * absorb self-heating next to the ESP32 and OLED, gains a humidity or
+ * pressure slope found against a reference instrument.
+ *
+ * An unset table (all offsets zero, all gains 1.0) is detected once when
+ * it changes, so apply() is never called on the acquisition path and the
+ * sample is used as it comes out of the compensation formulas.
+ */
+class SensorCalibration {
+public:
+    SensorCalibration();
+
+    /**
+     * @brief Load the table stored in NVS (host builds keep the defaults)
+     *
+     * @return true if a stored table was found
+     */
+    bool load();
+
+    /**
+     * @brief Store the table in NVS
+     *
+     * @return true if it was written
+     */
+    bool save() const;
+
+    /**
+     * @brief Back to offset 0, gain 1.0 and the default sea-level pressure
+     */
+    void clear();
+
+    /**
+     * @brief Set one channel's correction in sample units
+     */
+    void setChannel(SensorChannel channel, const SensorChannelCalibration& calibration);
+
+    /**
+     * @brief Set one channel's correction in reading units
+     *
+     * @param channel Channel to correct
+     * @param offset Added after the gain, in °C, %RH or hPa
+     * @param gain Slope, 0 to just under 2
+     */
+    void setChannel(SensorChannel channel, float offset, float gain = 1.0F);
+
+    const SensorChannelCalibration& getChannel(SensorChannel channel) const { return channels[channel]; }
+
+    /**
+     * @brief Local sea-level reference used for altitude
+     *
+     * @param pascals Reference pressure, 0 restores SEALEVELPRESSURE_HPA
+     */
+    void setSeaLevel(uint32_t pascals);
+
+    float getSeaLevelHpa() const { return seaLevelHpa; }
+
+    /**
+     * @brief Whether any channel differs from offset 0, gain 1.0
+     */
+    bool isActive() const { return active; }
+
+    /**
+     * @brief Correct a compensated sample in place
+     */
+    void apply(BME280Sample& sample) const;
+
+    /**
+     * @brief Handle a CONFIG downlink with a calibration key
+     *
+     * @param payload Downlink bytes starting with SENSOR_DOWNLINK_CONFIG
+     * @param size Payload length
+     * @return true if the table changed (call save() to keep it)
+     */
+    bool applyDownlink(const uint8_t* payload, size_t size);
+
+private:
+    SensorChannelCalibration channels[SENSOR_CHANNEL_COUNT];
+    uint32_t seaLevelPa;
+    float seaLevelHpa;
+    bool active;
+
+    void update();
+    static int32_t scale(int32_t value, const SensorChannelCalibration& calibration);
+};
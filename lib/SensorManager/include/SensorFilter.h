@@ -0,0 +1,123 @@
+#pragma once
+
+#include <stdint.h>
+
+// Samples kept per channel for the median (odd values only)
+#ifndef SENSOR_FILTER_WINDOW
+#define SENSOR_FILTER_WINDOW 3
+#endif
+
+// Consecutive rate-limit rejections after which a jump is accepted as a real step
+#ifndef SENSOR_FILTER_MAX_REJECTS
+#define SENSOR_FILTER_MAX_REJECTS 3
+#endif
+
+// Per-reading quality flags (one byte, sent as-is in the uplink)
+#define SENSOR_QUALITY_TEMPERATURE_HELD  0x01  // Sample rejected, last good value reported
+#define SENSOR_QUALITY_HUMIDITY_HELD     0x02
+#define SENSOR_QUALITY_PRESSURE_HELD     0x04
+#define SENSOR_QUALITY_OUT_OF_RANGE      0x08  // A sample was outside the physical range
+#define SENSOR_QUALITY_RATE_LIMITED      0x10  // A sample changed faster than its rate limit
+#define SENSOR_QUALITY_READ_ERROR        0x20  // Bus error, skipped conversion or no sensor
+#define SENSOR_QUALITY_WARMING_UP        0x40  // Median window not full yet
+#define SENSOR_QUALITY_NO_DATA           0x80  // A channel has never had a valid sample
+
+/**
+ * @brief One set of BME280 values
+ */
+struct SensorReading {
+    float temperature;  // °C
+    float humidity;     // %
+    float pressure;     // hPa
+    float altitude;     // m
+    uint8_t quality;    // SENSOR_QUALITY_* flags
+};
+
+enum SensorChannel : uint8_t {
+    SENSOR_CHANNEL_TEMPERATURE = 0,
+    SENSOR_CHANNEL_HUMIDITY,
+    SENSOR_CHANNEL_PRESSURE,
+    SENSOR_CHANNEL_COUNT
+};
+
+/**
+ * @brief Validation limits for one channel
+ *
+ * A sample is accepted if it lies in [min, max] and differs from the last
+ * accepted sample by at most minStep + maxRatePerSecond * elapsed seconds.
+ */
+struct SensorChannelLimits {
+    float min;
+    float max;
+    float maxRatePerSecond;
+    float minStep;
+};
+
+/**
+ * @brief Validation and smoothing stage for BME280 readings
+ *
+ * Each channel goes through a physical range check, a rate-of-change limit
+ * and a small median filter. Rejected samples are replaced by the last good
+ * filtered value and flagged, so callers get a usable reading on the first
+ * try instead of re-reading the sensor. A jump that persists for
+ * SENSOR_FILTER_MAX_REJECTS samples is treated as a real step change and
+ * restarts the channel at the new level.
+ */
+class SensorFilter {
+public:
+    SensorFilter();
+
+    /**
+     * @brief Validate and filter a reading in place
+     *
+     * Temperature, humidity and pressure are replaced by their filtered
+     * values (NAN while a channel has no valid sample yet); altitude is left
+     * untouched.
+     *
+     * @param reading Raw values in, filtered values and quality flags out
+     * @param valid false if the read itself failed (values are ignored)
+     * @param nowMs Sample timestamp in milliseconds
+     * @return uint8_t The quality flags also stored in reading.quality
+     */
+    uint8_t apply(SensorReading& reading, bool valid, uint32_t nowMs);
+
+    /**
+     * @brief Forget all history, e.g. after the sensor was re-initialized
+     */
+    void reset();
+
+    /**
+     * @brief Override the limits of one channel
+     */
+    void setLimits(SensorChannel channel, const SensorChannelLimits& limits);
+
+    /**
+     * @brief Get the limits of one channel
+     */
+    const SensorChannelLimits& getLimits(SensorChannel channel) const { return state[channel].limits; }
+
+    /**
+     * @brief Whether a reading's flags allow it to be used at all
+     */
+    static bool isUsable(uint8_t quality) { return (quality & SENSOR_QUALITY_NO_DATA) == 0; }
+
+private:
+    struct ChannelState {
+        SensorChannelLimits limits;
+        float window[SENSOR_FILTER_WINDOW];
+        uint8_t count;       // Valid entries in window
+        uint8_t next;        // Ring index of the next write
+        uint8_t rejects;     // Consecutive rate-limit rejections
+        bool hasSample;
+        float lastSample;    // Last accepted raw sample
+        uint32_t lastMs;
+        float output;        // Last filtered value
+    };
+
+    ChannelState state[SENSOR_CHANNEL_COUNT];
+
+    // Returns the flags for one channel; heldFlag is the channel's *_HELD bit
+    uint8_t filterChannel(ChannelState& channel, float& value, bool valid,
+                          uint32_t nowMs, uint8_t heldFlag);
+    static float median(const float* values, uint8_t count);
+};
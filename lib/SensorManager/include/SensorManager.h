@@ -1,10 +1,14 @@
 #pragma once
 
 #include <Arduino.h>
-#include <Wire.h>
-#include <Adafruit_Sensor.h>
-#include <Adafruit_BME280.h>
 #include "Config.h"
+#include "I2CEngine.h"
+#include "Esp32I2CBus.h"
+#include "BME280Driver.h"
+#include "BME280Profile.h"
+#include "SensorFilter.h"
+#include "SensorCalibration.h"
+#include "UlpSampler.h"
 
 // Default configuration values
 #ifndef I2C_SDA
@@ -19,27 +23,99 @@
 #define BME_ADDRESS 0x76
 #endif
 
-#ifndef SEALEVELPRESSURE_HPA
-#define SEALEVELPRESSURE_HPA 1013.25
-#endif
-
 #ifndef I2C_CLOCK_SPEED
 #define I2C_CLOCK_SPEED 100000
 #endif
 
+// Pause before retrying a sensor that NACKed
+#ifndef I2C_RECOVERY_RETRY_MS
+#define I2C_RECOVERY_RETRY_MS 10
+#endif
+
+// Completion callback for requestReading(); runs on the thread that executed the I2C transfer
+typedef void (*SensorReadingCallback)(bool success, const SensorReading& reading, void* context);
+
 class SensorManager {
 public:
+#if defined(ESP_PLATFORM)
+    /**
+     * @brief Constructor for a BME280 on the first hardware I2C controller
+     */
     SensorManager();
+#endif
+    
+    /**
+     * @brief Constructor for a BME280 on any bus, e.g. FakeI2CBus in host tests
+     * 
+     * @param bus Bus the sensor is attached to; must outlive the manager
+     */
+    explicit SensorManager(I2CBus& bus);
     
     /**
      * @brief Initialize the sensor manager
      * 
+     * After a deep-sleep wake the sensor address and calibration cached in
+     * RTC memory are reused, skipping detection. Full discovery only runs if
+     * that warm start fails; it resets the bus, power cycles the sensor or
+     * scans the bus only when the sensor does not answer.
+     * 
      * @param sda SDA pin for I2C
      * @param scl SCL pin for I2C
      * @return true if BME280 was detected and initialized, false otherwise
      */
     bool begin(int sda, int scl);
     
+    /**
+     * @brief Select oversampling, filter and mode
+     * 
+     * Takes effect at the next begin(), or right away if the sensor is
+     * running. Forced-mode profiles start one conversion per read() and wait
+     * exactly its maximum duration (see bme280MeasurementMaxUs()); the sensor
+     * sleeps in between.
+     * 
+     * @param profile Predefined profile (default SENSOR_PROFILE_HIGH_PRECISION)
+     * @return false if the running sensor did not accept the settings
+     */
+    bool setProfile(SensorProfile profile) { return setProfile(bme280Profile(profile)); }
+    
+    /**
+     * @brief Select custom settings
+     */
+    bool setProfile(const BME280Profile& profile);
+    
+    const BME280Profile& getProfile() const { return profile; }
+    
+    /**
+     * @brief Worst-case duration of one conversion with the current profile
+     * 
+     * @return uint32_t Microseconds
+     */
+    uint32_t getMeasurementUs() const { return measurementUs; }
+    
+    /**
+     * @brief Forget the cached sensor state so the next begin() runs full discovery
+     */
+    void invalidateWakeCache();
+    
+    /**
+     * @brief Whether the last begin() took the warm-wake fast path
+     */
+    bool isWarmStart() const { return warmStart; }
+    
+    /**
+     * @brief Time spent in the last begin() call
+     * 
+     * @return uint32_t Duration in microseconds
+     */
+    uint32_t getBeginDurationUs() const { return beginDurationUs; }
+    
+    /**
+     * @brief Time from boot (or wake) to the first valid reading in begin()
+     * 
+     * @return uint32_t Latency in microseconds, 0 if no valid reading yet
+     */
+    uint32_t getWakeToReadingUs() const { return wakeToReadingUs; }
+    
     /**
      * @brief Perform a complete reset of the I2C bus
      * 
@@ -51,48 +127,90 @@ public:
     /**
      * @brief Scan the I2C bus for connected devices
      * 
-     * @param wire TwoWire instance to use
      * @param sda SDA pin for I2C
      * @param scl SCL pin for I2C
      */
-    void scanI2CBus(TwoWire *wire, int sda, int scl);
+    void scanI2CBus(int sda, int scl);
     
     /**
      * @brief Power cycle the BME280 if VEXT pin is available
      */
     void powerCycleBME280();
     
+    /**
+     * @brief Set the level that switches VEXT on (defaults to VEXT_ACTIVE_HIGH)
+     * 
+     * @param activeHigh true if VEXT is on when HIGH
+     */
+    void setVextActiveHigh(bool activeHigh) { vextActiveHigh = activeHigh; }
+    
+    /**
+     * @brief Take the next recovery step after the sensor stopped answering
+     * 
+     * Call once per read that reported SENSOR_QUALITY_READ_ERROR, with no
+     * requestReading() outstanding. Each call escalates one step (retry,
+     * clock-out, controller reinit, VEXT power cycle); a successful read
+     * starts the ladder over.
+     * 
+     * @param sda SDA pin for I2C
+     * @param scl SCL pin for I2C
+     * @return Step taken, or I2C_RECOVERY_NONE if the last transfer succeeded or every step was tried
+     */
+    I2CRecoveryStep recoverBus(int sda, int scl);
+    
+    /**
+     * @brief NACK, timeout and stuck-bus counters per address, and recovery steps taken
+     * 
+     * Carried across deep-sleep wakes in RTC memory.
+     */
+    const I2CHealthMonitor& getHealth() const { return health; }
+    
+    /**
+     * @brief Read, validate and filter one set of BME280 values
+     * 
+     * Out-of-range samples, implausible jumps and failed reads are replaced
+     * by the last good filtered value and flagged in reading.quality, so a
+     * single call is enough; there is no need to retry.
+     * 
+     * @param reading Receives the filtered values and quality flags
+     * @return true if the values are usable (see SensorFilter::isUsable)
+     */
+    bool read(SensorReading& reading);
+    
     /**
      * @brief Read temperature from BME280
      * 
-     * @return float Temperature in Celsius, or -273.15 if sensor not available
+     * @return float Filtered temperature in Celsius, or NAN if there is no valid sample yet
      */
     float readTemperature();
     
     /**
      * @brief Read humidity from BME280
      * 
-     * @return float Humidity in %, or 0.0 if sensor not available
+     * @return float Filtered humidity in %, or NAN if there is no valid sample yet
      */
     float readHumidity();
     
     /**
      * @brief Read pressure from BME280
      * 
-     * @return float Pressure in hPa, or 0.0 if sensor not available
+     * @return float Filtered pressure in hPa, or NAN if there is no valid sample yet
      */
     float readPressure();
     
     /**
      * @brief Read altitude from BME280
      * 
-     * @return float Altitude in meters, or 0.0 if sensor not available
+     * @return float Altitude in meters from the filtered pressure, or NAN if there is no valid sample yet
      */
     float readAltitude();
     
     /**
      * @brief Read all BME280 values at once
      * 
+     * Same filtering as read(); the quality flags are available from
+     * getLastQuality() afterwards.
+     * 
      * @param temperature Reference to store temperature
      * @param humidity Reference to store humidity
      * @param pressure Reference to store pressure
@@ -100,14 +218,129 @@ public:
      */
     void readBME280(float &temperature, float &humidity, float &pressure, float &altitude);
     
+    /**
+     * @brief Quality flags of the most recent reading (SENSOR_QUALITY_*)
+     */
+    uint8_t getLastQuality() const { return lastQuality; }
+    
+    /**
+     * @brief Validation and filtering stage, e.g. to adjust channel limits
+     */
+    SensorFilter& getFilter() { return filter; }
+    
+    /**
+     * @brief Per-device offsets, gains and sea-level reference
+     * 
+     * Applied to every reading (and ULP sample) before validation; load()
+     * it from NVS at boot.
+     */
+    SensorCalibration& getCalibration() { return calibration; }
+    
+    /**
+     * @brief Queue a BME280 reading without blocking on the bus
+     * 
+     * The data burst is queued on the I2C engine and the callback fires once
+     * it has been read, compensated and filtered. Only one request can be
+     * outstanding. success is false if the values are not usable.
+     * 
+     * With a forced-mode profile the burst returns the conversion started
+     * by the previous request (or by begin()) and the next one is started
+     * right behind it, so requests should be at least getMeasurementUs()
+     * apart.
+     * 
+     * @param callback Called with the result
+     * @param context Passed through to the callback
+     * @return true if the request was queued
+     */
+    bool requestReading(SensorReadingCallback callback, void* context = nullptr);
+    
+    /**
+     * @brief Run queued I2C transactions when no background worker is active
+     */
+    void poll() { i2c.poll(); }
+    
+    /**
+     * @brief Move I2C execution to a background FreeRTOS task
+     * 
+     * @return true if the worker is running
+     */
+    bool startBackgroundI2C() { return i2c.startWorker(); }
+    
+    /**
+     * @brief Hand the sensor to the ULP coprocessor for the coming deep sleep
+     * 
+     * The current sample becomes the threshold reference, the BME280 is
+     * switched to 1 Hz normal mode without IIR filter and the I2C controller
+     * is released. Call right before esp_deep_sleep_start(); the next begin()
+     * stops the ULP and collects its batch (see getUlpSampler()).
+     * 
+     * @param sda SDA pin (must be an RTC GPIO)
+     * @param scl SCL pin (must be an RTC GPIO)
+     * @param thresholds Change from the current sample that wakes the main cores
+     * @param intervalMs ULP sampling period
+     * @return true if the ULP is sampling and will wake the main cores
+     */
+    bool startUlpSampling(int sda, int scl, const UlpThresholds& thresholds,
+                          uint32_t intervalMs = ULP_SAMPLER_INTERVAL_MS);
+    
+    /**
+     * @brief Samples taken by the ULP during the last sleep
+     */
+    const UlpSampler& getUlpSampler() const { return ulp; }
+    
     // Get sensor status
     bool isBME280Available() { return bme280Available; }
     
     // Direct sensor access (use carefully)
-    Adafruit_BME280& getBME280() { return bme; }
+    BME280Driver& getBME280() { return bme; }
+    
+    // Transaction engine, e.g. for batching reads of other devices on the same bus
+    I2CEngine& getI2CEngine() { return i2c; }
     
 private:
-    Adafruit_BME280 bme;
+#if defined(ESP_PLATFORM)
+    Esp32I2CBus defaultBus;
+#endif
+    I2CBus& i2cBus;
+    I2CEngine i2c;
+    BME280Driver bme;
     bool bme280Available;
-    TwoWire *wire; // Store which Wire instance we're using
+    bool vextActiveHigh;
+    UlpSampler ulp;
+    
+    // Validation stage shared by the synchronous and queued read paths
+    SensorFilter filter;
+    SensorCalibration calibration;
+    I2CHealthMonitor health;
+    
+    // Sampling settings; forced mode tracks the conversion in flight
+    BME280Profile profile;
+    uint32_t measurementUs;
+    volatile bool conversionPending;
+    volatile uint32_t conversionReadyUs;
+    volatile uint8_t lastQuality;
+    
+    // Startup timing
+    bool warmStart;
+    uint32_t beginDurationUs;
+    uint32_t wakeToReadingUs;
+    
+    // State of the outstanding requestReading() call
+    uint8_t asyncBurst[BME280_BURST_LEN];
+    SensorReadingCallback asyncCallback;
+    void* asyncContext;
+    volatile bool asyncBusy;
+    
+    bool convert(const BME280RawData& raw, SensorReading& reading);
+    bool finishReading(bool valid, SensorReading& reading);
+    bool beginWarm(int sda, int scl);
+    bool beginCold(int sda, int scl);
+    bool detectSensor(int sda, int scl);
+    void recover(I2CRecoveryStep step, uint8_t address, int sda, int scl);
+    bool configureSensor();
+    bool startConversion();
+    bool awaitConversion();
+    bool verifySensor();
+    static void onBurstComplete(const I2CTransaction& txn, void* context);
+    static void onConversionStarted(const I2CTransaction& txn, void* context);
 }; 
\ No newline at end of file
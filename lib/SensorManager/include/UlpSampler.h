@@ -0,0 +1,183 @@
+#pragma once
+
+#include <stdint.h>
+#include "BME280Driver.h"
+#include "SensorFilter.h"
+#include "SensorCalibration.h"
+
+// Samples the ULP stores in RTC memory before it wakes the main cores
+#ifndef ULP_SAMPLER_BATCH_SIZE
+#define ULP_SAMPLER_BATCH_SIZE 32
+#endif
+
+// Default sampling period while the main cores sleep
+#ifndef ULP_SAMPLER_INTERVAL_MS
+#define ULP_SAMPLER_INTERVAL_MS 60000
+#endif
+
+// Default change from the reference sample that wakes the main cores
+#ifndef ULP_THRESHOLD_TEMPERATURE
+#define ULP_THRESHOLD_TEMPERATURE 0.5F  // °C
+#endif
+
+#ifndef ULP_THRESHOLD_HUMIDITY
+#define ULP_THRESHOLD_HUMIDITY 3.0F     // %RH
+#endif
+
+#ifndef ULP_THRESHOLD_PRESSURE
+#define ULP_THRESHOLD_PRESSURE 1.0F     // hPa
+#endif
+
+/**
+ * @brief One sample as read by the ULP
+ *
+ * The ULP works on 16-bit registers, so temperature and pressure keep the
+ * upper 16 of their 20 ADC bits (about 0.01 °C and 0.03 hPa resolution at
+ * room conditions); humidity is a full 16-bit ADC value.
+ */
+struct UlpRawSample {
+    uint16_t temperature;
+    uint16_t humidity;
+    uint16_t pressure;
+};
+
+/**
+ * @brief Wake thresholds in physical units
+ */
+struct UlpThresholds {
+    float temperature;  // °C
+    float humidity;     // %RH
+    float pressure;     // hPa
+};
+
+enum UlpWakeReason : uint8_t {
+    ULP_WAKE_NONE = 0,        // Not woken by the ULP
+    ULP_WAKE_THRESHOLD = 1,   // A channel moved past its threshold
+    ULP_WAKE_BATCH_FULL = 2   // ULP_SAMPLER_BATCH_SIZE samples are waiting
+};
+
+/**
+ * @brief BME280 sampling by the ULP coprocessor during deep sleep
+ *
+ * start() loads a small ULP-FSM program that bit-bangs I2C on the sensor's
+ * RTC-capable pins, reads the data registers of the BME280 (left in normal
+ * mode with 1 s standby) on every ULP timer period and appends the sample to
+ * a batch in RTC memory. The main cores are only woken when a sample differs
+ * from the reference by more than a threshold, or when the batch is full.
+ * Thresholds are converted to raw ADC counts once on the main core using the
+ * sensor's calibration, so the ULP only compares integers.
+ *
+ * After the wake, the batch is available through getSample() until the next
+ * start().
+ */
+class UlpSampler {
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param bme Driver whose address and calibration the ULP samples with
+     */
+    explicit UlpSampler(BME280Driver& bme);
+
+    /**
+     * @brief Load and start the ULP program; call right before deep sleep
+     *
+     * The I2C controller must be released first, and VEXT must stay powered
+     * through the sleep.
+     *
+     * @param sda SDA pin (must be an RTC GPIO)
+     * @param scl SCL pin (must be an RTC GPIO)
+     * @param reference Sample the thresholds are measured from
+     * @param thresholds Wake thresholds
+     * @param intervalMs ULP sampling period
+     * @return true if the ULP is running and ULP wakeup is enabled
+     */
+    bool start(int sda, int scl, const BME280RawData& reference,
+               const UlpThresholds& thresholds, uint32_t intervalMs);
+
+    /**
+     * @brief Stop the ULP and hand the pins back to the digital I2C controller
+     *
+     * Collects the batch for getSample(). Safe to call when the ULP is not running.
+     */
+    void stop();
+
+    /**
+     * @brief Whether the ULP was sampling during the last sleep
+     */
+    bool wasActive() const;
+
+    /**
+     * @brief Why the ULP woke the main cores
+     */
+    UlpWakeReason getWakeReason() const { return wakeReason; }
+
+    /**
+     * @brief Number of samples collected by stop()
+     */
+    uint8_t getSampleCount() const { return count; }
+
+    /**
+     * @brief Raw sample from the collected batch, oldest first
+     */
+    const UlpRawSample& getRawSample(uint8_t index) const { return samples[index]; }
+
+    /**
+     * @brief Compensated sample from the collected batch, oldest first
+     *
+     * @return false if the index is out of range or the sample is invalid
+     */
+    bool getSample(uint8_t index, SensorReading& reading) const;
+
+    /**
+     * @brief Correct compensated samples with a per-device table (null disables)
+     */
+    void setCalibration(const SensorCalibration* calibration) { this->calibration = calibration; }
+
+    /**
+     * @brief Samples the ULP took since the counters were last reset
+     */
+    uint32_t getTotalSamples() const;
+
+    /**
+     * @brief Main-core wakes caused by the ULP since the counters were last reset
+     */
+    uint32_t getTotalWakes() const;
+
+    /**
+     * @brief Reset the sample and wake counters
+     */
+    void resetCounters();
+
+    /**
+     * @brief Expand a ULP sample into driver ADC values
+     */
+    static BME280RawData expand(const UlpRawSample& sample);
+
+    /**
+     * @brief Truncate driver ADC values to what the ULP reads
+     */
+    static UlpRawSample truncate(const BME280RawData& raw);
+
+    /**
+     * @brief Convert a physical threshold into ULP counts around a reference
+     *
+     * The compensation is linearised at the reference; the result is at
+     * least 1 and fits the ULP's signed 16-bit comparison.
+     *
+     * @param bme Driver holding the calibration
+     * @param reference Operating point
+     * @param channel Channel the threshold applies to
+     * @param delta Threshold in physical units (°C, %RH, hPa)
+     * @return uint16_t Threshold in ULP counts
+     */
+    static uint16_t thresholdCounts(const BME280Driver& bme, const BME280RawData& reference,
+                                    SensorChannel channel, float delta);
+
+private:
+    BME280Driver& bme;
+    const SensorCalibration* calibration;
+    UlpWakeReason wakeReason;
+    uint8_t count;
+    UlpRawSample samples[ULP_SAMPLER_BATCH_SIZE];
+};
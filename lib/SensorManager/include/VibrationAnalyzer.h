@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Samples per analysis block (power of two)
+#ifndef VIBRATION_FFT_SIZE
+#define VIBRATION_FFT_SIZE 1024
+#endif
+
+// Spectral peaks reported per block
+#ifndef VIBRATION_PEAKS
+#define VIBRATION_PEAKS 3
+#endif
+
+// Frequency bands with a separate energy
+#ifndef VIBRATION_BANDS
+#define VIBRATION_BANDS 4
+#endif
+
+// Bytes written by VibrationAnalyzer::encode()
+#define VIBRATION_PAYLOAD_SIZE (2 + 4 * VIBRATION_PEAKS + 2 * VIBRATION_BANDS)
+
+// esp-dsp uses the ESP32-S3 SIMD (and ESP32 ae32) FFT kernels when it is installed
+#if defined(ARDUINO) && defined(__has_include)
+#if __has_include(<esp_dsp.h>)
+#define VIBRATION_USE_ESP_DSP 1
+#endif
+#endif
+
+#ifndef VIBRATION_USE_ESP_DSP
+#define VIBRATION_USE_ESP_DSP 0
+#endif
+
+/**
+ * @brief A spectral peak
+ */
+struct VibrationPeak {
+    float frequency;  // Hz, interpolated between bins
+    float amplitude;  // Sine amplitude in the input units (e.g. g)
+};
+
+/**
+ * @brief Features extracted from one block; only these are uplinked
+ */
+struct VibrationFeatures {
+    float rms;                              // RMS with the mean removed
+    VibrationPeak peaks[VIBRATION_PEAKS];   // Strongest first
+    uint8_t peakCount;
+    float bandRms[VIBRATION_BANDS];         // RMS within each band
+};
+
+/**
+ * @brief Windowed FFT and feature extraction for vibration blocks
+ *
+ * analyze() removes the mean, applies a Hann window and runs a radix-2
+ * complex FFT over VIBRATION_FFT_SIZE samples, then derives the RMS, the
+ * strongest local maxima of the magnitude spectrum (frequency refined by
+ * parabolic interpolation) and the RMS in each band, scaled so the band
+ * energies add up to the total variance. The window, twiddle factors and
+ * work buffers live in the object; nothing is allocated per block.
+ *
+ * With esp-dsp available the FFT runs on its optimized kernels, otherwise
+ * on the portable scalar implementation also used on the host.
+ */
+class VibrationAnalyzer {
+public:
+    VibrationAnalyzer();
+
+    /**
+     * @brief Set the sample rate and the default bands
+     *
+     * Default band edges are 1, fs/160, fs/32, fs/8 and fs/2 Hz (20, 100,
+     * 400 and 1600 Hz at 3.2 kHz).
+     *
+     * @param sampleRateHz Rate the block was captured at
+     * @param unitsPerCount Scale from raw counts to output units (e.g. g per count)
+     * @return true if the FFT backend initialized
+     */
+    bool begin(float sampleRateHz, float unitsPerCount = 1.0F);
+
+    /**
+     * @brief Set the band edges in Hz
+     *
+     * @param edges VIBRATION_BANDS + 1 increasing frequencies
+     */
+    void setBands(const float* edges);
+
+    /**
+     * @brief Analyze one block of raw samples
+     *
+     * @param samples VIBRATION_FFT_SIZE raw ADC counts
+     * @param features Receives the features
+     */
+    void analyze(const int16_t* samples, VibrationFeatures& features);
+
+    /**
+     * @brief One-sided magnitude spectrum of the last block
+     *
+     * Bin k (0..VIBRATION_FFT_SIZE/2) is at k * getBinWidth() Hz; values are
+     * |X[k]| of the windowed block in output units, before amplitude scaling.
+     */
+    const float* getSpectrum() const { return magnitude; }
+
+    /**
+     * @brief Frequency resolution in Hz
+     */
+    float getBinWidth() const { return sampleRate / VIBRATION_FFT_SIZE; }
+
+    /**
+     * @brief In-place scalar radix-2 FFT on interleaved re/im data
+     *
+     * @param data 2 * VIBRATION_FFT_SIZE floats
+     */
+    void fftScalar(float* data) const;
+
+    /**
+     * @brief Pack features for an uplink
+     *
+     * Big-endian: RMS (mg), then per peak frequency (0.1 Hz) and amplitude
+     * (mg), then per band RMS (mg), all unsigned 16-bit and saturated.
+     * Assumes output units of g.
+     *
+     * @param features Features to pack
+     * @param buffer At least VIBRATION_PAYLOAD_SIZE bytes
+     * @return size_t Bytes written
+     */
+    static size_t encode(const VibrationFeatures& features, uint8_t* buffer);
+
+private:
+    float sampleRate;
+    float scale;
+    float bandEdges[VIBRATION_BANDS + 1];
+    float windowSum;      // Coherent gain: amplitude = 2 |X| / windowSum
+    float windowSquares;  // Power gain: variance = sum of 2 |X|^2 / (N * windowSquares)
+    bool fftReady;
+
+    float window[VIBRATION_FFT_SIZE];
+    float twiddle[VIBRATION_FFT_SIZE];  // cos/sin pairs for k < N/2
+    alignas(16) float work[2 * VIBRATION_FFT_SIZE];  // esp-dsp S3 kernels need 16-byte alignment
+    float magnitude[VIBRATION_FFT_SIZE / 2 + 1];
+
+    void fft(float* data);
+    void findPeaks(VibrationFeatures& features) const;
+};
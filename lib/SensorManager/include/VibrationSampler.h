@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+#include "VibrationAnalyzer.h"
+
+// Conversion rate of the vibration channel (ESP32-S3: 611 Hz to 83 kHz)
+#ifndef VIBRATION_SAMPLE_RATE_HZ
+#define VIBRATION_SAMPLE_RATE_HZ 3200
+#endif
+
+// Conversions per DMA interrupt
+#ifndef VIBRATION_DMA_FRAME
+#define VIBRATION_DMA_FRAME 256
+#endif
+
+/**
+ * @brief Block capture from one ADC1 channel over DMA
+ *
+ * The ADC runs in continuous mode and the DMA fills the driver's pool, which
+ * holds two blocks. capture() drains one block into the back buffer and
+ * swaps it to the front. Between begin() and end(), consecutive capture()
+ * calls join without a gap as long as the analysis is faster than one block
+ * period; blocks that lost samples to a full pool are counted as overruns.
+ * The firmware captures a single block per uplink and stops the ADC again
+ * for the battery reads, so its blocks are snapshots, not a continuous
+ * record.
+ */
+class VibrationSampler {
+public:
+    VibrationSampler();
+
+    /**
+     * @brief Configure the channel and start the conversions
+     *
+     * @param adcPin Pin with an ADC1 channel, e.g. an analog accelerometer axis
+     * @param sampleRateHz Conversion rate
+     * @return true if continuous mode started
+     */
+    bool begin(int adcPin, uint32_t sampleRateHz = VIBRATION_SAMPLE_RATE_HZ);
+
+    /**
+     * @brief Stop the conversions and release the ADC for one-shot reads
+     */
+    void end();
+
+    /**
+     * @brief Fill the next block and make it the front buffer
+     *
+     * @param timeoutMs Longest wait for the block
+     * @return const int16_t* VIBRATION_FFT_SIZE raw counts, or NULL on timeout
+     */
+    const int16_t* capture(uint32_t timeoutMs);
+
+    /**
+     * @brief The block returned by the last capture()
+     */
+    const int16_t* getFront() const { return blocks[front]; }
+
+    uint32_t getSampleRate() const { return sampleRate; }
+    uint32_t getBlocks() const { return blockCount; }
+    uint32_t getOverruns() const { return overruns; }
+    bool isRunning() const { return running; }
+
+private:
+    int16_t blocks[2][VIBRATION_FFT_SIZE];
+    uint8_t front;
+    int8_t channel;
+    uint32_t sampleRate;
+    uint32_t blockCount;
+    uint32_t overruns;
+    bool running;
+};
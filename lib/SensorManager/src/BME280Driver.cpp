@@ -0,0 +1,196 @@
+#include "BME280Driver.h"
+#include <string.h>
+
+// Bounds the wait for the NVM copy after a soft reset (one status read each)
+#define BME280_RESET_POLL_LIMIT 50
+
+BME280Driver::BME280Driver(I2CEngine& engine) :
+    engine(engine),
+    address(0),
+    ctrlMeas(0) {
+    memset(&calib, 0, sizeof(calib));
+}
+
+bool BME280Driver::begin(uint8_t address) {
+    this->address = address;
+
+    uint8_t chipId = 0;
+    if (engine.readRegisters(address, BME280_REG_CHIP_ID, &chipId, 1) != I2C_OK ||
+        chipId != BME280_CHIP_ID) {
+        return false;
+    }
+
+    if (engine.writeRegister(address, BME280_REG_RESET, BME280_RESET_COMMAND) != I2C_OK) {
+        return false;
+    }
+
+    // Wait for the trim values to be copied from NVM (status bit 0).
+    // The sensor may NACK while it restarts, so failed reads just retry.
+    bool ready = false;
+    for (int i = 0; i < BME280_RESET_POLL_LIMIT && !ready; i++) {
+        uint8_t status = 0;
+        ready = readStatus(status) && (status & 0x01) == 0;
+    }
+    if (!ready) {
+        return false;
+    }
+
+    return readCalibration();
+}
+
+void BME280Driver::restore(uint8_t address, const BME280Calibration& calibration) {
+    this->address = address;
+    calib = calibration;
+}
+
+bool BME280Driver::readStatus(uint8_t& status) {
+    return engine.readRegisters(address, BME280_REG_STATUS, &status, 1) == I2C_OK;
+}
+
+bool BME280Driver::readCalibration() {
+    uint8_t tp[BME280_CALIB_TP_LEN];
+    uint8_t h[BME280_CALIB_H_LEN];
+
+    if (engine.readRegisters(address, BME280_REG_CALIB_TP, tp, sizeof(tp)) != I2C_OK ||
+        engine.readRegisters(address, BME280_REG_CALIB_H, h, sizeof(h)) != I2C_OK) {
+        return false;
+    }
+
+    parseCalibration(tp, h, calib);
+    return true;
+}
+
+void BME280Driver::parseCalibration(const uint8_t* tp, const uint8_t* h, BME280Calibration& calib) {
+    calib.dig_T1 = (uint16_t)(tp[1] << 8 | tp[0]);
+    calib.dig_T2 = (int16_t)(tp[3] << 8 | tp[2]);
+    calib.dig_T3 = (int16_t)(tp[5] << 8 | tp[4]);
+    calib.dig_P1 = (uint16_t)(tp[7] << 8 | tp[6]);
+    calib.dig_P2 = (int16_t)(tp[9] << 8 | tp[8]);
+    calib.dig_P3 = (int16_t)(tp[11] << 8 | tp[10]);
+    calib.dig_P4 = (int16_t)(tp[13] << 8 | tp[12]);
+    calib.dig_P5 = (int16_t)(tp[15] << 8 | tp[14]);
+    calib.dig_P6 = (int16_t)(tp[17] << 8 | tp[16]);
+    calib.dig_P7 = (int16_t)(tp[19] << 8 | tp[18]);
+    calib.dig_P8 = (int16_t)(tp[21] << 8 | tp[20]);
+    calib.dig_P9 = (int16_t)(tp[23] << 8 | tp[22]);
+    // tp[24] (0xA0) is unused
+    calib.dig_H1 = tp[25];
+
+    calib.dig_H2 = (int16_t)(h[1] << 8 | h[0]);
+    calib.dig_H3 = h[2];
+    calib.dig_H4 = (int16_t)(((int8_t)h[3] * 16) | (h[4] & 0x0F));
+    calib.dig_H5 = (int16_t)(((int8_t)h[5] * 16) | (h[4] >> 4));
+    calib.dig_H6 = (int8_t)h[6];
+}
+
+bool BME280Driver::setSampling(sensor_mode mode, sensor_sampling tempSampling,
+                               sensor_sampling pressSampling, sensor_sampling humSampling,
+                               sensor_filter filter, standby_duration standby) {
+    ctrlMeas = (uint8_t)((tempSampling << 5) | (pressSampling << 2));
+    uint8_t config = (uint8_t)((standby << 5) | (filter << 2));
+
+    // Writes to config are ignored in normal mode, so go to sleep first.
+    // ctrl_hum only takes effect after the following ctrl_meas write.
+    return engine.writeRegister(address, BME280_REG_CTRL_MEAS, MODE_SLEEP) == I2C_OK &&
+           engine.writeRegister(address, BME280_REG_CTRL_HUM, humSampling) == I2C_OK &&
+           engine.writeRegister(address, BME280_REG_CONFIG, config) == I2C_OK &&
+           engine.writeRegister(address, BME280_REG_CTRL_MEAS, ctrlMeas | mode) == I2C_OK;
+}
+
+bool BME280Driver::hasSampling(sensor_mode mode, sensor_sampling tempSampling,
+                               sensor_sampling pressSampling, sensor_sampling humSampling,
+                               sensor_filter filter, standby_duration standby) {
+    // ctrl_hum, status, ctrl_meas, config
+    uint8_t regs[4];
+    if (engine.readRegisters(address, BME280_REG_CTRL_HUM, regs, sizeof(regs)) != I2C_OK) {
+        return false;
+    }
+
+    uint8_t oversampling = (uint8_t)((tempSampling << 5) | (pressSampling << 2));
+    uint8_t config = (uint8_t)((standby << 5) | (filter << 2));
+    bool normal = (regs[2] & 0x03) == MODE_NORMAL;
+    if ((regs[0] & 0x07) != humSampling || (regs[2] & 0xFC) != oversampling ||
+        (regs[3] & 0xFC) != config || normal != (mode == MODE_NORMAL)) {
+        return false;
+    }
+
+    ctrlMeas = oversampling;
+    return true;
+}
+
+bool BME280Driver::startForced() {
+    return engine.writeRegister(address, BME280_REG_CTRL_MEAS, ctrlMeas | MODE_FORCED) == I2C_OK;
+}
+
+bool BME280Driver::queueStartForced(I2CCallback callback, void* context) {
+    uint8_t value = ctrlMeas | MODE_FORCED;
+    return engine.queueWrite(address, BME280_REG_CTRL_MEAS, &value, 1, callback, context);
+}
+
+bool BME280Driver::readRaw(BME280RawData& raw) {
+    uint8_t burst[BME280_BURST_LEN];
+    if (engine.readRegisters(address, BME280_REG_DATA, burst, sizeof(burst)) != I2C_OK) {
+        return false;
+    }
+    raw = decodeRaw(burst);
+    return true;
+}
+
+bool BME280Driver::queueRawRead(uint8_t* burst, I2CCallback callback, void* context) {
+    return engine.queueRead(address, BME280_REG_DATA, burst, BME280_BURST_LEN, callback, context);
+}
+
+BME280RawData BME280Driver::decodeRaw(const uint8_t* burst) {
+    BME280RawData raw;
+    raw.adcP = (int32_t)(((uint32_t)burst[0] << 12) | ((uint32_t)burst[1] << 4) | (burst[2] >> 4));
+    raw.adcT = (int32_t)(((uint32_t)burst[3] << 12) | ((uint32_t)burst[4] << 4) | (burst[5] >> 4));
+    raw.adcH = (int32_t)(((uint32_t)burst[6] << 8) | burst[7]);
+    return raw;
+}
+
+bool BME280Driver::compensate(const BME280RawData& raw, BME280Sample& sample) const {
+    // Skipped channels read back as 0x80000 (T/P) and 0x8000 (H)
+    if (raw.adcT == 0x80000 || raw.adcP == 0x80000 || raw.adcH == 0x8000) {
+        return false;
+    }
+
+    // Temperature (datasheet 4.2.3, BME280_compensate_T_int32)
+    int32_t var1 = ((((raw.adcT >> 3) - ((int32_t)calib.dig_T1 << 1))) *
+                    ((int32_t)calib.dig_T2)) >> 11;
+    int32_t var2 = (((((raw.adcT >> 4) - ((int32_t)calib.dig_T1)) *
+                      ((raw.adcT >> 4) - ((int32_t)calib.dig_T1))) >> 12) *
+                    ((int32_t)calib.dig_T3)) >> 14;
+    int32_t tFine = var1 + var2;
+    sample.temperature = (tFine * 5 + 128) >> 8;
+
+    // Pressure (BME280_compensate_P_int64)
+    int64_t p1 = ((int64_t)tFine) - 128000;
+    int64_t p2 = p1 * p1 * (int64_t)calib.dig_P6;
+    p2 = p2 + ((p1 * (int64_t)calib.dig_P5) << 17);
+    p2 = p2 + (((int64_t)calib.dig_P4) << 35);
+    p1 = ((p1 * p1 * (int64_t)calib.dig_P3) >> 8) + ((p1 * (int64_t)calib.dig_P2) << 12);
+    p1 = (((((int64_t)1) << 47) + p1)) * ((int64_t)calib.dig_P1) >> 33;
+    if (p1 == 0) {
+        return false; // Avoid division by zero (uncalibrated sensor)
+    }
+    int64_t p = 1048576 - raw.adcP;
+    p = (((p << 31) - p2) * 3125) / p1;
+    p1 = (((int64_t)calib.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    p2 = (((int64_t)calib.dig_P8) * p) >> 19;
+    p = ((p + p1 + p2) >> 8) + (((int64_t)calib.dig_P7) << 4);
+    sample.pressure = (uint32_t)p;
+
+    // Humidity (bme280_compensate_H_int32)
+    int32_t h = tFine - ((int32_t)76800);
+    h = (((((raw.adcH << 14) - (((int32_t)calib.dig_H4) << 20) - (((int32_t)calib.dig_H5) * h)) +
+           ((int32_t)16384)) >> 15) *
+         (((((((h * ((int32_t)calib.dig_H6)) >> 10) *
+              (((h * ((int32_t)calib.dig_H3)) >> 11) + ((int32_t)32768))) >> 10) +
+            ((int32_t)2097152)) * ((int32_t)calib.dig_H2) + 8192) >> 14));
+    h = (h - (((((h >> 15) * (h >> 15)) >> 7) * ((int32_t)calib.dig_H1)) >> 4));
+    h = (h < 0 ? 0 : h);
+    h = (h > 419430400 ? 419430400 : h);
+    sample.humidity = (uint32_t)(h >> 12);
+
+    return true;
+}
@@ -0,0 +1,217 @@
+#include "BatteryMonitor.h"
+#include <string.h>
+
+// Resting single-cell LiPo discharge curve (mV -> %), linear in between
+struct SocPoint {
+    uint16_t millivolts;
+    uint8_t percent;
+};
+
+static const SocPoint SOC_CURVE[] = {
+    { 3270, 0 },
+    { 3610, 5 },
+    { 3690, 10 },
+    { 3730, 20 },
+    { 3770, 30 },
+    { 3800, 40 },
+    { 3840, 50 },
+    { 3870, 60 },
+    { 3950, 70 },
+    { 4020, 80 },
+    { 4110, 90 },
+    { 4200, 100 }
+};
+
+static const uint8_t SOC_POINTS = sizeof(SOC_CURVE) / sizeof(SOC_CURVE[0]);
+
+BatteryMonitor::BatteryMonitor() :
+    adcPin(-1),
+    ctrlPin(-1),
+    ctrlActiveHigh(true),
+    channel(-1),
+    sum(0),
+    count(0),
+    next(0),
+    loadedMv(0),
+    pendingLoadMv(0),
+    loadTimer(nullptr) {
+    memset(window, 0, sizeof(window));
+}
+
+void BatteryMonitor::addSample(uint16_t millivolts) {
+    // O(1) running sum over a fixed ring
+    if (count == BATTERY_AVERAGE_WINDOW) {
+        sum -= window[next];
+    } else {
+        count++;
+    }
+    window[next] = millivolts;
+    sum += millivolts;
+    next = (next + 1) % BATTERY_AVERAGE_WINDOW;
+}
+
+uint16_t BatteryMonitor::getMillivolts() const {
+    return count > 0 ? (uint16_t)((sum + count / 2) / count) : 0;
+}
+
+bool BatteryMonitor::endLoadSample(bool transmitted) {
+    stopLoadTimer();
+    uint16_t millivolts = pendingLoadMv;
+    pendingLoadMv = 0;
+    if (!transmitted || millivolts == 0) {
+        return false;
+    }
+    loadedMv = millivolts;
+    return isPresent();
+}
+
+uint16_t BatteryMonitor::getSagMillivolts() const {
+    uint16_t rest = getMillivolts();
+    return (loadedMv > 0 && loadedMv < rest) ? rest - loadedMv : 0;
+}
+
+uint8_t BatteryMonitor::getStateOfCharge() const {
+    return isPresent() ? estimateStateOfCharge(getMillivolts()) : BATTERY_SOC_UNKNOWN;
+}
+
+bool BatteryMonitor::isLow() const {
+    return isPresent() && getStateOfCharge() < BATTERY_LOW_SOC;
+}
+
+bool BatteryMonitor::isCritical() const {
+    if (!isPresent()) return false;
+    return getStateOfCharge() < BATTERY_CRITICAL_SOC ||
+           (loadedMv > 0 && loadedMv < BATTERY_CRITICAL_LOADED_MV);
+}
+
+uint8_t BatteryMonitor::estimateStateOfCharge(uint16_t millivolts) {
+    if (millivolts <= SOC_CURVE[0].millivolts) return 0;
+    if (millivolts >= SOC_CURVE[SOC_POINTS - 1].millivolts) return 100;
+
+    uint8_t i = 1;
+    while (SOC_CURVE[i].millivolts < millivolts) {
+        i++;
+    }
+
+    const SocPoint& lo = SOC_CURVE[i - 1];
+    const SocPoint& hi = SOC_CURVE[i];
+    uint32_t span = hi.millivolts - lo.millivolts;
+    uint32_t offset = millivolts - lo.millivolts;
+    return (uint8_t)(lo.percent + ((hi.percent - lo.percent) * offset + span / 2) / span);
+}
+
+// ADC access; host builds only get the averaging and SoC model above
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <driver/adc.h>
+#include <esp_adc_cal.h>
+#include <esp_timer.h>
+
+static esp_adc_cal_characteristics_t adcCharacteristics;
+
+// The divider output stays below 0.9 V, so 2.5 dB keeps the ADC in its most linear range
+#define BATTERY_ADC_ATTEN ADC_ATTEN_DB_2_5
+
+bool BatteryMonitor::begin(int adcPin, int ctrlPin, bool ctrlActiveHigh) {
+    this->adcPin = adcPin;
+    this->ctrlPin = ctrlPin;
+    this->ctrlActiveHigh = ctrlActiveHigh;
+
+    channel = digitalPinToAnalogChannel(adcPin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX) {
+        channel = -1;
+        return false;
+    }
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten((adc1_channel_t)channel, BATTERY_ADC_ATTEN);
+    esp_adc_cal_characterize(ADC_UNIT_1, BATTERY_ADC_ATTEN, ADC_WIDTH_BIT_12, 1100, &adcCharacteristics);
+
+    if (ctrlPin >= 0) {
+        pinMode(ctrlPin, OUTPUT);
+        setDivider(false); // Divider off between samples
+    }
+
+    if (!loadTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback = loadTimerCallback;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "battery_load";
+        esp_timer_handle_t timer = nullptr;
+        if (esp_timer_create(&args, &timer) == ESP_OK) {
+            loadTimer = timer;
+        }
+    }
+    return true;
+}
+
+void BatteryMonitor::setDivider(bool on) {
+    if (ctrlPin >= 0) {
+        digitalWrite(ctrlPin, on == ctrlActiveHigh ? HIGH : LOW);
+    }
+}
+
+uint16_t BatteryMonitor::measure() {
+    if (channel < 0) return 0;
+
+    setDivider(true);
+    if (ctrlPin >= 0) {
+        delay(BATTERY_SETTLE_MS);
+    }
+    uint16_t millivolts = readMillivolts();
+    setDivider(false);
+    return millivolts;
+}
+
+uint16_t BatteryMonitor::readMillivolts() {
+    // Average the raw codes first, then run the calibration curve once
+    uint32_t raw = 0;
+    for (int i = 0; i < BATTERY_OVERSAMPLING; i++) {
+        raw += adc1_get_raw((adc1_channel_t)channel);
+    }
+
+    uint32_t pinMv = esp_adc_cal_raw_to_voltage((raw + BATTERY_OVERSAMPLING / 2) / BATTERY_OVERSAMPLING,
+                                                &adcCharacteristics);
+    return (uint16_t)(pinMv * BATTERY_DIVIDER_RATIO * BATTERY_CALIBRATION_FACTOR + 0.5f);
+}
+
+bool BatteryMonitor::sample() {
+    addSample(measure());
+    return isPresent();
+}
+
+bool BatteryMonitor::beginLoadSample() {
+    if (channel < 0 || !loadTimer) return false;
+
+    // The settle time passes while the stack builds the frame
+    pendingLoadMv = 0;
+    setDivider(true);
+    if (esp_timer_start_once((esp_timer_handle_t)loadTimer, BATTERY_LOAD_SAMPLE_DELAY_MS * 1000ULL) != ESP_OK) {
+        setDivider(false);
+        return false;
+    }
+    return true;
+}
+
+void BatteryMonitor::loadTimerCallback(void* arg) {
+    // esp_timer task: the radio is transmitting
+    BatteryMonitor* monitor = static_cast<BatteryMonitor*>(arg);
+    monitor->addLoadSample(monitor->readMillivolts());
+    monitor->setDivider(false);
+}
+
+void BatteryMonitor::stopLoadTimer() {
+    if (loadTimer) {
+        esp_timer_stop((esp_timer_handle_t)loadTimer);
+    }
+    setDivider(false);
+}
+
+#else
+
+void BatteryMonitor::stopLoadTimer() {
+}
+
+#endif // ARDUINO
@@ -0,0 +1,87 @@
+#include "Esp32I2CBus.h"
+
+#if defined(ESP_PLATFORM)
+
+#include <freertos/FreeRTOS.h>
+
+Esp32I2CBus::Esp32I2CBus(i2c_port_t port) :
+    port(port),
+    installed(false),
+    frequency(0) {
+}
+
+bool Esp32I2CBus::begin(int sda, int scl, uint32_t frequency) {
+    // Start from a clean controller state (also releases a driver left
+    // behind by TwoWire on the same port)
+    end();
+    i2c_driver_delete(port);
+
+    i2c_config_t config = {};
+    config.mode = I2C_MODE_MASTER;
+    config.sda_io_num = sda;
+    config.scl_io_num = scl;
+    config.sda_pullup_en = GPIO_PULLUP_ENABLE;
+    config.scl_pullup_en = GPIO_PULLUP_ENABLE;
+    config.master.clk_speed = frequency;
+
+    if (i2c_param_config(port, &config) != ESP_OK) {
+        return false;
+    }
+    if (i2c_driver_install(port, I2C_MODE_MASTER, 0, 0, 0) != ESP_OK) {
+        return false;
+    }
+
+    installed = true;
+    this->frequency = frequency;
+    return true;
+}
+
+void Esp32I2CBus::end() {
+    if (installed) {
+        i2c_driver_delete(port);
+        installed = false;
+    }
+}
+
+I2CStatus Esp32I2CBus::transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                                uint8_t* rx, size_t rxLen, uint32_t timeoutMs) {
+    if (!installed) return I2C_ERR_OTHER;
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(cmdBuffer, sizeof(cmdBuffer));
+    if (cmd == NULL) return I2C_ERR_OTHER;
+
+    // Write phase (also used on its own as an address probe)
+    if (txLen > 0 || rxLen == 0) {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
+        if (txLen > 0) {
+            i2c_master_write(cmd, tx, txLen, true);
+        }
+    }
+
+    // Read phase with repeated start
+    if (rxLen > 0) {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_READ, true);
+        i2c_master_read(cmd, rx, rxLen, I2C_MASTER_LAST_NACK);
+    }
+    i2c_master_stop(cmd);
+
+    // Blocks this task on the controller's completion interrupt
+    esp_err_t err = i2c_master_cmd_begin(port, cmd, pdMS_TO_TICKS(timeoutMs));
+    i2c_cmd_link_delete_static(cmd);
+
+    switch (err) {
+        case ESP_OK:
+            return I2C_OK;
+        case ESP_FAIL:
+            // The driver reports any missing ACK this way
+            return I2C_ERR_NACK_ADDR;
+        case ESP_ERR_TIMEOUT:
+            return I2C_ERR_TIMEOUT;
+        default:
+            return I2C_ERR_OTHER;
+    }
+}
+
+#endif // ESP_PLATFORM
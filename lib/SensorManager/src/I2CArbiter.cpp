@@ -0,0 +1,95 @@
+#include "I2CArbiter.h"
+#include "I2CEngine.h"
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
+I2CArbiter::I2CArbiter(I2CBus& bus) :
+    bus(bus),
+    mutex(nullptr),
+    users(0),
+    depth(0) {
+    memset(&stats, 0, sizeof(stats));
+#if defined(ESP_PLATFORM)
+    mutex = xSemaphoreCreateRecursiveMutex();
+#endif
+}
+
+I2CArbiter::~I2CArbiter() {
+#if defined(ESP_PLATFORM)
+    if (mutex) vSemaphoreDelete((SemaphoreHandle_t)mutex);
+#endif
+}
+
+bool I2CArbiter::acquire(uint32_t timeoutMs) {
+#if defined(ESP_PLATFORM)
+    if (!mutex) return false;
+
+    SemaphoreHandle_t handle = (SemaphoreHandle_t)mutex;
+    if (xSemaphoreTakeRecursive(handle, 0) == pdTRUE) {
+        return true;
+    }
+
+    // Another task is mid-transfer or mid-frame
+    stats.contended++;
+    uint32_t start = I2CEngine::nowUs();
+    if (xSemaphoreTakeRecursive(handle, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) {
+        stats.timeouts++;
+        return false;
+    }
+    uint32_t waited = I2CEngine::nowUs() - start;
+    if (waited > stats.maxWaitUs) stats.maxWaitUs = waited;
+    return true;
+#else
+    (void)timeoutMs;
+    depth++;
+    return true;
+#endif
+}
+
+void I2CArbiter::release() {
+#if defined(ESP_PLATFORM)
+    if (mutex) xSemaphoreGiveRecursive((SemaphoreHandle_t)mutex);
+#else
+    if (depth > 0) depth--;
+#endif
+}
+
+bool I2CArbiter::begin(int sda, int scl, uint32_t frequency) {
+    if (!acquire()) return false;
+
+    bool ready = true;
+    if (users == 0) {
+        ready = bus.begin(sda, scl, frequency);
+    }
+    if (ready) users++;
+
+    release();
+    return ready;
+}
+
+void I2CArbiter::end() {
+    if (!acquire()) return;
+
+    if (users > 0 && --users == 0) {
+        bus.end();
+    }
+
+    release();
+}
+
+I2CStatus I2CArbiter::transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                               uint8_t* rx, size_t rxLen, uint32_t timeoutMs) {
+    if (!acquire(timeoutMs + I2C_ARBITER_TIMEOUT_MS)) {
+        return I2C_ERR_TIMEOUT;
+    }
+
+    stats.transfers++;
+    I2CStatus status = bus.transfer(address, tx, txLen, rx, rxLen, timeoutMs);
+
+    release();
+    return status;
+}
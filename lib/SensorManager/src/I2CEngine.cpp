@@ -0,0 +1,352 @@
+#include "I2CEngine.h"
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <esp_timer.h>
+
+static uint32_t defaultClock() {
+    return (uint32_t)esp_timer_get_time();
+}
+#else
+#include <chrono>
+
+static uint32_t defaultClock() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+uint32_t (*I2CEngine::clock)() = defaultClock;
+
+I2CEngine::I2CEngine(I2CBus* bus) :
+    bus(bus),
+    monitor(nullptr),
+    head(0),
+    count(0),
+    workerHandle(nullptr),
+    lock(nullptr) {
+    memset(queue, 0, sizeof(queue));
+    resetStats();
+}
+
+I2CEngine::~I2CEngine() {
+#if defined(ESP_PLATFORM)
+    if (workerHandle) vTaskDelete((TaskHandle_t)workerHandle);
+    if (lock) vSemaphoreDelete((SemaphoreHandle_t)lock);
+#endif
+}
+
+// One synchronous call; lives on the caller's stack, and the engine only
+// touches it while the call's transaction is queued or running
+struct I2CSyncCall {
+    volatile I2CStatus status;
+#if defined(ESP_PLATFORM)
+    StaticSemaphore_t storage;
+    SemaphoreHandle_t done;
+#endif
+};
+
+void I2CEngine::resetStats() {
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreTake((SemaphoreHandle_t)lock, portMAX_DELAY);
+#endif
+
+    memset(&stats, 0, sizeof(stats));
+    stats.windowStartUs = clock();
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreGive((SemaphoreHandle_t)lock);
+#endif
+}
+
+I2CEngineStats I2CEngine::getStats() const {
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreTake((SemaphoreHandle_t)lock, portMAX_DELAY);
+#endif
+
+    I2CEngineStats copy = stats;
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreGive((SemaphoreHandle_t)lock);
+#endif
+
+    return copy;
+}
+
+uint8_t I2CEngine::pending() const {
+    return count;
+}
+
+bool I2CEngine::enqueue(const I2CTransaction* txns, uint8_t n) {
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreTake((SemaphoreHandle_t)lock, portMAX_DELAY);
+#endif
+
+    bool accepted = (uint8_t)(count + n) <= QUEUE_DEPTH && n <= QUEUE_DEPTH;
+    if (accepted) {
+        uint32_t now = clock();
+        for (uint8_t i = 0; i < n; i++) {
+            I2CTransaction& slot = queue[(head + count) % QUEUE_DEPTH];
+            slot = txns[i];
+            slot.status = I2C_OK;
+            slot.queuedUs = now;
+            slot.startUs = 0;
+            slot.doneUs = 0;
+            count++;
+        }
+    } else {
+        stats.rejected += n;
+    }
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreGive((SemaphoreHandle_t)lock);
+    if (accepted && workerHandle) xTaskNotifyGive((TaskHandle_t)workerHandle);
+#endif
+
+    return accepted;
+}
+
+bool I2CEngine::dequeue(I2CTransaction& txn) {
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreTake((SemaphoreHandle_t)lock, portMAX_DELAY);
+#endif
+
+    bool available = count > 0;
+    if (available) {
+        txn = queue[head];
+        head = (head + 1) % QUEUE_DEPTH;
+        count--;
+    }
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreGive((SemaphoreHandle_t)lock);
+#endif
+
+    return available;
+}
+
+bool I2CEngine::cancel(const void* context) {
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreTake((SemaphoreHandle_t)lock, portMAX_DELAY);
+#endif
+
+    bool removed = false;
+    for (uint8_t i = 0; i < count && !removed; i++) {
+        if (queue[(head + i) % QUEUE_DEPTH].context != context) continue;
+
+        // Close the gap so the remaining transactions keep their order
+        for (uint8_t j = i; j + 1 < count; j++) {
+            queue[(head + j) % QUEUE_DEPTH] = queue[(head + j + 1) % QUEUE_DEPTH];
+        }
+        count--;
+        removed = true;
+    }
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreGive((SemaphoreHandle_t)lock);
+#endif
+
+    return removed;
+}
+
+void I2CEngine::execute(I2CTransaction& txn) {
+    txn.startUs = clock();
+    if (bus) {
+        txn.status = bus->transfer(txn.address, txn.tx, txn.txLen, txn.rx, txn.rxLen,
+                                   I2C_ENGINE_TIMEOUT_MS);
+    } else {
+        txn.status = I2C_ERR_OTHER;
+    }
+    txn.doneUs = clock();
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreTake((SemaphoreHandle_t)lock, portMAX_DELAY);
+#endif
+
+    uint32_t latency = txn.doneUs - txn.queuedUs;
+    stats.busyUs += txn.doneUs - txn.startUs;
+    stats.totalLatencyUs += latency;
+    if (latency > stats.maxLatencyUs) stats.maxLatencyUs = latency;
+    if (txn.status == I2C_OK) {
+        stats.completed++;
+        stats.bytes += txn.txLen + txn.rxLen;
+    } else {
+        stats.failed++;
+    }
+
+#if defined(ESP_PLATFORM)
+    if (lock) xSemaphoreGive((SemaphoreHandle_t)lock);
+#endif
+
+    if (monitor) {
+        monitor->record(txn.address, txn.status);
+    }
+
+    if (txn.callback) {
+        txn.callback(txn, txn.context);
+    }
+}
+
+bool I2CEngine::submit(const I2CTransaction& txn) {
+    return enqueue(&txn, 1);
+}
+
+bool I2CEngine::submitBatch(const I2CTransaction* txns, uint8_t count) {
+    return enqueue(txns, count);
+}
+
+bool I2CEngine::queueRead(uint8_t address, uint8_t reg, uint8_t* rx, uint8_t len,
+                          I2CCallback callback, void* context) {
+    I2CTransaction txn;
+    memset(&txn, 0, sizeof(txn));
+    txn.address = address;
+    txn.tx[0] = reg;
+    txn.txLen = 1;
+    txn.rx = rx;
+    txn.rxLen = len;
+    txn.callback = callback;
+    txn.context = context;
+    return submit(txn);
+}
+
+bool I2CEngine::queueWrite(uint8_t address, uint8_t reg, const uint8_t* data, uint8_t len,
+                           I2CCallback callback, void* context) {
+    if (len > I2C_ENGINE_MAX_WRITE - 1) return false;
+
+    I2CTransaction txn;
+    memset(&txn, 0, sizeof(txn));
+    txn.address = address;
+    txn.tx[0] = reg;
+    if (len > 0) memcpy(&txn.tx[1], data, len);
+    txn.txLen = len + 1;
+    txn.callback = callback;
+    txn.context = context;
+    return submit(txn);
+}
+
+uint8_t I2CEngine::poll(uint8_t maxTransactions) {
+    if (workerHandle) return 0; // The worker owns the queue
+
+    uint8_t executed = 0;
+    I2CTransaction txn;
+    while (executed < maxTransactions && dequeue(txn)) {
+        execute(txn);
+        executed++;
+    }
+    return executed;
+}
+
+void I2CEngine::syncCallback(const I2CTransaction& txn, void* context) {
+    I2CSyncCall* call = static_cast<I2CSyncCall*>(context);
+    call->status = txn.status;
+#if defined(ESP_PLATFORM)
+    if (call->done) xSemaphoreGive(call->done);
+#endif
+}
+
+I2CStatus I2CEngine::runSync(I2CTransaction& txn) {
+    I2CSyncCall call;
+    call.status = I2C_OK;
+    txn.callback = syncCallback;
+    txn.context = &call;
+
+#if defined(ESP_PLATFORM)
+    if (workerHandle) {
+        // Each call waits on its own semaphore, so a late completion can
+        // never be taken by the next caller
+        call.done = xSemaphoreCreateBinaryStatic(&call.storage);
+        if (!submit(txn)) return I2C_ERR_OTHER;
+
+        // Allow for everything queued ahead of us plus our own transaction
+        TickType_t limit = pdMS_TO_TICKS(I2C_ENGINE_TIMEOUT_MS * (QUEUE_DEPTH + 1));
+        if (xSemaphoreTake(call.done, limit) == pdTRUE) {
+            return call.status;
+        }
+
+        // rx and call are on our stack: take the transaction back, or let
+        // the worker finish it (the bus driver times out on its own)
+        if (cancel(&call)) return I2C_ERR_TIMEOUT;
+        xSemaphoreTake(call.done, portMAX_DELAY);
+        return call.status;
+    }
+    call.done = nullptr;
+#endif
+
+    // No worker: drain earlier work to keep ordering, then run inline
+    poll();
+    txn.queuedUs = clock();
+    execute(txn);
+    return call.status;
+}
+
+I2CStatus I2CEngine::readRegisters(uint8_t address, uint8_t reg, uint8_t* rx, uint8_t len) {
+    I2CTransaction txn;
+    memset(&txn, 0, sizeof(txn));
+    txn.address = address;
+    txn.tx[0] = reg;
+    txn.txLen = 1;
+    txn.rx = rx;
+    txn.rxLen = len;
+    return runSync(txn);
+}
+
+I2CStatus I2CEngine::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+    I2CTransaction txn;
+    memset(&txn, 0, sizeof(txn));
+    txn.address = address;
+    txn.tx[0] = reg;
+    txn.tx[1] = value;
+    txn.txLen = 2;
+    return runSync(txn);
+}
+
+I2CStatus I2CEngine::probe(uint8_t address) {
+    I2CTransaction txn;
+    memset(&txn, 0, sizeof(txn));
+    txn.address = address;
+    return runSync(txn);
+}
+
+void I2CEngine::workerTask(void* param) {
+#if defined(ESP_PLATFORM)
+    I2CEngine* engine = static_cast<I2CEngine*>(param);
+    I2CTransaction txn;
+    for (;;) {
+        // Sleep until something is queued; the bus driver blocks on its own
+        // completion interrupt while the peripheral runs the command list
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (engine->dequeue(txn)) {
+            engine->execute(txn);
+        }
+    }
+#else
+    (void)param;
+#endif
+}
+
+bool I2CEngine::startWorker(uint8_t priority, int core) {
+#if defined(ESP_PLATFORM)
+    if (workerHandle) return true;
+
+    lock = xSemaphoreCreateMutex();
+    if (!lock) return false;
+
+    TaskHandle_t handle = nullptr;
+    if (xTaskCreatePinnedToCore(workerTask, "i2c_engine", 3072, this, priority,
+                                &handle, core) != pdPASS) {
+        return false;
+    }
+    workerHandle = handle;
+
+    // Pick up anything queued before the worker existed
+    if (count > 0) xTaskNotifyGive(handle);
+    return true;
+#else
+    (void)priority;
+    (void)core;
+    return false;
+#endif
+}
@@ -0,0 +1,132 @@
+#include "I2CHealth.h"
+#include <string.h>
+
+I2CHealthMonitor::I2CHealthMonitor() {
+    reset();
+}
+
+void I2CHealthMonitor::reset() {
+    memset(&table, 0, sizeof(table));
+}
+
+void I2CHealthMonitor::restore(const I2CHealthTable& saved) {
+    table = saved;
+    if (table.deviceCount > I2C_HEALTH_MAX_DEVICES) {
+        reset();
+    }
+}
+
+I2CDeviceHealth* I2CHealthMonitor::find(uint8_t address) {
+    for (uint8_t i = 0; i < table.deviceCount; i++) {
+        if (table.devices[i].address == address) {
+            return &table.devices[i];
+        }
+    }
+    return nullptr;
+}
+
+const I2CDeviceHealth* I2CHealthMonitor::getDevice(uint8_t address) const {
+    return const_cast<I2CHealthMonitor*>(this)->find(address);
+}
+
+bool I2CHealthMonitor::watch(uint8_t address) {
+    if (find(address)) return true;
+    if (table.deviceCount >= I2C_HEALTH_MAX_DEVICES) return false;
+
+    I2CDeviceHealth& device = table.devices[table.deviceCount++];
+    memset(&device, 0, sizeof(device));
+    device.address = address;
+    return true;
+}
+
+void I2CHealthMonitor::record(uint8_t address, I2CStatus status) {
+    I2CDeviceHealth* device = find(address);
+    if (!device) return;
+
+    device->transfers++;
+    device->lastStatus = status;
+    if (status == I2C_OK) {
+        device->consecutiveFailures = 0;
+        return;
+    }
+
+    switch (status) {
+        case I2C_ERR_NACK_ADDR:
+        case I2C_ERR_NACK_DATA:
+            device->nacks++;
+            break;
+        case I2C_ERR_TIMEOUT:
+            device->timeouts++;
+            break;
+        default:
+            device->errors++;
+            break;
+    }
+
+    if (device->consecutiveFailures < UINT16_MAX) device->consecutiveFailures++;
+    if (device->consecutiveFailures > device->maxConsecutiveFailures) {
+        device->maxConsecutiveFailures = device->consecutiveFailures;
+    }
+}
+
+void I2CHealthMonitor::recordStuck(uint8_t address) {
+    I2CDeviceHealth* device = find(address);
+    if (device) device->stuckDetections++;
+}
+
+I2CRecoveryStep I2CHealthMonitor::nextStep(uint8_t address) {
+    I2CDeviceHealth* device = find(address);
+    if (!device || device->consecutiveFailures == 0 || device->escalation >= I2C_RECOVERY_STEP_COUNT) {
+        return I2C_RECOVERY_NONE;
+    }
+
+    uint8_t step;
+    if (device->escalation <= I2C_RECOVERY_RETRY && device->lastStatus != I2C_ERR_TIMEOUT &&
+        device->retries < I2C_HEALTH_RETRY_LIMIT) {
+        // A NACK is often a sensor still busy or a marginal edge; try again first
+        device->retries++;
+        step = I2C_RECOVERY_RETRY;
+    } else if (device->escalation < I2C_RECOVERY_CLOCK_OUT) {
+        step = I2C_RECOVERY_CLOCK_OUT;
+    } else {
+        step = device->escalation + 1;
+    }
+
+    device->escalation = step;
+    if (step >= I2C_RECOVERY_STEP_COUNT) {
+        table.bus.abandoned++;
+        return I2C_RECOVERY_NONE;
+    }
+
+    table.bus.steps[step]++;
+    return (I2CRecoveryStep)step;
+}
+
+void I2CHealthMonitor::recovered(uint8_t address) {
+    I2CDeviceHealth* device = find(address);
+    if (!device) return;
+
+    if (device->escalation != I2C_RECOVERY_NONE && device->escalation < I2C_RECOVERY_STEP_COUNT) {
+        table.bus.recovered++;
+    }
+    device->escalation = I2C_RECOVERY_NONE;
+    device->retries = 0;
+}
+
+void I2CHealthMonitor::resetEscalation(uint8_t address) {
+    I2CDeviceHealth* device = find(address);
+    if (!device) return;
+
+    device->escalation = I2C_RECOVERY_NONE;
+    device->retries = 0;
+}
+
+const char* I2CHealthMonitor::stepName(I2CRecoveryStep step) {
+    switch (step) {
+        case I2C_RECOVERY_RETRY:        return "retry";
+        case I2C_RECOVERY_CLOCK_OUT:    return "clock-out";
+        case I2C_RECOVERY_REINIT:       return "reinit";
+        case I2C_RECOVERY_POWER_CYCLE:  return "power cycle";
+        default:                        return "none";
+    }
+}
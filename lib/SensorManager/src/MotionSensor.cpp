@@ -0,0 +1,190 @@
+#include "MotionSensor.h"
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#define IRAM_ATTR
+#endif
+
+static_assert((MOTION_EVENT_QUEUE_SIZE & (MOTION_EVENT_QUEUE_SIZE - 1)) == 0,
+              "MOTION_EVENT_QUEUE_SIZE must be a power of two");
+
+MotionSensor::MotionSensor() :
+    head(0),
+    lastEdgeActive(false),
+    edgeSeen(false),
+    dropped(0),
+    tail(0),
+    intervalStartMs(0),
+    active(false),
+    activeSinceMs(0),
+    startedActive(false),
+    pending(false),
+    pendingActive(false),
+    pendingStartMs(0),
+    pendingLastMs(0),
+    pin(-1),
+    activeLevel(1) {
+    memset(queue, 0, sizeof(queue));
+    memset(&summary, 0, sizeof(summary));
+}
+
+// Runs in interrupt context, so it has to stay in IRAM
+void IRAM_ATTR MotionSensor::onEdge(bool active, uint32_t nowMs) {
+    // Repeats of the same level carry nothing; bounce is filtered by update()
+    if (edgeSeen && active == lastEdgeActive) {
+        return;
+    }
+
+    edgeSeen = true;
+    lastEdgeActive = active;
+
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= MOTION_EVENT_QUEUE_SIZE) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Edge& edge = queue[h & (MOTION_EVENT_QUEUE_SIZE - 1)];
+    edge.timeMs = nowMs;
+    edge.active = active;
+    head.store(h + 1, std::memory_order_release);
+}
+
+bool MotionSensor::apply(bool level, uint32_t timeMs) {
+    // A burst that started before takeSummary() counts from the new interval
+    if ((int32_t)(timeMs - intervalStartMs) < 0) {
+        timeMs = intervalStartMs;
+    }
+
+    if (level && !active) {
+        active = true;
+        activeSinceMs = timeMs;
+        if (summary.count == 0) {
+            summary.firstEventMs = timeMs;
+        }
+        summary.lastEventMs = timeMs;
+        if (summary.count < UINT16_MAX) {
+            summary.count++;
+        }
+        return true;
+    }
+    if (!level && active) {
+        active = false;
+        summary.activeMs += timeMs - activeSinceMs;
+    }
+    return false;
+}
+
+uint16_t MotionSensor::update(uint32_t nowMs) {
+    uint16_t starts = 0;
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+
+    for (; t != h; t++) {
+        const Edge& edge = queue[t & (MOTION_EVENT_QUEUE_SIZE - 1)];
+
+        if (pending && edge.timeMs - pendingLastMs < MOTION_DEBOUNCE_MS) {
+            // Still bouncing: follow the level, keep the start of the burst
+            pendingActive = edge.active;
+            pendingLastMs = edge.timeMs;
+            continue;
+        }
+
+        // The previous level held long enough
+        if (pending && apply(pendingActive, pendingStartMs)) {
+            starts++;
+        }
+        pending = true;
+        pendingActive = edge.active;
+        pendingStartMs = edge.timeMs;
+        pendingLastMs = edge.timeMs;
+    }
+    tail.store(t, std::memory_order_release);
+
+    // The last level settles without a further edge
+    if (pending && nowMs - pendingLastMs >= MOTION_DEBOUNCE_MS) {
+        pending = false;
+        if (apply(pendingActive, pendingStartMs)) {
+            starts++;
+        }
+    }
+    return starts;
+}
+
+void MotionSensor::start(bool active, uint32_t nowMs) {
+    intervalStartMs = nowMs;
+    startedActive = active;
+    if (active) {
+        onEdge(true, nowMs);
+    }
+}
+
+void MotionSensor::recordWakeEvent(uint32_t nowMs) {
+    // The PIR was still active at begin(), which counts this start already
+    if (startedActive) {
+        return;
+    }
+
+    if (summary.count == 0) {
+        summary.firstEventMs = nowMs;
+    }
+    summary.lastEventMs = nowMs;
+    if (summary.count < UINT16_MAX) {
+        summary.count++;
+    }
+}
+
+MotionSummary MotionSensor::takeSummary(uint32_t nowMs) {
+    update(nowMs);
+
+    MotionSummary result = summary;
+    if (active) {
+        result.activeMs += nowMs - activeSinceMs;
+        activeSinceMs = nowMs;
+    }
+    result.intervalMs = nowMs - intervalStartMs;
+    result.dropped = dropped.exchange(0, std::memory_order_relaxed);
+
+    memset(&summary, 0, sizeof(summary));
+    intervalStartMs = nowMs;
+    return result;
+}
+
+void MotionSensor::restoreSummary(const MotionSummary& taken) {
+    if (taken.count > 0) {
+        summary.firstEventMs = taken.firstEventMs;
+        if (summary.count == 0) {
+            summary.lastEventMs = taken.lastEventMs;
+        }
+    }
+    uint32_t count = (uint32_t)summary.count + taken.count;
+    summary.count = count > UINT16_MAX ? UINT16_MAX : (uint16_t)count;
+    summary.activeMs += taken.activeMs;
+    intervalStartMs -= taken.intervalMs;
+    dropped.fetch_add(taken.dropped, std::memory_order_relaxed);
+}
+
+// Interrupt wiring; host builds feed edges through onEdge() directly
+#if defined(ARDUINO)
+
+bool MotionSensor::begin(int pin, int activeLevel) {
+    this->pin = pin;
+    this->activeLevel = activeLevel;
+
+    pinMode(pin, activeLevel == HIGH ? INPUT_PULLDOWN : INPUT_PULLUP);
+
+    // Start from the current level so a PIR that is already active counts once
+    start(digitalRead(pin) == activeLevel, millis());
+
+    attachInterruptArg(digitalPinToInterrupt(pin), isr, this, CHANGE);
+    return true;
+}
+
+void IRAM_ATTR MotionSensor::isr(void* arg) {
+    MotionSensor* self = static_cast<MotionSensor*>(arg);
+    self->onEdge(digitalRead(self->pin) == self->activeLevel, millis());
+}
+
+#endif // ARDUINO
@@ -0,0 +1,161 @@
+#include "SensorCalibration.h"
+#include <math.h>
+#include <string.h>
+
+// Sample units per reading unit: 0.01 °C, 1/1024 %RH and 1/256 Pa (hPa = 25600)
+static const float UNITS_PER_READING[SENSOR_CHANNEL_COUNT] = { 100.0F, 1024.0F, 25600.0F };
+
+// Sample units per 0.01 reading unit in a downlink offset, as a ratio
+static const int32_t DOWNLINK_OFFSET_NUM[SENSOR_CHANNEL_COUNT] = { 1, 1024, 256 };
+static const int32_t DOWNLINK_OFFSET_DEN[SENSOR_CHANNEL_COUNT] = { 1, 100, 1 };
+
+// 100 %RH in Q22.10
+#define HUMIDITY_MAX (100 * 1024)
+
+// Layout stored in NVS
+struct SensorCalibrationBlob {
+    uint8_t version;
+    SensorChannelCalibration channels[SENSOR_CHANNEL_COUNT];
+    uint32_t seaLevelPa;
+};
+
+SensorCalibration::SensorCalibration() {
+    clear();
+}
+
+void SensorCalibration::clear() {
+    for (uint8_t c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        channels[c].offset = 0;
+        channels[c].gain = SENSOR_CALIBRATION_UNITY_GAIN;
+    }
+    setSeaLevel(0);
+    update();
+}
+
+void SensorCalibration::setChannel(SensorChannel channel, const SensorChannelCalibration& calibration) {
+    if (channel >= SENSOR_CHANNEL_COUNT) return;
+    channels[channel] = calibration;
+    update();
+}
+
+void SensorCalibration::setChannel(SensorChannel channel, float offset, float gain) {
+    if (channel >= SENSOR_CHANNEL_COUNT) return;
+    float q15 = gain * SENSOR_CALIBRATION_UNITY_GAIN;
+    SensorChannelCalibration calibration;
+    calibration.offset = (int32_t)lroundf(offset * UNITS_PER_READING[channel]);
+    calibration.gain = q15 <= 0.0F ? 0 : (q15 >= 0xFFFF ? 0xFFFF : (uint16_t)lroundf(q15));
+    setChannel(channel, calibration);
+}
+
+void SensorCalibration::setSeaLevel(uint32_t pascals) {
+    seaLevelPa = pascals;
+    seaLevelHpa = pascals == 0 ? (float)SEALEVELPRESSURE_HPA : pascals / 100.0F;
+}
+
+void SensorCalibration::update() {
+    active = false;
+    for (uint8_t c = 0; c < SENSOR_CHANNEL_COUNT; c++) {
+        if (channels[c].offset != 0 || channels[c].gain != SENSOR_CALIBRATION_UNITY_GAIN) {
+            active = true;
+        }
+    }
+}
+
+int32_t SensorCalibration::scale(int32_t value, const SensorChannelCalibration& calibration) {
+    int64_t scaled = ((int64_t)value * calibration.gain) >> 15;
+    return (int32_t)scaled + calibration.offset;
+}
+
+void SensorCalibration::apply(BME280Sample& sample) const {
+    sample.temperature = scale(sample.temperature, channels[SENSOR_CHANNEL_TEMPERATURE]);
+
+    int32_t humidity = scale((int32_t)sample.humidity, channels[SENSOR_CHANNEL_HUMIDITY]);
+    sample.humidity = humidity < 0 ? 0 : (humidity > HUMIDITY_MAX ? HUMIDITY_MAX : (uint32_t)humidity);
+
+    int32_t pressure = scale((int32_t)sample.pressure, channels[SENSOR_CHANNEL_PRESSURE]);
+    sample.pressure = pressure < 0 ? 0 : (uint32_t)pressure;
+}
+
+bool SensorCalibration::applyDownlink(const uint8_t* payload, size_t size) {
+    if (size < 2 || payload[0] != SENSOR_DOWNLINK_CONFIG) {
+        return false;
+    }
+
+    switch (payload[1]) {
+        case SENSOR_CONFIG_CALIBRATION: {
+            if (size < 7 || payload[2] >= SENSOR_CHANNEL_COUNT) {
+                return false;
+            }
+            uint8_t channel = payload[2];
+            int16_t offset = (int16_t)((payload[3] << 8) | payload[4]);
+            SensorChannelCalibration calibration;
+            calibration.offset = offset * DOWNLINK_OFFSET_NUM[channel] / DOWNLINK_OFFSET_DEN[channel];
+            calibration.gain = (uint16_t)((payload[5] << 8) | payload[6]);
+            setChannel((SensorChannel)channel, calibration);
+            return true;
+        }
+
+        case SENSOR_CONFIG_SEA_LEVEL:
+            if (size < 5) {
+                return false;
+            }
+            setSeaLevel(((uint32_t)payload[2] << 16) | (payload[3] << 8) | payload[4]);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// NVS access; host builds only keep the table in RAM
+#if defined(ARDUINO)
+
+#include <Preferences.h>
+
+bool SensorCalibration::load() {
+    Preferences preferences;
+    if (!preferences.begin(SENSOR_CALIBRATION_NAMESPACE, true)) {
+        return false;
+    }
+
+    SensorCalibrationBlob blob;
+    size_t length = preferences.getBytes("table", &blob, sizeof(blob));
+    preferences.end();
+    if (length != sizeof(blob) || blob.version != SENSOR_CALIBRATION_VERSION) {
+        return false;
+    }
+
+    memcpy(channels, blob.channels, sizeof(channels));
+    setSeaLevel(blob.seaLevelPa);
+    update();
+    return true;
+}
+
+bool SensorCalibration::save() const {
+    Preferences preferences;
+    if (!preferences.begin(SENSOR_CALIBRATION_NAMESPACE, false)) {
+        return false;
+    }
+
+    SensorCalibrationBlob blob;
+    memset(&blob, 0, sizeof(blob));
+    blob.version = SENSOR_CALIBRATION_VERSION;
+    memcpy(blob.channels, channels, sizeof(channels));
+    blob.seaLevelPa = seaLevelPa;
+
+    bool written = preferences.putBytes("table", &blob, sizeof(blob)) == sizeof(blob);
+    preferences.end();
+    return written;
+}
+
+#else
+
+bool SensorCalibration::load() {
+    return false;
+}
+
+bool SensorCalibration::save() const {
+    return false;
+}
+
+#endif // ARDUINO
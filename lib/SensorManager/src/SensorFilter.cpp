@@ -0,0 +1,122 @@
+#include "SensorFilter.h"
+#include <math.h>
+
+// BME280 operating ranges (datasheet table 1) and conservative indoor/outdoor
+// rates; the step allowance covers sensor noise between close samples
+static const SensorChannelLimits DEFAULT_LIMITS[SENSOR_CHANNEL_COUNT] = {
+    { -40.0F, 85.0F, 0.5F, 1.0F },     // Temperature, °C
+    { 0.0F, 100.0F, 2.0F, 5.0F },      // Humidity, %
+    { 300.0F, 1100.0F, 0.5F, 1.0F }    // Pressure, hPa
+};
+
+SensorFilter::SensorFilter() {
+    for (uint8_t i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+        state[i].limits = DEFAULT_LIMITS[i];
+    }
+    reset();
+}
+
+void SensorFilter::reset() {
+    for (uint8_t i = 0; i < SENSOR_CHANNEL_COUNT; i++) {
+        ChannelState& channel = state[i];
+        channel.count = 0;
+        channel.next = 0;
+        channel.rejects = 0;
+        channel.hasSample = false;
+        channel.lastSample = 0.0F;
+        channel.lastMs = 0;
+        channel.output = NAN;
+    }
+}
+
+void SensorFilter::setLimits(SensorChannel channel, const SensorChannelLimits& limits) {
+    if (channel < SENSOR_CHANNEL_COUNT) {
+        state[channel].limits = limits;
+    }
+}
+
+uint8_t SensorFilter::apply(SensorReading& reading, bool valid, uint32_t nowMs) {
+    uint8_t quality = valid ? 0 : SENSOR_QUALITY_READ_ERROR;
+
+    quality |= filterChannel(state[SENSOR_CHANNEL_TEMPERATURE], reading.temperature, valid,
+                             nowMs, SENSOR_QUALITY_TEMPERATURE_HELD);
+    quality |= filterChannel(state[SENSOR_CHANNEL_HUMIDITY], reading.humidity, valid,
+                             nowMs, SENSOR_QUALITY_HUMIDITY_HELD);
+    quality |= filterChannel(state[SENSOR_CHANNEL_PRESSURE], reading.pressure, valid,
+                             nowMs, SENSOR_QUALITY_PRESSURE_HELD);
+
+    reading.quality = quality;
+    return quality;
+}
+
+uint8_t SensorFilter::filterChannel(ChannelState& channel, float& value, bool valid,
+                                    uint32_t nowMs, uint8_t heldFlag) {
+    uint8_t flags = 0;
+    bool accept = valid && !isnan(value);
+
+    if (accept && (value < channel.limits.min || value > channel.limits.max)) {
+        flags |= SENSOR_QUALITY_OUT_OF_RANGE;
+        accept = false;
+    }
+
+    if (accept && channel.hasSample) {
+        float elapsed = (nowMs - channel.lastMs) / 1000.0F;
+        float allowed = channel.limits.minStep + channel.limits.maxRatePerSecond * elapsed;
+
+        if (fabsf(value - channel.lastSample) > allowed) {
+            if (++channel.rejects < SENSOR_FILTER_MAX_REJECTS) {
+                flags |= SENSOR_QUALITY_RATE_LIMITED;
+                accept = false;
+            } else {
+                // The jump persisted: restart the median at the new level
+                channel.count = 0;
+                channel.next = 0;
+            }
+        }
+    }
+
+    if (accept) {
+        channel.rejects = 0;
+        channel.hasSample = true;
+        channel.lastSample = value;
+        channel.lastMs = nowMs;
+
+        channel.window[channel.next] = value;
+        channel.next = (channel.next + 1) % SENSOR_FILTER_WINDOW;
+        if (channel.count < SENSOR_FILTER_WINDOW) {
+            channel.count++;
+        }
+        channel.output = median(channel.window, channel.count);
+    } else {
+        flags |= heldFlag;
+    }
+
+    if (!channel.hasSample) {
+        flags |= SENSOR_QUALITY_NO_DATA;
+    } else if (channel.count < SENSOR_FILTER_WINDOW) {
+        flags |= SENSOR_QUALITY_WARMING_UP;
+    }
+
+    value = channel.output;
+    return flags;
+}
+
+float SensorFilter::median(const float* values, uint8_t count) {
+    // Insertion sort of a copy; the window is only a handful of samples
+    float sorted[SENSOR_FILTER_WINDOW];
+    for (uint8_t i = 0; i < count; i++) {
+        float v = values[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+
+    // Even counts (while warming up) average the two middle samples
+    if (count % 2 == 0) {
+        return (sorted[count / 2 - 1] + sorted[count / 2]) / 2.0F;
+    }
+    return sorted[count / 2];
+}
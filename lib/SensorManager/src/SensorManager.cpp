@@ -1,8 +1,64 @@
 #include "SensorManager.h"
 #include "Config.h"
 
-SensorManager::SensorManager() : bme280Available(false), wire(&Wire) {
-    // Use primary Wire by default (more compatible with sensors)
+// Sensor state kept in RTC memory so deep-sleep wakes can skip discovery
+#define SENSOR_WAKE_CACHE_MAGIC 0x42574331  // "BWC1"
+
+// How often a sensor known to be missing is searched for again (in wakes)
+#ifndef SENSOR_REDISCOVERY_INTERVAL
+#define SENSOR_REDISCOVERY_INTERVAL 16
+#endif
+
+// Level that switches VEXT on when Config.h does not set it
+#ifndef VEXT_ACTIVE_HIGH
+#define VEXT_ACTIVE_HIGH false
+#endif
+
+// The SDO pin selects the BME280 address; the other one is tried too
+#define BME_ALTERNATE_ADDRESS (BME_ADDRESS ^ 0x01)
+
+struct SensorWakeCache {
+    uint32_t magic;
+    bool present;          // BME280 found at the last initialization
+    uint8_t address;
+    uint16_t absentWakes;  // Wakes since the sensor was last found missing
+    BME280Calibration calibration;
+    I2CHealthTable health;  // Bus error counters accumulated across wakes
+};
+
+RTC_DATA_ATTR static SensorWakeCache wakeCache;
+
+// The filter is updated from the caller of read() and from the I2C worker
+// completing a queued reading
+static portMUX_TYPE filterLock = portMUX_INITIALIZER_UNLOCKED;
+
+#if defined(ESP_PLATFORM)
+// Use the first hardware controller (same one TwoWire would use)
+SensorManager::SensorManager() :
+    SensorManager(defaultBus) {
+}
+#endif
+
+SensorManager::SensorManager(I2CBus& bus) :
+    i2cBus(bus),
+    i2c(&i2cBus),
+    bme(i2c),
+    bme280Available(false),
+    vextActiveHigh(VEXT_ACTIVE_HIGH),
+    ulp(bme),
+    profile(BME280_PROFILE_HIGH_PRECISION),
+    measurementUs(bme280MeasurementMaxUs(BME280_PROFILE_HIGH_PRECISION)),
+    conversionPending(false),
+    conversionReadyUs(0),
+    lastQuality(SENSOR_QUALITY_NO_DATA),
+    warmStart(false),
+    beginDurationUs(0),
+    wakeToReadingUs(0),
+    asyncCallback(nullptr),
+    asyncContext(nullptr),
+    asyncBusy(false) {
+    ulp.setCalibration(&calibration);
+    i2c.setMonitor(&health);
 }
 
 // Power cycle the BME280 to reset it if possible
@@ -12,11 +68,11 @@ void SensorManager::powerCycleBME280() {
     pinMode(VEXT_PIN, OUTPUT);
     
     // Power off
-    digitalWrite(VEXT_PIN, HIGH); // HIGH turns power off on VEXT
+    digitalWrite(VEXT_PIN, vextActiveHigh ? LOW : HIGH);
     delay(500);
     
-    // Power on
-    digitalWrite(VEXT_PIN, LOW); // LOW turns power on on VEXT
+    // Power on, with the same level setup() used
+    digitalWrite(VEXT_PIN, vextActiveHigh ? HIGH : LOW);
     delay(500);
     
     Serial.println("BME280 power cycle complete");
@@ -30,8 +86,7 @@ void SensorManager::resetI2C(int sda, int scl) {
     Serial.println("Performing complete I2C bus reset on pins SDA=" + String(sda) + ", SCL=" + String(scl));
     
     // End any existing bus first
-    Wire.end();
-    delay(100);
+    i2cBus.end();
     
     // Configure SDA and SCL for bit-banging
     pinMode(sda, OUTPUT);
@@ -71,15 +126,14 @@ void SensorManager::resetI2C(int sda, int scl) {
 }
 
 // Scan the I2C bus for devices
-void SensorManager::scanI2CBus(TwoWire *wire, int sda, int scl) {
+void SensorManager::scanI2CBus(int sda, int scl) {
     Serial.println("Performing detailed I2C bus scan on pins SDA=" + String(sda) + ", SCL=" + String(scl));
     
     byte foundDevices = 0;
     byte error, address;
     
     for (address = 1; address < 127; address++) {
-        wire->beginTransmission(address);
-        error = wire->endTransmission();
+        error = i2c.probe(address);
         
         if (error == 0) {
             Serial.print("I2C device found at address 0x");
@@ -117,133 +171,437 @@ void SensorManager::scanI2CBus(TwoWire *wire, int sda, int scl) {
 }
 
 bool SensorManager::begin(int sda, int scl) {
-    // Log the I2C pins being used for debugging
-    Serial.println("\n=== BME280 Sensor Initialization ===");
-    Serial.println("Initializing BME280 with primary Wire on pins SDA=" + String(sda) + ", SCL=" + String(scl));
+    uint32_t startUs = micros();
+    warmStart = false;
+    wakeToReadingUs = 0;
+    filter.reset();
+    
+    // Take the pins back from the ULP and collect what it sampled during sleep
+    ulp.stop();
+    if (ulp.getSampleCount() > 0) {
+        Serial.println("ULP sampled " + String(ulp.getSampleCount()) + " readings during sleep (wake reason " +
+                       String(ulp.getWakeReason()) + ")");
+    }
     
-    // Complete reset of I2C infrastructure
-    resetI2C(sda, scl);
-    delay(100);
+    // RTC memory only survives deep sleep, so a valid cache implies a warm wake
+    bool deepSleepWake = esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED;
+    if (deepSleepWake && wakeCache.magic == SENSOR_WAKE_CACHE_MAGIC) {
+        health.restore(wakeCache.health);
+        if (wakeCache.present) {
+            warmStart = beginWarm(sda, scl);
+            if (!warmStart) {
+                Serial.println("Warm start failed, falling back to full discovery");
+            }
+        } else if (++wakeCache.absentWakes % SENSOR_REDISCOVERY_INTERVAL != 0) {
+            // Known to be missing: skip the multi-second discovery on most wakes
+            Serial.println("BME280 absent at last discovery, skipping initialization");
+            bme280Available = false;
+            beginDurationUs = micros() - startUs;
+            return false;
+        }
+    }
     
-    // Terminate any existing Wire connection
-    Wire.end();
-    delay(100);
+    if (!warmStart) {
+        beginCold(sda, scl);
+    }
     
-    // Initialize with our pins
-    Serial.println("Setting up primary Wire bus for BME280...");
-    if (Wire.begin(sda, scl)) {
+    // Refresh the cache for the next wake
+    wakeCache.magic = SENSOR_WAKE_CACHE_MAGIC;
+    wakeCache.present = bme280Available;
+    wakeCache.health = health.getTable();
+    if (bme280Available) {
+        wakeCache.address = bme.getAddress();
+        wakeCache.calibration = bme.getCalibration();
+        wakeCache.absentWakes = 0;
+    }
+    
+    beginDurationUs = micros() - startUs;
+    Serial.println(String(warmStart ? "Warm" : "Cold") + " sensor start took " +
+                   String(beginDurationUs / 1000) + " ms, first reading " +
+                   String(wakeToReadingUs / 1000) + " ms after boot");
+    
+    return bme280Available;
+}
+
+void SensorManager::invalidateWakeCache() {
+    wakeCache.magic = 0;
+}
+
+bool SensorManager::beginWarm(int sda, int scl) {
+    Serial.print("Warm start: reusing cached BME280 at address 0x");
+    Serial.println(wakeCache.address, HEX);
+    
+    if (!i2cBus.begin(sda, scl, I2C_CLOCK_SPEED)) {
+        return false;
+    }
+    
+    // Address and trim values come from RTC memory. A sensor that kept
+    // power and its profile through sleep is confirmed by one register
+    // read; after VEXT was off (or the ULP ran it with its own settings)
+    // only the mode registers need rewriting
+    bme.restore(wakeCache.address, wakeCache.calibration);
+    if (bme.hasSampling(profile.mode, profile.temperature, profile.pressure,
+                        profile.humidity, profile.filter, profile.standby)) {
+        Serial.println("BME280 kept its configuration through sleep");
+        bme280Available = true;
+        conversionPending = false;
+        wakeToReadingUs = micros();  // Normal mode holds a finished conversion
+        return true;
+    }
+    bme280Available = configureSensor() && verifySensor();
+    return bme280Available;
+}
+
+bool SensorManager::beginCold(int sda, int scl) {
+    // Log the I2C pins being used for debugging
+    Serial.println("\n=== BME280 Sensor Initialization ===");
+    Serial.println("Initializing BME280 on hardware I2C pins SDA=" + String(sda) + ", SCL=" + String(scl));
+    
+    // Initialize with our pins, 100kHz by default for better reliability.
+    // The bus is only reset when the sensor does not answer (see detectSensor)
+    Serial.println("Setting up hardware I2C bus for BME280...");
+    if (i2cBus.begin(sda, scl, I2C_CLOCK_SPEED)) {
         Serial.println("Primary I2C bus initialized successfully");
     } else {
         Serial.println("Primary I2C bus initialization failed");
+        bme280Available = false;
         return false;
     }
     
-    // Set clock to 100kHz for better reliability (standard I2C speed)
-    Wire.setClock(100000); // 100kHz
-    delay(100);
+    bme280Available = detectSensor(sda, scl);
+    if (!bme280Available) {
+        Serial.println("BME280 not detected at either address");
+        
+        // List what does answer, unless the bus is wedged and every probe would time out
+        const I2CDeviceHealth* device = health.getDevice(BME_ADDRESS);
+        if (device && device->lastStatus != I2C_ERR_TIMEOUT) {
+            scanI2CBus(sda, scl);
+        }
+    }
     
-    // Scan I2C bus to see what's connected
-    scanI2CBus(wire, sda, scl);
+    if (bme280Available) {
+        bme280Available = configureSensor() && verifySensor();
+    }
     
-    // Try to initialize BME280 at primary address
-    Serial.print("Trying BME280 at address 0x");
-    Serial.print(BME_ADDRESS, HEX);
-    Serial.print(" with primary Wire... ");
+    return bme280Available;
+}
+
+bool SensorManager::detectSensor(int sda, int scl) {
+    health.watch(BME_ADDRESS);
+    health.watch(BME_ALTERNATE_ADDRESS);
+    health.resetEscalation(BME_ADDRESS);
     
-    // Multiple attempts to initialize BME280
-    for (int attempt = 0; attempt < 3; attempt++) {
-        bme280Available = bme.begin(BME_ADDRESS, wire);
-        if (bme280Available) {
-            Serial.println("Success on attempt " + String(attempt+1) + "!");
+    // Both addresses are tried after every step, so a sensor strapped to the
+    // other one is found without escalating
+    while (true) {
+        Serial.print("Trying BME280 at address 0x");
+        Serial.print(BME_ADDRESS, HEX);
+        Serial.print("... ");
+        if (bme.begin(BME_ADDRESS)) {
             break;
-        } else {
-            if (attempt < 2) {
-                Serial.println("Failed attempt " + String(attempt+1) + ", retrying...");
-                delay(200); // Longer delay before retry
-            } else {
-                Serial.println("Failed after multiple attempts");
-            }
         }
+        Serial.print("failed, trying 0x");
+        Serial.print(BME_ALTERNATE_ADDRESS, HEX);
+        Serial.print("... ");
+        if (bme.begin(BME_ALTERNATE_ADDRESS)) {
+            break;
+        }
+        
+        I2CRecoveryStep step = health.nextStep(BME_ADDRESS);
+        if (step == I2C_RECOVERY_NONE) {
+            Serial.println("failed, no recovery steps left");
+            return false;
+        }
+        Serial.println("failed, recovering with " + String(I2CHealthMonitor::stepName(step)));
+        recover(step, BME_ADDRESS, sda, scl);
     }
     
-    if (!bme280Available) {
-        // Try alternative I2C address
-        Serial.print("Trying BME280 at alternative address 0x77... ");
-        bme280Available = bme.begin(0x77, wire);
-        if (bme280Available) {
-            Serial.println("Success at address 0x77!");
-        } else {
-            Serial.println("Failed. BME280 not detected at either address.");
-        }
+    Serial.println("found");
+    health.recovered(BME_ADDRESS);
+    return true;
+}
+
+void SensorManager::recover(I2CRecoveryStep step, uint8_t address, int sda, int scl) {
+    switch (step) {
+        case I2C_RECOVERY_RETRY:
+            delay(I2C_RECOVERY_RETRY_MS);
+            break;
+            
+        case I2C_RECOVERY_CLOCK_OUT:
+            // A slave reset mid-byte keeps SDA low until it has clocked out its bits
+            i2cBus.end();
+            pinMode(sda, INPUT);
+            if (digitalRead(sda) == LOW) {
+                health.recordStuck(address);
+                Serial.println("SDA held low by a slave");
+            }
+            resetI2C(sda, scl);
+            i2cBus.begin(sda, scl, I2C_CLOCK_SPEED);
+            break;
+            
+        case I2C_RECOVERY_REINIT:
+            i2cBus.end();
+            i2cBus.begin(sda, scl, I2C_CLOCK_SPEED);
+            break;
+            
+        case I2C_RECOVERY_POWER_CYCLE:
+            powerCycleBME280();
+            break;
+            
+        default:
+            break;
+    }
+}
+
+I2CRecoveryStep SensorManager::recoverBus(int sda, int scl) {
+    uint8_t address = bme.getAddress();
+    I2CRecoveryStep step = health.nextStep(address);
+    if (step == I2C_RECOVERY_NONE) {
+        return step;
     }
     
-    if (bme280Available) {
-        // Configure the BME280 sensor for weather monitoring mode
-        bme.setSampling(Adafruit_BME280::MODE_NORMAL,     // Operating Mode
-                        Adafruit_BME280::SAMPLING_X2,     // Temperature Oversampling
-                        Adafruit_BME280::SAMPLING_X16,    // Pressure Oversampling
-                        Adafruit_BME280::SAMPLING_X1,     // Humidity Oversampling
-                        Adafruit_BME280::FILTER_X16,      // Filtering
-                        Adafruit_BME280::STANDBY_MS_500); // Standby Time
-        
-        // Give BME280 time to stabilize after initialization
-        delay(200);
-                        
-        // Verify we can read from the sensor
-        float test_temp = bme.readTemperature();
-        float test_hum = bme.readHumidity();
-        float test_pressure = bme.readPressure() / 100.0F;
-        
-        Serial.println("Verification readings:");
-        Serial.println("  Temperature: " + String(test_temp) + "°C");
-        Serial.println("  Humidity: " + String(test_hum) + "%");
-        Serial.println("  Pressure: " + String(test_pressure) + " hPa");
-        
-        if (isnan(test_temp) || isnan(test_hum) || isnan(test_pressure) || 
-            (test_temp == 0.0 && test_hum == 0.0 && test_pressure == 0.0)) {
-            Serial.println("WARNING: BME280 returning zeros or NaN values.");
-            Serial.println("May not be working correctly despite successful initialization.");
-            bme280Available = false;
-        }
+    Serial.println("BME280 not answering, recovering with " + String(I2CHealthMonitor::stepName(step)));
+    recover(step, address, sda, scl);
+    
+    // Power loss reset the mode registers; the trim values are still valid
+    if (step == I2C_RECOVERY_POWER_CYCLE && bme280Available) {
+        configureSensor();
+    }
+    return step;
+}
+
+bool SensorManager::setProfile(const BME280Profile& profile) {
+    this->profile = profile;
+    measurementUs = bme280MeasurementMaxUs(profile);
+    return !bme280Available || configureSensor();
+}
+
+// Wait on the Arduino scheduler for whole milliseconds, busy-wait the rest
+static void waitUs(uint32_t us) {
+    delay(us / 1000);
+    delayMicroseconds(us % 1000);
+}
+
+bool SensorManager::configureSensor() {
+    // Forced profiles leave the sensor asleep between the conversions read() starts
+    bool forced = profile.mode == BME280Driver::MODE_FORCED;
+    bool configured = bme.setSampling(forced ? BME280Driver::MODE_SLEEP : profile.mode,
+                                      profile.temperature,
+                                      profile.pressure,
+                                      profile.humidity,
+                                      profile.filter,
+                                      profile.standby);
+    if (!configured) {
+        Serial.println("BME280 did not accept its configuration");
+        return false;
     }
     
-    return bme280Available;
+    conversionPending = false;
+    if (forced) {
+        // Start the first conversion now; the verification read waits for the rest of it
+        return startConversion();
+    }
+    
+    // Wait for the first conversion; normal mode starts one immediately
+    waitUs(measurementUs);
+    return true;
 }
 
-float SensorManager::readTemperature() {
-    if (!bme280Available) return -273.15; // Absolute zero if sensor not available
+bool SensorManager::startConversion() {
+    if (!bme.startForced()) {
+        return false;
+    }
+    conversionReadyUs = micros() + measurementUs;
+    conversionPending = true;
+    return true;
+}
+
+bool SensorManager::awaitConversion() {
+    if (profile.mode != BME280Driver::MODE_FORCED) {
+        return true; // Normal mode always has a finished conversion to read
+    }
+    if (!conversionPending && !startConversion()) {
+        return false;
+    }
     
-    return bme.readTemperature();
+    int32_t remaining = (int32_t)(conversionReadyUs - micros());
+    if (remaining > 0) {
+        waitUs((uint32_t)remaining);
+    }
+    conversionPending = false;
+    return true;
 }
 
-float SensorManager::readHumidity() {
-    if (!bme280Available) return 0.0;
+bool SensorManager::verifySensor() {
+    // Verify we can read from the sensor
+    SensorReading reading;
+    bme280Available = true;
+    read(reading);
     
-    return bme.readHumidity();
+    Serial.println("Verification readings:");
+    Serial.println("  Temperature: " + String(reading.temperature) + "°C");
+    Serial.println("  Humidity: " + String(reading.humidity) + "%");
+    Serial.println("  Pressure: " + String(reading.pressure) + " hPa");
+    
+    // The filter has no history yet, so only the read itself and the range checks can fail
+    if (reading.quality & (SENSOR_QUALITY_READ_ERROR | SENSOR_QUALITY_OUT_OF_RANGE | SENSOR_QUALITY_NO_DATA)) {
+        Serial.println("WARNING: BME280 returning invalid values (quality 0x" + String(reading.quality, HEX) + ").");
+        Serial.println("May not be working correctly despite successful initialization.");
+        filter.reset();
+        return false;
+    }
+    
+    // micros() counts from boot, which includes the wake from deep sleep
+    wakeToReadingUs = micros();
+    return true;
 }
 
-float SensorManager::readPressure() {
-    if (!bme280Available) return 0.0;
+bool SensorManager::convert(const BME280RawData& raw, SensorReading& reading) {
+    BME280Sample sample;
+    if (!bme.compensate(raw, sample)) {
+        return false;
+    }
+    if (calibration.isActive()) {
+        calibration.apply(sample);
+    }
     
-    return bme.readPressure() / 100.0F; // Convert Pa to hPa
+    reading.temperature = sample.temperature / 100.0F;
+    reading.humidity = sample.humidity / 1024.0F;
+    reading.pressure = sample.pressure / 25600.0F; // Q24.8 Pa to hPa
+    return true;
 }
 
-float SensorManager::readAltitude() {
-    if (!bme280Available) return 0.0;
+bool SensorManager::finishReading(bool valid, SensorReading& reading) {
+    portENTER_CRITICAL(&filterLock);
+    uint8_t quality = filter.apply(reading, valid, millis());
+    portEXIT_CRITICAL(&filterLock);
     
-    return bme.readAltitude(SEALEVELPRESSURE_HPA);
+    // Altitude follows the filtered pressure
+    if (isnan(reading.pressure)) {
+        reading.altitude = NAN;
+    } else {
+        reading.altitude = 44330.0F * (1.0F - pow(reading.pressure / calibration.getSeaLevelHpa(), 0.1903F));
+    }
+    
+    lastQuality = quality;
+    return SensorFilter::isUsable(quality);
+}
+
+bool SensorManager::read(SensorReading& reading) {
+    BME280RawData raw;
+    
+    // Unavailable sensors and failed reads go through the filter too, so the
+    // caller gets the last good values with the matching flags
+    bool valid = bme280Available && awaitConversion() && bme.readRaw(raw) && convert(raw, reading);
+    if (valid) {
+        health.recovered(bme.getAddress());
+    }
+    return finishReading(valid, reading);
+}
+
+float SensorManager::readTemperature() {
+    SensorReading reading;
+    read(reading);
+    return reading.temperature;
+}
+
+float SensorManager::readHumidity() {
+    SensorReading reading;
+    read(reading);
+    return reading.humidity;
+}
+
+float SensorManager::readPressure() {
+    SensorReading reading;
+    read(reading);
+    return reading.pressure;
+}
+
+float SensorManager::readAltitude() {
+    SensorReading reading;
+    read(reading);
+    return reading.altitude;
 }
 
 void SensorManager::readBME280(float &temperature, float &humidity, float &pressure, float &altitude) {
-    if (bme280Available) {
-        temperature = bme.readTemperature();
-        humidity = bme.readHumidity();
-        pressure = bme.readPressure() / 100.0F; // Convert Pa to hPa
-        altitude = bme.readAltitude(SEALEVELPRESSURE_HPA);
-    } else {
-        temperature = -273.15;
-        humidity = 0.0;
-        pressure = 0.0;
-        altitude = 0.0;
+    SensorReading reading;
+    read(reading);
+    
+    temperature = reading.temperature;
+    humidity = reading.humidity;
+    pressure = reading.pressure;
+    altitude = reading.altitude;
+}
+
+bool SensorManager::startUlpSampling(int sda, int scl, const UlpThresholds& thresholds, uint32_t intervalMs) {
+    BME280RawData reference;
+    if (!bme280Available || !bme.readRaw(reference)) {
+        return false;
     }
-} 
\ No newline at end of file
+    
+    // The ULP reads the last finished conversion on every period
+    bool configured = bme.setSampling(BME280Driver::MODE_NORMAL,
+                                      BME280Driver::SAMPLING_X1,
+                                      BME280Driver::SAMPLING_X1,
+                                      BME280Driver::SAMPLING_X1,
+                                      BME280Driver::FILTER_OFF,
+                                      BME280Driver::STANDBY_MS_1000);
+    if (!configured) {
+        return false;
+    }
+    
+    i2cBus.end();
+    if (!ulp.start(sda, scl, reference, thresholds, intervalMs)) {
+        Serial.println("ULP sampling not started");
+        i2cBus.begin(sda, scl, I2C_CLOCK_SPEED);
+        configureSensor();
+        return false;
+    }
+    return true;
+}
+
+bool SensorManager::requestReading(SensorReadingCallback callback, void* context) {
+    if (!bme280Available || asyncBusy) return false;
+    
+    asyncCallback = callback;
+    asyncContext = context;
+    asyncBusy = true;
+    
+    if (!bme.queueRawRead(asyncBurst, onBurstComplete, this)) {
+        asyncBusy = false;
+        return false;
+    }
+    
+    // Start the conversion the next request will read; if the queue is
+    // full, the next synchronous read() starts one itself
+    if (profile.mode == BME280Driver::MODE_FORCED) {
+        conversionPending = false;
+        bme.queueStartForced(onConversionStarted, this);
+    }
+    return true;
+}
+
+void SensorManager::onConversionStarted(const I2CTransaction& txn, void* context) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    if (txn.status == I2C_OK) {
+        self->conversionReadyUs = micros() + self->measurementUs;
+        self->conversionPending = true;
+    }
+}
+
+void SensorManager::onBurstComplete(const I2CTransaction& txn, void* context) {
+    SensorManager* self = static_cast<SensorManager*>(context);
+    SensorReading reading = { NAN, NAN, NAN, NAN, 0 };
+    
+    bool valid = txn.status == I2C_OK &&
+                 self->convert(BME280Driver::decodeRaw(self->asyncBurst), reading);
+    bool success = self->finishReading(valid, reading);
+    
+    // Clear busy first so the callback may queue the next reading
+    SensorReadingCallback callback = self->asyncCallback;
+    self->asyncBusy = false;
+    if (callback) {
+        callback(success, reading, self->asyncContext);
+    }
+}
+
@@ -0,0 +1,473 @@
+#include "UlpSampler.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#define RTC_DATA_ATTR
+#endif
+
+// Layout shared with the ULP program. The ULP addresses 32-bit words and
+// only uses their lower 16 bits; ST fills the upper half with bookkeeping,
+// so the main cores mask every value they read back.
+struct UlpShared {
+    uint32_t magic;
+    uint32_t active;                          // ULP was started before the last sleep
+    int32_t sda;
+    int32_t scl;
+    uint32_t totalSamples;
+    uint32_t totalWakes;
+    uint32_t burst[BME280_BURST_LEN];         // Last data burst, one byte per word
+    uint32_t reference[SENSOR_CHANNEL_COUNT]; // T, H, P in ULP counts
+    uint32_t threshold[SENSOR_CHANNEL_COUNT];
+    uint32_t count;
+    uint32_t samples[ULP_SAMPLER_BATCH_SIZE * SENSOR_CHANNEL_COUNT];
+};
+
+#define ULP_SHARED_MAGIC 0x554C5031  // "ULP1"
+
+RTC_DATA_ATTR static UlpShared shared;
+
+UlpSampler::UlpSampler(BME280Driver& bme) :
+    bme(bme),
+    calibration(nullptr),
+    wakeReason(ULP_WAKE_NONE),
+    count(0) {
+    memset(samples, 0, sizeof(samples));
+}
+
+BME280RawData UlpSampler::expand(const UlpRawSample& sample) {
+    BME280RawData raw;
+    raw.adcT = (int32_t)sample.temperature << 4;
+    raw.adcP = (int32_t)sample.pressure << 4;
+    raw.adcH = sample.humidity;
+    return raw;
+}
+
+UlpRawSample UlpSampler::truncate(const BME280RawData& raw) {
+    UlpRawSample sample;
+    sample.temperature = (uint16_t)(raw.adcT >> 4);
+    sample.humidity = (uint16_t)raw.adcH;
+    sample.pressure = (uint16_t)(raw.adcP >> 4);
+    return sample;
+}
+
+// Channel value in the units of UlpThresholds
+static bool channelValue(const BME280Driver& bme, const BME280RawData& raw,
+                         SensorChannel channel, float& value) {
+    BME280Sample sample;
+    if (!bme.compensate(raw, sample)) {
+        return false;
+    }
+
+    switch (channel) {
+        case SENSOR_CHANNEL_TEMPERATURE: value = sample.temperature / 100.0F; break;
+        case SENSOR_CHANNEL_HUMIDITY:    value = sample.humidity / 1024.0F; break;
+        default:                         value = sample.pressure / 25600.0F; break;
+    }
+    return true;
+}
+
+uint16_t UlpSampler::thresholdCounts(const BME280Driver& bme, const BME280RawData& reference,
+                                     SensorChannel channel, float delta) {
+    // Slope of the compensation over +-SPAN ULP counts around the reference
+    const int32_t SPAN = 64;
+    const uint16_t NEVER = 0x7FFF;
+
+    BME280RawData lo = reference;
+    BME280RawData hi = reference;
+    switch (channel) {
+        case SENSOR_CHANNEL_TEMPERATURE: lo.adcT -= SPAN << 4; hi.adcT += SPAN << 4; break;
+        case SENSOR_CHANNEL_HUMIDITY:    lo.adcH -= SPAN;      hi.adcH += SPAN;      break;
+        default:                         lo.adcP -= SPAN << 4; hi.adcP += SPAN << 4; break;
+    }
+
+    float vLo, vHi;
+    if (!channelValue(bme, lo, channel, vLo) || !channelValue(bme, hi, channel, vHi)) {
+        return NEVER;
+    }
+
+    // Pressure falls as its ADC value rises, so only the magnitude matters
+    float perCount = fabsf(vHi - vLo) / (2 * SPAN);
+    if (perCount <= 0.0F) {
+        return NEVER;
+    }
+
+    float counts = ceilf(delta / perCount);
+    if (counts < 1.0F) return 1;
+    if (counts > NEVER) return NEVER;
+    return (uint16_t)counts;
+}
+
+bool UlpSampler::getSample(uint8_t index, SensorReading& reading) const {
+    if (index >= count) {
+        return false;
+    }
+
+    BME280Sample sample;
+    if (!bme.compensate(expand(samples[index]), sample)) {
+        return false;
+    }
+    if (calibration && calibration->isActive()) {
+        calibration->apply(sample);
+    }
+
+    reading.temperature = sample.temperature / 100.0F;
+    reading.humidity = sample.humidity / 1024.0F;
+    reading.pressure = sample.pressure / 25600.0F;
+    reading.altitude = NAN;
+    reading.quality = 0;
+    return true;
+}
+
+bool UlpSampler::wasActive() const {
+    return shared.magic == ULP_SHARED_MAGIC && shared.active;
+}
+
+uint32_t UlpSampler::getTotalSamples() const {
+    return shared.magic == ULP_SHARED_MAGIC ? shared.totalSamples : 0;
+}
+
+uint32_t UlpSampler::getTotalWakes() const {
+    return shared.magic == ULP_SHARED_MAGIC ? shared.totalWakes : 0;
+}
+
+void UlpSampler::resetCounters() {
+    shared.totalSamples = 0;
+    shared.totalWakes = 0;
+}
+
+// ULP program; host builds only get the sample conversion above
+#if defined(ARDUINO) && (CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32)
+
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+#include <soc/rtc_cntl_reg.h>
+#include <soc/rtc_io_reg.h>
+#include <soc/soc.h>
+#if CONFIG_IDF_TARGET_ESP32S3
+#include <esp32s3/ulp.h>
+#else
+#include <esp32/ulp.h>
+#endif
+
+#ifndef RTC_SLOW_MEM
+#define RTC_SLOW_MEM ((uint32_t*) SOC_RTC_DATA_LOW)
+#endif
+
+// Cycles SCL is held high before SDA is sampled, to cover the pull-up rise time
+#define ULP_I2C_SETTLE_CYCLES 20
+
+// Open-drain emulation: the output latch stays 0 and the ULP toggles the driver
+#define SDA_LOW     I_WR_REG(RTC_GPIO_ENABLE_W1TS_REG, RTC_GPIO_ENABLE_W1TS_S + sda, RTC_GPIO_ENABLE_W1TS_S + sda, 1)
+#define SDA_RELEASE I_WR_REG(RTC_GPIO_ENABLE_W1TC_REG, RTC_GPIO_ENABLE_W1TC_S + sda, RTC_GPIO_ENABLE_W1TC_S + sda, 1)
+#define SCL_LOW     I_WR_REG(RTC_GPIO_ENABLE_W1TS_REG, RTC_GPIO_ENABLE_W1TS_S + scl, RTC_GPIO_ENABLE_W1TS_S + scl, 1)
+#define SCL_RELEASE I_WR_REG(RTC_GPIO_ENABLE_W1TC_REG, RTC_GPIO_ENABLE_W1TC_S + scl, RTC_GPIO_ENABLE_W1TC_S + scl, 1)
+#define SDA_READ    I_RD_REG(RTC_GPIO_IN_REG, RTC_GPIO_IN_NEXT_S + sda, RTC_GPIO_IN_NEXT_S + sda)
+
+enum {
+    LBL_WRITE, LBL_WRITE_BIT, LBL_WRITE_ZERO, LBL_WRITE_CLOCK,
+    LBL_RET_ADDRESS, LBL_RET_REGISTER, LBL_RET_READ,
+    LBL_READ_BYTE, LBL_READ_BIT, LBL_READ_NACK,
+    LBL_ABS_T, LBL_ABS_H, LBL_ABS_P,
+    LBL_WAKE, LBL_ERROR
+};
+
+// Word offset of a shared field as seen by the ULP
+static uint16_t ulpWord(const volatile void* field) {
+    return (uint16_t)((const volatile uint32_t*)field - RTC_SLOW_MEM);
+}
+
+static bool loadProgram(uint8_t address, int sdaPin, int sclPin) {
+    const uint32_t sda = rtc_io_number_get((gpio_num_t)sdaPin);
+    const uint32_t scl = rtc_io_number_get((gpio_num_t)sclPin);
+    const uint16_t burst = ulpWord(shared.burst);
+    const uint16_t reference = ulpWord(shared.reference);
+    const uint16_t threshold = ulpWord(shared.threshold);
+    const uint16_t count = ulpWord(&shared.count);
+    const uint16_t samples = ulpWord(shared.samples);
+
+    // Registers: R0 scratch/compare, R1 byte, R2 bit counter or zero base,
+    // R3 return address or pointer
+    const ulp_insn_t program[] = {
+        // Nothing to do until the main cores have drained a full batch
+        I_MOVI(R2, 0),
+        I_LD(R0, R2, count),
+        M_BGE(LBL_WAKE, ULP_SAMPLER_BATCH_SIZE),
+
+        // START, address+W, data register
+        SDA_LOW,
+        SCL_LOW,
+        I_MOVI(R1, address << 1),
+        M_MOVL(R3, LBL_RET_ADDRESS),
+        M_BX(LBL_WRITE),
+        M_LABEL(LBL_RET_ADDRESS),
+        I_MOVI(R1, BME280_REG_DATA),
+        M_MOVL(R3, LBL_RET_REGISTER),
+        M_BX(LBL_WRITE),
+        M_LABEL(LBL_RET_REGISTER),
+
+        // Repeated START, address+R
+        SCL_RELEASE,
+        SDA_LOW,
+        SCL_LOW,
+        I_MOVI(R1, (address << 1) | 1),
+        M_MOVL(R3, LBL_RET_READ),
+        M_BX(LBL_WRITE),
+        M_LABEL(LBL_RET_READ),
+
+        // Read the burst one byte per word; ACK all but the last byte
+        I_MOVI(R3, burst),
+        M_LABEL(LBL_READ_BYTE),
+        I_MOVI(R1, 1),  // Sentinel: the byte is complete once it reaches bit 8
+        SDA_RELEASE,
+        M_LABEL(LBL_READ_BIT),
+        SCL_RELEASE,
+        I_DELAY(ULP_I2C_SETTLE_CYCLES),
+        SDA_READ,
+        I_LSHI(R1, R1, 1),
+        I_ORR(R1, R1, R0),
+        SCL_LOW,
+        I_MOVR(R0, R1),
+        M_BL(LBL_READ_BIT, 0x100),
+        I_ANDI(R1, R1, 0xFF),
+        I_ST(R1, R3, 0),
+        I_MOVR(R0, R3),
+        M_BGE(LBL_READ_NACK, burst + BME280_BURST_LEN - 1),
+        SDA_LOW,
+        M_LABEL(LBL_READ_NACK),
+        SCL_RELEASE,
+        SCL_LOW,
+        I_ADDI(R3, R3, 1),
+        I_MOVR(R0, R3),
+        M_BL(LBL_READ_BYTE, burst + BME280_BURST_LEN),
+
+        // STOP
+        SDA_LOW,
+        SCL_RELEASE,
+        SDA_RELEASE,
+
+        // R3 = &samples[count * 3], then count++
+        I_MOVI(R2, 0),
+        I_LD(R0, R2, count),
+        I_ADDR(R3, R0, R0),
+        I_ADDR(R3, R3, R0),
+        I_ADDI(R3, R3, samples),
+        I_ADDI(R0, R0, 1),
+        I_ST(R0, R2, count),
+
+        // Upper 16 bits of T and P, all of H (burst: P P P T T T H H)
+        I_LD(R0, R2, burst + 3),
+        I_LSHI(R0, R0, 8),
+        I_LD(R1, R2, burst + 4),
+        I_ORR(R0, R0, R1),
+        I_ST(R0, R3, SENSOR_CHANNEL_TEMPERATURE),
+        I_LD(R0, R2, burst + 6),
+        I_LSHI(R0, R0, 8),
+        I_LD(R1, R2, burst + 7),
+        I_ORR(R0, R0, R1),
+        I_ST(R0, R3, SENSOR_CHANNEL_HUMIDITY),
+        I_LD(R0, R2, burst + 0),
+        I_LSHI(R0, R0, 8),
+        I_LD(R1, R2, burst + 1),
+        I_ORR(R0, R0, R1),
+        I_ST(R0, R3, SENSOR_CHANNEL_PRESSURE),
+
+        // |sample - reference| > threshold wakes the main cores; the last
+        // SUBR borrows exactly when the difference exceeds the threshold
+        I_LD(R0, R3, SENSOR_CHANNEL_TEMPERATURE),
+        I_LD(R1, R2, reference + SENSOR_CHANNEL_TEMPERATURE),
+        I_SUBR(R0, R0, R1),
+        M_BL(LBL_ABS_T, 0x8000),
+        I_SUBR(R0, R2, R0),
+        M_LABEL(LBL_ABS_T),
+        I_LD(R1, R2, threshold + SENSOR_CHANNEL_TEMPERATURE),
+        I_SUBR(R0, R1, R0),
+        M_BXF(LBL_WAKE),
+
+        I_LD(R0, R3, SENSOR_CHANNEL_HUMIDITY),
+        I_LD(R1, R2, reference + SENSOR_CHANNEL_HUMIDITY),
+        I_SUBR(R0, R0, R1),
+        M_BL(LBL_ABS_H, 0x8000),
+        I_SUBR(R0, R2, R0),
+        M_LABEL(LBL_ABS_H),
+        I_LD(R1, R2, threshold + SENSOR_CHANNEL_HUMIDITY),
+        I_SUBR(R0, R1, R0),
+        M_BXF(LBL_WAKE),
+
+        I_LD(R0, R3, SENSOR_CHANNEL_PRESSURE),
+        I_LD(R1, R2, reference + SENSOR_CHANNEL_PRESSURE),
+        I_SUBR(R0, R0, R1),
+        M_BL(LBL_ABS_P, 0x8000),
+        I_SUBR(R0, R2, R0),
+        M_LABEL(LBL_ABS_P),
+        I_LD(R1, R2, threshold + SENSOR_CHANNEL_PRESSURE),
+        I_SUBR(R0, R1, R0),
+        M_BXF(LBL_WAKE),
+
+        // Wake once the batch is full, otherwise sleep until the next period
+        I_LD(R0, R2, count),
+        M_BGE(LBL_WAKE, ULP_SAMPLER_BATCH_SIZE),
+        I_HALT(),
+
+        M_LABEL(LBL_WAKE),
+        I_WAKE(),
+        I_HALT(),
+
+        // NACK: release the bus and drop this sample
+        M_LABEL(LBL_ERROR),
+        SDA_LOW,
+        SCL_RELEASE,
+        SDA_RELEASE,
+        I_HALT(),
+
+        // Write R1 MSB first and check the ACK; returns to R3
+        M_LABEL(LBL_WRITE),
+        I_MOVI(R2, 8),
+        M_LABEL(LBL_WRITE_BIT),
+        I_ANDI(R0, R1, 0x80),
+        M_BL(LBL_WRITE_ZERO, 1),
+        SDA_RELEASE,
+        M_BX(LBL_WRITE_CLOCK),
+        M_LABEL(LBL_WRITE_ZERO),
+        SDA_LOW,
+        M_LABEL(LBL_WRITE_CLOCK),
+        SCL_RELEASE,
+        I_DELAY(ULP_I2C_SETTLE_CYCLES),
+        SCL_LOW,
+        I_LSHI(R1, R1, 1),
+        I_SUBI(R2, R2, 1),
+        I_MOVR(R0, R2),
+        M_BGE(LBL_WRITE_BIT, 1),
+        SDA_RELEASE,
+        SCL_RELEASE,
+        I_DELAY(ULP_I2C_SETTLE_CYCLES),
+        SDA_READ,
+        SCL_LOW,
+        M_BGE(LBL_ERROR, 1),
+        I_BXR(R3),
+    };
+
+    size_t size = sizeof(program) / sizeof(ulp_insn_t);
+    esp_err_t err = ulp_process_macros_and_load(0, program, &size);
+    if (err != ESP_OK) {
+        Serial.println("ULP program not loaded: " + String(esp_err_to_name(err)));
+        return false;
+    }
+    return true;
+}
+
+static void setupPin(int pin) {
+    gpio_num_t gpio = (gpio_num_t)pin;
+    rtc_gpio_init(gpio);
+    rtc_gpio_set_level(gpio, 0);
+    rtc_gpio_set_direction(gpio, RTC_GPIO_MODE_INPUT_ONLY);
+    rtc_gpio_pulldown_dis(gpio);
+    rtc_gpio_pullup_en(gpio);
+}
+
+bool UlpSampler::start(int sda, int scl, const BME280RawData& reference,
+                       const UlpThresholds& thresholds, uint32_t intervalMs) {
+    if (!rtc_gpio_is_valid_gpio((gpio_num_t)sda) || !rtc_gpio_is_valid_gpio((gpio_num_t)scl)) {
+        Serial.println("ULP sampling needs RTC-capable I2C pins");
+        return false;
+    }
+
+    if (shared.magic != ULP_SHARED_MAGIC) {
+        memset(&shared, 0, sizeof(shared));
+        shared.magic = ULP_SHARED_MAGIC;
+    }
+
+    UlpRawSample ref = truncate(reference);
+    shared.reference[SENSOR_CHANNEL_TEMPERATURE] = ref.temperature;
+    shared.reference[SENSOR_CHANNEL_HUMIDITY] = ref.humidity;
+    shared.reference[SENSOR_CHANNEL_PRESSURE] = ref.pressure;
+    shared.threshold[SENSOR_CHANNEL_TEMPERATURE] =
+        thresholdCounts(bme, reference, SENSOR_CHANNEL_TEMPERATURE, thresholds.temperature);
+    shared.threshold[SENSOR_CHANNEL_HUMIDITY] =
+        thresholdCounts(bme, reference, SENSOR_CHANNEL_HUMIDITY, thresholds.humidity);
+    shared.threshold[SENSOR_CHANNEL_PRESSURE] =
+        thresholdCounts(bme, reference, SENSOR_CHANNEL_PRESSURE, thresholds.pressure);
+    shared.count = 0;
+    shared.sda = sda;
+    shared.scl = scl;
+
+    if (!loadProgram(bme.getAddress(), sda, scl)) {
+        return false;
+    }
+
+    setupPin(sda);
+    setupPin(scl);
+
+    if (ulp_set_wakeup_period(0, intervalMs * 1000) != ESP_OK) {
+        Serial.println("ULP sampling interval out of range: " + String(intervalMs) + " ms");
+        rtc_gpio_deinit((gpio_num_t)sda);
+        rtc_gpio_deinit((gpio_num_t)scl);
+        return false;
+    }
+
+    if (ulp_run(0) != ESP_OK) {
+        rtc_gpio_deinit((gpio_num_t)sda);
+        rtc_gpio_deinit((gpio_num_t)scl);
+        return false;
+    }
+
+    esp_sleep_enable_ulp_wakeup();
+    shared.active = 1;
+    return true;
+}
+
+void UlpSampler::stop() {
+    wakeReason = ULP_WAKE_NONE;
+    count = 0;
+    if (!wasActive()) {
+        return;
+    }
+
+    // Stop the ULP timer; a program already running finishes within microseconds
+    CLEAR_PERI_REG_MASK(RTC_CNTL_ULP_CP_TIMER_REG, RTC_CNTL_ULP_CP_SLP_TIMER_EN);
+    delayMicroseconds(500);
+
+    rtc_gpio_deinit((gpio_num_t)shared.sda);
+    rtc_gpio_deinit((gpio_num_t)shared.scl);
+    shared.active = 0;
+
+    uint32_t n = shared.count & 0xFFFF;
+    if (n > ULP_SAMPLER_BATCH_SIZE) {
+        n = ULP_SAMPLER_BATCH_SIZE;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        const uint32_t* words = &shared.samples[i * SENSOR_CHANNEL_COUNT];
+        samples[i].temperature = (uint16_t)(words[SENSOR_CHANNEL_TEMPERATURE] & 0xFFFF);
+        samples[i].humidity = (uint16_t)(words[SENSOR_CHANNEL_HUMIDITY] & 0xFFFF);
+        samples[i].pressure = (uint16_t)(words[SENSOR_CHANNEL_PRESSURE] & 0xFFFF);
+    }
+    count = (uint8_t)n;
+    shared.count = 0;
+    shared.totalSamples += n;
+
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_ULP) {
+        wakeReason = n >= ULP_SAMPLER_BATCH_SIZE ? ULP_WAKE_BATCH_FULL : ULP_WAKE_THRESHOLD;
+        shared.totalWakes++;
+    }
+}
+
+#else
+
+bool UlpSampler::start(int sda, int scl, const BME280RawData& reference,
+                       const UlpThresholds& thresholds, uint32_t intervalMs) {
+    (void)sda;
+    (void)scl;
+    (void)reference;
+    (void)thresholds;
+    (void)intervalMs;
+    return false;
+}
+
+void UlpSampler::stop() {
+    wakeReason = ULP_WAKE_NONE;
+    count = 0;
+}
+
+#endif // ULP program
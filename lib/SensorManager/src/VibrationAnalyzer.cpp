@@ -0,0 +1,231 @@
+#include "VibrationAnalyzer.h"
+#include <math.h>
+#include <string.h>
+
+#if VIBRATION_USE_ESP_DSP
+#include <esp_dsp.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static_assert((VIBRATION_FFT_SIZE & (VIBRATION_FFT_SIZE - 1)) == 0, "VIBRATION_FFT_SIZE must be a power of two");
+
+VibrationAnalyzer::VibrationAnalyzer() :
+    sampleRate(1.0F),
+    scale(1.0F),
+    windowSum(0.0F),
+    windowSquares(0.0F),
+    fftReady(false) {
+    memset(bandEdges, 0, sizeof(bandEdges));
+    memset(magnitude, 0, sizeof(magnitude));
+
+    // Hann window and twiddle factors are computed once
+    for (int n = 0; n < VIBRATION_FFT_SIZE; n++) {
+        window[n] = 0.5F - 0.5F * cosf(2.0F * (float)M_PI * n / VIBRATION_FFT_SIZE);
+        windowSum += window[n];
+        windowSquares += window[n] * window[n];
+    }
+    for (int k = 0; k < VIBRATION_FFT_SIZE / 2; k++) {
+        twiddle[2 * k] = cosf(2.0F * (float)M_PI * k / VIBRATION_FFT_SIZE);
+        twiddle[2 * k + 1] = -sinf(2.0F * (float)M_PI * k / VIBRATION_FFT_SIZE);
+    }
+}
+
+bool VibrationAnalyzer::begin(float sampleRateHz, float unitsPerCount) {
+    sampleRate = sampleRateHz;
+    scale = unitsPerCount;
+
+#if VIBRATION_BANDS == 4
+    const float defaults[] = { 1.0F, sampleRateHz / 160.0F, sampleRateHz / 32.0F,
+                               sampleRateHz / 8.0F, sampleRateHz / 2.0F };
+    setBands(defaults);
+#else
+    // Log-spaced from 1 Hz to Nyquist
+    for (int b = 0; b <= VIBRATION_BANDS; b++) {
+        bandEdges[b] = powf(sampleRateHz / 2.0F, (float)b / VIBRATION_BANDS);
+    }
+#endif
+
+#if VIBRATION_USE_ESP_DSP
+    // The table is shared by all instances; a second init is harmless
+    fftReady = dsps_fft2r_init_fc32(NULL, VIBRATION_FFT_SIZE) == ESP_OK;
+#else
+    fftReady = true;
+#endif
+    return fftReady;
+}
+
+void VibrationAnalyzer::setBands(const float* edges) {
+    memcpy(bandEdges, edges, sizeof(bandEdges));
+}
+
+void VibrationAnalyzer::fftScalar(float* data) const {
+    const int n = VIBRATION_FFT_SIZE;
+
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float re = data[2 * i];
+            float im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    // Iterative decimation-in-time butterflies
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int stride = n / len;
+        for (int start = 0; start < n; start += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = twiddle[2 * k * stride];
+                float wi = twiddle[2 * k * stride + 1];
+                float* a = &data[2 * (start + k)];
+                float* b = &data[2 * (start + k + half)];
+                float tr = b[0] * wr - b[1] * wi;
+                float ti = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+void VibrationAnalyzer::fft(float* data) {
+#if VIBRATION_USE_ESP_DSP
+    if (fftReady) {
+        dsps_fft2r_fc32(data, VIBRATION_FFT_SIZE);
+        dsps_bit_rev_fc32(data, VIBRATION_FFT_SIZE);
+        return;
+    }
+#endif
+    fftScalar(data);
+}
+
+void VibrationAnalyzer::analyze(const int16_t* samples, VibrationFeatures& features) {
+    memset(&features, 0, sizeof(features));
+
+    int32_t sum = 0;
+    for (int n = 0; n < VIBRATION_FFT_SIZE; n++) {
+        sum += samples[n];
+    }
+    float mean = (float)sum / VIBRATION_FFT_SIZE;
+
+    // Mean removal, scaling and windowing in one pass; the imaginary part is zero
+    float squares = 0.0F;
+    for (int n = 0; n < VIBRATION_FFT_SIZE; n++) {
+        float x = (samples[n] - mean) * scale;
+        squares += x * x;
+        work[2 * n] = x * window[n];
+        work[2 * n + 1] = 0.0F;
+    }
+    features.rms = sqrtf(squares / VIBRATION_FFT_SIZE);
+
+    fft(work);
+
+    // One-sided magnitudes and band energies
+    const float binWidth = getBinWidth();
+    const float powerScale = 2.0F / ((float)VIBRATION_FFT_SIZE * windowSquares);
+    float bandEnergy[VIBRATION_BANDS] = { 0 };
+    int band = 0;
+    for (int k = 0; k <= VIBRATION_FFT_SIZE / 2; k++) {
+        float re = work[2 * k];
+        float im = work[2 * k + 1];
+        float power = re * re + im * im;
+        magnitude[k] = sqrtf(power);
+
+        float frequency = k * binWidth;
+        while (band < VIBRATION_BANDS - 1 && frequency >= bandEdges[band + 1]) {
+            band++;
+        }
+        if (frequency >= bandEdges[0] && frequency <= bandEdges[VIBRATION_BANDS]) {
+            // DC and Nyquist have no mirror image
+            float factor = (k == 0 || k == VIBRATION_FFT_SIZE / 2) ? 0.5F : 1.0F;
+            bandEnergy[band] += power * powerScale * factor;
+        }
+    }
+    for (int b = 0; b < VIBRATION_BANDS; b++) {
+        features.bandRms[b] = sqrtf(bandEnergy[b]);
+    }
+
+    findPeaks(features);
+}
+
+void VibrationAnalyzer::findPeaks(VibrationFeatures& features) const {
+    const float binWidth = getBinWidth();
+    int first = (int)ceilf(bandEdges[0] / binWidth);
+    if (first < 1) first = 1;
+
+    int bins[VIBRATION_PEAKS];
+    uint8_t count = 0;
+
+    // Keep the strongest local maxima, sorted by magnitude
+    for (int k = first; k < VIBRATION_FFT_SIZE / 2; k++) {
+        float m = magnitude[k];
+        if (m <= 0.0F || m <= magnitude[k - 1] || m < magnitude[k + 1]) continue;
+
+        int pos = count;
+        while (pos > 0 && magnitude[bins[pos - 1]] < m) {
+            pos--;
+        }
+        if (pos >= VIBRATION_PEAKS) continue;
+
+        int last = count < VIBRATION_PEAKS ? count : VIBRATION_PEAKS - 1;
+        for (int i = last; i > pos; i--) {
+            bins[i] = bins[i - 1];
+        }
+        bins[pos] = k;
+        if (count < VIBRATION_PEAKS) count++;
+    }
+
+    // Parabolic interpolation around each maximum
+    for (uint8_t i = 0; i < count; i++) {
+        int k = bins[i];
+        float a = magnitude[k - 1];
+        float b = magnitude[k];
+        float c = magnitude[k + 1];
+        float denominator = a - 2.0F * b + c;
+        float delta = denominator != 0.0F ? 0.5F * (a - c) / denominator : 0.0F;
+
+        features.peaks[i].frequency = (k + delta) * binWidth;
+        features.peaks[i].amplitude = 2.0F * (b - 0.25F * (a - c) * delta) / windowSum;
+    }
+    features.peakCount = count;
+}
+
+static void putScaled(uint8_t* buffer, float value, float factor) {
+    float scaled = value * factor + 0.5F;
+    uint16_t raw = scaled <= 0.0F ? 0 : (scaled >= 65535.0F ? 65535 : (uint16_t)scaled);
+    buffer[0] = raw >> 8;
+    buffer[1] = raw & 0xFF;
+}
+
+size_t VibrationAnalyzer::encode(const VibrationFeatures& features, uint8_t* buffer) {
+    uint8_t* p = buffer;
+    putScaled(p, features.rms, 1000.0F);
+    p += 2;
+
+    for (int i = 0; i < VIBRATION_PEAKS; i++) {
+        bool present = i < features.peakCount;
+        putScaled(p, present ? features.peaks[i].frequency : 0.0F, 10.0F);
+        putScaled(p + 2, present ? features.peaks[i].amplitude : 0.0F, 1000.0F);
+        p += 4;
+    }
+
+    for (int b = 0; b < VIBRATION_BANDS; b++) {
+        putScaled(p, features.bandRms[b], 1000.0F);
+        p += 2;
+    }
+    return p - buffer;
+}
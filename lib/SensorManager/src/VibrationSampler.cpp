@@ -0,0 +1,119 @@
+#include "VibrationSampler.h"
+#include <string.h>
+
+VibrationSampler::VibrationSampler() :
+    front(0),
+    channel(-1),
+    sampleRate(0),
+    blockCount(0),
+    overruns(0),
+    running(false) {
+    memset(blocks, 0, sizeof(blocks));
+}
+
+// ADC continuous mode; host builds only get the buffers above
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <driver/adc.h>
+
+// Full 0-3.1 V range: an analog accelerometer idles at half supply
+#define VIBRATION_ADC_ATTEN ADC_ATTEN_DB_11
+
+bool VibrationSampler::begin(int adcPin, uint32_t sampleRateHz) {
+    if (running) {
+        end();
+    }
+
+    channel = digitalPinToAnalogChannel(adcPin);
+    if (channel < 0 || channel >= ADC1_CHANNEL_MAX ||
+        sampleRateHz < SOC_ADC_SAMPLE_FREQ_THRES_LOW || sampleRateHz > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+        channel = -1;
+        return false;
+    }
+
+    // The pool holds two blocks: one being analyzed, one being converted
+    adc_digi_init_config_t init = {};
+    init.max_store_buf_size = 2 * VIBRATION_FFT_SIZE * SOC_ADC_DIGI_RESULT_BYTES;
+    init.conv_num_each_intr = VIBRATION_DMA_FRAME * SOC_ADC_DIGI_RESULT_BYTES;
+    init.adc1_chan_mask = 1 << channel;
+    init.adc2_chan_mask = 0;
+    if (adc_digi_initialize(&init) != ESP_OK) {
+        return false;
+    }
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = VIBRATION_ADC_ATTEN;
+    pattern.channel = channel;
+    pattern.unit = 0;  // ADC1
+    pattern.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+    adc_digi_configuration_t config = {};
+    config.conv_limit_en = false;
+    config.pattern_num = 1;
+    config.adc_pattern = &pattern;
+    config.sample_freq_hz = sampleRateHz;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+
+    if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+        adc_digi_deinitialize();
+        return false;
+    }
+
+    sampleRate = sampleRateHz;
+    running = true;
+    return true;
+}
+
+void VibrationSampler::end() {
+    if (!running) return;
+    adc_digi_stop();
+    adc_digi_deinitialize();
+    running = false;
+}
+
+const int16_t* VibrationSampler::capture(uint32_t timeoutMs) {
+    if (!running) return NULL;
+
+    uint8_t back = front ^ 1;
+    int16_t* block = blocks[back];
+    uint32_t filled = 0;
+    bool lost = false;
+    uint32_t start = millis();
+
+    // Drain one DMA frame at a time straight into the back buffer
+    uint8_t frame[VIBRATION_DMA_FRAME * SOC_ADC_DIGI_RESULT_BYTES];
+    while (filled < VIBRATION_FFT_SIZE) {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= timeoutMs) {
+            return NULL;
+        }
+
+        uint32_t length = 0;
+        esp_err_t result = adc_digi_read_bytes(frame, sizeof(frame), &length, timeoutMs - elapsed);
+        if (result == ESP_ERR_INVALID_STATE) {
+            // The pool overflowed and old conversions were dropped
+            lost = true;
+        } else if (result != ESP_OK) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= length && filled < VIBRATION_FFT_SIZE;
+             i += SOC_ADC_DIGI_RESULT_BYTES) {
+            const adc_digi_output_data_t* out = (const adc_digi_output_data_t*)&frame[i];
+            if (out->type2.channel == (uint32_t)channel) {
+                block[filled++] = (int16_t)out->type2.data;
+            }
+        }
+    }
+
+    if (lost) {
+        overruns++;
+    }
+    blockCount++;
+    front = back;
+    return block;
+}
+
+#endif // ARDUINO
@@ -0,0 +1,38 @@
+#include <Arduino.h>
+#include <ReportPolicy.h>
+
+// Simulated sensor: a slow drift with an occasional step
+ReportPolicy report;
+float temperature = 21.0;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) delay(10);
+
+  Serial.println("\nTelemetryManager Report-by-Exception Example");
+  Serial.println("============================================");
+
+  // Short intervals so the example shows all decisions within a few minutes
+  report.setMinSpacing(10000);
+  report.setMaxSilence(60000);
+  report.setDeadband(REPORT_FIELD_TEMPERATURE, 0.5, 0.0);
+}
+
+void loop() {
+  temperature += (random(0, 100) < 5) ? 1.0 : 0.01;
+
+  float values[REPORT_FIELD_COUNT] = { temperature, 45.0, 1013.0, 3.9 };
+  ReportReason reason = report.evaluate(values, false, millis());
+
+  if (ReportPolicy::shouldSend(reason)) {
+    Serial.printf("Uplink: %.2f C (reason %d)\n", temperature, reason);
+    report.commit(values, reason, millis());
+  }
+
+  const ReportStats& stats = report.getStats();
+  Serial.printf("sent %lu, suppressed %lu, ratio %.1f\n",
+                (unsigned long)stats.sent, (unsigned long)stats.suppressed,
+                stats.suppressionRatio());
+
+  delay(2000);
+}
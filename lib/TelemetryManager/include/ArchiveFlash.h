@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Erase unit of the SPI flash (SPI_FLASH_SEC_SIZE)
+#define ARCHIVE_FLASH_SECTOR_SIZE 4096
+
+// Label of the archive partition in partitions.csv
+#ifndef ARCHIVE_PARTITION_LABEL
+#define ARCHIVE_PARTITION_LABEL "archive"
+#endif
+
+/**
+ * @brief Flash region that SampleArchive writes to
+ *
+ * NOR semantics: erase() sets a whole sector to 0xFF, write() can only clear
+ * bits. Reads go through data(), a read-only mapping of the whole region, so
+ * the archive hands out pointers instead of copying records out.
+ */
+class ArchiveFlash {
+public:
+    virtual ~ArchiveFlash() {}
+
+    /**
+     * @brief Region size in bytes, a multiple of ARCHIVE_FLASH_SECTOR_SIZE
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Memory-mapped contents, or null if the region is not mapped
+     */
+    virtual const uint8_t* data() const = 0;
+
+    /**
+     * @brief Erase the sector starting at offset
+     */
+    virtual bool erase(size_t offset) = 0;
+
+    /**
+     * @brief Program bytes at offset (bits can only go from 1 to 0)
+     */
+    virtual bool write(size_t offset, const void* data, size_t length) = 0;
+};
+
+#if defined(ARDUINO)
+#include <esp_partition.h>
+
+/**
+ * @brief ArchiveFlash over a data partition, mapped with esp_partition_mmap()
+ *
+ * esp_partition_write() and esp_partition_erase_range() flush the cache
+ * lines of the range they touch, so the mapping sees new records at once.
+ */
+class PartitionFlash : public ArchiveFlash {
+public:
+    PartitionFlash();
+    ~PartitionFlash();
+
+    /**
+     * @brief Find and map the partition
+     *
+     * @param label Partition name in the partition table
+     * @return true if the partition exists and is mapped
+     */
+    bool begin(const char* label = ARCHIVE_PARTITION_LABEL);
+
+    size_t size() const override;
+    const uint8_t* data() const override { return mapped; }
+    bool erase(size_t offset) override;
+    bool write(size_t offset, const void* data, size_t length) override;
+
+private:
+    const esp_partition_t* partition;
+    const uint8_t* mapped;
+    spi_flash_mmap_handle_t handle;
+};
+#endif
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string.h>
+#include "ArchiveFlash.h"
+
+// Typical timings of the 8 MB quad SPI NOR on the Heltec V3 (W25Q64 class)
+#define FAKE_FLASH_PAGE_SIZE 256
+#define FAKE_FLASH_PAGE_PROGRAM_US 400
+#define FAKE_FLASH_SECTOR_ERASE_US 45000
+
+/**
+ * @brief RAM-backed NOR flash for host tests and benchmarks
+ *
+ * Behaves like the real part: erased bytes read 0xFF and programming ANDs
+ * the new bits in. A write that would have to set a cleared bit fails and is
+ * counted, so a test catches the archive rewriting flash without an erase.
+ * Busy time accumulates per sector erase and per page touched by a write.
+ */
+class FakeFlash : public ArchiveFlash {
+public:
+    uint32_t erases;
+    uint32_t writes;
+    uint32_t bytesWritten;
+    uint32_t violations;     // Writes that needed an erase first
+    uint64_t busyUs;         // Modelled program/erase time
+
+    explicit FakeFlash(size_t size) :
+        memory(new uint8_t[size]),
+        length(size - size % ARCHIVE_FLASH_SECTOR_SIZE),
+        failWrites(false) {
+        memset(memory, 0xFF, size);
+        resetCounters();
+    }
+
+    ~FakeFlash() {
+        delete[] memory;
+    }
+
+    FakeFlash(const FakeFlash&) = delete;
+    FakeFlash& operator=(const FakeFlash&) = delete;
+
+    size_t size() const override { return length; }
+    const uint8_t* data() const override { return memory; }
+
+    bool erase(size_t offset) override {
+        if (offset % ARCHIVE_FLASH_SECTOR_SIZE != 0 || offset >= length) return false;
+        memset(memory + offset, 0xFF, ARCHIVE_FLASH_SECTOR_SIZE);
+        erases++;
+        busyUs += FAKE_FLASH_SECTOR_ERASE_US;
+        return true;
+    }
+
+    bool write(size_t offset, const void* data, size_t count) override {
+        if (failWrites || offset + count > length) return false;
+
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < count; i++) {
+            if (bytes[i] & ~memory[offset + i]) {
+                violations++;
+                return false;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            memory[offset + i] &= bytes[i];
+        }
+
+        writes++;
+        bytesWritten += count;
+        size_t pages = (offset + count - 1) / FAKE_FLASH_PAGE_SIZE - offset / FAKE_FLASH_PAGE_SIZE + 1;
+        busyUs += pages * FAKE_FLASH_PAGE_PROGRAM_US;
+        return true;
+    }
+
+    /**
+     * @brief Make every following write fail, e.g. to cut power mid-record
+     */
+    void setFailWrites(bool fail) { failWrites = fail; }
+
+    void resetCounters() {
+        erases = 0;
+        writes = 0;
+        bytesWritten = 0;
+        violations = 0;
+        busyUs = 0;
+    }
+
+private:
+    uint8_t* memory;
+    size_t length;
+    bool failWrites;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include "ReportPolicy.h"
+
+// Default bounds of the sampling interval
+#ifndef INTERVAL_MIN_MS
+#define INTERVAL_MIN_MS 30000UL
+#endif
+
+#ifndef INTERVAL_MAX_MS
+#define INTERVAL_MAX_MS 900000UL
+#endif
+
+// Fraction of a deadband the signal may move between two samples
+#ifndef INTERVAL_TARGET_CHANGE
+#define INTERVAL_TARGET_CHANGE 0.5F
+#endif
+
+// Largest growth of the interval per sample (shrinking is immediate)
+#ifndef INTERVAL_GROWTH
+#define INTERVAL_GROWTH 1.5F
+#endif
+
+/**
+ * @brief Sampling interval driven by signal dynamics, motion and battery
+ *
+ * Each update() measures how fast the fields move, in deadbands per unit
+ * time, and picks the interval at which the next sample is expected to move
+ * INTERVAL_TARGET_CHANGE deadbands. A faster signal or motion shortens the
+ * interval at once; a calm signal lets it grow by at most INTERVAL_GROWTH
+ * per sample, so a single quiet sample does not jump to the maximum. The
+ * battery factor stretches the result. Everything is clamped to the bounds.
+ */
+class IntervalController {
+public:
+    IntervalController();
+
+    /**
+     * @brief Feed a new sample and compute the next interval
+     *
+     * @param values REPORT_FIELD_COUNT values in ReportField order (NAN skipped)
+     * @param motion true if motion started since the previous sample
+     * @param nowMs Time of the sample
+     * @return uint32_t Interval until the next sample, in ms
+     */
+    uint32_t update(const float* values, bool motion, uint32_t nowMs);
+
+    /**
+     * @brief Interval until the next sample, including the battery factor
+     */
+    uint32_t getIntervalMs() const;
+
+    /**
+     * @brief Largest rate seen in the last update, in deadbands per minute
+     */
+    float getActivity() const { return activity; }
+
+    /**
+     * @brief Set the interval bounds
+     */
+    void setBounds(uint32_t minMs, uint32_t maxMs);
+
+    /**
+     * @brief Stretch the interval, e.g. 2 or 4 while the battery is low
+     */
+    void setBatteryFactor(uint8_t factor) { batteryFactor = factor > 0 ? factor : 1; }
+
+    /**
+     * @brief Measure change in units of the report deadbands
+     *
+     * Fields without an absolute deadband use their relative band at the
+     * last value.
+     */
+    void useDeadbands(const ReportPolicyConfig& config);
+
+    /**
+     * @brief Forget the history, e.g. after a long gap
+     */
+    void reset();
+
+private:
+    float scale[REPORT_FIELD_COUNT];
+    float lastValues[REPORT_FIELD_COUNT];
+    float relative[REPORT_FIELD_COUNT];
+    uint32_t lastMs;
+    bool hasLast;
+    uint32_t minMs;
+    uint32_t maxMs;
+    uint32_t intervalMs;
+    uint8_t batteryFactor;
+    float activity;
+};
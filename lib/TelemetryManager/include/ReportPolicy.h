@@ -0,0 +1,170 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Default heartbeat: send at least this often even if nothing changed
+#ifndef REPORT_MAX_SILENCE_MS
+#define REPORT_MAX_SILENCE_MS 3600000UL
+#endif
+
+// Default minimum time between two uplinks
+#ifndef REPORT_MIN_SPACING_MS
+#define REPORT_MIN_SPACING_MS 60000UL
+#endif
+
+// Downlink layout (type byte shared with the payload formatter's CONFIG type)
+#define REPORT_DOWNLINK_CONFIG       0x01
+#define REPORT_CONFIG_DEADBAND       0x02  // field, absolute (u16, 0.01 units), relative (u8, 0.1 %)
+#define REPORT_CONFIG_MAX_SILENCE    0x03  // seconds (u24)
+#define REPORT_CONFIG_MIN_SPACING    0x04  // seconds (u24)
+
+/**
+ * @brief Fields compared against their last reported value
+ */
+enum ReportField : uint8_t {
+    REPORT_FIELD_TEMPERATURE = 0,  // °C
+    REPORT_FIELD_HUMIDITY,         // %RH
+    REPORT_FIELD_PRESSURE,         // hPa
+    REPORT_FIELD_BATTERY,          // V
+    REPORT_FIELD_COUNT
+};
+
+/**
+ * @brief Why evaluate() decided to send (or not)
+ */
+enum ReportReason : uint8_t {
+    REPORT_SUPPRESSED = 0,  // Nothing changed beyond its deadband
+    REPORT_DEFERRED,        // Something to send, but the minimum spacing has not passed
+    REPORT_FIRST,           // Nothing has been sent yet
+    REPORT_CHANGED,         // A field left its deadband
+    REPORT_EVENT,           // The caller flagged an event (e.g. motion)
+    REPORT_HEARTBEAT        // Maximum silence reached
+};
+
+/**
+ * @brief Change needed before a field is reported again
+ *
+ * A field is reported when it moves more than either enabled band away from
+ * the last reported value. Bands <= 0 are disabled; a field with both bands
+ * disabled is only sent with other changes or the heartbeat.
+ */
+struct ReportDeadband {
+    float absolute;  // In the field's unit
+    float relative;  // Fraction of the last reported value, e.g. 0.02 = 2 %
+};
+
+struct ReportPolicyConfig {
+    ReportDeadband deadband[REPORT_FIELD_COUNT];
+    uint32_t maxSilenceMs;  // Heartbeat period
+    uint32_t minSpacingMs;  // Minimum time between uplinks
+};
+
+struct ReportStats {
+    uint32_t sent;        // Uplinks committed
+    uint32_t suppressed;  // Evaluations with nothing to report
+    uint32_t deferred;    // Evaluations held back by the minimum spacing
+    uint32_t heartbeats;  // Uplinks sent only because of the heartbeat
+
+    /**
+     * @brief Suppressed evaluations per uplink sent
+     */
+    float suppressionRatio() const {
+        return sent > 0 ? (float)suppressed / sent : 0.0F;
+    }
+};
+
+/**
+ * @brief Report-by-exception decision between sensor readings and the radio
+ *
+ * The caller evaluates every new reading; the policy compares it with the
+ * values of the last uplink and only asks for a new uplink when a field
+ * leaves its deadband, an event is flagged, or the heartbeat is due, never
+ * closer together than the minimum spacing. Changes and events that fall
+ * inside the spacing are reported at the first evaluation after it.
+ */
+class ReportPolicy {
+public:
+    ReportPolicy();
+
+    /**
+     * @brief Decide whether the current values need an uplink
+     *
+     * NAN values are allowed; a field switching between NAN and a number
+     * counts as a change.
+     *
+     * @param values REPORT_FIELD_COUNT values in ReportField order
+     * @param event true to report regardless of deadbands (spacing still applies)
+     * @param nowMs Current time
+     * @return ReportReason REPORT_SUPPRESSED or REPORT_DEFERRED if nothing should be sent
+     */
+    ReportReason evaluate(const float* values, bool event, uint32_t nowMs);
+
+    /**
+     * @brief Whether a reason returned by evaluate() means "send now"
+     */
+    static bool shouldSend(ReportReason reason) { return reason >= REPORT_FIRST; }
+
+    /**
+     * @brief Record a successful uplink of these values
+     *
+     * Failed uplinks should not be committed so the change is retried.
+     *
+     * @param values Values that were sent
+     * @param reason Reason returned by evaluate()
+     * @param nowMs Time of the uplink
+     */
+    void commit(const float* values, ReportReason reason, uint32_t nowMs);
+
+    /**
+     * @brief Bit mask of fields (1 << ReportField) outside their deadband
+     */
+    uint8_t changedFields(const float* values) const;
+
+    /**
+     * @brief Apply a configuration downlink
+     *
+     * @param payload Downlink bytes starting with REPORT_DOWNLINK_CONFIG
+     * @param size Number of bytes
+     * @return true if the payload was a valid report configuration
+     */
+    bool applyDownlink(const uint8_t* payload, size_t size);
+
+    const ReportPolicyConfig& getConfig() const { return config; }
+    void setConfig(const ReportPolicyConfig& config) { this->config = config; }
+    void setDeadband(ReportField field, float absolute, float relative);
+    void setMinSpacing(uint32_t ms) { config.minSpacingMs = ms; }
+    void setMaxSilence(uint32_t ms) { config.maxSilenceMs = ms; }
+
+    /**
+     * @brief Stretch the configured spacing, e.g. while the battery is low
+     */
+    void setSpacingFactor(uint8_t factor) { spacingFactor = factor > 0 ? factor : 1; }
+
+    /**
+     * @brief Spacing in effect: configured spacing times the spacing factor
+     */
+    uint32_t getMinSpacingMs() const { return config.minSpacingMs * spacingFactor; }
+
+    const ReportStats& getStats() const { return stats; }
+    void resetStats();
+
+    /**
+     * @brief Time of the last committed uplink
+     */
+    uint32_t getLastSentMs() const { return lastSentMs; }
+
+    /**
+     * @brief Default deadbands, heartbeat and spacing
+     */
+    static ReportPolicyConfig defaultConfig();
+
+private:
+    ReportPolicyConfig config;
+    ReportStats stats;
+    float lastSent[REPORT_FIELD_COUNT];
+    uint32_t lastSentMs;
+    bool hasSent;
+    bool eventPending;
+    uint8_t spacingFactor;
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ArchiveFlash.h"
+#include "SeriesCodec.h"
+
+// Sectors tracked by the time index (64 x 4 KB = the 256 KB partition)
+#ifndef SAMPLE_ARCHIVE_MAX_SECTORS
+#define SAMPLE_ARCHIVE_MAX_SECTORS 64
+#endif
+
+// Sector header: magic, sequence number
+#define SAMPLE_ARCHIVE_MAGIC 0x31524153UL  // "SAR1"
+#define SAMPLE_ARCHIVE_SECTOR_HEADER 8
+
+// Record header: marker, frame length, 2 spare bytes, first and last time
+#define SAMPLE_ARCHIVE_RECORD_HEADER 12
+
+// Default age of the open frame that writes it as a record (seconds, 0 = only when full)
+#ifndef SAMPLE_ARCHIVE_MAX_PENDING_AGE
+#define SAMPLE_ARCHIVE_MAX_PENDING_AGE 0
+#endif
+
+// Downlink layout (type byte shared with the payload formatter's COMMAND type)
+#define SAMPLE_ARCHIVE_DOWNLINK_COMMAND 0x02
+#define SAMPLE_ARCHIVE_QUERY_COMMAND 0x03  // from, to (u32 seconds each)
+
+/**
+ * @brief One stored block, pointing into the mapped flash
+ */
+struct ArchiveRecord {
+    uint32_t firstTime;     // Seconds, first sample of the block
+    uint32_t lastTime;      // Seconds, last sample of the block
+    const uint8_t* frame;   // SeriesEncoder frame; channel 0 is the sample time
+    uint8_t size;
+};
+
+/**
+ * @brief Read position of a range query, plain data so it can live in RTC memory
+ */
+struct ArchiveCursor {
+    uint32_t sequence;      // Sector being read, 0 once the range is done
+    uint16_t offset;        // Next record in that sector
+    uint32_t from;
+    uint32_t to;
+};
+
+/**
+ * @brief Time index entry of one sector
+ */
+struct ArchiveSector {
+    uint32_t sequence;      // Order of use, 0 = free
+    uint32_t firstTime;
+    uint32_t lastTime;
+    uint16_t used;          // Bytes written, header included
+    uint16_t records;
+};
+
+/**
+ * @brief Archive counters
+ */
+struct ArchiveStats {
+    uint32_t samples;       // Appended since begin()
+    uint32_t records;       // Records in flash
+    uint32_t bytes;         // Flash in use, headers included
+    uint32_t sectors;       // Sectors in use
+    uint32_t recycled;      // Sectors erased to make room since begin()
+    uint32_t oldestTime;
+    uint32_t newestTime;
+};
+
+/**
+ * @brief Append-only history of compressed samples in a flash partition
+ *
+ * Samples are collected in a SeriesEncoder frame with the sample time as an
+ * extra delta-of-delta channel 0, so regular sampling costs one bit for the
+ * time and irregular gaps stay exact. A full frame (or flush()) becomes one
+ * record. Records are appended to 4 KB sectors; when the partition is full
+ * the oldest sector is erased, so the archive always holds the most recent
+ * weeks.
+ *
+ * The time index is sparse: one entry per sector with its first and last
+ * time, rebuilt from flash by begin(). A query binary-searches the sectors
+ * and walks the records of the first match, handing out pointers into the
+ * mapped partition; a record is never copied on the way to the radio.
+ *
+ * Power loss: a record's marker byte is programmed after the rest of it, so
+ * a torn record is skipped on the next scan. Samples still in the frame
+ * buffer are lost, so call flush() before deep sleep; setMaxPendingAge()
+ * bounds the loss on a reset that gives no warning.
+ *
+ * Times are seconds and must not go backwards; append() rejects older ones.
+ */
+class SampleArchive {
+public:
+    /**
+     * @param channels Values per sample, 1..SERIES_MAX_CHANNELS - 1
+     * @param periodSeconds Nominal sample period stored in the frames
+     * @param orderMask Bit c set: value channel c uses delta-of-delta
+     */
+    SampleArchive(uint8_t channels, uint16_t periodSeconds, uint8_t orderMask = 0);
+
+    /**
+     * @brief Scan the flash and rebuild the time index
+     *
+     * @param flash Mapped region, SAMPLE_ARCHIVE_MAX_SECTORS sectors at most are used
+     * @return false if the region is unmapped or smaller than two sectors
+     */
+    bool begin(ArchiveFlash* flash);
+
+    /**
+     * @brief Add one sample
+     *
+     * @param time Sample time in seconds, not before the newest archived sample
+     * @param values One value per channel
+     * @return false if the time went backwards or the flash write failed
+     */
+    bool append(uint32_t time, const int32_t* values);
+
+    /**
+     * @brief Write the samples collected so far as a record
+     */
+    bool flush();
+
+    /**
+     * @brief Write the open frame once its first sample is this old
+     *
+     * @param seconds Age checked by append(), 0 waits for a full frame
+     */
+    void setMaxPendingAge(uint32_t seconds) { maxPendingAge = seconds; }
+
+    /**
+     * @brief Erase everything
+     */
+    bool clear();
+
+    /**
+     * @brief Start reading the records that overlap [from, to]
+     *
+     * @return false if nothing in the archive overlaps the range
+     */
+    bool seek(uint32_t from, uint32_t to, ArchiveCursor& cursor) const;
+
+    /**
+     * @brief Next record of a range, oldest first
+     *
+     * A cursor whose sector was recycled in the meantime continues with the
+     * oldest remaining record.
+     *
+     * @return false once the range is done
+     */
+    bool next(ArchiveCursor& cursor, ArchiveRecord& record) const;
+
+    /**
+     * @brief Collect up to maxRecords records that overlap [from, to]
+     *
+     * @return Records written to records
+     */
+    size_t query(uint32_t from, uint32_t to, ArchiveRecord* records, size_t maxRecords) const;
+
+    /**
+     * @brief Start a replay from a COMMAND downlink (02 03 from to, big-endian seconds)
+     *
+     * @return true if the payload was a range request
+     */
+    bool applyDownlink(const uint8_t* payload, size_t size);
+
+    /**
+     * @brief Next record of the replay started by applyDownlink()
+     */
+    bool nextReplay(ArchiveRecord& record) { return next(replay, record); }
+
+    bool isReplaying() const { return replay.sequence != 0; }
+
+    /**
+     * @brief Replay position, e.g. to carry it across deep sleep
+     */
+    const ArchiveCursor& getReplay() const { return replay; }
+    void restoreReplay(const ArchiveCursor& cursor) { replay = cursor; }
+
+    /**
+     * @brief Time of the newest sample, archived or pending (0 if empty)
+     */
+    uint32_t getNewestTime() const { return newestTime; }
+
+    ArchiveStats getStats() const;
+
+    /**
+     * @brief Index entry of a sector (by physical position)
+     */
+    const ArchiveSector& getSector(size_t index) const { return sectors[index]; }
+    size_t getSectorCount() const { return sectorCount; }
+
+private:
+    ArchiveFlash* flash;
+    SeriesEncoder encoder;
+    uint8_t channels;
+    ArchiveSector sectors[SAMPLE_ARCHIVE_MAX_SECTORS];
+    size_t sectorCount;
+    size_t head;             // Sector being appended to
+    uint32_t pendingFirst;
+    uint32_t pendingLast;
+    uint32_t maxPendingAge;
+    uint32_t newestTime;
+    uint32_t appended;
+    uint32_t recycled;
+    ArchiveCursor replay;
+
+    void scanSector(size_t sector);
+    bool openNextSector();
+    size_t oldestSector() const;
+    size_t sectorOf(uint32_t sequence) const;
+    const uint8_t* sectorData(size_t sector) const;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Largest frame the encoder builds (US915 DR1 allows 53 bytes of application payload)
+#ifndef SERIES_MAX_BYTES
+#define SERIES_MAX_BYTES 51
+#endif
+
+// Channels per sample
+#ifndef SERIES_MAX_CHANNELS
+#define SERIES_MAX_CHANNELS 4
+#endif
+
+#define SERIES_FORMAT_VERSION 1
+
+// Version/channels, order mask, sample count, period (16-bit seconds)
+#define SERIES_HEADER_BYTES 5
+
+/**
+ * @brief Streaming encoder for batches of fixed-point sensor samples
+ *
+ * Each channel is coded as the difference from a prediction: the previous
+ * value (order 1, plain delta) or the previous value plus the previous delta
+ * (order 2, delta-of-delta). The residual is zigzag-mapped and written with
+ * a prefix code of 1, 4, 7 or 14 bits; larger residuals are escaped with
+ * their own bit length. A steady or slowly drifting series costs a few bits
+ * per sample. The first sample is coded against a zero prediction, so every
+ * frame decodes on its own.
+ *
+ * All state fits in the object: the frame buffer of SERIES_MAX_BYTES plus a
+ * few words per channel. append() is all-or-nothing; when a sample no longer
+ * fits, the frame is left complete and the caller sends it and calls reset().
+ *
+ * Frame layout: [version << 4 | channels] [order mask, bit c = order 2]
+ * [sample count] [period seconds, big-endian 16-bit] [bit stream, MSB first].
+ */
+class SeriesEncoder {
+public:
+    /**
+     * @param channels Values per sample, 1..SERIES_MAX_CHANNELS
+     * @param periodSeconds Nominal time between samples, stored for the decoder
+     * @param orderMask Bit c set: channel c uses delta-of-delta, else delta
+     */
+    SeriesEncoder(uint8_t channels, uint16_t periodSeconds, uint8_t orderMask = 0);
+
+    /**
+     * @brief Add one sample to the frame
+     *
+     * @param values One value per channel
+     * @return true if it fit; false leaves the frame unchanged
+     */
+    bool append(const int32_t* values);
+
+    /**
+     * @brief Start a new frame (same channels, period and orders)
+     */
+    void reset();
+
+    /**
+     * @brief Change the period stored in the next frames
+     */
+    void setPeriod(uint16_t periodSeconds);
+
+    const uint8_t* data() const { return buffer; }
+    size_t size() const { return (bitCount + 7) / 8; }
+    uint8_t count() const { return samples; }
+    bool isEmpty() const { return samples == 0; }
+
+    /**
+     * @brief Bits the residual takes with the prefix code
+     */
+    static uint8_t codeLength(uint32_t zigzag);
+
+    static uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+    static int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+private:
+    uint8_t buffer[SERIES_MAX_BYTES];
+    size_t bitCount;
+    uint8_t channels;
+    uint8_t orderMask;
+    uint8_t samples;
+    uint16_t period;
+    int32_t last[SERIES_MAX_CHANNELS];
+    int32_t lastDelta[SERIES_MAX_CHANNELS];
+
+    int32_t residual(uint8_t channel, int32_t value) const;
+    void writeBits(uint32_t value, uint8_t bits);
+    void writeCode(uint32_t zigzag);
+};
+
+/**
+ * @brief Decoder for SeriesEncoder frames (host tools and tests)
+ */
+class SeriesDecoder {
+public:
+    /**
+     * @brief Decode a frame
+     *
+     * @param frame Frame bytes
+     * @param size Frame length
+     * @param values Receives count * channels values, sample-major
+     * @param maxValues Capacity of values
+     * @param channels Receives the channel count
+     * @param periodSeconds Receives the sample period
+     * @return int Samples decoded, or -1 if the frame is malformed or too large
+     */
+    static int decode(const uint8_t* frame, size_t size, int32_t* values, size_t maxValues,
+                      uint8_t* channels, uint16_t* periodSeconds);
+};
@@ -0,0 +1,51 @@
+#include "ArchiveFlash.h"
+
+#if defined(ARDUINO)
+
+PartitionFlash::PartitionFlash() :
+    partition(nullptr),
+    mapped(nullptr),
+    handle(0) {
+}
+
+PartitionFlash::~PartitionFlash() {
+    if (mapped) {
+        spi_flash_munmap(handle);
+    }
+}
+
+bool PartitionFlash::begin(const char* label) {
+    if (mapped) {
+        return true;
+    }
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!partition || partition->size < ARCHIVE_FLASH_SECTOR_SIZE) {
+        partition = nullptr;
+        return false;
+    }
+
+    // One mapping for the whole partition; records are read in place
+    const void* address = nullptr;
+    if (esp_partition_mmap(partition, 0, size(), SPI_FLASH_MMAP_DATA, &address, &handle) != ESP_OK) {
+        partition = nullptr;
+        return false;
+    }
+    mapped = (const uint8_t*)address;
+    return true;
+}
+
+size_t PartitionFlash::size() const {
+    if (!partition) return 0;
+    return partition->size - partition->size % ARCHIVE_FLASH_SECTOR_SIZE;
+}
+
+bool PartitionFlash::erase(size_t offset) {
+    return partition && esp_partition_erase_range(partition, offset, ARCHIVE_FLASH_SECTOR_SIZE) == ESP_OK;
+}
+
+bool PartitionFlash::write(size_t offset, const void* data, size_t length) {
+    return partition && esp_partition_write(partition, offset, data, length) == ESP_OK;
+}
+
+#endif
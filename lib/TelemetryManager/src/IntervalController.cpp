@@ -0,0 +1,81 @@
+#include "IntervalController.h"
+#include <math.h>
+#include <string.h>
+
+IntervalController::IntervalController() :
+    lastMs(0),
+    hasLast(false),
+    minMs(INTERVAL_MIN_MS),
+    maxMs(INTERVAL_MAX_MS),
+    intervalMs(INTERVAL_MIN_MS),
+    batteryFactor(1),
+    activity(0.0F) {
+    useDeadbands(ReportPolicy::defaultConfig());
+    reset();
+}
+
+void IntervalController::useDeadbands(const ReportPolicyConfig& config) {
+    for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+        scale[i] = config.deadband[i].absolute;
+        relative[i] = config.deadband[i].relative;
+    }
+}
+
+void IntervalController::setBounds(uint32_t minMs, uint32_t maxMs) {
+    this->minMs = minMs;
+    this->maxMs = maxMs > minMs ? maxMs : minMs;
+    if (intervalMs < this->minMs) intervalMs = this->minMs;
+    if (intervalMs > this->maxMs) intervalMs = this->maxMs;
+}
+
+void IntervalController::reset() {
+    for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+        lastValues[i] = NAN;
+    }
+    hasLast = false;
+    intervalMs = minMs;
+    activity = 0.0F;
+}
+
+uint32_t IntervalController::update(const float* values, bool motion, uint32_t nowMs) {
+    // Fastest field, in deadbands per millisecond
+    float rate = 0.0F;
+    if (hasLast && nowMs != lastMs) {
+        float dt = (float)(nowMs - lastMs);
+        for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+            if (isnan(values[i]) || isnan(lastValues[i])) continue;
+
+            float band = scale[i] > 0.0F ? scale[i] : relative[i] * fabsf(lastValues[i]);
+            if (band <= 0.0F) continue;
+
+            float fieldRate = fabsf(values[i] - lastValues[i]) / band / dt;
+            if (fieldRate > rate) rate = fieldRate;
+        }
+    }
+    activity = rate * 60000.0F;
+
+    memcpy(lastValues, values, sizeof(lastValues));
+    lastMs = nowMs;
+    hasLast = true;
+
+    float next;
+    if (motion) {
+        next = (float)minMs;
+    } else {
+        // Interval at which the next sample moves INTERVAL_TARGET_CHANGE deadbands,
+        // growing by a bounded step but shrinking at once
+        float target = rate > 0.0F ? INTERVAL_TARGET_CHANGE / rate : (float)maxMs;
+        float grown = intervalMs * INTERVAL_GROWTH;
+        next = target < grown ? target : grown;
+    }
+
+    if (next < minMs) next = (float)minMs;
+    if (next > maxMs) next = (float)maxMs;
+    intervalMs = (uint32_t)next;
+    return getIntervalMs();
+}
+
+uint32_t IntervalController::getIntervalMs() const {
+    uint64_t stretched = (uint64_t)intervalMs * batteryFactor;
+    return stretched > maxMs ? maxMs : (uint32_t)stretched;
+}
@@ -0,0 +1,139 @@
+#include "ReportPolicy.h"
+#include <math.h>
+#include <string.h>
+
+ReportPolicy::ReportPolicy() :
+    config(defaultConfig()),
+    lastSentMs(0),
+    hasSent(false),
+    eventPending(false),
+    spacingFactor(1) {
+    memset(&stats, 0, sizeof(stats));
+    for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+        lastSent[i] = NAN;
+    }
+}
+
+ReportPolicyConfig ReportPolicy::defaultConfig() {
+    ReportPolicyConfig defaults;
+    defaults.deadband[REPORT_FIELD_TEMPERATURE] = { 0.2F, 0.0F };
+    defaults.deadband[REPORT_FIELD_HUMIDITY] = { 2.0F, 0.0F };
+    defaults.deadband[REPORT_FIELD_PRESSURE] = { 0.5F, 0.0F };
+    defaults.deadband[REPORT_FIELD_BATTERY] = { 0.05F, 0.0F };
+    defaults.maxSilenceMs = REPORT_MAX_SILENCE_MS;
+    defaults.minSpacingMs = REPORT_MIN_SPACING_MS;
+    return defaults;
+}
+
+void ReportPolicy::setDeadband(ReportField field, float absolute, float relative) {
+    if (field < REPORT_FIELD_COUNT) {
+        config.deadband[field].absolute = absolute;
+        config.deadband[field].relative = relative;
+    }
+}
+
+void ReportPolicy::resetStats() {
+    memset(&stats, 0, sizeof(stats));
+}
+
+uint8_t ReportPolicy::changedFields(const float* values) const {
+    uint8_t mask = 0;
+    for (int i = 0; i < REPORT_FIELD_COUNT; i++) {
+        float last = lastSent[i];
+        float value = values[i];
+
+        // Appearing or disappearing data is always worth reporting
+        if (isnan(last) || isnan(value)) {
+            if (isnan(last) != isnan(value)) {
+                mask |= 1 << i;
+            }
+            continue;
+        }
+
+        const ReportDeadband& band = config.deadband[i];
+        float delta = fabsf(value - last);
+        if ((band.absolute > 0.0F && delta > band.absolute) ||
+            (band.relative > 0.0F && delta > band.relative * fabsf(last))) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+}
+
+ReportReason ReportPolicy::evaluate(const float* values, bool event, uint32_t nowMs) {
+    if (!hasSent) {
+        return REPORT_FIRST;
+    }
+
+    uint32_t elapsed = nowMs - lastSentMs;
+    eventPending = eventPending || event;
+
+    ReportReason reason;
+    if (elapsed >= config.maxSilenceMs) {
+        reason = REPORT_HEARTBEAT;
+    } else if (eventPending) {
+        reason = REPORT_EVENT;
+    } else if (changedFields(values) != 0) {
+        reason = REPORT_CHANGED;
+    } else {
+        stats.suppressed++;
+        return REPORT_SUPPRESSED;
+    }
+
+    if (elapsed < getMinSpacingMs()) {
+        stats.deferred++;
+        return REPORT_DEFERRED;
+    }
+    return reason;
+}
+
+void ReportPolicy::commit(const float* values, ReportReason reason, uint32_t nowMs) {
+    memcpy(lastSent, values, sizeof(lastSent));
+    lastSentMs = nowMs;
+    hasSent = true;
+    eventPending = false;
+
+    stats.sent++;
+    if (reason == REPORT_HEARTBEAT) {
+        stats.heartbeats++;
+    }
+}
+
+bool ReportPolicy::applyDownlink(const uint8_t* payload, size_t size) {
+    if (size < 2 || payload[0] != REPORT_DOWNLINK_CONFIG) {
+        return false;
+    }
+
+    switch (payload[1]) {
+        case REPORT_CONFIG_DEADBAND:
+            if (size < 6 || payload[2] >= REPORT_FIELD_COUNT) {
+                return false;
+            }
+            setDeadband((ReportField)payload[2],
+                        ((payload[3] << 8) | payload[4]) / 100.0F,
+                        payload[5] / 1000.0F);
+            return true;
+
+        case REPORT_CONFIG_MAX_SILENCE:
+        case REPORT_CONFIG_MIN_SPACING: {
+            if (size < 5) {
+                return false;
+            }
+            uint32_t seconds = ((uint32_t)payload[2] << 16) | (payload[3] << 8) | payload[4];
+            // A u24 of seconds can exceed what fits in uint32_t milliseconds
+            if (seconds > UINT32_MAX / 1000) {
+                seconds = UINT32_MAX / 1000;
+            }
+            if (payload[1] == REPORT_CONFIG_MAX_SILENCE) {
+                if (seconds == 0) return false;
+                config.maxSilenceMs = seconds * 1000;
+            } else {
+                config.minSpacingMs = seconds * 1000;
+            }
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,396 @@
+#include "SampleArchive.h"
+#include <string.h>
+
+// Marker of a complete record; programmed last, so 0xFF means torn
+static const uint8_t RECORD_VALID = 0xA5;
+static const uint8_t RECORD_ERASED = 0xFF;
+static const size_t NO_SECTOR = (size_t)-1;
+
+static uint32_t readLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeLe32(uint8_t* p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+}
+
+// Value channels next to the time channel
+static uint8_t valueChannels(uint8_t channels) {
+    return channels == 0 ? 1 : (channels >= SERIES_MAX_CHANNELS ? SERIES_MAX_CHANNELS - 1 : channels);
+}
+
+// Records stay 4-byte aligned
+static size_t recordSize(uint8_t frameBytes) {
+    return SAMPLE_ARCHIVE_RECORD_HEADER + ((frameBytes + 3u) & ~3u);
+}
+
+SampleArchive::SampleArchive(uint8_t channels, uint16_t periodSeconds, uint8_t orderMask) :
+    flash(nullptr),
+    encoder(valueChannels(channels) + 1, periodSeconds, (uint8_t)((orderMask << 1) | 1)),
+    channels(valueChannels(channels)),
+    sectorCount(0),
+    head(0),
+    pendingFirst(0),
+    pendingLast(0),
+    maxPendingAge(SAMPLE_ARCHIVE_MAX_PENDING_AGE),
+    newestTime(0),
+    appended(0),
+    recycled(0) {
+    memset(sectors, 0, sizeof(sectors));
+    memset(&replay, 0, sizeof(replay));
+}
+
+const uint8_t* SampleArchive::sectorData(size_t sector) const {
+    return flash->data() + sector * ARCHIVE_FLASH_SECTOR_SIZE;
+}
+
+bool SampleArchive::begin(ArchiveFlash* region) {
+    flash = region;
+    sectorCount = 0;
+    if (!flash || !flash->data()) {
+        return false;
+    }
+
+    sectorCount = flash->size() / ARCHIVE_FLASH_SECTOR_SIZE;
+    if (sectorCount > SAMPLE_ARCHIVE_MAX_SECTORS) {
+        sectorCount = SAMPLE_ARCHIVE_MAX_SECTORS;
+    }
+    if (sectorCount < 2) {
+        sectorCount = 0;
+        return false;
+    }
+
+    // The index is rebuilt from the headers; the newest sector is the head
+    memset(sectors, 0, sizeof(sectors));
+    head = 0;
+    for (size_t s = 0; s < sectorCount; s++) {
+        scanSector(s);
+        if (sectors[s].sequence > sectors[head].sequence) {
+            head = s;
+        }
+    }
+
+    encoder.reset();
+    newestTime = 0;
+    for (size_t s = 0; s < sectorCount; s++) {
+        if (sectors[s].records > 0 && sectors[s].lastTime > newestTime) {
+            newestTime = sectors[s].lastTime;
+        }
+    }
+    appended = 0;
+    recycled = 0;
+    memset(&replay, 0, sizeof(replay));
+    return true;
+}
+
+void SampleArchive::scanSector(size_t sector) {
+    ArchiveSector& entry = sectors[sector];
+    memset(&entry, 0, sizeof(entry));
+
+    const uint8_t* data = sectorData(sector);
+    uint32_t sequence = readLe32(data + 4);
+    if (readLe32(data) != SAMPLE_ARCHIVE_MAGIC || sequence == 0 || sequence == 0xFFFFFFFFUL) {
+        return;  // Free, or never formatted (erased before first use)
+    }
+    entry.sequence = sequence;
+
+    size_t offset = SAMPLE_ARCHIVE_SECTOR_HEADER;
+    while (offset + SAMPLE_ARCHIVE_RECORD_HEADER <= ARCHIVE_FLASH_SECTOR_SIZE) {
+        const uint8_t* record = data + offset;
+        uint8_t length = record[1];
+        if (length == RECORD_ERASED || length > SERIES_MAX_BYTES ||
+            offset + recordSize(length) > ARCHIVE_FLASH_SECTOR_SIZE) {
+            break;
+        }
+        if (record[0] == RECORD_VALID) {
+            if (entry.records == 0) {
+                entry.firstTime = readLe32(record + 4);
+            }
+            entry.lastTime = readLe32(record + 8);
+            entry.records++;
+        }
+        offset += recordSize(length);
+    }
+    entry.used = offset;
+}
+
+bool SampleArchive::openNextSector() {
+    uint32_t sequence = sectors[head].sequence + 1;
+    size_t next = sectors[head].sequence == 0 ? head : (head + 1) % sectorCount;
+
+    if (sectors[next].sequence != 0) {
+        recycled++;  // Drops the oldest sector
+    }
+    memset(&sectors[next], 0, sizeof(sectors[next]));
+
+    uint8_t header[SAMPLE_ARCHIVE_SECTOR_HEADER];
+    writeLe32(header, SAMPLE_ARCHIVE_MAGIC);
+    writeLe32(header + 4, sequence);
+    size_t offset = next * ARCHIVE_FLASH_SECTOR_SIZE;
+    if (!flash->erase(offset) || !flash->write(offset, header, sizeof(header))) {
+        return false;
+    }
+
+    sectors[next].sequence = sequence;
+    sectors[next].used = SAMPLE_ARCHIVE_SECTOR_HEADER;
+    head = next;
+    return true;
+}
+
+bool SampleArchive::append(uint32_t time, const int32_t* values) {
+    if (sectorCount == 0 || time < newestTime) {
+        return false;
+    }
+
+    int32_t sample[SERIES_MAX_CHANNELS];
+    sample[0] = (int32_t)time;
+    memcpy(sample + 1, values, channels * sizeof(int32_t));
+
+    if (!encoder.append(sample)) {
+        if (!flush()) {
+            return false;
+        }
+        encoder.append(sample);  // An empty frame always takes one sample
+    }
+
+    if (encoder.count() == 1) {
+        pendingFirst = time;
+    }
+    pendingLast = time;
+    newestTime = time;
+    appended++;
+
+    // Bound what a reset without flush() can lose
+    if (maxPendingAge > 0 && time - pendingFirst >= maxPendingAge) {
+        return flush();
+    }
+    return true;
+}
+
+bool SampleArchive::flush() {
+    if (encoder.isEmpty()) {
+        return true;
+    }
+    if (sectorCount == 0) {
+        return false;
+    }
+
+    uint8_t length = (uint8_t)encoder.size();
+    size_t total = recordSize(length);
+    if (sectors[head].sequence == 0 || sectors[head].used + total > ARCHIVE_FLASH_SECTOR_SIZE) {
+        if (!openNextSector()) {
+            return false;
+        }
+    }
+
+    uint8_t record[SAMPLE_ARCHIVE_RECORD_HEADER + SERIES_MAX_BYTES + 3];
+    memset(record, 0xFF, sizeof(record));
+    record[1] = length;
+    writeLe32(record + 4, pendingFirst);
+    writeLe32(record + 8, pendingLast);
+    memcpy(record + SAMPLE_ARCHIVE_RECORD_HEADER, encoder.data(), length);
+
+    // Body first, marker last. After a failed write the rest of the sector
+    // is left alone, since its bytes may be partly programmed
+    ArchiveSector& sector = sectors[head];
+    size_t offset = head * ARCHIVE_FLASH_SECTOR_SIZE + sector.used;
+    if (!flash->write(offset + 1, record + 1, total - 1) || !flash->write(offset, &RECORD_VALID, 1)) {
+        sector.used = ARCHIVE_FLASH_SECTOR_SIZE;
+        return false;
+    }
+    sector.used += total;
+
+    if (sector.records == 0) {
+        sector.firstTime = pendingFirst;
+    }
+    sector.lastTime = pendingLast;
+    sector.records++;
+    encoder.reset();
+    return true;
+}
+
+bool SampleArchive::clear() {
+    if (sectorCount == 0) {
+        return false;
+    }
+
+    bool ok = true;
+    for (size_t s = 0; s < sectorCount; s++) {
+        ok = flash->erase(s * ARCHIVE_FLASH_SECTOR_SIZE) && ok;
+    }
+    memset(sectors, 0, sizeof(sectors));
+    memset(&replay, 0, sizeof(replay));
+    head = 0;
+    newestTime = 0;
+    encoder.reset();
+    return ok;
+}
+
+size_t SampleArchive::oldestSector() const {
+    for (size_t k = 1; k <= sectorCount; k++) {
+        size_t s = (head + k) % sectorCount;
+        if (sectors[s].sequence != 0) {
+            return s;
+        }
+    }
+    return NO_SECTOR;
+}
+
+size_t SampleArchive::sectorOf(uint32_t sequence) const {
+    uint32_t newest = sectors[head].sequence;
+    if (newest == 0 || sequence > newest || newest - sequence >= sectorCount) {
+        return NO_SECTOR;
+    }
+    size_t s = (head + sectorCount - (newest - sequence)) % sectorCount;
+    return sectors[s].sequence == sequence ? s : NO_SECTOR;
+}
+
+bool SampleArchive::seek(uint32_t from, uint32_t to, ArchiveCursor& cursor) const {
+    cursor.sequence = 0;
+    size_t oldest = sectorCount > 0 ? oldestSector() : NO_SECTOR;
+    if (from > to || oldest == NO_SECTOR) {
+        return false;
+    }
+
+    // Sectors from the oldest to the head hold increasing times, so the
+    // first one ending at or after `from` is found by bisection
+    size_t span = (head + sectorCount - oldest) % sectorCount + 1;
+    size_t low = 0;
+    size_t high = span;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        const ArchiveSector& sector = sectors[(oldest + mid) % sectorCount];
+        if (sector.records == 0 || sector.lastTime >= from) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    while (low < span && sectors[(oldest + low) % sectorCount].records == 0) {
+        low++;  // Freshly opened head
+    }
+    if (low == span) {
+        return false;
+    }
+
+    const ArchiveSector& first = sectors[(oldest + low) % sectorCount];
+    if (first.firstTime > to) {
+        return false;
+    }
+    cursor.sequence = first.sequence;
+    cursor.offset = SAMPLE_ARCHIVE_SECTOR_HEADER;
+    cursor.from = from;
+    cursor.to = to;
+    return true;
+}
+
+bool SampleArchive::next(ArchiveCursor& cursor, ArchiveRecord& record) const {
+    while (cursor.sequence != 0 && sectorCount > 0) {
+        size_t s = sectorOf(cursor.sequence);
+        if (s == NO_SECTOR) {
+            // Recycled while the range was read: continue with what is left
+            size_t oldest = oldestSector();
+            if (oldest == NO_SECTOR || cursor.sequence > sectors[head].sequence ||
+                sectors[oldest].sequence <= cursor.sequence) {
+                cursor.sequence = 0;
+                return false;
+            }
+            cursor.sequence = sectors[oldest].sequence;
+            cursor.offset = SAMPLE_ARCHIVE_SECTOR_HEADER;
+            continue;
+        }
+
+        const ArchiveSector& sector = sectors[s];
+        if (cursor.offset + SAMPLE_ARCHIVE_RECORD_HEADER > sector.used) {
+            if (s == head) {
+                cursor.sequence = 0;
+                return false;
+            }
+            cursor.sequence++;
+            cursor.offset = SAMPLE_ARCHIVE_SECTOR_HEADER;
+            continue;
+        }
+
+        const uint8_t* data = sectorData(s) + cursor.offset;
+        if (data[1] > SERIES_MAX_BYTES) {
+            cursor.offset = sector.used;  // Failed write: nothing valid follows
+            continue;
+        }
+        cursor.offset += recordSize(data[1]);
+        if (data[0] != RECORD_VALID) {
+            continue;
+        }
+
+        uint32_t firstTime = readLe32(data + 4);
+        uint32_t lastTime = readLe32(data + 8);
+        if (lastTime < cursor.from) {
+            continue;
+        }
+        if (firstTime > cursor.to) {
+            cursor.sequence = 0;
+            return false;
+        }
+
+        record.firstTime = firstTime;
+        record.lastTime = lastTime;
+        record.frame = data + SAMPLE_ARCHIVE_RECORD_HEADER;
+        record.size = data[1];
+        return true;
+    }
+    return false;
+}
+
+size_t SampleArchive::query(uint32_t from, uint32_t to, ArchiveRecord* records, size_t maxRecords) const {
+    ArchiveCursor cursor;
+    size_t count = 0;
+    if (!seek(from, to, cursor)) {
+        return 0;
+    }
+    while (count < maxRecords && next(cursor, records[count])) {
+        count++;
+    }
+    return count;
+}
+
+bool SampleArchive::applyDownlink(const uint8_t* payload, size_t size) {
+    // 02 03 ffffffff tttttttt: COMMAND, range request, big-endian seconds
+    if (size < 10 || payload[0] != SAMPLE_ARCHIVE_DOWNLINK_COMMAND || payload[1] != SAMPLE_ARCHIVE_QUERY_COMMAND) {
+        return false;
+    }
+
+    uint32_t from = ((uint32_t)payload[2] << 24) | ((uint32_t)payload[3] << 16) |
+                    ((uint32_t)payload[4] << 8) | payload[5];
+    uint32_t to = ((uint32_t)payload[6] << 24) | ((uint32_t)payload[7] << 16) |
+                  ((uint32_t)payload[8] << 8) | payload[9];
+
+    // Samples still in the frame buffer belong to the range too
+    flush();
+    seek(from, to, replay);
+    return true;
+}
+
+ArchiveStats SampleArchive::getStats() const {
+    ArchiveStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.samples = appended;
+    stats.recycled = recycled;
+    stats.newestTime = newestTime;
+
+    size_t oldest = sectorCount > 0 ? oldestSector() : NO_SECTOR;
+    for (size_t k = 0; oldest != NO_SECTOR && k < sectorCount; k++) {
+        const ArchiveSector& sector = sectors[(oldest + k) % sectorCount];
+        if (sector.sequence == 0) {
+            continue;
+        }
+        if (stats.records == 0 && sector.records > 0) {
+            stats.oldestTime = sector.firstTime;
+        }
+        stats.records += sector.records;
+        stats.bytes += sector.used;
+        stats.sectors++;
+    }
+    return stats;
+}
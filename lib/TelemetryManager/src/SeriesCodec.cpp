@@ -0,0 +1,211 @@
+#include "SeriesCodec.h"
+#include <string.h>
+
+// Prefix code on the zigzag residual. Each bucket starts where the previous
+// one ends: '0' is 0, '10' + 2 bits is 1-4, '110' + 4 bits is 5-20 and
+// '1110' + 10 bits is 21-1044. Anything larger is escaped as '1111', the bit
+// length minus one in 5 bits, then the value itself.
+struct SeriesBucket {
+    uint8_t prefix;      // Prefix bits, right-aligned
+    uint8_t prefixBits;
+    uint8_t payloadBits;
+    uint32_t first;      // Smallest value in the bucket
+};
+
+static const SeriesBucket BUCKETS[] = {
+    { 0x0, 1, 0, 0 },
+    { 0x2, 2, 2, 1 },
+    { 0x6, 3, 4, 5 },
+    { 0xE, 4, 10, 21 },
+    { 0xF, 4, 0, 1045 }  // Escape
+};
+
+static const uint8_t BUCKET_COUNT = sizeof(BUCKETS) / sizeof(BUCKETS[0]);
+static const uint8_t ESCAPE = BUCKET_COUNT - 1;
+static const uint8_t ESCAPE_LENGTH_BITS = 5;
+
+static uint8_t bucketFor(uint32_t zigzag) {
+    uint8_t b = 0;
+    while (b < ESCAPE && zigzag >= BUCKETS[b + 1].first) {
+        b++;
+    }
+    return b;
+}
+
+static uint8_t bitLength(uint32_t value) {
+    uint8_t bits = 1;
+    while (bits < 32 && (value >> bits) != 0) {
+        bits++;
+    }
+    return bits;
+}
+
+SeriesEncoder::SeriesEncoder(uint8_t channels, uint16_t periodSeconds, uint8_t orderMask) :
+    bitCount(0),
+    channels(channels == 0 ? 1 : (channels > SERIES_MAX_CHANNELS ? SERIES_MAX_CHANNELS : channels)),
+    orderMask(orderMask),
+    samples(0),
+    period(periodSeconds) {
+    reset();
+}
+
+void SeriesEncoder::setPeriod(uint16_t periodSeconds) {
+    period = periodSeconds;
+    buffer[3] = period >> 8;
+    buffer[4] = period & 0xFF;
+}
+
+void SeriesEncoder::reset() {
+    memset(buffer, 0, sizeof(buffer));
+    memset(last, 0, sizeof(last));
+    memset(lastDelta, 0, sizeof(lastDelta));
+    samples = 0;
+
+    buffer[0] = (SERIES_FORMAT_VERSION << 4) | channels;
+    buffer[1] = orderMask;
+    buffer[2] = 0;
+    setPeriod(period);
+    bitCount = SERIES_HEADER_BYTES * 8;
+}
+
+uint8_t SeriesEncoder::codeLength(uint32_t zigzag) {
+    uint8_t b = bucketFor(zigzag);
+    if (b == ESCAPE) {
+        return BUCKETS[ESCAPE].prefixBits + ESCAPE_LENGTH_BITS + bitLength(zigzag);
+    }
+    return BUCKETS[b].prefixBits + BUCKETS[b].payloadBits;
+}
+
+int32_t SeriesEncoder::residual(uint8_t channel, int32_t value) const {
+    // Wrapping arithmetic keeps extreme values lossless
+    uint32_t prediction = (uint32_t)last[channel];
+    if (orderMask & (1 << channel)) {
+        prediction += (uint32_t)lastDelta[channel];
+    }
+    return (int32_t)((uint32_t)value - prediction);
+}
+
+void SeriesEncoder::writeBits(uint32_t value, uint8_t bits) {
+    for (int i = bits - 1; i >= 0; i--) {
+        if (value & (1UL << i)) {
+            buffer[bitCount >> 3] |= 0x80 >> (bitCount & 7);
+        }
+        bitCount++;
+    }
+}
+
+void SeriesEncoder::writeCode(uint32_t zigzag) {
+    uint8_t b = bucketFor(zigzag);
+    const SeriesBucket& bucket = BUCKETS[b];
+    writeBits(bucket.prefix, bucket.prefixBits);
+    if (b == ESCAPE) {
+        uint8_t bits = bitLength(zigzag);
+        writeBits(bits - 1, ESCAPE_LENGTH_BITS);
+        writeBits(zigzag, bits);
+    } else if (bucket.payloadBits > 0) {
+        writeBits(zigzag - bucket.first, bucket.payloadBits);
+    }
+}
+
+bool SeriesEncoder::append(const int32_t* values) {
+    if (samples == 0xFF) {
+        return false;
+    }
+
+    // Size the whole sample first so a rejected sample leaves no trace
+    uint32_t codes[SERIES_MAX_CHANNELS];
+    size_t bits = 0;
+    for (uint8_t c = 0; c < channels; c++) {
+        codes[c] = zigzag(residual(c, values[c]));
+        bits += codeLength(codes[c]);
+    }
+    if (bitCount + bits > SERIES_MAX_BYTES * 8) {
+        return false;
+    }
+
+    for (uint8_t c = 0; c < channels; c++) {
+        writeCode(codes[c]);
+        lastDelta[c] = samples == 0 ? 0 : (int32_t)((uint32_t)values[c] - (uint32_t)last[c]);
+        last[c] = values[c];
+    }
+    buffer[2] = ++samples;
+    return true;
+}
+
+// Bit reader over a decoded frame
+struct SeriesReader {
+    const uint8_t* data;
+    size_t bitCount;
+    size_t position;
+
+    bool read(uint8_t bits, uint32_t* value) {
+        if (position + bits > bitCount) return false;
+        uint32_t result = 0;
+        for (uint8_t i = 0; i < bits; i++) {
+            result = (result << 1) | ((data[position >> 3] >> (7 - (position & 7))) & 1);
+            position++;
+        }
+        *value = result;
+        return true;
+    }
+
+    bool readCode(uint32_t* zigzag) {
+        // Count leading ones, up to the escape prefix
+        uint8_t ones = 0;
+        uint32_t bit = 1;
+        while (ones < ESCAPE) {
+            if (!read(1, &bit)) return false;
+            if (bit == 0) break;
+            ones++;
+        }
+        if (ones == 0) {
+            *zigzag = 0;
+            return true;
+        }
+        if (ones == ESCAPE) {
+            uint32_t bits;
+            return read(ESCAPE_LENGTH_BITS, &bits) && read(bits + 1, zigzag);
+        }
+        if (!read(BUCKETS[ones].payloadBits, zigzag)) return false;
+        *zigzag += BUCKETS[ones].first;
+        return true;
+    }
+};
+
+int SeriesDecoder::decode(const uint8_t* frame, size_t size, int32_t* values, size_t maxValues,
+                          uint8_t* channels, uint16_t* periodSeconds) {
+    if (size < SERIES_HEADER_BYTES || (frame[0] >> 4) != SERIES_FORMAT_VERSION) {
+        return -1;
+    }
+
+    uint8_t count = frame[0] & 0x0F;
+    uint8_t orderMask = frame[1];
+    uint8_t samples = frame[2];
+    if (count == 0 || count > SERIES_MAX_CHANNELS || (size_t)samples * count > maxValues) {
+        return -1;
+    }
+    *channels = count;
+    *periodSeconds = (frame[3] << 8) | frame[4];
+
+    SeriesReader reader = { frame, size * 8, SERIES_HEADER_BYTES * 8 };
+    uint32_t last[SERIES_MAX_CHANNELS] = { 0 };
+    uint32_t lastDelta[SERIES_MAX_CHANNELS] = { 0 };
+
+    for (uint8_t s = 0; s < samples; s++) {
+        for (uint8_t c = 0; c < count; c++) {
+            uint32_t code;
+            if (!reader.readCode(&code)) {
+                return -1;
+            }
+            uint32_t prediction = last[c];
+            if (orderMask & (1 << c)) {
+                prediction += lastDelta[c];
+            }
+            uint32_t value = prediction + (uint32_t)SeriesEncoder::unzigzag(code);
+            lastDelta[c] = s == 0 ? 0 : value - last[c];
+            last[c] = value;
+            values[s * count + c] = (int32_t)value;
+        }
+    }
+    return samples;
+}
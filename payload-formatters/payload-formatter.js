@@ -28,7 +28,66 @@ const BYTE_POSITIONS = {
   HUMIDITY: { START: 2, LENGTH: 2 },
   PRESSURE: { START: 4, LENGTH: 2 },
   MOTION: { START: 6, LENGTH: 1 },
-  RESERVED: { START: 7, LENGTH: 1 }
+  QUALITY: { START: 7, LENGTH: 1 },
+  BATTERY_MV: { START: 8, LENGTH: 2 },
+  BATTERY_SOC: { START: 10, LENGTH: 1 },
+  MOTION_COUNT: { START: 11, LENGTH: 2 },
+  MOTION_FIRST_AGE: { START: 13, LENGTH: 2 },
+  MOTION_LAST_AGE: { START: 15, LENGTH: 2 },
+  OCCUPANCY: { START: 17, LENGTH: 1 },
+  NODE_TIME: { START: 18, LENGTH: 4 }
+};
+
+// Motion event age when the interval had no motion
+const MOTION_NO_EVENT = 0xFFFF;
+
+// Battery state of charge when no cell is connected
+const BATTERY_SOC_UNKNOWN = 0xFF;
+
+// Sensor quality flags in byte 7 (SENSOR_QUALITY_* in SensorFilter.h)
+const QUALITY_FLAGS = {
+  TEMPERATURE_HELD: 0x01,
+  HUMIDITY_HELD: 0x02,
+  PRESSURE_HELD: 0x04,
+  OUT_OF_RANGE: 0x08,
+  RATE_LIMITED: 0x10,
+  READ_ERROR: 0x20,
+  WARMING_UP: 0x40,
+  NO_DATA: 0x80
+};
+
+// Vibration features uplinked on their own port (VibrationAnalyzer::encode)
+const VIBRATION = {
+  PORT: 2,
+  PEAKS: 3,
+  BANDS: 4,
+  LENGTH: 22,
+  // Default band edges at 3.2 kHz sampling, in Hz
+  BAND_EDGES: [1, 20, 100, 400, 1600]
+};
+
+// Compressed sample batches (SeriesEncoder in TelemetryManager)
+const SERIES = {
+  PORT: 3,
+  VERSION: 1,
+  HEADER_BYTES: 5,
+  // Channel names and scale of the sleep batches, in firmware order
+  CHANNELS: ['temperature', 'humidity', 'pressure'],
+  SCALE: 100,
+  // Prefix code buckets: leading ones select the bucket, four ones escape
+  BUCKETS: [
+    { bits: 0, first: 0 },
+    { bits: 2, first: 1 },
+    { bits: 4, first: 5 },
+    { bits: 10, first: 21 }
+  ],
+  ESCAPE_LENGTH_BITS: 5
+};
+
+// Archive replay frames (SampleArchive): series frames whose channel 0 is
+// the sample time in seconds of the node clock, followed by SERIES.CHANNELS
+const ARCHIVE = {
+  PORT: 4
 };
 
 // Downlink message types
@@ -37,10 +96,28 @@ const DOWNLINK_TYPES = {
   COMMAND: 0x02
 };
 
+// Configuration keys (second byte of a CONFIG downlink)
+const CONFIG_KEYS = {
+  INTERVAL: 0x01,
+  DEADBAND: 0x02,
+  MAX_SILENCE: 0x03,
+  MIN_SPACING: 0x04,
+  CALIBRATION: 0x05,
+  SEA_LEVEL: 0x06
+};
+
+// Report-by-exception fields, in firmware order
+const REPORT_FIELDS = ['temperature', 'humidity', 'pressure', 'battery'];
+
+// Calibrated sensor channels, in firmware order (gain 1.0 = 0x8000)
+const CALIBRATION_CHANNELS = ['temperature', 'humidity', 'pressure'];
+const CALIBRATION_UNITY_GAIN = 0x8000;
+
 // Downlink commands
 const COMMANDS = {
   RESET: 0x01,
-  FORCE_READ: 0x02
+  FORCE_READ: 0x02,
+  ARCHIVE_QUERY: 0x03
 };
 
 // Utility functions for byte conversion
@@ -53,6 +130,11 @@ const ByteConverter = {
   toUInt16: (bytes, startIndex) => {
     return (bytes[startIndex] << 8) | bytes[startIndex + 1];
   },
+
+  toUInt32: (bytes, startIndex) => {
+    return ((bytes[startIndex] << 24) | (bytes[startIndex + 1] << 16) |
+            (bytes[startIndex + 2] << 8) | bytes[startIndex + 3]) >>> 0;
+  },
   
   getBit: (byte, bitPosition) => {
     return (byte >> bitPosition) & 1;
@@ -84,9 +166,175 @@ const SensorDecoder = {
     // Looking at logs: payload[6] = 0x01 when motion detected
     // The device is setting bit 0 to 1 for motion
     return (bytes[BYTE_POSITIONS.MOTION.START] & 0x01) === 1;
+  },
+
+  battery: (bytes) => {
+    const millivolts = ByteConverter.toUInt16(bytes, BYTE_POSITIONS.BATTERY_MV.START);
+    const soc = bytes[BYTE_POSITIONS.BATTERY_SOC.START];
+    return {
+      present: soc !== BATTERY_SOC_UNKNOWN,
+      voltage: millivolts / 1000,
+      state_of_charge: soc === BATTERY_SOC_UNKNOWN ? null : soc
+    };
+  },
+
+  motionSummary: (bytes) => {
+    const firstAge = ByteConverter.toUInt16(bytes, BYTE_POSITIONS.MOTION_FIRST_AGE.START);
+    const lastAge = ByteConverter.toUInt16(bytes, BYTE_POSITIONS.MOTION_LAST_AGE.START);
+    return {
+      count: ByteConverter.toUInt16(bytes, BYTE_POSITIONS.MOTION_COUNT.START),
+      first_event_seconds_ago: firstAge === MOTION_NO_EVENT ? null : firstAge,
+      last_event_seconds_ago: lastAge === MOTION_NO_EVENT ? null : lastAge,
+      occupancy_percent: bytes[BYTE_POSITIONS.OCCUPANCY.START]
+    };
+  },
+
+  // Node clock at the uplink, in the seconds archive samples and range
+  // requests use; with the receive time it maps wall-clock times to node time
+  nodeTime: (bytes, recvTime) => {
+    const seconds = ByteConverter.toUInt32(bytes, BYTE_POSITIONS.NODE_TIME.START);
+    const clock = { seconds: seconds };
+    if (recvTime) {
+      clock.offset_seconds = Math.round(new Date(recvTime).getTime() / 1000) - seconds;
+    }
+    return clock;
+  },
+
+  quality: (bytes) => {
+    const flags = bytes[BYTE_POSITIONS.QUALITY.START];
+    return {
+      flags: flags,
+      temperature_held: (flags & QUALITY_FLAGS.TEMPERATURE_HELD) !== 0,
+      humidity_held: (flags & QUALITY_FLAGS.HUMIDITY_HELD) !== 0,
+      pressure_held: (flags & QUALITY_FLAGS.PRESSURE_HELD) !== 0,
+      out_of_range: (flags & QUALITY_FLAGS.OUT_OF_RANGE) !== 0,
+      rate_limited: (flags & QUALITY_FLAGS.RATE_LIMITED) !== 0,
+      read_error: (flags & QUALITY_FLAGS.READ_ERROR) !== 0,
+      warming_up: (flags & QUALITY_FLAGS.WARMING_UP) !== 0,
+      no_data: (flags & QUALITY_FLAGS.NO_DATA) !== 0
+    };
   }
 };
 
+// Vibration feature decoder: RMS, peaks (0.1 Hz, mg) and band RMS, all in mg
+function decodeVibration(bytes) {
+  if (bytes.length !== VIBRATION.LENGTH) {
+    throw new Error(`Invalid vibration payload length. Expected ${VIBRATION.LENGTH} bytes, got ${bytes.length}`);
+  }
+
+  let offset = 0;
+  const rms = ByteConverter.toUInt16(bytes, offset) / 1000;
+  offset += 2;
+
+  const peaks = [];
+  for (let i = 0; i < VIBRATION.PEAKS; i++) {
+    const frequency = ByteConverter.toUInt16(bytes, offset) / 10;
+    const amplitude = ByteConverter.toUInt16(bytes, offset + 2) / 1000;
+    offset += 4;
+    if (frequency > 0) {
+      peaks.push({ frequency_hz: frequency, amplitude_g: amplitude });
+    }
+  }
+
+  const bands = [];
+  for (let b = 0; b < VIBRATION.BANDS; b++) {
+    bands.push({
+      from_hz: VIBRATION.BAND_EDGES[b],
+      to_hz: VIBRATION.BAND_EDGES[b + 1],
+      rms_g: ByteConverter.toUInt16(bytes, offset) / 1000
+    });
+    offset += 2;
+  }
+
+  return { rms_g: rms, peaks: peaks, bands: bands };
+}
+
+// Series decoder: delta or delta-of-delta residuals, zigzag, prefix-coded.
+// Returns the raw integer values of each sample, oldest first
+function decodeSeriesValues(bytes) {
+  if (bytes.length < SERIES.HEADER_BYTES || (bytes[0] >> 4) !== SERIES.VERSION) {
+    throw new Error('Invalid series frame header');
+  }
+
+  const channels = bytes[0] & 0x0F;
+  const orderMask = bytes[1];
+  const count = bytes[2];
+  const period = ByteConverter.toUInt16(bytes, 3);
+  let position = SERIES.HEADER_BYTES * 8;
+
+  const readBits = (bits) => {
+    if (position + bits > bytes.length * 8) {
+      throw new Error('Truncated series frame');
+    }
+    let value = 0;
+    for (let i = 0; i < bits; i++) {
+      value = value * 2 + ((bytes[position >> 3] >> (7 - (position & 7))) & 1);
+      position++;
+    }
+    return value;
+  };
+
+  const readCode = () => {
+    let ones = 0;
+    while (ones < 4 && readBits(1) === 1) {
+      ones++;
+    }
+    if (ones === 4) {
+      return readBits(readBits(SERIES.ESCAPE_LENGTH_BITS) + 1);
+    }
+    const bucket = SERIES.BUCKETS[ones];
+    return bucket.first + readBits(bucket.bits);
+  };
+
+  // 32-bit wrapping arithmetic, as on the device
+  const last = new Array(channels).fill(0);
+  const lastDelta = new Array(channels).fill(0);
+  const rows = [];
+  for (let s = 0; s < count; s++) {
+    const row = [];
+    for (let c = 0; c < channels; c++) {
+      const zigzag = readCode();
+      const residual = (zigzag >>> 1) ^ -(zigzag & 1);
+      const prediction = (orderMask & (1 << c)) ? (last[c] + lastDelta[c]) | 0 : last[c];
+      const value = (prediction + residual) | 0;
+      lastDelta[c] = s === 0 ? 0 : (value - last[c]) | 0;
+      last[c] = value;
+      row.push(value);
+    }
+    rows.push(row);
+  }
+
+  return { period: period, rows: rows };
+}
+
+function decodeSeries(bytes) {
+  const series = decodeSeriesValues(bytes);
+  const samples = series.rows.map((row, s) => {
+    const sample = {};
+    row.forEach((value, c) => {
+      sample[SERIES.CHANNELS[c] || ('channel_' + c)] = value / SERIES.SCALE;
+    });
+    // Oldest first; the last sample was taken about one period before the uplink
+    sample.seconds_ago = (series.rows.length - s) * series.period;
+    return sample;
+  });
+
+  return { period_seconds: series.period, samples: samples };
+}
+
+function decodeArchive(bytes) {
+  const series = decodeSeriesValues(bytes);
+  const samples = series.rows.map((row) => {
+    const sample = { time: row[0] >>> 0 };
+    row.slice(1).forEach((value, c) => {
+      sample[SERIES.CHANNELS[c] || ('channel_' + c)] = value / SERIES.SCALE;
+    });
+    return sample;
+  });
+
+  return { period_seconds: series.period, samples: samples };
+}
+
 // Validation functions
 const Validator = {
   isInRange: (value, min, max) => {
@@ -113,10 +361,34 @@ function decodeUplink(input) {
       throw new Error('Invalid input format');
     }
 
-    // Check payload length
-    const EXPECTED_LENGTH = 8; // Matches current payload
-    if (input.bytes.length !== EXPECTED_LENGTH) {
-      throw new Error(`Invalid payload length. Expected ${EXPECTED_LENGTH} bytes, got ${input.bytes.length}`);
+    if (input.fPort === SERIES.PORT) {
+      return {
+        data: { series: decodeSeries(input.bytes) },
+        warnings: [],
+        errors: []
+      };
+    }
+
+    if (input.fPort === ARCHIVE.PORT) {
+      return {
+        data: { archive: decodeArchive(input.bytes) },
+        warnings: [],
+        errors: []
+      };
+    }
+
+    if (input.fPort === VIBRATION.PORT) {
+      return {
+        data: { vibration: decodeVibration(input.bytes) },
+        warnings: [],
+        errors: []
+      };
+    }
+
+    // Check payload length (8 bytes from firmware without the battery monitor)
+    const EXPECTED_LENGTHS = [8, 11, 18, 22];
+    if (!EXPECTED_LENGTHS.includes(input.bytes.length)) {
+      throw new Error(`Invalid payload length. Expected ${EXPECTED_LENGTHS.join(' or ')} bytes, got ${input.bytes.length}`);
     }
 
     // Enhanced motion detection analysis
@@ -143,9 +415,20 @@ function decodeUplink(input) {
       },
       humidity: SensorDecoder.humidity(input.bytes),
       pressure: SensorDecoder.pressure(input.bytes),
-      motion_detected: SensorDecoder.motion(input.bytes)
+      motion_detected: SensorDecoder.motion(input.bytes),
+      quality: SensorDecoder.quality(input.bytes)
     };
 
+    if (input.bytes.length >= 11) {
+      decoded.battery = SensorDecoder.battery(input.bytes);
+    }
+    if (input.bytes.length >= 18) {
+      decoded.motion = SensorDecoder.motionSummary(input.bytes);
+    }
+    if (input.bytes.length >= 22) {
+      decoded.node_time = SensorDecoder.nodeTime(input.bytes, input.recvTime);
+    }
+
     // Validate readings
     decoded.status = {
       temperature_valid: Validator.validateReading('temperature', decoded.temperature.celsius, SENSOR_LIMITS.TEMPERATURE),
@@ -188,9 +471,33 @@ function decodeDownlink(input) {
       case COMMANDS.FORCE_READ:
         decoded.action = 'force_read';
         break;
+      case COMMANDS.ARCHIVE_QUERY:
+        if (input.bytes.length >= 10) {
+          decoded.action = 'archive_query';
+          decoded.from = ByteConverter.toUInt32(input.bytes, 2);
+          decoded.to = ByteConverter.toUInt32(input.bytes, 6);
+        }
+        break;
     }
+  } else if (input.bytes[0] === DOWNLINK_TYPES.CONFIG && input.bytes[1] === CONFIG_KEYS.DEADBAND &&
+             input.bytes.length >= 6) {
+    decoded.action = 'set_deadband';
+    decoded.field = REPORT_FIELDS[input.bytes[2]] || 'unknown';
+    decoded.absolute = ((input.bytes[3] << 8) | input.bytes[4]) / 100;
+    decoded.relativePercent = input.bytes[5] / 10;
+  } else if (input.bytes[0] === DOWNLINK_TYPES.CONFIG && input.bytes[1] === CONFIG_KEYS.CALIBRATION &&
+             input.bytes.length >= 7) {
+    decoded.action = 'set_calibration';
+    decoded.channel = CALIBRATION_CHANNELS[input.bytes[2]] || 'unknown';
+    decoded.offset = (((input.bytes[3] << 8) | input.bytes[4]) << 16 >> 16) / 100;
+    decoded.gain = ((input.bytes[5] << 8) | input.bytes[6]) / CALIBRATION_UNITY_GAIN;
   } else if (input.bytes[0] === DOWNLINK_TYPES.CONFIG && input.bytes.length >= 5) {
-    decoded.action = 'set_interval';
+    const actions = {};
+    actions[CONFIG_KEYS.INTERVAL] = 'set_interval';
+    actions[CONFIG_KEYS.MAX_SILENCE] = 'set_max_silence';
+    actions[CONFIG_KEYS.MIN_SPACING] = 'set_min_spacing';
+    actions[CONFIG_KEYS.SEA_LEVEL] = 'set_sea_level';
+    decoded.action = actions[input.bytes[1]] || 'unknown';
     decoded.value = (input.bytes[2] << 16) | (input.bytes[3] << 8) | input.bytes[4];
   }
   
@@ -211,17 +518,76 @@ function encodeDownlink(input) {
     case 'force_read':
       bytes = [DOWNLINK_TYPES.COMMAND, COMMANDS.FORCE_READ];
       break;
+    case 'archive_query': {
+      // { from: 1000000, to: 1003600 } in seconds of the node clock (time in port 4
+      // samples); wall-clock seconds minus node_time.offset_seconds of a recent uplink
+      const from = (input.data.from || 0) >>> 0;
+      const to = (typeof input.data.to === 'number' ? input.data.to : 0xFFFFFFFF) >>> 0;
+      bytes = [
+        DOWNLINK_TYPES.COMMAND,
+        COMMANDS.ARCHIVE_QUERY,
+        (from >>> 24) & 0xFF, (from >>> 16) & 0xFF, (from >>> 8) & 0xFF, from & 0xFF,
+        (to >>> 24) & 0xFF, (to >>> 16) & 0xFF, (to >>> 8) & 0xFF, to & 0xFF
+      ];
+      break;
+    }
     case 'set_interval':
+    case 'set_max_silence':
+    case 'set_min_spacing':
+    case 'set_sea_level':
+      // set_sea_level takes Pa; 0 restores the firmware default
       if (typeof input.data.value === 'number') {
+        const keys = {
+          set_interval: CONFIG_KEYS.INTERVAL,
+          set_max_silence: CONFIG_KEYS.MAX_SILENCE,
+          set_min_spacing: CONFIG_KEYS.MIN_SPACING,
+          set_sea_level: CONFIG_KEYS.SEA_LEVEL
+        };
         bytes = [
           DOWNLINK_TYPES.CONFIG,
-          0x01,
+          keys[input.data.command],
           (input.data.value >> 16) & 0xFF,
           (input.data.value >> 8) & 0xFF,
           input.data.value & 0xFF
         ];
       }
       break;
+    case 'set_deadband': {
+      // { field: 'temperature', absolute: 0.5, relativePercent: 1.0 }
+      const field = REPORT_FIELDS.indexOf(input.data.field);
+      if (field >= 0) {
+        const absolute = Math.round((input.data.absolute || 0) * 100) & 0xFFFF;
+        const relative = Math.min(255, Math.round((input.data.relativePercent || 0) * 10));
+        bytes = [
+          DOWNLINK_TYPES.CONFIG,
+          CONFIG_KEYS.DEADBAND,
+          field,
+          (absolute >> 8) & 0xFF,
+          absolute & 0xFF,
+          relative
+        ];
+      }
+      break;
+    }
+    case 'set_calibration': {
+      // { channel: 'temperature', offset: -1.5, gain: 1.0 }
+      const channel = CALIBRATION_CHANNELS.indexOf(input.data.channel);
+      if (channel >= 0) {
+        const offset = Math.round((input.data.offset || 0) * 100) & 0xFFFF;
+        const gainValue = typeof input.data.gain === 'number' ? input.data.gain : 1;
+        const gain = Math.max(0, Math.min(0xFFFF, Math.round(gainValue * CALIBRATION_UNITY_GAIN)));
+        bytes = [
+          DOWNLINK_TYPES.CONFIG,
+          CONFIG_KEYS.CALIBRATION,
+          channel,
+          (offset >> 8) & 0xFF,
+          offset & 0xFF,
+          (gain >> 8) & 0xFF,
+          gain & 0xFF
+        ];
+      }
+      break;
+    }
   }
   
   return {
@@ -1,18 +1,45 @@
 #include <Arduino.h>
+#include <time.h>
+#include <sys/time.h>
 #include "Config.h"
 #include <DisplayManager.h>
 #include <DisplayLogger.h>
 #include <SensorManager.h>
+#include <I2CArbiter.h>
+#include <BatteryMonitor.h>
+#include <MotionSensor.h>
+#include <VibrationAnalyzer.h>
+#include <VibrationSampler.h>
 #include <LoRaManager.h>
+#include <ReportPolicy.h>
+#include <IntervalController.h>
+#include <SeriesCodec.h>
+#include <SampleArchive.h>
 
 // Include secrets for LoRaWAN credentials
 #include "secrets.h"
 
 // Global instances
 DisplayManager display;
+#if DISPLAY_HW_I2C
+Esp32I2CBus displayBus((i2c_port_t)DISPLAY_I2C_PORT);
+I2CArbiter displayI2C(displayBus);
+#endif
 DisplayLogger logger(display);
 SensorManager sensors;
+BatteryMonitor battery;
+MotionSensor motion;
+#if VIBRATION_ENABLED
+VibrationSampler vibrationSampler;
+VibrationAnalyzer vibration;
+#endif
 LoRaManager lora(US915, 2); // Initialize with US915 band and subband 2
+ReportPolicy report;
+IntervalController interval;
+#if SAMPLE_ARCHIVE_ENABLED
+PartitionFlash archiveFlash;
+SampleArchive archive(3, ULP_SAMPLE_INTERVAL / 1000);
+#endif
 
 // RTC variables (preserved during deep sleep)
 RTC_DATA_ATTR uint32_t bootCount = 0;
@@ -22,12 +49,21 @@ RTC_DATA_ATTR int consecutiveErrors = 0;
 RTC_DATA_ATTR uint32_t errorBackoffTime = MINIMUM_DELAY;
 RTC_DATA_ATTR bool pirWake = false;
 RTC_DATA_ATTR int lastJoinError = 0;
+#if SAMPLE_ARCHIVE_ENABLED
+RTC_DATA_ATTR ArchiveCursor archiveReplay;
+#endif
+
+// ULP samples from the last sleep that still have to be uplinked, and the
+// first of them no frame has been acknowledged for yet
+bool sleepBatchPending = false;
+uint8_t sleepBatchNext = 0;
 
 // Timers
 uint32_t lastDisplayUpdate = 0;
 uint32_t displayTimeout = 0;
-uint32_t lastDataSendTime = 0;
+uint32_t lastReportCheck = 0;
 uint32_t lastButtonCheck = 0;
+uint32_t lastBatterySample = 0;
 
 // Button state
 bool lastButtonState = HIGH;
@@ -35,10 +71,23 @@ bool lastButtonState = HIGH;
 // Function prototypes
 void goToSleep(uint32_t sleepTime);
 void updateDisplay();
-void sendSensorData(bool motionDetected = false);
+void reportSensorData(bool event = false);
+bool sendSensorData(const SensorReading& reading, bool motionDetected = false);
 void processDownlink();
 String getBmeStatusString();
 void checkButton();
+SensorReading readSensors();
+void printI2CHealth();
+float batteryVoltage();
+int batteryPercent();
+uint8_t batterySpacingFactor();
+uint32_t reportCheckIntervalMs();
+void sendVibrationFeatures();
+void sendSleepBatch();
+bool sendSeriesFrame(const SeriesEncoder& encoder);
+void beginArchive();
+void archiveReading(uint32_t time, const SensorReading& reading);
+void sendArchiveReplay();
 
 // Callback function for downlink data
 void handleDownlink(uint8_t* payload, size_t size, uint8_t port) {
@@ -61,6 +110,25 @@ void handleDownlink(uint8_t* payload, size_t size, uint8_t port) {
       // e.g., payload[1] could be a parameter
     }
     
+    // Deadband, heartbeat and spacing configuration
+    if (report.applyDownlink(payload, size)) {
+      interval.useDeadbands(report.getConfig());
+      Serial.println("Report configuration updated");
+    }
+    
+    // Calibration offsets/gains and the sea-level reference survive reboots in NVS
+    if (sensors.getCalibration().applyDownlink(payload, size)) {
+      Serial.println(sensors.getCalibration().save() ? "Sensor calibration saved" : "Sensor calibration not saved");
+    }
+    
+    #if SAMPLE_ARCHIVE_ENABLED
+    // Range request: replayed a few frames per report cycle on ARCHIVE_PORT
+    if (archive.applyDownlink(payload, size)) {
+      archiveReplay = archive.getReplay();
+      Serial.println(archive.isReplaying() ? "Archive replay requested" : "Archive holds nothing in the requested range");
+    }
+    #endif
+    
     // Use logger instead of direct display.log
     logger.info("Downlink received");
   }
@@ -82,6 +150,9 @@ void setup() {
   } else if (wakeup_reason == ESP_SLEEP_WAKEUP_TIMER) {
     Serial.println("Wakeup caused by timer");
     pirWake = false;
+  } else if (wakeup_reason == ESP_SLEEP_WAKEUP_ULP) {
+    Serial.println("Wakeup caused by ULP sensor sampling");
+    pirWake = false;
   } else {
     Serial.println("Wakeup was not caused by deep sleep");
     pirWake = false;
@@ -90,30 +161,40 @@ void setup() {
   // Initialize button pin
   pinMode(BUTTON_PIN, INPUT_PULLUP);
   
-  // Initialize PIR motion sensor
+  // Initialize PIR motion sensor (edges are captured by interrupt)
   #ifdef PIR_PIN
-  pinMode(PIR_PIN, INPUT_PULLUP);
+  motion.begin(PIR_PIN, PIR_WAKE_LEVEL);
+  if (pirWake) {
+    motion.recordWakeEvent(millis());
+  }
   Serial.println("PIR motion sensor initialized on pin " + String(PIR_PIN));
   #endif
 
-  // Define VEXT pin for the Heltec board to control peripherals
-  #define VEXT_PIN 36
-  
-  // First, toggle VEXT to power cycle all external sensors
+  // Switch VEXT on for the external sensors and the OLED (VEXT_PIN and
+  // VEXT_ACTIVE_HIGH from Config.h, shared with SensorManager and DisplayManager).
+  // A sensor that does not answer is power cycled by SensorManager's bus recovery,
+  // so a healthy boot no longer spends a second cycling VEXT.
   pinMode(VEXT_PIN, OUTPUT);
+  bool deepSleepWake = wakeup_reason != ESP_SLEEP_WAKEUP_UNDEFINED;
+  if (deepSleepWake) {
+    // VEXT was unpowered during deep sleep (or held on for the ULP)
+    gpio_hold_dis((gpio_num_t)VEXT_PIN);
+  }
+  digitalWrite(VEXT_PIN, VEXT_ACTIVE_HIGH ? HIGH : LOW);
+  delay(10); // BME280 start-up time is 2 ms
   
-  // Power cycle for the BME280 sensor (HIGH = off, LOW = on for VEXT)
-  // The V3.2 board has inverted VEXT logic
-  if (HELTEC_BOARD_VERSION == 1) {
-    digitalWrite(VEXT_PIN, LOW);  // Turn OFF external devices for V3.2 (inverted)
-    delay(500);
-    digitalWrite(VEXT_PIN, HIGH); // Turn ON external devices for V3.2 (inverted)
+  // Battery monitor (ADC_Ctrl is inverted on V3.2)
+  if (battery.begin(VBAT_ADC_PIN, VBAT_ADC_CTRL_PIN, HELTEC_BOARD_VERSION == 1) && battery.sample()) {
+    Serial.println("Battery: " + String(battery.getMillivolts()) + " mV, " +
+                   String(battery.getStateOfCharge()) + "%");
   } else {
-    digitalWrite(VEXT_PIN, HIGH); // Turn OFF external devices for V3.0/V3.1
-    delay(500);
-    digitalWrite(VEXT_PIN, LOW);  // Turn ON external devices for V3.0/V3.1
+    Serial.println("No battery detected, running from external power");
   }
-  delay(500); // Wait for devices to power up
+  lastBatterySample = millis();
+
+  #if VIBRATION_ENABLED
+  vibration.begin(VIBRATION_SAMPLE_RATE_HZ, 1.0F / VIBRATION_COUNTS_PER_G);
+  #endif
 
   // IMPORTANT: Initialize BME280 BEFORE display
   Serial.println("Initializing BME280 sensor with priority...");
@@ -124,53 +205,81 @@ void setup() {
   Serial.println("BME280 address: 0x" + String(BME_ADDRESS, HEX));
   #endif
 
-  // Try to initialize BME280 with multiple attempts
-  bool sensorInitialized = false;
-  for (int i = 0; i < 3; i++) {
-    Serial.println("BME280 initialization attempt " + String(i+1) + " of 3");
-    if (sensors.begin(I2C_SDA, I2C_SCL)) {
-      sensorInitialized = true;
-      Serial.println("BME280 sensor initialized successfully on attempt " + String(i+1));
-      break;
-    } else {
-      Serial.println("BME280 sensor init failed, attempt " + String(i+1));
-      delay(300); // Longer wait before retry
-    }
+  // Per-device offsets and sea-level reference set by downlink
+  if (sensors.getCalibration().load()) {
+    Serial.println("Sensor calibration loaded (sea level " +
+                   String(sensors.getCalibration().getSeaLevelHpa()) + " hPa)");
+  }
+
+  // Oversampling/filter profile; its conversion time and noise come from the datasheet model
+  sensors.setProfile(SENSOR_PROFILE);
+  Serial.println("BME280 profile: " + String(sensorProfileName(SENSOR_PROFILE)) + ", " +
+                 String(sensors.getMeasurementUs() / 1000.0, 1) + " ms per conversion, " +
+                 String(bme280PressureNoisePa(bme280Profile(SENSOR_PROFILE))) + " Pa noise");
+  
+  // begin() escalates through retries, bus clock-out, controller reinit and a
+  // VEXT power cycle by itself, and falls back from the warm-wake fast path
+  bool sensorInitialized = sensors.begin(I2C_SDA, I2C_SCL);
+  printI2CHealth();
+  
+  if (sensorInitialized) {
+    Serial.println("Wake-to-reading latency: " + String(sensors.getWakeToReadingUs() / 1000) + " ms (" +
+                   (sensors.isWarmStart() ? "warm" : "cold") + " start)");
+  }
+  
+  const UlpSampler& ulp = sensors.getUlpSampler();
+  if (ulp.getTotalWakes() > 0) {
+    Serial.println("ULP: " + String(ulp.getTotalSamples()) + " sleep samples over " +
+                   String(ulp.getTotalWakes()) + " wakes");
+  }
+  sleepBatchPending = ulp.getSampleCount() > 0;
+  sleepBatchNext = 0;
+  
+  // Sleep samples go to the archive whether or not they can be uplinked
+  beginArchive();
+  
+  // Hand I2C execution to a background task so bus transfers don't block the main loop
+  if (sensorInitialized && !sensors.startBackgroundI2C()) {
+    Serial.println("I2C worker not started, using synchronous transfers");
   }
   
   // Now initialize the display AFTER BME280 setup
   Serial.println("Initializing display...");
-  display.begin(OLED_SDA, OLED_SCL, HELTEC_BOARD_VERSION == 1 ? DisplayManager::V3_2 : DisplayManager::V3_0);
+#if DISPLAY_HW_I2C
+  display.useHardwareI2C(&displayI2C);
+#endif
+  display.begin(OLED_SDA, OLED_SCL);
   display.setNormalMode(); // Ensure display is in normal mode
+  display.setStaticPowerSave(DISPLAY_STATIC_TIMEOUT);
+  if (!display.startRenderTask()) {
+    Serial.println("Display render task not started, frames are sent inline");
+  }
   display.drawStartupScreen();
   display.updateStartupProgress(10, "Initializing...");
   
   // Update user about sensor initialization
   if (!sensorInitialized) {
-    Serial.println("WARNING: BME280 sensor not found after multiple attempts!");
+    Serial.println("WARNING: BME280 sensor not found after every recovery step!");
     logger.warning("BME280 sensor not found!");
     display.updateStartupProgress(30, "BME280 not found!");
   } else {
     display.updateStartupProgress(30, "BME280 initialized");
     
     // Check sensor readings immediately after initialization
-    float t, h, p, a;
-    sensors.readBME280(t, h, p, a);
-    
-    Serial.println("Initial BME280 readings:");
-    Serial.println("  Temperature: " + String(t) + "°C");
-    Serial.println("  Humidity: " + String(h) + "%");
-    Serial.println("  Pressure: " + String(p) + " hPa");
-    
-    // Check if readings are valid
-    if (isnan(t) || isnan(h) || isnan(p) || 
-        (t == 0.0 && h == 0.0 && p == 0.0)) {
+    SensorReading reading = readSensors();
+    if (reading.quality & (SENSOR_QUALITY_READ_ERROR | SENSOR_QUALITY_OUT_OF_RANGE)) {
       Serial.println("WARNING: BME280 returning invalid readings");
       logger.warning("BME280 reading error");
     }
   }
   delay(300);
   
+  // Uplink policy and adaptive check interval from Config.h
+  report.setMinSpacing(UPLINK_MIN_SPACING_MS);
+  report.setMaxSilence(UPLINK_MAX_SILENCE_MS);
+  interval.useDeadbands(report.getConfig());
+  interval.setBounds(INTERVAL_MIN_MS, INTERVAL_MAX_MS);
+  
   // Initialize LoRa radio
   display.updateStartupProgress(50, "Initializing LoRa...");
   if (!lora.begin(LORA_CS, LORA_DIO1, LORA_RST, LORA_BUSY)) {
@@ -216,40 +325,12 @@ void setup() {
     consecutiveErrors = 0;
     
     // Read sensor data before showing sensor screen
-    float temperature = 0, humidity = 0, pressure = 0, altitude = 0;
-    
-    if (sensors.isBME280Available()) {
-      Serial.println("Reading sensor data after network join");
-      for (int attempt = 0; attempt < 3; attempt++) {
-        sensors.readBME280(temperature, humidity, pressure, altitude);
-        Serial.println("Post-join sensor readings (attempt " + String(attempt+1) + ") - Temp: " + 
-                      String(temperature) + "°C, Humidity: " + String(humidity) + 
-                      "%, Pressure: " + String(pressure) + " hPa");
-        
-        // If we got non-zero readings, break the loop
-        if (temperature != 0 || humidity != 0 || pressure != 0) {
-          Serial.println("Got valid sensor readings post-join");
-          break;
-        }
-        delay(100);
-      }
-    } else {
-      // Use zeros if sensor is unavailable
-      temperature = 0.0;
-      humidity = 0.0;
-      pressure = 0.0;
-      Serial.println("BME280 unavailable, using zeros for display");
-    }
+    Serial.println("Reading sensor data after network join");
+    SensorReading reading = readSensors();
     
-    // First draw the sensor data screen and populate it with data
-    display.drawSensorDataScreen();
-    Serial.println("Drew sensor data screen after join");
-    
-    display.updateSensorData(temperature, humidity, pressure, 3.7);
-    Serial.println("Updated sensor data after join");
-    
-    // Explicitly update the current screen state without redrawing
-    display.setScreen(3, false); // Sensor data screen
+    // Fill the sensor data screen model, then show it
+    display.updateSensorData(reading.temperature, reading.humidity, reading.pressure, batteryVoltage(), batteryPercent());
+    display.setScreen(3); // Sensor data screen
     Serial.println("Set screen to sensor data screen (index 3)");
     
     // Explicit display refresh
@@ -263,10 +344,10 @@ void setup() {
     delay(1000);
     
     // Send sensor data
-    sendSensorData();
+    reportSensorData();
     
-    // Update the last send time to maintain the regular schedule
-    lastDataSendTime = millis();
+    // Update the last check time to maintain the regular schedule
+    lastReportCheck = millis();
     
   } else {
     display.updateStartupProgress(100, "Join failed!");
@@ -299,8 +380,8 @@ void setup() {
     // Small delay to ensure system is ready
     delay(1000);
     
-    sendSensorData(true);
-    lastDataSendTime = millis();
+    reportSensorData(true);
+    lastReportCheck = millis();
   }
 }
 
@@ -311,39 +392,28 @@ void loop() {
   // Check button presses
   checkButton();
   
-  // Check for motion detection
+  // Fold PIR edges captured by the interrupt into the current interval;
+  // they are reported with the next scheduled uplink
+  bool motionStarted = false;
   #ifdef PIR_PIN
-  static bool lastMotionState = LOW;
-  bool currentMotionState = digitalRead(PIR_PIN);
-  
-  // If motion is detected (rising edge)
-  if (currentMotionState == PIR_WAKE_LEVEL && lastMotionState != PIR_WAKE_LEVEL) {
+  if (motion.update(millis()) > 0) {
+    motionStarted = true;
     Serial.println("Motion detected!");
     display.wakeup(); // Wake up display if it was sleeping
     logger.info("Motion detected");
     displayTimeout = millis() + DISPLAY_TIMEOUT; // Reset display timeout
-    
-    // If we're joined to the network, send data immediately
-    if (lora.isNetworkJoined()) {
-      // Only send if it's been at least 10 seconds since last transmission
-      // This prevents too frequent transmissions when motion is continuous
-      if (millis() - lastDataSendTime > 10000) {
-        Serial.println("Sending sensor data due to motion detection");
-        logger.info("Sending motion alert");
-        
-        // Add a small delay to make sure everything is ready
-        delay(500);
-        
-        sendSensorData(true);
-        lastDataSendTime = millis();
-      } else {
-        Serial.println("Motion detected but skipping transmission (too soon after last send)");
-      }
-    }
   }
-  lastMotionState = currentMotionState;
   #endif
   
+  // Keep the resting battery average current between uplinks
+  if (millis() - lastBatterySample > BATTERY_SAMPLE_INTERVAL) {
+    battery.sample();
+    lastBatterySample = millis();
+  }
+  
+  // Send the frame the scheduler held back, if any
+  display.update();
+  
   // Update display periodically
   if (millis() - lastDisplayUpdate > 5000) {
     updateDisplay();
@@ -369,21 +439,16 @@ void loop() {
     display.sleep();
   }
   
-  // If we're joined to the network and it's time to send data
-  if (lora.isNetworkJoined() && (millis() - lastDataSendTime > (MINIMUM_DELAY * 1000))) {
-    Serial.println("Network joined, preparing to send sensor data");
-    logger.info("Preparing to send data");
-    
-    // Add a small delay to make sure everything is ready
-    delay(1000);
-    
-    sendSensorData(false); // Regular scheduled transmission, not motion triggered
-    lastDataSendTime = millis();
+  // Check the readings on the adaptive interval (and on motion); the report
+  // policy only sends when something changed or the heartbeat is due
+  if (lora.isNetworkJoined() && (motionStarted || millis() - lastReportCheck > reportCheckIntervalMs())) {
+    reportSensorData(motionStarted);
+    lastReportCheck = millis();
   } else if (lora.isNetworkJoined()) {
-    // Debug: print time until next transmission
-    unsigned long timeToNext = (MINIMUM_DELAY * 1000) - (millis() - lastDataSendTime);
+    // Debug: print time until the next check
+    unsigned long timeToNext = reportCheckIntervalMs() - (millis() - lastReportCheck);
     if (millis() % 10000 < 10) { // Print only occasionally to avoid flooding
-      Serial.println("Network joined. Next transmission in " + String(timeToNext/1000) + " seconds");
+      Serial.println("Network joined. Next report check in " + String(timeToNext/1000) + " seconds");
     }
   }
   
@@ -402,34 +467,21 @@ void updateDisplay() {
   displayTimeout = millis() + DISPLAY_TIMEOUT;
   
   // Read sensor data
-  float temperature = 0, humidity = 0, pressure = 0, altitude = 0;
-  float batteryVoltage = 3.7; // Default value, replace with actual battery reading if available
-  
-  if (sensors.isBME280Available()) {
-    Serial.println("Reading BME280 data for display update");
-    
-    // Try multiple times to get valid readings
-    for (int attempt = 0; attempt < 3; attempt++) {
-      sensors.readBME280(temperature, humidity, pressure, altitude);
-      Serial.println("Display update readings (attempt " + String(attempt+1) + ") - Temp: " + String(temperature) + 
-                  "°C, Humidity: " + String(humidity) + "%, Pressure: " + String(pressure) + " hPa");
-                  
-      // If we got non-zero readings, break the loop
-      if (temperature != 0 || humidity != 0 || pressure != 0) {
-        Serial.println("Got valid sensor readings for display");
-        break;
-      }
-      
-      // Short delay before trying again
-      delay(100);
-    }
-  } else {
-    Serial.println("BME280 not available for display update, using zeros");
-    // Use zeros when sensor not available
-    temperature = 0.0;
-    humidity = 0.0;
-    pressure = 0.0;
-  }
+  Serial.println("Reading BME280 data for display update");
+  SensorReading reading = readSensors();
+  float temperature = reading.temperature;
+  float humidity = reading.humidity;
+  float pressure = reading.pressure;
+  
+  // The screen models keep their values whichever screen is shown; only
+  // values that changed are drawn, and only on the visible screen
+  display.updateSensorData(temperature, humidity, pressure, batteryVoltage(), batteryPercent());
+  display.updateLoRaWANStatus(
+    lora.isNetworkJoined(),
+    lastRssi,
+    0, // We don't have uplink counter in the new API
+    0  // We don't have downlink counter in the new API
+  );
   
   // If we're on screen 1 (startup), move to sensor or status screen
   if (display.getCurrentScreen() == 1) {
@@ -440,100 +492,82 @@ void updateDisplay() {
       // Show the appropriate screen based on network status
       if (lora.isNetworkJoined()) {
         Serial.println("Moving from startup to sensor data screen");
-        
-        // Draw sensor data screen first
-        display.drawSensorDataScreen();
-        
-        // Then update with the sensor data we've loaded
-        display.updateSensorData(temperature, humidity, pressure, batteryVoltage);
-        
-        // Make sure changes are visible
-        display.refresh();
-        
-        // Only then set the screen index (which won't redraw since we've done it manually)
-        display.setScreen(3, false); // Sensor data screen
+        display.setScreen(3); // Sensor data screen
       } else {
         display.setScreen(2); // LoRaWAN status screen
       }
     }
-  } else {
-    // For sensor data screen, always update the data
-    if (display.getCurrentScreen() == 3) {
-      display.updateSensorData(temperature, humidity, pressure, batteryVoltage);
-    }
   }
   
-  // Update LoRaWAN status screen
-  if (display.getCurrentScreen() == 2) {
-    display.updateLoRaWANStatus(
-      lora.isNetworkJoined(),
-      lastRssi,
-      0, // We don't have uplink counter in the new API
-      0  // We don't have downlink counter in the new API
-    );
-  }
-  
-  // Ensure display is refreshed
+  // One frame for everything drawn above
   display.refresh();
 }
 
-void sendSensorData(bool motionDetected) {
-  Serial.println("Starting sendSensorData function");
-  
+void reportSensorData(bool event) {
   if (!lora.isNetworkJoined()) {
     Serial.println("Cannot send data - not joined to network");
     return;
   }
   
-  // Read sensor data
-  float temperature = 0, humidity = 0, pressure = 0, altitude = 0;
+  // Resting battery voltage before the radio draws current
+  battery.sample();
+  lastBatterySample = millis();
   
-  if (sensors.isBME280Available()) {
-    Serial.println("Reading BME280 sensor data for transmission");
-    
-    // Try to read sensor values multiple times if they return zero
-    for (int attempt = 0; attempt < 3; attempt++) {
-      sensors.readBME280(temperature, humidity, pressure, altitude);
-      
-      Serial.println("Sensor readings (attempt " + String(attempt+1) + ") - Temp: " + String(temperature) + 
-                    "°C, Humidity: " + String(humidity) + "%, Pressure: " + String(pressure) + " hPa");
-      
-      // If we got non-zero readings, break the loop
-      if (temperature != 0 || humidity != 0 || pressure != 0) {
-        Serial.println("Received valid readings, proceeding with transmission");
-        break;
-      }
-      
-      // If we got zeros, wait briefly and try again
-      if (attempt < 2) {
-        Serial.println("Got zero readings, retrying after delay...");
-        delay(100);
-      }
+  // Read sensor data; a single filtered read replaces the old zero-check retries
+  SensorReading reading = readSensors();
+  if (!(reading.quality & (SENSOR_QUALITY_READ_ERROR | SENSOR_QUALITY_NO_DATA))) {
+    archiveReading((uint32_t)time(nullptr), reading);
+  }
+  float values[REPORT_FIELD_COUNT] = { reading.temperature, reading.humidity, reading.pressure, batteryVoltage() };
+  
+  // Low battery stretches the spacing between uplinks and between checks
+  report.setSpacingFactor(batterySpacingFactor());
+  interval.setBatteryFactor(batterySpacingFactor());
+  interval.update(values, event, millis());
+  
+  ReportReason reason = report.evaluate(values, event, millis());
+  if (!ReportPolicy::shouldSend(reason)) {
+    if (reason == REPORT_DEFERRED) {
+      Serial.println("Report deferred until the minimum spacing has passed");
     }
-  } else {
-    Serial.println("BME280 not available, using zeros");
-    
-    // Set zeros if sensor is not available
-    temperature = 0.0;
-    humidity = 0.0;
-    pressure = 0.0;
-    Serial.println("Using zeros - Temp: 0.0°C, Humidity: 0.0%, Pressure: 0.0 hPa");
+    return;
   }
   
+  Serial.println("Reporting (reason " + String(reason) + ", changed fields 0x" +
+                 String(report.changedFields(values), HEX) + ")");
+  logger.info("Preparing to send data");
+  
+  if (sendSensorData(reading, event)) {
+    report.commit(values, reason, millis());
+    sendVibrationFeatures();
+    sendSleepBatch();
+    sendArchiveReplay();
+  }
+  
+  const ReportStats& stats = report.getStats();
+  Serial.println("Reports: " + String(stats.sent) + " sent, " + String(stats.suppressed) + " suppressed, " +
+                 String(stats.heartbeats) + " heartbeats");
+}
+
+bool sendSensorData(const SensorReading& reading, bool motionDetected) {
+  Serial.println("Starting sendSensorData function");
+  
+  float temperature = reading.temperature;
+  float humidity = reading.humidity;
+  float pressure = reading.pressure;
+  
   // Show sensor data screen before sending
-  display.drawSensorDataScreen();
   display.updateSensorData(
     temperature, 
     humidity, 
     pressure, 
-    3.7 // Default battery value, replace with actual reading if available
+    batteryVoltage(),
+    batteryPercent()
   );
-  
-  // Make sure to display any updates right away
-  display.refresh();
+  display.drawSensorDataScreen();
   
   // Prepare payload (simple binary format)
-  uint8_t payload[8];
+  uint8_t payload[22];
   
   // Convert float to int16_t (2 bytes) with 1 decimal place precision
   int16_t temp_int = (int16_t)(temperature * 10);
@@ -548,10 +582,41 @@ void sendSensorData(bool motionDetected) {
   payload[4] = press_int >> 8;
   payload[5] = press_int & 0xFF;
   payload[6] = 0; // Use bit 0 of byte 6 as motion flag
-  payload[7] = 0; // Reserved for future use
+  payload[7] = reading.quality; // SENSOR_QUALITY_* flags
   
-  // Set motion flag if data is being sent due to motion detection
-  if (motionDetected) {
+  // Battery: resting voltage in mV and state of charge (0xFF = no battery)
+  uint16_t batteryMv = battery.isPresent() ? battery.getMillivolts() : 0;
+  payload[8] = batteryMv >> 8;
+  payload[9] = batteryMv & 0xFF;
+  payload[10] = battery.getStateOfCharge();
+  
+  // Motion since the previous uplink: count, age of first/last event in
+  // seconds before this uplink (0xFFFF = none) and occupancy duty in %
+  uint32_t now = millis();
+  MotionSummary activity = motion.takeSummary(now);
+  uint16_t firstAge = activity.count > 0 ? MotionSummary::ageSeconds(activity.firstEventMs, now) : MOTION_NO_EVENT;
+  uint16_t lastAge = activity.count > 0 ? MotionSummary::ageSeconds(activity.lastEventMs, now) : MOTION_NO_EVENT;
+  payload[11] = activity.count >> 8;
+  payload[12] = activity.count & 0xFF;
+  payload[13] = firstAge >> 8;
+  payload[14] = firstAge & 0xFF;
+  payload[15] = lastAge >> 8;
+  payload[16] = lastAge & 0xFF;
+  payload[17] = activity.occupancyPercent();
+  
+  // Node clock in seconds, the time base of the archive; the backend pairs it
+  // with the receive time to turn an outage window into a range request
+  uint32_t nodeTime = (uint32_t)time(nullptr);
+  payload[18] = nodeTime >> 24;
+  payload[19] = (nodeTime >> 16) & 0xFF;
+  payload[20] = (nodeTime >> 8) & 0xFF;
+  payload[21] = nodeTime & 0xFF;
+  Serial.println("Motion: " + String(activity.count) + " events, " +
+                 String(activity.occupancyPercent()) + "% occupancy" +
+                 (activity.dropped > 0 ? ", " + String(activity.dropped) + " dropped" : String("")));
+  
+  // Set motion flag if data is being sent due to motion detection or motion was seen
+  if (motionDetected || activity.count > 0) {
     payload[6] |= 0x01; // Set bit 0 of byte 6
     Serial.println("Motion flag set in payload");
   }
@@ -562,6 +627,9 @@ void sendSensorData(bool motionDetected) {
   } else {
     logger.info("Sending data...");
   }
+  
+  // Show the screen and the log line before the radio blocks; with the
+  // render task this only swaps buffers and the push runs alongside
   display.refresh();
   
   // Send the data
@@ -574,9 +642,20 @@ void sendSensorData(bool motionDetected) {
   }
   Serial.println();
   
+  // Measure the cell while the uplink is on air to see how far it sags under load
+  bool loadSample = battery.beginLoadSample();
+  
   // Use the LoRaManager to send data (port 1, unconfirmed)
   bool success = lora.sendData(payload, sizeof(payload), 1, LORAWAN_CONFIRMED_MESSAGES);
   
+  if (loadSample && battery.endLoadSample(success)) {
+    Serial.println("Battery during TX: " + String(battery.getLoadedMillivolts()) + " mV (sag " +
+                   String(battery.getSagMillivolts()) + " mV)");
+    if (battery.isCritical()) {
+      logger.warning("Battery critical");
+    }
+  }
+  
   if (success) {
     Serial.println("Data sent successfully!");
     logger.info("Data sent successfully");
@@ -592,6 +671,9 @@ void sendSensorData(bool motionDetected) {
     Serial.println("Failed to send data! Error code: " + String(lora.getLastErrorCode()));
     logger.error("Failed to send data");
     
+    // The motion of this interval goes out with the next uplink instead
+    motion.restoreSummary(activity);
+    
     // Get the error code
     int errorCode = lora.getLastErrorCode();
     
@@ -632,24 +714,50 @@ void sendSensorData(bool motionDetected) {
   
   // Update display with latest status
   updateDisplay();
+  return success;
 }
 
 void processDownlink() {
   // This function is now replaced by the handleDownlink callback
 }
 
+// Not called yet: the loop stays awake because the LoRaWAN session does not
+// survive deep sleep. The ULP sampling below only runs once it is.
 void goToSleep(uint32_t sleepTime) {
   Serial.println("Going to sleep for " + String(sleepTime) + " seconds");
-  logger.info("Sleep: " + String(sleepTime) + "s");
-  display.refresh();
+  logger.info("Sleep: %lus", (unsigned long)sleepTime);
+  display.flush();
   delay(100);
   
+  const DisplayStats& displayStats = display.getStats();
+  Serial.println("Display: " + String(displayStats.frames) + " frames (" + String(displayStats.fullFrames) +
+                 " full), " + String(displayStats.bytesPerFrame(), 0) + " bytes and " +
+                 String(displayStats.msPerFrame(), 1) + " ms per frame, " +
+                 String(displayStats.pagesSkipped) + " unchanged pages skipped" +
+                 (display.isHardwareI2C() ? String(", ") + String(displayStats.busErrors) + " bus errors" : String("")));
+  
   // Turn off display to save power
   display.sleep();
   
+  #if SAMPLE_ARCHIVE_ENABLED
+  // The open frame lives in RAM; write it out before RAM is lost
+  archive.flush();
+  archiveReplay = archive.getReplay();
+  #endif
+  
   // Configure wake sources
   esp_sleep_enable_timer_wakeup(sleepTime * 1000000ULL);
   
+  #if ULP_SAMPLING_ENABLED
+  // Let the ULP watch the BME280 while the cores sleep; VEXT has to stay on for it
+  UlpThresholds thresholds = { ULP_THRESHOLD_TEMPERATURE, ULP_THRESHOLD_HUMIDITY, ULP_THRESHOLD_PRESSURE };
+  if (sensors.startUlpSampling(I2C_SDA, I2C_SCL, thresholds, ULP_SAMPLE_INTERVAL)) {
+    gpio_hold_en((gpio_num_t)VEXT_PIN);
+    gpio_deep_sleep_hold_en();
+    Serial.println("ULP sampling every " + String(ULP_SAMPLE_INTERVAL / 1000) + " s during sleep");
+  }
+  #endif
+  
   // Enable PIR wake if configured
   #ifdef PIR_PIN
   esp_sleep_enable_ext0_wakeup((gpio_num_t)PIR_PIN, PIR_WAKE_LEVEL);
@@ -664,14 +772,220 @@ String getBmeStatusString() {
     return "BME280 not found";
   }
   
-  float temp = sensors.readTemperature();
-  float humidity = sensors.readHumidity();
-  
-  if (isnan(temp) || isnan(humidity) || (temp == 0.0 && humidity == 0.0)) {
+  SensorReading reading;
+  if (!sensors.read(reading)) {
     return "BME280 error";
   }
   
-  return String(temp, 1) + "C " + String(humidity, 0) + "%";
+  return String(reading.temperature, 1) + "C " + String(reading.humidity, 0) + "%";
+}
+
+float batteryVoltage() {
+  return battery.isPresent() ? battery.getVoltage() : 0.0;
+}
+
+int batteryPercent() {
+  return battery.isPresent() ? battery.getStateOfCharge() : -1;
+}
+
+uint8_t batterySpacingFactor() {
+  // Stretch the spacing between uplinks as the battery drains
+  if (battery.isCritical()) {
+    return 4;
+  }
+  if (battery.isLow()) {
+    return 2;
+  }
+  return 1;
+}
+
+void sendVibrationFeatures() {
+  #if VIBRATION_ENABLED
+  // Capture one block on demand, a snapshot of this uplink only; the ADC
+  // is unavailable for one-shot (battery) reads while continuous mode runs
+  if (!vibrationSampler.begin(VIBRATION_ADC_PIN, VIBRATION_SAMPLE_RATE_HZ)) {
+    Serial.println("Vibration capture failed to start");
+    return;
+  }
+  uint32_t blockMs = VIBRATION_FFT_SIZE * 1000UL / VIBRATION_SAMPLE_RATE_HZ;
+  const int16_t* block = vibrationSampler.capture(2 * blockMs + 100);
+  vibrationSampler.end();
+  if (block == NULL) {
+    Serial.println("Vibration capture timed out");
+    return;
+  }
+  
+  VibrationFeatures features;
+  vibration.analyze(block, features);
+  Serial.printf("Vibration: %.3f g rms, peak %.1f Hz at %.3f g\n", features.rms,
+                features.peaks[0].frequency, features.peaks[0].amplitude);
+  
+  // Only the features go over the air
+  uint8_t payload[VIBRATION_PAYLOAD_SIZE];
+  size_t length = VibrationAnalyzer::encode(features, payload);
+  if (!lora.sendData(payload, length, VIBRATION_PORT, LORAWAN_CONFIRMED_MESSAGES)) {
+    Serial.println("Failed to send vibration features");
+  }
+  #endif
+}
+
+bool sendSeriesFrame(const SeriesEncoder& encoder) {
+  uint8_t payload[SERIES_MAX_BYTES];
+  memcpy(payload, encoder.data(), encoder.size());
+  Serial.println("Sleep batch: " + String(encoder.count()) + " samples in " + String(encoder.size()) +
+                 " bytes (" + String(encoder.count() * 6) + " uncompressed)");
+  return lora.sendData(payload, encoder.size(), SERIES_PORT, LORAWAN_CONFIRMED_MESSAGES);
+}
+
+void sendSleepBatch() {
+  if (!sleepBatchPending) {
+    return;
+  }
+  
+  // Hundredths of °C, %RH and hPa, packed into as few frames as possible;
+  // a failed frame and everything after it are retried next cycle
+  const UlpSampler& ulp = sensors.getUlpSampler();
+  SeriesEncoder encoder(3, ULP_SAMPLE_INTERVAL / 1000);
+  uint8_t frameStart = sleepBatchNext;
+  for (uint8_t i = sleepBatchNext; i < ulp.getSampleCount(); i++) {
+    SensorReading sample;
+    if (!ulp.getSample(i, sample)) {
+      continue;
+    }
+    int32_t values[3] = { (int32_t)lroundf(sample.temperature * 100.0F),
+                          (int32_t)lroundf(sample.humidity * 100.0F),
+                          (int32_t)lroundf(sample.pressure * 100.0F) };
+    if (!encoder.append(values)) {
+      if (!sendSeriesFrame(encoder)) {
+        sleepBatchNext = frameStart;
+        return;
+      }
+      frameStart = i;
+      encoder.reset();
+      encoder.append(values);
+    }
+  }
+  if (!encoder.isEmpty() && !sendSeriesFrame(encoder)) {
+    sleepBatchNext = frameStart;
+    return;
+  }
+  sleepBatchPending = false;
+  sleepBatchNext = ulp.getSampleCount();
+}
+
+void beginArchive() {
+  #if SAMPLE_ARCHIVE_ENABLED
+  // goToSleep() flushes the open frame; a reset or brown-out does not
+  archive.setMaxPendingAge(ARCHIVE_MAX_PENDING_AGE);
+  if (!archiveFlash.begin() || !archive.begin(&archiveFlash)) {
+    Serial.println("Sample archive partition not found");
+    return;
+  }
+  
+  // The RTC clock runs through deep sleep but restarts at 0 after a power
+  // loss; archive times must not go backwards, so continue from the newest
+  if ((uint32_t)time(nullptr) <= archive.getNewestTime()) {
+    struct timeval now = { (time_t)archive.getNewestTime() + 1, 0 };
+    settimeofday(&now, NULL);
+  }
+  archive.restoreReplay(archiveReplay);
+  
+  // ULP samples were taken one period apart, the last one a period ago
+  const UlpSampler& ulp = sensors.getUlpSampler();
+  uint32_t now = (uint32_t)time(nullptr);
+  uint32_t period = ULP_SAMPLE_INTERVAL / 1000;
+  for (uint8_t i = 0; i < ulp.getSampleCount(); i++) {
+    SensorReading sample;
+    if (ulp.getSample(i, sample)) {
+      archiveReading(now - (ulp.getSampleCount() - i) * period, sample);
+    }
+  }
+  
+  ArchiveStats stats = archive.getStats();
+  Serial.println("Archive: " + String(stats.records) + " records in " + String(stats.sectors) + " sectors (" +
+                 String(stats.bytes / 1024) + " KB), " + String((stats.newestTime - stats.oldestTime) / 3600) +
+                 " h of history" + (archive.isReplaying() ? ", replay pending" : ""));
+  #endif
+}
+
+void archiveReading(uint32_t time, const SensorReading& reading) {
+  #if SAMPLE_ARCHIVE_ENABLED
+  // Same hundredths of °C, %RH and hPa as the sleep batches
+  int32_t values[3] = { (int32_t)lroundf(reading.temperature * 100.0F),
+                        (int32_t)lroundf(reading.humidity * 100.0F),
+                        (int32_t)lroundf(reading.pressure * 100.0F) };
+  if (!archive.append(time, values)) {
+    Serial.println("Archive append failed");
+  }
+  #endif
+}
+
+void sendArchiveReplay() {
+  #if SAMPLE_ARCHIVE_ENABLED
+  ArchiveRecord record;
+  for (int i = 0; i < ARCHIVE_FRAMES_PER_REPORT && archive.isReplaying(); i++) {
+    ArchiveCursor before = archive.getReplay();
+    if (!archive.nextReplay(record)) {
+      break;
+    }
+    // Straight from the mapped partition to the radio; a failed frame is retried next cycle
+    if (!lora.sendData(const_cast<uint8_t*>(record.frame), record.size, ARCHIVE_PORT, LORAWAN_CONFIRMED_MESSAGES)) {
+      archive.restoreReplay(before);
+      break;
+    }
+    Serial.println("Archive replay: " + String(record.frame[2]) + " samples from " + String(record.firstTime));
+  }
+  archiveReplay = archive.getReplay();
+  #endif
+}
+
+uint32_t reportCheckIntervalMs() {
+  // Back off after failed uplinks instead of retrying at the adaptive rate
+  uint32_t next = interval.getIntervalMs();
+  if (consecutiveErrors > 0 && errorBackoffTime * 1000UL > next) {
+    next = errorBackoffTime * 1000UL;
+  }
+  return next;
+}
+
+SensorReading readSensors() {
+  SensorReading reading;
+  sensors.read(reading);
+  
+  // Escalate one recovery step per failed read; a good read starts over
+  if (sensors.isBME280Available() && (reading.quality & SENSOR_QUALITY_READ_ERROR) &&
+      sensors.recoverBus(I2C_SDA, I2C_SCL) == I2C_RECOVERY_POWER_CYCLE) {
+    // The OLED is on VEXT too and came back blank, with its settings reset
+    display.restartController();
+  }
+  
+  // Channels that never had a valid sample are reported as zero;
+  // SENSOR_QUALITY_NO_DATA tells them apart from real zeros
+  if (isnan(reading.temperature)) reading.temperature = 0.0;
+  if (isnan(reading.humidity)) reading.humidity = 0.0;
+  if (isnan(reading.pressure)) reading.pressure = 0.0;
+  
+  Serial.println("Sensor readings - Temp: " + String(reading.temperature) + "°C, Humidity: " +
+                 String(reading.humidity) + "%, Pressure: " + String(reading.pressure) +
+                 " hPa, quality: 0x" + String(reading.quality, HEX));
+  return reading;
+}
+
+void printI2CHealth() {
+  // Steady NACK or timeout counts across boots point at flaky wiring
+  const I2CHealthMonitor& health = sensors.getHealth();
+  const I2CDeviceHealth* device = health.getDevice(BME_ADDRESS);
+  if (device) {
+    Serial.println("I2C 0x" + String(BME_ADDRESS, HEX) + ": " + String(device->transfers) + " transfers, " +
+                   String(device->nacks) + " NACKs, " + String(device->timeouts) + " timeouts, " +
+                   String(device->stuckDetections) + " stuck");
+  }
+  const I2CBusHealth& bus = health.getBusHealth();
+  Serial.println("I2C recovery: " + String(bus.steps[I2C_RECOVERY_RETRY]) + " retries, " +
+                 String(bus.steps[I2C_RECOVERY_CLOCK_OUT]) + " clock-outs, " +
+                 String(bus.steps[I2C_RECOVERY_REINIT]) + " reinits, " +
+                 String(bus.steps[I2C_RECOVERY_POWER_CYCLE]) + " power cycles, " +
+                 String(bus.recovered) + " recovered, " + String(bus.abandoned) + " abandoned");
 }
 
 void checkButton() {
@@ -697,37 +1011,12 @@ void checkButton() {
     // If switching to the sensor data screen, pre-load the data
     if (nextScreen == 3) {
       // Read sensor data before switching
-      float temperature = 0, humidity = 0, pressure = 0, altitude = 0;
-      
-      if (sensors.isBME280Available()) {
-        Serial.println("Reading sensor data for screen change");
-        for (int attempt = 0; attempt < 3; attempt++) {
-          sensors.readBME280(temperature, humidity, pressure, altitude);
-          
-          // If we got non-zero readings, break the loop
-          if (temperature != 0 || humidity != 0 || pressure != 0) {
-            break;
-          }
-          delay(100);
-        }
-      } else {
-        // Use zeros when sensor not available
-        temperature = 0.0;
-        humidity = 0.0;
-        pressure = 0.0;
-      }
+      Serial.println("Reading sensor data for screen change");
+      SensorReading reading = readSensors();
       
-      // Draw the screen first, then update with data
-      display.drawSensorDataScreen();
-      display.updateSensorData(temperature, humidity, pressure, 3.7);
-      display.refresh();
-      
-      // Set the screen index without redrawing
-      display.setScreen(nextScreen, false);
-    } else {
-      // For other screens, use normal screen change
-      display.setScreen(nextScreen);
+      display.updateSensorData(reading.temperature, reading.humidity, reading.pressure, batteryVoltage(), batteryPercent());
     }
+    display.setScreen(nextScreen);
     
     // Reset display timeout
     displayTimeout = millis() + DISPLAY_TIMEOUT;
@@ -0,0 +1,181 @@
+#pragma once
+
+// Minimal Arduino core for host builds (pio test -e native). Time runs on
+// the FakeI2CBus virtual clock, so delay() costs nothing and every duration
+// measured with micros() is deterministic. Pin writes can be observed with
+// hostSetPinHook(), e.g. to feed bit-banged SCL clocks to FakeI2CBus, and
+// pin levels supplied with hostSetPinReadHook().
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include "FakeI2CBus.h"
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define HEX 16
+#define DEC 10
+
+#define RTC_DATA_ATTR
+#define IRAM_ATTR
+
+// Time
+
+inline uint32_t micros() { return FakeI2CBus::now(); }
+inline uint32_t millis() { return FakeI2CBus::now() / 1000; }
+inline void delay(uint32_t ms) { FakeI2CBus::advance(ms * 1000); }
+inline void delayMicroseconds(uint32_t us) { FakeI2CBus::advance(us); }
+
+// GPIO
+
+typedef void (*HostPinHook)(uint8_t pin, uint8_t level);
+
+inline HostPinHook& hostPinHook() {
+    static HostPinHook hook = nullptr;
+    return hook;
+}
+
+/**
+ * @brief Observe digitalWrite() calls (null removes the hook)
+ */
+inline void hostSetPinHook(HostPinHook hook) { hostPinHook() = hook; }
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t level) {
+    if (hostPinHook()) hostPinHook()(pin, level);
+}
+
+typedef uint8_t (*HostPinReadHook)(uint8_t pin);
+
+inline HostPinReadHook& hostPinReadHook() {
+    static HostPinReadHook hook = nullptr;
+    return hook;
+}
+
+/**
+ * @brief Supply digitalRead() levels (null reads every pin HIGH, as if pulled up)
+ */
+inline void hostSetPinReadHook(HostPinReadHook hook) { hostPinReadHook() = hook; }
+
+inline int digitalRead(uint8_t pin) {
+    return hostPinReadHook() ? hostPinReadHook()(pin) : HIGH;
+}
+
+// Critical sections (single-threaded on the host)
+
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (void)(mux)
+#define portEXIT_CRITICAL(mux) (void)(mux)
+
+// Sleep
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+    ESP_SLEEP_WAKEUP_EXT0 = 2,
+    ESP_SLEEP_WAKEUP_EXT1 = 3,
+    ESP_SLEEP_WAKEUP_TIMER = 4,
+    ESP_SLEEP_WAKEUP_ULP = 6
+} esp_sleep_wakeup_cause_t;
+
+inline esp_sleep_wakeup_cause_t& hostWakeupCause() {
+    static esp_sleep_wakeup_cause_t cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    return cause;
+}
+
+/**
+ * @brief Simulate a boot (UNDEFINED) or a wake from deep sleep
+ */
+inline void hostSetWakeupCause(esp_sleep_wakeup_cause_t cause) { hostWakeupCause() = cause; }
+
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return hostWakeupCause(); }
+
+// Strings
+
+class String {
+public:
+    String(const char* text = "") : text(text ? text : "") {}
+    String(const std::string& text) : text(text) {}
+    String(int value, unsigned char base = DEC) : text(format(base == HEX ? "%x" : "%d", value)) {}
+    String(unsigned int value, unsigned char base = DEC) : text(format(base == HEX ? "%x" : "%u", value)) {}
+    String(long value, unsigned char base = DEC) : text(format(base == HEX ? "%lx" : "%ld", value)) {}
+    String(unsigned long value, unsigned char base = DEC) : text(format(base == HEX ? "%lx" : "%lu", value)) {}
+    String(double value, unsigned int decimals = 2) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+        text = buffer;
+    }
+
+    const char* c_str() const { return text.c_str(); }
+    unsigned int length() const { return (unsigned int)text.size(); }
+    String substring(unsigned int from, unsigned int to = (unsigned int)-1) const {
+        if (from > text.size()) return String();
+        return String(text.substr(from, to > from ? to - from : 0));
+    }
+    int lastIndexOf(char c) const {
+        size_t index = text.rfind(c);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    String& operator+=(const String& other) { text += other.text; return *this; }
+    friend String operator+(const String& a, const String& b) { return String(a.text + b.text); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.text); }
+
+private:
+    std::string text;
+
+    template <typename T>
+    static std::string format(const char* spec, T value) {
+        char buffer[24];
+        snprintf(buffer, sizeof(buffer), spec, value);
+        return buffer;
+    }
+};
+
+// Flash strings are plain strings on the host
+#define F(text) (text)
+
+// Serial output goes to stdout only when enabled, to keep test output readable
+
+class HostSerial {
+public:
+    bool echo = false;
+
+    void begin(unsigned long baud) { (void)baud; }
+    void print(const String& value) { write(value.c_str()); }
+    void print(const char* value) { write(value); }
+    void print(int value, int base = DEC) { print(String(value, (unsigned char)base)); }
+    void print(unsigned int value, int base = DEC) { print(String(value, (unsigned char)base)); }
+    void print(long value, int base = DEC) { print(String(value, (unsigned char)base)); }
+    void print(unsigned long value, int base = DEC) { print(String(value, (unsigned char)base)); }
+    void print(double value, int decimals = 2) { print(String(value, (unsigned int)decimals)); }
+
+    template <typename T>
+    void println(T value) { print(value); write("\n"); }
+    template <typename T>
+    void println(T value, int format) { print(value, format); write("\n"); }
+    void println() { write("\n"); }
+
+private:
+    void write(const char* text) {
+        if (echo) fputs(text, stdout);
+    }
+};
+
+inline HostSerial& hostSerial() {
+    static HostSerial serial;
+    return serial;
+}
+
+#define Serial hostSerial()
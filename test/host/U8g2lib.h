@@ -0,0 +1,291 @@
+#pragma once
+
+// U8g2 stand-in for host builds (pio test -e native). Drawing goes to a real
+// 128x64 page-layout framebuffer, and u8x8_DrawTile() copies tiles into the
+// GDDRAM of a simulated SSD1306, so tests see exactly what the panel would
+// show after partial refreshes. Commands are not sent anywhere; the shim
+// records the controller state they set (contrast, power save, ...) and
+// counts the command bytes.
+//
+// Text uses the 5x7 glyphs of HostFont.h at the advance width and vertical
+// metrics of the real font (profont12: 6 px, profont10: 5 px), so layout
+// matches the board while glyph shapes do not.
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include "Arduino.h"
+#include "HostFont.h"
+
+#define U8X8_PIN_NONE 255
+
+#define U8X8_MSG_BYTE_INIT 20
+#define U8X8_MSG_BYTE_SET_DC 32
+#define U8X8_MSG_BYTE_START_TRANSFER 24
+#define U8X8_MSG_BYTE_SEND 23
+#define U8X8_MSG_BYTE_END_TRANSFER 25
+
+static const int HOST_PANEL_WIDTH = 128;
+static const int HOST_PANEL_HEIGHT = 64;
+static const int HOST_PANEL_BYTES = HOST_PANEL_WIDTH * HOST_PANEL_HEIGHT / 8;
+
+typedef struct u8x8_struct u8x8_t;
+typedef uint8_t (*u8x8_msg_cb)(u8x8_t* u8x8, uint8_t msg, uint8_t argInt, void* argPtr);
+
+/**
+ * @brief The simulated SSD1306: display RAM plus the state commands set
+ */
+struct u8x8_struct {
+    uint8_t i2c_address;
+    u8x8_msg_cb byteCb;
+    uint8_t ram[HOST_PANEL_BYTES];     // GDDRAM, page layout like the framebuffer
+    uint8_t powerSave;
+    uint8_t contrast;
+    uint8_t flipMode;
+    uint8_t inverted;                   // 0xA7 seen after the last 0xA6
+    uint8_t muxRatio;
+    uint32_t tilesWritten;
+    uint32_t commandBytes;
+};
+
+struct u8g2_struct {
+    u8x8_t u8x8;
+    uint8_t buffer[HOST_PANEL_BYTES];
+};
+typedef struct u8g2_struct u8g2_t;
+
+typedef struct {
+    uint8_t rotation;
+} u8g2_cb_t;
+
+static const u8g2_cb_t u8g2_cb_r0 = { 0 };
+#define U8G2_R0 (&u8g2_cb_r0)
+
+// Fonts: advance, max char height, ascent, descent below the baseline
+static const uint8_t u8g2_font_profont12_tf[] = { 6, 11, 8, 3 };
+static const uint8_t u8g2_font_profont10_tf[] = { 5, 9, 7, 2 };
+
+/**
+ * @brief The panel set up last, for tests that cannot reach the U8G2 object
+ */
+inline u8x8_t*& hostPanel() {
+    static u8x8_t* panel = nullptr;
+    return panel;
+}
+
+inline uint8_t u8x8_byte_arduino_sw_i2c(u8x8_t* u8x8, uint8_t msg, uint8_t argInt, void* argPtr) {
+    (void)u8x8;
+    (void)msg;
+    (void)argInt;
+    (void)argPtr;
+    return 1;
+}
+
+inline uint8_t u8x8_gpio_and_delay_arduino(u8x8_t* u8x8, uint8_t msg, uint8_t argInt, void* argPtr) {
+    (void)u8x8;
+    (void)msg;
+    (void)argInt;
+    (void)argPtr;
+    return 1;
+}
+
+inline void u8g2_Setup_ssd1306_i2c_128x64_noname_f(u8g2_t* u8g2, const u8g2_cb_t* rotation,
+                                                     u8x8_msg_cb byteCb, u8x8_msg_cb gpioCb) {
+    (void)rotation;
+    (void)gpioCb;
+    u8g2->u8x8.i2c_address = 0x78;
+    u8g2->u8x8.byteCb = byteCb;
+    hostPanel() = &u8g2->u8x8;
+}
+
+inline void u8x8_SetPin_HW_I2C(u8x8_t* u8x8, uint8_t reset, uint8_t clock, uint8_t data) {
+    (void)u8x8;
+    (void)reset;
+    (void)clock;
+    (void)data;
+}
+
+inline void u8x8_SetPin_SW_I2C(u8x8_t* u8x8, uint8_t clock, uint8_t data, uint8_t reset) {
+    (void)u8x8;
+    (void)clock;
+    (void)data;
+    (void)reset;
+}
+
+#define u8x8_GetI2CAddress(u8x8) ((u8x8)->i2c_address)
+
+inline uint8_t u8x8_DrawTile(u8x8_t* u8x8, uint8_t x, uint8_t y, uint8_t count, uint8_t* tiles) {
+    if (y >= HOST_PANEL_HEIGHT / 8 || x >= HOST_PANEL_WIDTH / 8) return 0;
+    if (x + count > HOST_PANEL_WIDTH / 8) count = HOST_PANEL_WIDTH / 8 - x;
+    memcpy(u8x8->ram + y * HOST_PANEL_WIDTH + x * 8, tiles, count * 8);
+    u8x8->tilesWritten += count;
+    return 1;
+}
+
+class U8G2 {
+public:
+    U8G2() : font(u8g2_font_profont12_tf), drawColor(1), fontMode(0) {
+        memset(&u8g2, 0, sizeof(u8g2));
+        u8g2.u8x8.muxRatio = 0x3F;
+        u8g2.u8x8.powerSave = 1;
+    }
+
+    u8g2_t* getU8g2() { return &u8g2; }
+    u8x8_t* getU8x8() { return &u8g2.u8x8; }
+
+    bool begin() {
+        // Like u8g2.begin(): init, clear the display, power save off
+        memset(u8g2.buffer, 0, sizeof(u8g2.buffer));
+        memset(u8g2.u8x8.ram, 0, sizeof(u8g2.u8x8.ram));
+        setPowerSave(0);
+        return true;
+    }
+
+    void initDisplay() {
+        // Like u8g2.initDisplay(): the init sequence ends in power save
+        u8g2.u8x8.powerSave = 1;
+        u8g2.u8x8.muxRatio = 0x3F;
+    }
+
+    void setBusClock(uint32_t clock) { (void)clock; }
+    void setDisplayRotation(const u8g2_cb_t* rotation) { (void)rotation; }
+
+    // Commands
+
+    void setPowerSave(uint8_t on) { u8g2.u8x8.powerSave = on; u8g2.u8x8.commandBytes++; }
+    void setContrast(uint8_t value) { u8g2.u8x8.contrast = value; u8g2.u8x8.commandBytes += 2; }
+    void setFlipMode(uint8_t mode) { u8g2.u8x8.flipMode = mode; u8g2.u8x8.commandBytes += 2; }
+
+    /**
+     * @brief Commands ('c') with arguments ('a'); data bytes ('d') are counted only
+     */
+    void sendF(const char* format, ...) {
+        va_list args;
+        va_start(args, format);
+        uint8_t command = 0;
+        for (const char* f = format; *f; f++) {
+            uint8_t value = (uint8_t)va_arg(args, int);
+            u8g2.u8x8.commandBytes++;
+            if (*f == 'c') {
+                command = value;
+                if (value == 0xA6) u8g2.u8x8.inverted = 0;
+                if (value == 0xA7) u8g2.u8x8.inverted = 1;
+            } else if (*f == 'a' && command == 0xA8) {
+                u8g2.u8x8.muxRatio = value;
+            }
+        }
+        va_end(args);
+    }
+
+    // Framebuffer
+
+    uint8_t* getBufferPtr() { return u8g2.buffer; }
+    uint8_t getBufferTileWidth() { return HOST_PANEL_WIDTH / 8; }
+    uint8_t getBufferTileHeight() { return HOST_PANEL_HEIGHT / 8; }
+
+    void clearBuffer() { memset(u8g2.buffer, 0, sizeof(u8g2.buffer)); }
+
+    void sendBuffer() { updateDisplayArea(0, 0, getBufferTileWidth(), getBufferTileHeight()); }
+
+    void updateDisplayArea(uint8_t tx, uint8_t ty, uint8_t tw, uint8_t th) {
+        for (uint8_t row = ty; row < ty + th; row++) {
+            u8x8_DrawTile(getU8x8(), tx, row, tw, u8g2.buffer + row * HOST_PANEL_WIDTH + tx * 8);
+        }
+    }
+
+    // Drawing
+
+    void setDrawColor(uint8_t color) { drawColor = color; }
+    void setColorIndex(uint8_t color) { drawColor = color; }
+    uint8_t getColorIndex() { return drawColor; }
+    void setFontMode(uint8_t mode) { fontMode = mode; }
+
+    void drawPixel(int x, int y) { plot(x, y, drawColor); }
+
+    void drawHLine(int x, int y, int width) {
+        for (int i = 0; i < width; i++) plot(x + i, y, drawColor);
+    }
+
+    void drawVLine(int x, int y, int height) {
+        for (int i = 0; i < height; i++) plot(x, y + i, drawColor);
+    }
+
+    void drawBox(int x, int y, int width, int height) {
+        for (int row = 0; row < height; row++) drawHLine(x, y + row, width);
+    }
+
+    void drawFrame(int x, int y, int width, int height) {
+        if (width <= 0 || height <= 0) return;
+        drawHLine(x, y, width);
+        drawHLine(x, y + height - 1, width);
+        drawVLine(x, y, height);
+        drawVLine(x + width - 1, y, height);
+    }
+
+    void drawLine(int x0, int y0, int x1, int y1) {
+        int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+        int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+        int sx = x0 < x1 ? 1 : -1;
+        int sy = y0 < y1 ? 1 : -1;
+        int error = dx + dy;
+        for (;;) {
+            plot(x0, y0, drawColor);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * error;
+            if (e2 >= dy) { error += dy; x0 += sx; }
+            if (e2 <= dx) { error += dx; y0 += sy; }
+        }
+    }
+
+    // Text, with y the baseline
+
+    void setFont(const uint8_t* font) { this->font = font; }
+
+    int getStrWidth(const char* text) { return text ? (int)strlen(text) * font[0] : 0; }
+    int8_t getAscent() { return (int8_t)font[2]; }
+    int8_t getDescent() { return -(int8_t)font[3]; }
+    uint8_t getMaxCharWidth() { return font[0]; }
+    uint8_t getMaxCharHeight() { return font[1]; }
+
+    int drawStr(int x, int y, const char* text) {
+        if (!text) return 0;
+        int start = x;
+        for (const char* c = text; *c; c++) {
+            drawGlyph(x, y, (uint8_t)*c);
+            x += font[0];
+        }
+        return x - start;
+    }
+
+protected:
+    u8g2_t u8g2;
+    const uint8_t* font;
+    uint8_t drawColor;
+    uint8_t fontMode;
+
+    void plot(int x, int y, uint8_t color) {
+        if (x < 0 || y < 0 || x >= HOST_PANEL_WIDTH || y >= HOST_PANEL_HEIGHT) return;
+        uint8_t& byte = u8g2.buffer[(y / 8) * HOST_PANEL_WIDTH + x];
+        uint8_t bit = (uint8_t)(1 << (y % 8));
+        if (color == 0) byte &= ~bit;
+        else if (color == 1) byte |= bit;
+        else byte ^= bit;
+    }
+
+    void drawGlyph(int x, int y, uint8_t code) {
+        // Solid mode paints the background of the whole character cell
+        if (fontMode == 0) {
+            for (int row = y - font[2]; row < y + font[3]; row++) {
+                for (int col = 0; col < font[0]; col++) plot(x + col, row, drawColor ? 0 : 1);
+            }
+        }
+        if (code < HOST_FONT_FIRST || code > HOST_FONT_LAST) return;
+
+        const uint8_t* glyph = hostFontGlyphs[code - HOST_FONT_FIRST];
+        for (int col = 0; col < HOST_FONT_COLUMNS; col++) {
+            for (int row = 0; row < HOST_FONT_ROWS; row++) {
+                if (glyph[col] & (1 << row)) plot(x + col, y - HOST_FONT_ROWS + row, drawColor);
+            }
+        }
+    }
+};
@@ -0,0 +1,92 @@
+#include <unity.h>
+#include "BatteryMonitor.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_state_of_charge_curve() {
+    TEST_ASSERT_EQUAL_UINT8(0, BatteryMonitor::estimateStateOfCharge(3000));
+    TEST_ASSERT_EQUAL_UINT8(100, BatteryMonitor::estimateStateOfCharge(4250));
+    TEST_ASSERT_EQUAL_UINT8(50, BatteryMonitor::estimateStateOfCharge(3840));
+
+    // Halfway between the 3730 mV (20 %) and 3770 mV (30 %) points
+    TEST_ASSERT_EQUAL_UINT8(25, BatteryMonitor::estimateStateOfCharge(3750));
+
+    // Monotonic over the whole range
+    uint8_t previous = 0;
+    for (uint16_t mv = 3200; mv <= 4300; mv += 5) {
+        uint8_t soc = BatteryMonitor::estimateStateOfCharge(mv);
+        TEST_ASSERT_GREATER_OR_EQUAL(previous, soc);
+        previous = soc;
+    }
+}
+
+void test_moving_average_over_fixed_window() {
+    BatteryMonitor monitor;
+    TEST_ASSERT_EQUAL_UINT16(0, monitor.getMillivolts());
+    TEST_ASSERT_FALSE(monitor.isPresent());
+
+    monitor.addSample(3800);
+    monitor.addSample(3900);
+    TEST_ASSERT_EQUAL_UINT16(3850, monitor.getMillivolts());
+
+    // Once the window is full the oldest samples drop out
+    for (int i = 0; i < BATTERY_AVERAGE_WINDOW; i++) {
+        monitor.addSample(4000);
+    }
+    TEST_ASSERT_EQUAL_UINT16(4000, monitor.getMillivolts());
+    TEST_ASSERT_TRUE(monitor.isPresent());
+    TEST_ASSERT_FALSE(monitor.isLow());
+}
+
+void test_missing_battery_reports_unknown() {
+    BatteryMonitor monitor;
+    monitor.addSample(120); // Floating divider on USB power
+
+    TEST_ASSERT_FALSE(monitor.isPresent());
+    TEST_ASSERT_EQUAL_UINT8(BATTERY_SOC_UNKNOWN, monitor.getStateOfCharge());
+    TEST_ASSERT_FALSE(monitor.isLow());
+    TEST_ASSERT_FALSE(monitor.isCritical());
+}
+
+void test_load_sample_is_kept_only_after_a_transmission() {
+    BatteryMonitor monitor;
+    for (int i = 0; i < BATTERY_AVERAGE_WINDOW; i++) {
+        monitor.addSample(3900);
+    }
+    TEST_ASSERT_FALSE(monitor.endLoadSample());  // The timer never fired
+
+    monitor.addLoadSample(3650);
+    TEST_ASSERT_TRUE(monitor.endLoadSample(true));
+    TEST_ASSERT_EQUAL_UINT16(3650, monitor.getLoadedMillivolts());
+    TEST_ASSERT_EQUAL_UINT16(250, monitor.getSagMillivolts());
+
+    // A failed send keeps the previous value
+    monitor.addLoadSample(3200);
+    TEST_ASSERT_FALSE(monitor.endLoadSample(false));
+    TEST_ASSERT_EQUAL_UINT16(3650, monitor.getLoadedMillivolts());
+    TEST_ASSERT_FALSE(monitor.isCritical());
+
+    monitor.addLoadSample(3200);
+    TEST_ASSERT_TRUE(monitor.endLoadSample(true));
+    TEST_ASSERT_TRUE(monitor.isCritical());
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_state_of_charge_curve);
+    RUN_TEST(test_moving_average_over_fixed_window);
+    RUN_TEST(test_missing_battery_reports_unknown);
+    RUN_TEST(test_load_sample_is_kept_only_after_a_transmission);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <unity.h>
+#include <stdio.h>
+#include "BME280Profile.h"
+#include "FakeBME280.h"
+
+// The profile model is constexpr; these tests compare it with the emulator's
+// independent timing and with the use-case figures in datasheet section 3.5
+
+static const BME280Driver::sensor_sampling SAMPLINGS[] = {
+    BME280Driver::SAMPLING_NONE, BME280Driver::SAMPLING_X1, BME280Driver::SAMPLING_X2,
+    BME280Driver::SAMPLING_X4, BME280Driver::SAMPLING_X8, BME280Driver::SAMPLING_X16
+};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_measurement_time_matches_emulator() {
+    for (auto t : SAMPLINGS) {
+        for (auto p : SAMPLINGS) {
+            for (auto h : SAMPLINGS) {
+                BME280Profile profile = BME280_PROFILE_LOW_POWER;
+                profile.temperature = t;
+                profile.pressure = p;
+                profile.humidity = h;
+                uint8_t ctrlMeas = (uint8_t)((t << 5) | (p << 2) | BME280Driver::MODE_FORCED);
+                TEST_ASSERT_EQUAL_UINT32(FakeBME280::measurementTimeUs(h, ctrlMeas),
+                                         bme280MeasurementMaxUs(profile));
+                TEST_ASSERT_LESS_THAN(bme280MeasurementMaxUs(profile), bme280MeasurementTypUs(profile));
+            }
+        }
+    }
+}
+
+void test_profiles_are_compile_time_constants() {
+    constexpr uint32_t lowPower = bme280MeasurementMaxUs(bme280Profile(SENSOR_PROFILE_LOW_POWER));
+    constexpr uint32_t balanced = bme280MeasurementMaxUs(bme280Profile(SENSOR_PROFILE_BALANCED));
+    constexpr uint32_t precise = bme280MeasurementMaxUs(bme280Profile(SENSOR_PROFILE_HIGH_PRECISION));
+    constexpr float noise = bme280PressureNoisePa(BME280_PROFILE_BALANCED);
+    static_assert(lowPower < balanced && balanced < precise, "profiles get slower");
+    static_assert(noise > bme280PressureNoisePa(BME280_PROFILE_HIGH_PRECISION), "and quieter");
+
+    TEST_ASSERT_EQUAL_UINT32(9300, lowPower);
+    TEST_ASSERT_EQUAL_UINT32(18500, balanced);
+    TEST_ASSERT_EQUAL_UINT32(46100, precise);
+    TEST_ASSERT_EQUAL_UINT32(540000, bme280NormalPeriodUs(BME280_PROFILE_HIGH_PRECISION));
+    TEST_ASSERT_EQUAL_UINT32(500, bme280StandbyUs(BME280Driver::STANDBY_MS_0_5));
+    TEST_ASSERT_EQUAL_UINT32(20000, bme280StandbyUs(BME280Driver::STANDBY_MS_20));
+    TEST_ASSERT_EQUAL_STRING("balanced", sensorProfileName(SENSOR_PROFILE_BALANCED));
+}
+
+void test_noise_and_current_match_datasheet_use_cases() {
+    // Weather monitoring (3.5.1): forced x1/x1/x1 once a minute, 0.16 µA, 3.3 Pa
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.16F, bme280AverageCurrentUa(BME280_PROFILE_LOW_POWER, 60000000));
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 3.3F, bme280PressureNoisePa(BME280_PROFILE_LOW_POWER));
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.07F, bme280HumidityNoise(BME280_PROFILE_LOW_POWER));
+
+    // Indoor navigation (3.5.3): x16 pressure with filter 16, 0.2 Pa
+    TEST_ASSERT_FLOAT_WITHIN(0.05F, 0.2F, bme280PressureNoisePa(BME280_PROFILE_HIGH_PRECISION));
+
+    // Skipped channels cost nothing and have no noise figure
+    BME280Profile humidityOnly = BME280_PROFILE_LOW_POWER;
+    humidityOnly.pressure = BME280Driver::SAMPLING_NONE;
+    TEST_ASSERT_EQUAL_FLOAT(0.0F, bme280PressureNoisePa(humidityOnly));
+    TEST_ASSERT_EQUAL_UINT32(6425, bme280MeasurementMaxUs(humidityOnly));
+
+    // Forced mode at one reading a minute; normal mode runs at its own rate
+    for (uint8_t p = 0; p < SENSOR_PROFILE_COUNT; p++) {
+        BME280Profile profile = bme280Profile((SensorProfile)p);
+        printf("\n  %-14s %5.1f ms  %.2f Pa  %.3f %%RH  %6.2f uA",
+               sensorProfileName((SensorProfile)p), bme280MeasurementMaxUs(profile) / 1000.0F,
+               bme280PressureNoisePa(profile), bme280HumidityNoise(profile),
+               bme280AverageCurrentUa(profile, 60000000));
+        if (profile.mode == BME280Driver::MODE_NORMAL) {
+            printf(" at %.2f/s", 1000000.0F / bme280NormalPeriodUs(profile));
+        } else {
+            printf(" at 1/min");
+        }
+    }
+    printf("\n");
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_measurement_time_matches_emulator);
+    RUN_TEST(test_profiles_are_compile_time_constants);
+    RUN_TEST(test_noise_and_current_match_datasheet_use_cases);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include <unity.h>
+#include "DisplayManager.h"
+#include "Esp32I2CBus.h"
+#include "I2CArbiter.h"
+
+void setUp(void) {
+    // Setup code before each test
+}
+
+void tearDown(void) {
+    // Cleanup code after each test
+}
+
+void test_display_initialization() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    TEST_ASSERT_FALSE(display.isFramePending());
+    
+    // The panel RAM is unknown after power-up, so the first frame is a full one
+    display.refresh();
+    TEST_ASSERT_EQUAL_UINT32(1, display.getStats().fullFrames);
+    TEST_ASSERT_EQUAL_UINT32(0, display.getStats().busErrors);
+}
+
+void test_display_update() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    
+    // update() only sends frames that were requested
+    TEST_ASSERT_FALSE(display.update());
+    
+    // The first request goes out at once and leaves nothing pending
+    display.requestFrame();
+    TEST_ASSERT_EQUAL_UINT32(1, display.getStats().frames);
+    TEST_ASSERT_FALSE(display.update());
+}
+
+void test_display_clear() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    display.clear();
+    TEST_ASSERT_TRUE(true); // Add specific display state verification
+}
+
+void test_value_update_sends_changed_tiles() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    
+    // Drawing a screen from scratch sends every tile once
+    display.setScreen(3);
+    TEST_ASSERT_EQUAL_UINT32(1, display.getStats().fullFrames);
+    
+    // New values only touch the data rows below the title
+    display.resetStats();
+    display.updateSensorData(21.5, 40.0, 1013.2, 3.9, 80);
+    display.refresh();
+    const DisplayStats& stats = display.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.fullFrames);
+    TEST_ASSERT_LESS_THAN(DisplayManager::TILE_COLUMNS * DisplayManager::TILE_ROWS, stats.tiles);
+    
+    // Nothing left to send
+    display.refresh();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.skipped);
+}
+
+void test_requests_within_interval_are_coalesced() {
+    DisplayManager display;
+    display.setFrameInterval(1000);
+    display.begin(-1, -1);
+    
+    // The first request goes out at once, the rest wait for the interval
+    display.setScreen(3);
+    display.resetStats();
+    for (int i = 0; i < 10; i++) {
+        display.updateSensorData(20.0 + i, 40.0, 1013.2, 3.9, 80);
+    }
+    const DisplayStats& stats = display.getStats();
+    TEST_ASSERT_EQUAL_UINT32(10, stats.requests);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.frames);
+    TEST_ASSERT_TRUE(display.isFramePending());
+    TEST_ASSERT_FALSE(display.update());
+    
+    // One frame carries all of them
+    delay(1000);
+    TEST_ASSERT_TRUE(display.update());
+    TEST_ASSERT_EQUAL_UINT32(1, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(9, stats.coalesced);  // setScreen() went out on its own
+    TEST_ASSERT_FALSE(display.isFramePending());
+    TEST_ASSERT_FALSE(display.update());
+}
+
+void test_only_changed_widgets_are_drawn() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    display.updateSensorData(21.5, 40.0, 1013.2, 3.9, 80);
+    display.setScreen(3);
+    display.refresh();
+    
+    // Values that print the same draw nothing and request no frame
+    display.resetStats();
+    display.updateSensorData(21.52, 40.0, 1013.2, 3.9, 80);
+    display.refresh();
+    const DisplayStats& stats = display.getStats();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.widgets);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.requests);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.skipped);
+    
+    // One new value redraws that value, and the humidity value whose box
+    // (profont10, rows 10 px apart) the erase touched
+    display.updateSensorData(22.0, 40.0, 1013.2, 3.9, 80);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.widgets);
+    
+    // Values set while another screen is shown appear when switching back
+    display.setScreen(2);
+    display.updateSensorData(23.0, 41.0, 1013.2, 3.9, 80);
+    display.resetStats();
+    display.setScreen(3);
+    TEST_ASSERT_EQUAL_UINT32(display.getScreenModel(3).size(), stats.widgets);
+    TEST_ASSERT_EQUAL_STRING("23.0 C", display.getScreenModel(3).widget(3).text);
+}
+
+void test_identical_pages_are_not_sent() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    display.updateSensorData(21.5, 40.0, 1013.2, 3.9, 80);
+    display.setScreen(3);
+    display.refresh();
+    
+    // Clearing and drawing the same screen again changes no pixel
+    display.resetStats();
+    display.setScreen(3, true);
+    display.refresh();
+    const DisplayStats& stats = display.getStats();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(DisplayManager::TILE_ROWS, stats.pagesSkipped);
+    
+    // After invalidate() every page goes out again
+    display.invalidate();
+    display.refresh();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fullFrames);
+}
+
+void test_static_frame_enters_power_save() {
+    DisplayManager display;
+    display.setFrameInterval(0);
+    display.begin(-1, -1);
+    display.setStaticPowerSave(200);
+    display.setScreen(3);
+    
+    delay(250);
+    display.update();
+    TEST_ASSERT_TRUE(display.isStaticPowerSave());
+    TEST_ASSERT_EQUAL_UINT32(1, display.getStats().powerSaves);
+    
+    // wakeup() alone keeps a static panel off, a changed value turns it on
+    display.wakeup();
+    TEST_ASSERT_TRUE(display.isStaticPowerSave());
+    display.updateSensorData(22.0, 40.0, 1013.2, 3.9, 80);
+    TEST_ASSERT_FALSE(display.isStaticPowerSave());
+}
+
+void test_render_task_keeps_refresh_short() {
+    DisplayManager direct;
+    direct.begin(-1, -1);
+    direct.setScreen(3);
+    direct.invalidate();
+    uint32_t start = micros();
+    direct.refresh();
+    uint32_t inlineUs = micros() - start;
+    
+    DisplayManager tasked;
+    tasked.begin(-1, -1);
+    TEST_ASSERT_TRUE(tasked.startRenderTask());
+    tasked.setScreen(3);
+    tasked.invalidate();
+    start = micros();
+    tasked.refresh();
+    uint32_t swapUs = micros() - start;
+    
+    // The caller only copied pages; the frame reaches the panel via the task
+    TEST_ASSERT_TRUE(tasked.flush());
+    const DisplayStats& stats = tasked.getStats();
+    TEST_ASSERT_EQUAL_UINT32(1, stats.swaps);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.fullFrames);
+    
+    printf("\n  full frame refresh: inline %u us, swap %u us\n", (unsigned)inlineUs, (unsigned)swapUs);
+    TEST_ASSERT_TRUE(swapUs * 10 < inlineUs);
+    
+    tasked.stopRenderTask();
+    TEST_ASSERT_FALSE(tasked.hasRenderTask());
+}
+
+void test_layout_cache_render_time() {
+    DisplayManager display;
+    display.begin(-1, -1);
+    display.updateSensorData(21.5, 40.0, 1013.2, 3.9, 80);
+    display.setScreen(3);
+    
+    // Alternating values: every draw measures with U8g2 or hits the cache
+    const int count = 200;
+    uint32_t start = micros();
+    for (int i = 0; i < count; i++) {
+        display.clearLayoutCache();
+        display.updateSensorData(21.5 + (i % 2), 40.0 + (i % 2), 1013.2, 3.9, 80);
+        display.drawCenteredString(12, "Sensor Data");
+    }
+    float coldUs = (float)(micros() - start) / count;
+    
+    start = micros();
+    for (int i = 0; i < count; i++) {
+        display.updateSensorData(21.5 + (i % 2), 40.0 + (i % 2), 1013.2, 3.9, 80);
+        display.drawCenteredString(12, "Sensor Data");
+    }
+    float warmUs = (float)(micros() - start) / count;
+    
+    const TextLayoutCache& cache = display.getLayoutCache();
+    printf("\n  value update + title: %.1f us measured, %.1f us cached (%u hits, %u misses)\n",
+           coldUs, warmUs, (unsigned)cache.getHits(), (unsigned)cache.getMisses());
+    TEST_ASSERT_TRUE(warmUs < coldUs);
+}
+
+// Full frames of the sensor screen, as after a wakeup
+static float renderFullFrames(DisplayManager& display, int frames) {
+    display.setScreen(3);
+    display.updateSensorData(21.5, 40.0, 1013.2, 3.9, 80);
+    display.resetStats();
+    for (int i = 0; i < frames; i++) {
+        display.invalidate();
+        display.refresh();
+    }
+    return display.getStats().msPerFrame();
+}
+
+void test_render_time_software_vs_hardware() {
+    DisplayManager software;
+    software.begin(-1, -1);
+    float softwareMs = renderFullFrames(software, 20);
+    
+    Esp32I2CBus controller(I2C_NUM_1);
+    I2CArbiter shared(controller);
+    DisplayManager hardware;
+    hardware.useHardwareI2C(&shared);
+    hardware.begin(-1, -1);
+    float hardwareMs = renderFullFrames(hardware, 20);
+    
+    printf("\n  full frame: software I2C %.1f ms, hardware I2C %.1f ms (%u transfers, max wait %u us)\n",
+           softwareMs, hardwareMs, (unsigned)shared.getStats().transfers,
+           (unsigned)shared.getStats().maxWaitUs);
+    
+    TEST_ASSERT_EQUAL_UINT32(0, hardware.getStats().busErrors);
+    TEST_ASSERT_TRUE(hardwareMs < softwareMs);
+    
+    hardware.useHardwareI2C(nullptr);
+    shared.end();
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_display_initialization);
+    RUN_TEST(test_display_update);
+    RUN_TEST(test_display_clear);
+    RUN_TEST(test_value_update_sends_changed_tiles);
+    RUN_TEST(test_requests_within_interval_are_coalesced);
+    RUN_TEST(test_only_changed_widgets_are_drawn);
+    RUN_TEST(test_identical_pages_are_not_sent);
+    RUN_TEST(test_static_frame_enters_power_save);
+    RUN_TEST(test_render_task_keeps_refresh_short);
+    RUN_TEST(test_layout_cache_render_time);
+    RUN_TEST(test_render_time_software_vs_hardware);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+} 
\ No newline at end of file
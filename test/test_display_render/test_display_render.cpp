@@ -0,0 +1,300 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include "DisplayManager.h"
+
+// Golden images, relative to the project directory pio test runs in.
+// Run with UPDATE_GOLDEN=1 to rewrite them after an intended layout change.
+#ifndef DISPLAY_GOLDEN_DIR
+#define DISPLAY_GOLDEN_DIR "test/golden"
+#endif
+
+static double secondsSince(const struct timespec& start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Plain PBM: a '1' per lit pixel, one line per pixel row
+static std::string toPbm(const uint8_t* ram) {
+    std::string image = "P1\n128 64\n";
+    for (int y = 0; y < HOST_PANEL_HEIGHT; y++) {
+        for (int x = 0; x < HOST_PANEL_WIDTH; x++) {
+            image += (ram[(y / 8) * HOST_PANEL_WIDTH + x] & (1 << (y % 8))) ? '1' : '0';
+        }
+        image += '\n';
+    }
+    return image;
+}
+
+static bool readFile(const char* path, std::string& content) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    char buffer[512];
+    size_t length;
+    content.clear();
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        content.append(buffer, length);
+    }
+    fclose(file);
+    return true;
+}
+
+static void writeFile(const char* path, const std::string& content) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return;
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+}
+
+/**
+ * @brief Compare what the panel shows with DISPLAY_GOLDEN_DIR/<name>.pbm
+ *
+ * A mismatch is written next to it as <name>.actual.pbm.
+ */
+static void assertPanelMatches(const char* name) {
+    static char message[256];
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s.pbm", DISPLAY_GOLDEN_DIR, name);
+    std::string image = toPbm(hostPanel()->ram);
+
+    if (getenv("UPDATE_GOLDEN")) {
+        writeFile(path, image);
+        return;
+    }
+
+    std::string golden;
+    if (!readFile(path, golden)) {
+        snprintf(message, sizeof(message), "%s missing, run with UPDATE_GOLDEN=1", path);
+        TEST_FAIL_MESSAGE(message);
+    }
+    if (golden != image) {
+        snprintf(path, sizeof(path), "%s/%s.actual.pbm", DISPLAY_GOLDEN_DIR, name);
+        writeFile(path, image);
+        snprintf(message, sizeof(message), "panel differs from the golden image, see %s", path);
+        TEST_FAIL_MESSAGE(message);
+    }
+}
+
+static DisplayManager* display;
+
+void setUp(void) {
+    display = new DisplayManager();
+    display->setFrameInterval(0);
+    display->begin();
+}
+
+void tearDown(void) {
+    delete display;
+}
+
+static void showSensorData(DisplayManager& target, float temperature) {
+    target.updateSensorData(temperature, 45.2, 1013.2, 3.92, 80);
+    target.drawSensorDataScreen();
+    target.refresh();
+}
+
+void test_startup_screen() {
+    display->drawStartupScreen();
+    display->updateStartupProgress(40, "Initializing LoRa...");
+    assertPanelMatches("startup");
+}
+
+void test_lorawan_status_screen() {
+    display->updateLoRaWANStatus(true, -97, 12, 3);
+    display->drawLoRaWANStatusScreen();
+    display->refresh();
+    assertPanelMatches("lorawan_status");
+}
+
+void test_sensor_data_screen() {
+    showSensorData(*display, 21.5);
+    assertPanelMatches("sensor_data");
+}
+
+void test_lora_error_screen() {
+    showSensorData(*display, 21.5);
+    display->showLoRaError(-1106);
+    assertPanelMatches("lora_error");
+}
+
+void test_log_screen() {
+    display->log("INFO: Display ready");
+    display->log("INFO: BME280 found at 0x76");
+    display->logf("WARN: RSSI %d dBm", -118);
+    display->log("INFO: Joined network");
+    display->drawLogScreen();
+    display->refresh();
+    assertPanelMatches("log");
+}
+
+void test_value_update_matches_fresh_render() {
+    // The same values drawn onto an empty screen
+    showSensorData(*display, 22.75);
+    uint8_t fresh[HOST_PANEL_BYTES];
+    memcpy(fresh, hostPanel()->ram, sizeof(fresh));
+
+    // Only the temperature is redrawn, over a wider old value, after a
+    // detour through another screen
+    DisplayManager updated;
+    updated.setFrameInterval(0);
+    updated.begin();
+    showSensorData(updated, -10.25);
+    updated.setScreen(2);
+    updated.updateSensorData(22.75, 45.2, 1013.2, 3.92, 80);
+    updated.setScreen(3);
+    updated.updateSensorData(22.75, 45.2, 1013.2, 3.92, 80);
+    updated.refresh();
+
+    TEST_ASSERT_EQUAL_MEMORY(fresh, hostPanel()->ram, sizeof(fresh));
+}
+
+void test_static_labels_are_measured_once() {
+    showSensorData(*display, 21.5);
+    uint32_t misses = display->getLayoutCache().getMisses();
+    TEST_ASSERT_TRUE(misses > 0);
+
+    // Switching away and back draws every label again without measuring
+    display->setScreen(2);
+    display->setScreen(3);
+    display->setScreen(3, true);
+    TEST_ASSERT_EQUAL_UINT32(misses + 5, display->getLayoutCache().getMisses());  // Title and labels of screen 2
+
+    // A value that comes back is a cache hit
+    display->updateSensorData(22.0, 45.2, 1013.2, 3.92, 80);
+    misses = display->getLayoutCache().getMisses();
+    display->updateSensorData(21.5, 45.2, 1013.2, 3.92, 80);
+    TEST_ASSERT_EQUAL_UINT32(misses, display->getLayoutCache().getMisses());
+}
+
+void test_controller_settings_are_sent_once() {
+    u8x8_t* panel = hostPanel();
+    TEST_ASSERT_EQUAL_UINT8(255, panel->contrast);
+    TEST_ASSERT_EQUAL_UINT8(0x3F, panel->muxRatio);
+    
+    // What main.cpp does every few seconds: only pixel data goes out
+    uint32_t commandBytes = panel->commandBytes;
+    for (int i = 0; i < 3; i++) {
+        display->wakeup();
+        display->setNormalMode();
+        showSensorData(*display, 21.5 + i);
+    }
+    display->setContrast(255);
+    TEST_ASSERT_EQUAL_UINT32(commandBytes, panel->commandBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, display->getStats().commands);
+    TEST_ASSERT_EQUAL_UINT32(13, display->getStats().commandsSkipped);
+    
+    // A different contrast is sent, and setNormalMode() restores only that
+    display->setContrast(40);
+    TEST_ASSERT_EQUAL_UINT8(40, panel->contrast);
+    display->setNormalMode();
+    TEST_ASSERT_EQUAL_UINT8(255, panel->contrast);
+    TEST_ASSERT_EQUAL_UINT32(commandBytes + 4, panel->commandBytes);
+    
+    // A panel that was reset behind our back gets everything again
+    panel->contrast = 0;
+    panel->muxRatio = 0;
+    panel->inverted = 1;
+    display->resyncController();
+    display->setNormalMode();
+    TEST_ASSERT_EQUAL_UINT8(255, panel->contrast);
+    TEST_ASSERT_EQUAL_UINT8(0x3F, panel->muxRatio);
+    TEST_ASSERT_EQUAL_UINT8(0, panel->inverted);
+    
+    // Optionally on every wakeup
+    commandBytes = panel->commandBytes;
+    display->setResyncOnWake(true);
+    display->sleep();
+    display->wakeup();
+    display->setNormalMode();
+    TEST_ASSERT_EQUAL_UINT32(commandBytes + 2 + 7, panel->commandBytes);  // Power save twice, settings
+}
+
+void test_panel_restored_after_power_loss() {
+    showSensorData(*display, 21.5);
+    
+    // VEXT cycled by the sensor recovery: blank RAM, reset settings, panel off
+    u8x8_t* panel = hostPanel();
+    memset(panel->ram, 0, sizeof(panel->ram));
+    panel->contrast = 0x7F;
+    panel->powerSave = 1;
+    
+    display->restartController();
+    TEST_ASSERT_EQUAL_UINT8(0, panel->powerSave);
+    TEST_ASSERT_EQUAL_UINT8(255, panel->contrast);
+    TEST_ASSERT_EQUAL_UINT8(0x3F, panel->muxRatio);
+    assertPanelMatches("sensor_data");
+}
+
+// Full draws of each screen (setScreen() with redraw) plus one value change
+static void benchmarkScreen(const char* name, uint8_t screen, int count) {
+    display->setScreen(screen);
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        display->setScreen(screen, true);
+    }
+    double drawUs = secondsSince(start) * 1e6 / count;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        display->updateSensorData(20.0 + (i % 2), 45.2, 1013.2, 3.92, 80);
+        display->updateLoRaWANStatus(true, -97 - (i % 2), 12, 3);
+    }
+    double updateUs = secondsSince(start) * 1e6 / count;
+
+    printf("\n  %-15s full draw %6.1f us, value update %5.1f us", name, drawUs, updateUs);
+}
+
+void test_render_time_per_screen() {
+    const int count = 2000;
+    display->updateSensorData(21.5, 45.2, 1013.2, 3.92, 80);
+    display->updateLoRaWANStatus(true, -97, 12, 3);
+    display->log("INFO: Display ready");
+
+    benchmarkScreen("startup", 1, count);
+    benchmarkScreen("lorawan status", 2, count);
+    benchmarkScreen("sensor data", 3, count);
+    benchmarkScreen("log", 4, count);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        display->showLoRaError(i % 2 ? -1106 : -1118);
+    }
+    printf("\n  %-15s full draw %6.1f us\n", "lora error", secondsSince(start) * 1e6 / count);
+    printf("  layout cache: %u hits, %u misses\n", (unsigned)display->getLayoutCache().getHits(),
+           (unsigned)display->getLayoutCache().getMisses());
+
+    const DisplayStats& stats = display->getStats();
+    TEST_ASSERT_TRUE(stats.widgets > 0);
+    TEST_ASSERT_TRUE(stats.pagesSkipped > 0);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_startup_screen);
+    RUN_TEST(test_lorawan_status_screen);
+    RUN_TEST(test_sensor_data_screen);
+    RUN_TEST(test_lora_error_screen);
+    RUN_TEST(test_log_screen);
+    RUN_TEST(test_value_update_matches_fresh_render);
+    RUN_TEST(test_static_labels_are_measured_once);
+    RUN_TEST(test_controller_settings_are_sent_once);
+    RUN_TEST(test_panel_restored_after_power_loss);
+    RUN_TEST(test_render_time_per_screen);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <unity.h>
+#include "I2CArbiter.h"
+#include "FakeI2CBus.h"
+
+static FakeI2CBus bus;
+static FakeRegisterDevice oled;
+static FakeRegisterDevice sensor;
+
+void setUp(void) {
+    bus = FakeI2CBus();
+    bus.attach(0x3C, &oled);
+    bus.attach(0x76, &sensor);
+}
+
+void tearDown(void) {
+}
+
+void test_first_begin_configures_last_end_releases() {
+    I2CArbiter arbiter(bus);
+
+    TEST_ASSERT_TRUE(arbiter.begin(17, 18, 400000));
+    TEST_ASSERT_EQUAL_UINT32(400000, arbiter.getFrequency());
+
+    // A second client joins without reconfiguring the controller
+    TEST_ASSERT_TRUE(arbiter.begin(41, 42, 100000));
+    TEST_ASSERT_EQUAL_UINT32(400000, arbiter.getFrequency());
+    TEST_ASSERT_EQUAL_UINT8(2, arbiter.getUsers());
+
+    // One client leaving keeps the bus up for the other
+    arbiter.end();
+    uint8_t command[] = { 0x00, 0xAF };
+    TEST_ASSERT_EQUAL(I2C_OK, arbiter.transfer(0x3C, command, sizeof(command), nullptr, 0, 50));
+
+    arbiter.end();
+    TEST_ASSERT_EQUAL_UINT8(0, arbiter.getUsers());
+    TEST_ASSERT_EQUAL(I2C_ERR_OTHER, arbiter.transfer(0x3C, command, sizeof(command), nullptr, 0, 50));
+
+    // Unbalanced end() calls are ignored
+    arbiter.end();
+    TEST_ASSERT_EQUAL_UINT8(0, arbiter.getUsers());
+}
+
+void test_transfers_pass_through() {
+    I2CArbiter arbiter(bus);
+    arbiter.begin(17, 18, 400000);
+
+    uint8_t write[] = { 0xD0 };
+    uint8_t id = 0;
+    sensor.regs[0xD0] = 0x60;
+    TEST_ASSERT_EQUAL(I2C_OK, arbiter.transfer(0x76, write, 1, &id, 1, 50));
+    TEST_ASSERT_EQUAL_HEX8(0x60, id);
+
+    // Errors of the wrapped bus reach the client unchanged
+    TEST_ASSERT_EQUAL(I2C_ERR_NACK_ADDR, arbiter.transfer(0x50, nullptr, 0, nullptr, 0, 50));
+    bus.injectFailure(I2C_ERR_TIMEOUT);
+    TEST_ASSERT_EQUAL(I2C_ERR_TIMEOUT, arbiter.transfer(0x76, write, 1, &id, 1, 50));
+
+    const I2CArbiterStats& stats = arbiter.getStats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.transfers);
+    TEST_ASSERT_EQUAL_UINT32(3, bus.getTransferCount());
+    TEST_ASSERT_EQUAL_UINT32(0, stats.contended);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.timeouts);
+}
+
+void test_acquire_nests_over_a_frame() {
+    I2CArbiter arbiter(bus);
+    arbiter.begin(17, 18, 400000);
+
+    // A display frame holds the bus over several transfers
+    TEST_ASSERT_TRUE(arbiter.acquire());
+    TEST_ASSERT_TRUE(arbiter.acquire());
+    uint8_t page[17] = { 0x40 };
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL(I2C_OK, arbiter.transfer(0x3C, page, sizeof(page), nullptr, 0, 50));
+    }
+    arbiter.release();
+    arbiter.release();
+
+    TEST_ASSERT_EQUAL_UINT32(8, arbiter.getStats().transfers);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_begin_configures_last_end_releases);
+    RUN_TEST(test_transfers_pass_through);
+    RUN_TEST(test_acquire_nests_over_a_frame);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <unity.h>
+#include "I2CEngine.h"
+#include "BME280Driver.h"
+#include "FakeI2CBus.h"
+
+// Calibration and ADC example from the Bosch BMP280 datasheet (section 8.2),
+// which shares the BME280 temperature/pressure compensation
+static const uint8_t EXAMPLE_CALIB_TP[BME280_CALIB_TP_LEN] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,              // T1=27504, T2=26435, T3=-1000
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,  // P1=36477, P2=-10685, P3=3024, P4=2855
+    0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6,  // P5=140, P6=-7, P7=15500, P8=-14600
+    0x70, 0x17, 0x00, 0x4B                           // P9=6000, unused, H1=75
+};
+static const uint8_t EXAMPLE_CALIB_H[BME280_CALIB_H_LEN] = {
+    0x6A, 0x01, 0x00, 0x13, 0x2A, 0x03, 0x1E         // H2=362, H3=0, H4=314, H5=50, H6=30
+};
+
+struct CallbackLog {
+    uint8_t calls;
+    uint8_t order[8];
+    I2CStatus status[8];
+};
+
+static FakeI2CBus bus;
+static FakeRegisterDevice deviceA;
+static FakeRegisterDevice deviceB;
+
+static void recordCallback(const I2CTransaction& txn, void* context) {
+    CallbackLog* log = static_cast<CallbackLog*>(context);
+    log->order[log->calls] = txn.address;
+    log->status[log->calls] = txn.status;
+    log->calls++;
+}
+
+void setUp(void) {
+    I2CEngine::setClock(FakeI2CBus::now);
+    bus = FakeI2CBus();
+    bus.begin(0, 0, 100000);
+    deviceA = FakeRegisterDevice();
+    deviceB = FakeRegisterDevice();
+    bus.attach(0x76, &deviceA);
+    bus.attach(0x3C, &deviceB);
+}
+
+void tearDown(void) {
+}
+
+void test_queued_read_completes_on_poll() {
+    I2CEngine engine(&bus);
+    deviceA.regs[0xD0] = 0x60;
+
+    uint8_t value = 0;
+    CallbackLog log = {};
+    TEST_ASSERT_TRUE(engine.queueRead(0x76, 0xD0, &value, 1, recordCallback, &log));
+
+    // Nothing happens until the queue is serviced
+    TEST_ASSERT_EQUAL(1, engine.pending());
+    TEST_ASSERT_EQUAL(0, log.calls);
+
+    TEST_ASSERT_EQUAL(1, engine.poll());
+    TEST_ASSERT_EQUAL(1, log.calls);
+    TEST_ASSERT_EQUAL(I2C_OK, log.status[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x60, value);
+}
+
+void test_batch_reads_several_devices_in_order() {
+    I2CEngine engine(&bus);
+    deviceA.regs[0xF7] = 0x11;
+    deviceB.regs[0x00] = 0x22;
+
+    uint8_t a[8] = {0};
+    uint8_t b[2] = {0};
+    CallbackLog log = {};
+
+    I2CTransaction batch[2] = {};
+    batch[0].address = 0x76;
+    batch[0].tx[0] = 0xF7;
+    batch[0].txLen = 1;
+    batch[0].rx = a;
+    batch[0].rxLen = sizeof(a);
+    batch[0].callback = recordCallback;
+    batch[0].context = &log;
+    batch[1] = batch[0];
+    batch[1].address = 0x3C;
+    batch[1].tx[0] = 0x00;
+    batch[1].rx = b;
+    batch[1].rxLen = sizeof(b);
+
+    TEST_ASSERT_TRUE(engine.submitBatch(batch, 2));
+    TEST_ASSERT_EQUAL(2, engine.poll());
+
+    TEST_ASSERT_EQUAL(2, log.calls);
+    TEST_ASSERT_EQUAL_HEX8(0x76, log.order[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x3C, log.order[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x11, a[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x22, b[0]);
+}
+
+void test_batch_is_all_or_nothing() {
+    I2CEngine engine(&bus);
+    uint8_t value;
+    for (int i = 0; i < I2CEngine::QUEUE_DEPTH - 1; i++) {
+        TEST_ASSERT_TRUE(engine.queueRead(0x76, 0x00, &value, 1));
+    }
+
+    I2CTransaction batch[2] = {};
+    batch[0].address = 0x76;
+    batch[1].address = 0x3C;
+    TEST_ASSERT_FALSE(engine.submitBatch(batch, 2));
+    TEST_ASSERT_EQUAL(I2CEngine::QUEUE_DEPTH - 1, engine.pending());
+    TEST_ASSERT_EQUAL(2, engine.getStats().rejected);
+}
+
+void test_cancel_removes_only_that_transaction() {
+    I2CEngine engine(&bus);
+    CallbackLog log = {};
+    CallbackLog cancelled = {};
+    uint8_t value[3];
+
+    TEST_ASSERT_TRUE(engine.queueRead(0x76, 0x00, &value[0], 1, recordCallback, &log));
+    TEST_ASSERT_TRUE(engine.queueRead(0x3C, 0x00, &value[1], 1, recordCallback, &cancelled));
+    TEST_ASSERT_TRUE(engine.queueRead(0x3C, 0x00, &value[2], 1, recordCallback, &log));
+
+    TEST_ASSERT_TRUE(engine.cancel(&cancelled));
+    TEST_ASSERT_FALSE(engine.cancel(&cancelled));
+    TEST_ASSERT_EQUAL(2, engine.pending());
+
+    TEST_ASSERT_EQUAL(2, engine.poll());
+    TEST_ASSERT_EQUAL(0, cancelled.calls);
+    TEST_ASSERT_EQUAL(2, log.calls);
+    TEST_ASSERT_EQUAL_HEX8(0x76, log.order[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x3C, log.order[1]);
+
+    // Nothing left to cancel once it ran
+    TEST_ASSERT_FALSE(engine.cancel(&log));
+}
+
+void test_errors_are_reported_and_counted() {
+    I2CEngine engine(&bus);
+    uint8_t value;
+
+    // Missing device
+    TEST_ASSERT_EQUAL(I2C_ERR_NACK_ADDR, engine.readRegisters(0x50, 0x00, &value, 1));
+
+    // Injected timeout on a present device
+    bus.injectFailure(I2C_ERR_TIMEOUT);
+    TEST_ASSERT_EQUAL(I2C_ERR_TIMEOUT, engine.readRegisters(0x76, 0x00, &value, 1));
+
+    TEST_ASSERT_EQUAL(I2C_OK, engine.readRegisters(0x76, 0x00, &value, 1));
+    TEST_ASSERT_EQUAL(2, engine.getStats().failed);
+    TEST_ASSERT_EQUAL(1, engine.getStats().completed);
+}
+
+void test_occupancy_and_latency_are_measured() {
+    I2CEngine engine(&bus);
+    engine.resetStats();
+    uint8_t burst[8];
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(engine.queueRead(0x76, 0xF7, burst, sizeof(burst)));
+    }
+    uint32_t start = FakeI2CBus::now();
+    engine.poll();
+    uint32_t elapsed = FakeI2CBus::now() - start;
+
+    I2CEngineStats stats = engine.getStats();
+    TEST_ASSERT_EQUAL(3, stats.completed);
+    TEST_ASSERT_EQUAL(3 * (1 + 8), stats.bytes);
+
+    // The fake bus charges 9 bit times per byte at 100kHz: ~1 ms per burst
+    TEST_ASSERT_EQUAL_UINT32(elapsed, (uint32_t)stats.busyUs);
+    TEST_ASSERT_UINT32_WITHIN(100, 1010, (uint32_t)(stats.busyUs / 3));
+
+    // The last transaction waited for the first two
+    TEST_ASSERT_EQUAL_UINT32(elapsed, stats.maxLatencyUs);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, stats.occupancy(FakeI2CBus::now()));
+
+    // Idle time lowers occupancy
+    FakeI2CBus::advance(elapsed);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.5f, stats.occupancy(FakeI2CBus::now()));
+}
+
+void test_bme280_compensation_matches_datasheet() {
+    I2CEngine engine(&bus);
+    BME280Driver driver(engine);
+    BME280Calibration calib;
+    BME280Driver::parseCalibration(EXAMPLE_CALIB_TP, EXAMPLE_CALIB_H, calib);
+
+    TEST_ASSERT_EQUAL(27504, calib.dig_T1);
+    TEST_ASSERT_EQUAL(-1000, calib.dig_T3);
+    TEST_ASSERT_EQUAL(-7, calib.dig_P6);
+    TEST_ASSERT_EQUAL(314, calib.dig_H4);
+    TEST_ASSERT_EQUAL(50, calib.dig_H5);
+
+    // Load the calibration through a fake sensor
+    deviceA.regs[BME280_REG_CHIP_ID] = BME280_CHIP_ID;
+    memcpy(&deviceA.regs[BME280_REG_CALIB_TP], EXAMPLE_CALIB_TP, sizeof(EXAMPLE_CALIB_TP));
+    memcpy(&deviceA.regs[BME280_REG_CALIB_H], EXAMPLE_CALIB_H, sizeof(EXAMPLE_CALIB_H));
+    TEST_ASSERT_TRUE(driver.begin(0x76));
+
+    BME280RawData raw = { 519888, 415148, 30000 };
+    BME280Sample sample;
+    TEST_ASSERT_TRUE(driver.compensate(raw, sample));
+
+    TEST_ASSERT_EQUAL(2508, sample.temperature);                // 25.08 °C
+    TEST_ASSERT_UINT32_WITHIN(256, 100653 * 256, sample.pressure); // 100653 Pa
+    TEST_ASSERT_LESS_OR_EQUAL(100u * 1024u, sample.humidity);
+
+    // Skipped humidity channel is rejected
+    raw.adcH = 0x8000;
+    TEST_ASSERT_FALSE(driver.compensate(raw, sample));
+}
+
+void test_bme280_burst_decoding() {
+    const uint8_t burst[BME280_BURST_LEN] = { 0x65, 0x5A, 0xC0, 0x7E, 0xED, 0x00, 0x75, 0x30 };
+    BME280RawData raw = BME280Driver::decodeRaw(burst);
+    TEST_ASSERT_EQUAL(415148, raw.adcP);
+    TEST_ASSERT_EQUAL(519888, raw.adcT);
+    TEST_ASSERT_EQUAL(30000, raw.adcH);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_queued_read_completes_on_poll);
+    RUN_TEST(test_batch_reads_several_devices_in_order);
+    RUN_TEST(test_batch_is_all_or_nothing);
+    RUN_TEST(test_cancel_removes_only_that_transaction);
+    RUN_TEST(test_errors_are_reported_and_counted);
+    RUN_TEST(test_occupancy_and_latency_are_measured);
+    RUN_TEST(test_bme280_compensation_matches_datasheet);
+    RUN_TEST(test_bme280_burst_decoding);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <unity.h>
+#include "I2CEngine.h"
+#include "I2CHealth.h"
+#include "FakeI2CBus.h"
+
+static I2CHealthMonitor monitor;
+
+void setUp(void) {
+    monitor.reset();
+}
+
+void tearDown(void) {
+}
+
+void test_counts_by_status() {
+    TEST_ASSERT_TRUE(monitor.watch(0x76));
+    monitor.record(0x76, I2C_OK);
+    monitor.record(0x76, I2C_ERR_NACK_ADDR);
+    monitor.record(0x76, I2C_ERR_NACK_DATA);
+    monitor.record(0x76, I2C_ERR_TIMEOUT);
+    monitor.record(0x76, I2C_ERR_OTHER);
+    monitor.record(0x76, I2C_OK);
+    monitor.record(0x76, I2C_ERR_NACK_ADDR);
+    monitor.recordStuck(0x76);
+
+    const I2CDeviceHealth* device = monitor.getDevice(0x76);
+    TEST_ASSERT_NOT_NULL(device);
+    TEST_ASSERT_EQUAL_UINT32(7, device->transfers);
+    TEST_ASSERT_EQUAL_UINT32(3, device->nacks);
+    TEST_ASSERT_EQUAL_UINT32(1, device->timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, device->errors);
+    TEST_ASSERT_EQUAL_UINT32(1, device->stuckDetections);
+    TEST_ASSERT_EQUAL_UINT16(1, device->consecutiveFailures);
+    TEST_ASSERT_EQUAL_UINT16(4, device->maxConsecutiveFailures);
+
+    // Scan probes of unwatched addresses leave no trace
+    monitor.record(0x3C, I2C_ERR_NACK_ADDR);
+    TEST_ASSERT_NULL(monitor.getDevice(0x3C));
+
+    // The table is fixed-size
+    for (uint8_t address = 0x40; address < 0x40 + I2C_HEALTH_MAX_DEVICES - 1; address++) {
+        TEST_ASSERT_TRUE(monitor.watch(address));
+    }
+    TEST_ASSERT_FALSE(monitor.watch(0x50));
+    TEST_ASSERT_TRUE(monitor.watch(0x76));
+}
+
+void test_nacks_escalate_through_every_step() {
+    monitor.watch(0x76);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_NONE, monitor.nextStep(0x76));  // Nothing failed yet
+
+    const I2CRecoveryStep expected[] = {
+        I2C_RECOVERY_RETRY, I2C_RECOVERY_RETRY, I2C_RECOVERY_CLOCK_OUT,
+        I2C_RECOVERY_REINIT, I2C_RECOVERY_POWER_CYCLE, I2C_RECOVERY_NONE, I2C_RECOVERY_NONE
+    };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        monitor.record(0x76, I2C_ERR_NACK_ADDR);
+        TEST_ASSERT_EQUAL(expected[i], monitor.nextStep(0x76));
+    }
+
+    const I2CBusHealth& bus = monitor.getBusHealth();
+    TEST_ASSERT_EQUAL_UINT32(2, bus.steps[I2C_RECOVERY_RETRY]);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.steps[I2C_RECOVERY_POWER_CYCLE]);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.abandoned);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.recovered);
+
+    // Giving up restarts the ladder without counting a recovery
+    monitor.resetEscalation(0x76);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_RETRY, monitor.nextStep(0x76));
+    monitor.recovered(0x76);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.recovered);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.abandoned);
+}
+
+void test_timeouts_skip_retries() {
+    monitor.watch(0x76);
+    monitor.record(0x76, I2C_ERR_TIMEOUT);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_CLOCK_OUT, monitor.nextStep(0x76));
+
+    // A later NACK does not step back down to retries
+    monitor.record(0x76, I2C_ERR_NACK_ADDR);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_REINIT, monitor.nextStep(0x76));
+
+    // A successful transfer part-way through (e.g. the chip ID read) keeps the level
+    monitor.record(0x76, I2C_OK);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_NONE, monitor.nextStep(0x76));
+    monitor.record(0x76, I2C_ERR_NACK_DATA);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_POWER_CYCLE, monitor.nextStep(0x76));
+
+    monitor.recovered(0x76);
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.getBusHealth().recovered);
+    monitor.record(0x76, I2C_ERR_NACK_ADDR);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_RETRY, monitor.nextStep(0x76));
+}
+
+void test_engine_reports_transfers() {
+    I2CEngine::setClock(FakeI2CBus::now);
+    static FakeI2CBus bus;
+    static FakeRegisterDevice device;
+    bus = FakeI2CBus();
+    bus.begin(0, 0, 100000);
+    bus.attach(0x76, &device);
+
+    I2CEngine engine(&bus);
+    engine.setMonitor(&monitor);
+    monitor.watch(0x76);
+    monitor.watch(0x77);
+
+    uint8_t value;
+    TEST_ASSERT_EQUAL(I2C_OK, engine.readRegisters(0x76, 0xD0, &value, 1));
+    TEST_ASSERT_EQUAL(I2C_ERR_NACK_ADDR, engine.readRegisters(0x77, 0xD0, &value, 1));
+    bus.injectStuckBus();
+    TEST_ASSERT_EQUAL(I2C_ERR_TIMEOUT, engine.probe(0x76));
+    TEST_ASSERT_EQUAL(I2C_ERR_TIMEOUT, engine.probe(0x40));
+
+    TEST_ASSERT_EQUAL_UINT32(2, monitor.getDevice(0x76)->transfers);
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.getDevice(0x76)->timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, monitor.getDevice(0x77)->nacks);
+    TEST_ASSERT_NULL(monitor.getDevice(0x40));
+
+    // Counters carried over, e.g. through RTC memory across deep sleep
+    I2CHealthMonitor woken;
+    woken.restore(monitor.getTable());
+    TEST_ASSERT_EQUAL_UINT32(1, woken.getDevice(0x76)->timeouts);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_CLOCK_OUT, woken.nextStep(0x76));
+
+    engine.setMonitor(nullptr);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_counts_by_status);
+    RUN_TEST(test_nacks_escalate_through_every_step);
+    RUN_TEST(test_timeouts_skip_retries);
+    RUN_TEST(test_engine_reports_transfers);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
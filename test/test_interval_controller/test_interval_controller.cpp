@@ -0,0 +1,193 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "IntervalController.h"
+#include "ReportPolicy.h"
+
+// Trace replay: a day of ground truth at TRACE_STEP_MS resolution
+#define TRACE_STEP_MS 10000UL
+#define TRACE_POINTS (24UL * 3600UL * 1000UL / TRACE_STEP_MS)
+
+// Relative energy per wake-and-sample and per uplink (SF7 TX + RX windows
+// cost roughly two orders of magnitude more than a BME280 read)
+#define ENERGY_SAMPLE 1.0
+#define ENERGY_UPLINK 100.0
+
+struct TracePoint {
+    float values[REPORT_FIELD_COUNT];
+    bool motion;
+};
+
+static TracePoint trace[TRACE_POINTS];
+
+struct ReplayResult {
+    uint32_t samples;
+    uint32_t uplinks;
+    double energy;
+    double temperatureRms;  // Zero-order-hold reconstruction from the uplinks, °C
+    double temperatureMax;
+};
+
+// Indoor day: diurnal swing, a few door openings (fast drop and slow
+// recovery, with motion), humidity following, slow pressure drift
+static void buildTrace() {
+    const uint32_t doors[] = { 7 * 360, 12 * 360 + 100, 18 * 360 + 200, 22 * 360 };
+    uint32_t seed = 12345;
+
+    for (uint32_t i = 0; i < TRACE_POINTS; i++) {
+        float hours = i * (TRACE_STEP_MS / 1000.0F) / 3600.0F;
+        float temperature = 21.0F + 2.5F * sinf((hours - 9.0F) * 3.14159F / 12.0F);
+        bool motion = false;
+
+        for (uint32_t door : doors) {
+            if (i >= door) {
+                float minutes = (i - door) * (TRACE_STEP_MS / 60000.0F);
+                temperature -= 3.0F * expf(-minutes / 15.0F) * (minutes < 2.0F ? minutes / 2.0F : 1.0F);
+            }
+            if (i >= door && i < door + 6) {
+                motion = (i == door);
+            }
+        }
+
+        // Small sensor noise
+        seed = seed * 1103515245 + 12345;
+        float noise = ((int)((seed >> 16) % 100) - 50) / 2500.0F;
+
+        trace[i].values[REPORT_FIELD_TEMPERATURE] = temperature + noise;
+        trace[i].values[REPORT_FIELD_HUMIDITY] = 45.0F - 1.5F * (temperature - 21.0F);
+        trace[i].values[REPORT_FIELD_PRESSURE] = 1013.0F + 2.0F * sinf(hours * 3.14159F / 24.0F);
+        trace[i].values[REPORT_FIELD_BATTERY] = 3.9F;
+        trace[i].motion = motion;
+    }
+}
+
+// fixedMs == 0 replays the adaptive controller
+static ReplayResult replay(uint32_t fixedMs) {
+    ReportPolicy policy;
+    IntervalController controller;
+    controller.useDeadbands(policy.getConfig());
+
+    ReplayResult result = { 0, 0, 0.0, 0.0, 0.0 };
+    float sent = NAN;
+    uint32_t nextSampleMs = 0;
+    double squares = 0.0;
+
+    for (uint32_t i = 0; i < TRACE_POINTS; i++) {
+        uint32_t now = i * TRACE_STEP_MS;
+        const TracePoint& point = trace[i];
+
+        // Motion triggers an immediate check, like the loop does
+        if (now >= nextSampleMs || point.motion) {
+            result.samples++;
+            ReportReason reason = policy.evaluate(point.values, point.motion, now);
+            if (ReportPolicy::shouldSend(reason)) {
+                policy.commit(point.values, reason, now);
+                sent = point.values[REPORT_FIELD_TEMPERATURE];
+                result.uplinks++;
+            }
+            uint32_t interval = fixedMs > 0 ? fixedMs : controller.update(point.values, point.motion, now);
+            nextSampleMs = now + interval;
+        }
+
+        double error = isnan(sent) ? 0.0 : fabs(point.values[REPORT_FIELD_TEMPERATURE] - sent);
+        squares += error * error;
+        if (error > result.temperatureMax) result.temperatureMax = error;
+    }
+
+    result.energy = result.samples * ENERGY_SAMPLE + result.uplinks * ENERGY_UPLINK;
+    result.temperatureRms = sqrt(squares / TRACE_POINTS);
+    return result;
+}
+
+static void printResult(const char* name, const ReplayResult& r) {
+    printf("  %-10s samples %5u  uplinks %4u  energy %8.0f  T rms %.3f  T max %.2f\n",
+           name, (unsigned)r.samples, (unsigned)r.uplinks, r.energy, r.temperatureRms, r.temperatureMax);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_motion_and_fast_change_shorten_the_interval() {
+    IntervalController controller;
+    controller.setBounds(30000, 600000);
+    const float calm[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1013.0F, 3.9F };
+
+    // A calm signal grows the interval step by step up to the maximum
+    uint32_t now = 0;
+    uint32_t previous = 0;
+    for (int i = 0; i < 20; i++) {
+        uint32_t interval = controller.update(calm, false, now);
+        TEST_ASSERT_GREATER_OR_EQUAL(previous, interval);
+        TEST_ASSERT_LESS_OR_EQUAL(600000, interval);
+        previous = interval;
+        now += interval;
+    }
+    TEST_ASSERT_EQUAL_UINT32(600000, controller.getIntervalMs());
+
+    // 1 °C in 10 minutes is 0.5 deadbands per minute: next sample after one minute
+    float warmer[REPORT_FIELD_COUNT] = { 22.0F, 45.0F, 1013.0F, 3.9F };
+    uint32_t interval = controller.update(warmer, false, now);
+    TEST_ASSERT_UINT32_WITHIN(1000, 60000, interval);
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.5F, controller.getActivity());
+
+    // Motion goes straight to the minimum
+    TEST_ASSERT_EQUAL_UINT32(30000, controller.update(warmer, true, now + 60000));
+}
+
+void test_battery_factor_stretches_within_bounds() {
+    IntervalController controller;
+    controller.setBounds(30000, 600000);
+    const float calm[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1013.0F, 3.9F };
+    controller.update(calm, true, 0);
+
+    controller.setBatteryFactor(4);
+    TEST_ASSERT_EQUAL_UINT32(120000, controller.getIntervalMs());
+
+    for (uint32_t now = 1000; now < 20000; now += 1000) {
+        controller.update(calm, false, now);
+    }
+    TEST_ASSERT_EQUAL_UINT32(600000, controller.getIntervalMs());
+}
+
+void test_trace_energy_versus_reconstruction_error() {
+    buildTrace();
+
+    ReplayResult fast = replay(30000);
+    ReplayResult legacy = replay(120000);
+    ReplayResult slow = replay(600000);
+    ReplayResult adaptive = replay(0);
+
+    printf("\n");
+    printResult("fixed 30s", fast);
+    printResult("fixed 2min", legacy);
+    printResult("fixed 10min", slow);
+    printResult("adaptive", adaptive);
+
+    // Far fewer wakes than a fixed short interval, and cheaper than the old
+    // fixed two-minute cycle while reconstructing the trace better
+    TEST_ASSERT_LESS_THAN(fast.samples / 4, adaptive.samples);
+    TEST_ASSERT_LESS_THAN(legacy.energy, adaptive.energy);
+    TEST_ASSERT_LESS_THAN(legacy.temperatureRms, adaptive.temperatureRms);
+
+    // Door events are caught as quickly as with the shortest interval
+    TEST_ASSERT_LESS_THAN(slow.temperatureMax, adaptive.temperatureMax);
+    TEST_ASSERT_FLOAT_WITHIN(0.1, fast.temperatureMax, adaptive.temperatureMax);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_motion_and_fast_change_shorten_the_interval);
+    RUN_TEST(test_battery_factor_stretches_within_bounds);
+    RUN_TEST(test_trace_energy_versus_reconstruction_error);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <Arduino.h>
+#include "LogRing.h"
+
+static LogRing ring;
+
+static double secondsSince(const struct timespec& start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+void setUp(void) {
+    ring.clear();
+}
+
+void tearDown(void) {
+}
+
+void test_keeps_the_newest_lines_oldest_first() {
+    TEST_ASSERT_EQUAL_UINT32(0, ring.size());
+    TEST_ASSERT_EQUAL_STRING("", ring.newest());
+
+    char text[16];
+    for (int i = 0; i < (int)LogRing::LINES + 3; i++) {
+        snprintf(text, sizeof(text), "line %d", i);
+        ring.append(text);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(LogRing::LINES, ring.size());
+    TEST_ASSERT_EQUAL_STRING("line 3", ring.line(0));
+    TEST_ASSERT_EQUAL_STRING("line 12", ring.newest());
+    TEST_ASSERT_EQUAL_STRING("", ring.line(LogRing::LINES));
+    TEST_ASSERT_EQUAL_UINT32(LogRing::LINES + 3, ring.getAppended());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getTruncated());
+}
+
+void test_formats_into_the_slot() {
+    const char* line = ring.appendf("Sleep: %lus", 900UL);
+    TEST_ASSERT_EQUAL_STRING("Sleep: 900s", line);
+    TEST_ASSERT_EQUAL_PTR(line, ring.newest());
+    ring.append(nullptr);
+    TEST_ASSERT_EQUAL_STRING("", ring.newest());
+}
+
+static const char* prefixed(const char* prefix, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    const char* line = ring.vappendf(prefix, format, args);
+    va_end(args);
+    return line;
+}
+
+void test_long_lines_are_cut_and_marked() {
+    char text[LogRing::LINE_SIZE * 2];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+
+    // Exactly fitting lines are kept whole
+    text[LogRing::LINE_SIZE - 1] = '\0';
+    TEST_ASSERT_EQUAL_UINT32(LogRing::LINE_SIZE - 1, strlen(ring.append(text)));
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getTruncated());
+    text[LogRing::LINE_SIZE - 1] = 'x';
+
+    const char* line = ring.append(text);
+    TEST_ASSERT_EQUAL_UINT32(LogRing::LINE_SIZE - 1, strlen(line));
+    TEST_ASSERT_EQUAL_CHAR(LOG_RING_TRUNCATION_MARK, line[LogRing::LINE_SIZE - 2]);
+
+    line = prefixed("ERROR: ", "%s", text);
+    TEST_ASSERT_EQUAL_UINT32(LogRing::LINE_SIZE - 1, strlen(line));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(line, "ERROR: xxx", 10));
+    TEST_ASSERT_EQUAL_CHAR(LOG_RING_TRUNCATION_MARK, line[LogRing::LINE_SIZE - 2]);
+
+    // Even an oversized prefix leaves a terminated line
+    line = prefixed(text, "%d", 42);
+    TEST_ASSERT_EQUAL_UINT32(LogRing::LINE_SIZE - 1, strlen(line));
+    TEST_ASSERT_EQUAL_UINT32(3, ring.getTruncated());
+
+    line = prefixed("INFO: ", "%s", "short");
+    TEST_ASSERT_EQUAL_STRING("INFO: short", line);
+    TEST_ASSERT_EQUAL_UINT32(3, ring.getTruncated());
+}
+
+// The previous log: shift ten Strings up and assign the prefixed message
+static String shifted[LogRing::LINES];
+
+static void appendShifted(const String& message) {
+    String formatted = "INFO: " + message;
+    for (size_t i = 0; i < LogRing::LINES - 1; i++) {
+        shifted[i] = shifted[i + 1];
+    }
+    shifted[LogRing::LINES - 1] = formatted;
+}
+
+void test_append_cost() {
+    const int count = 200000;
+    struct timespec start;
+    volatile size_t sink = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        appendShifted(String("Data sent, RSSI ") + String(-87 - i % 20) + " dBm");
+        sink += shifted[LogRing::LINES - 1].length();
+    }
+    double stringNs = secondsSince(start) * 1e9 / count;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        sink += strlen(prefixed("INFO: ", "Data sent, RSSI %d dBm", -87 - i % 20));
+    }
+    double ringNs = secondsSince(start) * 1e9 / count;
+    TEST_ASSERT_EQUAL_STRING(shifted[LogRing::LINES - 1].c_str(), ring.newest());
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; i++) {
+        sink += strlen(ring.append("INFO: Data sent"));
+    }
+    double copyNs = secondsSince(start) * 1e9 / count;
+
+    printf("\n  append: String shift %.0f ns, ring printf %.0f ns, ring copy %.0f ns (%u bytes fixed)\n",
+           stringNs, ringNs, copyNs, (unsigned)sizeof(LogRing));
+
+    TEST_ASSERT_TRUE(sink > 0);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_keeps_the_newest_lines_oldest_first);
+    RUN_TEST(test_formats_into_the_slot);
+    RUN_TEST(test_long_lines_are_cut_and_marked);
+    RUN_TEST(test_append_cost);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -142,7 +142,7 @@ void RUN_UNITY_TESTS() {
     UNITY_END();
 }
 
-int main(int argc, char **argv) {
+int main(void) {
     RUN_UNITY_TESTS();
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include <unity.h>
+#include "MotionSensor.h"
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_edges_are_counted_with_first_and_last_time() {
+    MotionSensor motion;
+    motion.onEdge(true, 1000);
+    motion.onEdge(false, 3000);
+    motion.onEdge(true, 10000);
+    motion.onEdge(false, 11000);
+
+    TEST_ASSERT_EQUAL(2, motion.update(12000));
+
+    MotionSummary summary = motion.takeSummary(20000);
+    TEST_ASSERT_EQUAL(2, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(1000, summary.firstEventMs);
+    TEST_ASSERT_EQUAL_UINT32(10000, summary.lastEventMs);
+    TEST_ASSERT_EQUAL_UINT32(3000, summary.activeMs);
+    TEST_ASSERT_EQUAL_UINT8(15, summary.occupancyPercent());
+    TEST_ASSERT_EQUAL(10, MotionSummary::ageSeconds(summary.lastEventMs, 20000));
+}
+
+void test_bounces_are_filtered() {
+    MotionSensor motion;
+    motion.onEdge(true, 1000);
+    motion.onEdge(false, 1000 + MOTION_DEBOUNCE_MS / 2);  // Bounce
+    motion.onEdge(true, 1000 + MOTION_DEBOUNCE_MS);       // Same level again
+    motion.onEdge(false, 5000);
+
+    MotionSummary summary = motion.takeSummary(10000);
+    TEST_ASSERT_EQUAL(1, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(4000, summary.activeMs);
+}
+
+void test_settled_level_is_applied_without_a_later_edge() {
+    MotionSensor motion;
+    motion.onEdge(true, 1000);
+    TEST_ASSERT_EQUAL(1, motion.update(2000));
+
+    // The PIR drops out with a bounce that ends inactive inside the window
+    motion.onEdge(false, 5000);
+    motion.onEdge(true, 5000 + MOTION_DEBOUNCE_MS / 4);
+    motion.onEdge(false, 5000 + MOTION_DEBOUNCE_MS / 2);
+    TEST_ASSERT_EQUAL(0, motion.update(5000 + MOTION_DEBOUNCE_MS / 2));
+    TEST_ASSERT_TRUE(motion.isActive());  // Not settled yet
+
+    MotionSummary summary = motion.takeSummary(10000);
+    TEST_ASSERT_FALSE(motion.isActive());
+    TEST_ASSERT_EQUAL(1, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(4000, summary.activeMs);
+
+    // A glitch shorter than the window is not motion
+    motion.onEdge(true, 12000);
+    motion.onEdge(false, 12000 + MOTION_DEBOUNCE_MS / 2);
+    summary = motion.takeSummary(20000);
+    TEST_ASSERT_EQUAL(0, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(0, summary.activeMs);
+}
+
+void test_restored_summary_goes_out_with_the_next() {
+    MotionSensor motion;
+    motion.onEdge(true, 1000);
+    motion.onEdge(false, 3000);
+    MotionSummary failed = motion.takeSummary(10000);
+
+    // The uplink failed; more motion happens before the next one
+    motion.restoreSummary(failed);
+    motion.onEdge(true, 14000);
+    motion.onEdge(false, 15000);
+
+    MotionSummary summary = motion.takeSummary(20000);
+    TEST_ASSERT_EQUAL(2, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(1000, summary.firstEventMs);
+    TEST_ASSERT_EQUAL_UINT32(14000, summary.lastEventMs);
+    TEST_ASSERT_EQUAL_UINT32(3000, summary.activeMs);
+    TEST_ASSERT_EQUAL_UINT32(20000, summary.intervalMs);
+}
+
+void test_activity_carries_across_intervals() {
+    MotionSensor motion;
+    motion.onEdge(true, 8000);
+
+    MotionSummary first = motion.takeSummary(10000);
+    TEST_ASSERT_EQUAL(1, first.count);
+    TEST_ASSERT_EQUAL_UINT32(2000, first.activeMs);
+    TEST_ASSERT_TRUE(motion.isActive());
+
+    motion.onEdge(false, 15000);
+    MotionSummary second = motion.takeSummary(20000);
+    TEST_ASSERT_EQUAL(0, second.count);
+    TEST_ASSERT_EQUAL_UINT32(5000, second.activeMs);
+    TEST_ASSERT_EQUAL_UINT8(50, second.occupancyPercent());
+}
+
+void test_full_queue_counts_dropped_edges() {
+    MotionSensor motion;
+    uint32_t t = 0;
+    for (int i = 0; i < MOTION_EVENT_QUEUE_SIZE + 4; i++) {
+        motion.onEdge(i % 2 == 0, t);
+        t += 1000;
+    }
+
+    MotionSummary summary = motion.takeSummary(t);
+    TEST_ASSERT_EQUAL(MOTION_EVENT_QUEUE_SIZE / 2, summary.count);
+    TEST_ASSERT_EQUAL(4, summary.dropped);
+}
+
+void test_wake_with_pir_still_active_counts_once() {
+    // ext0 wake, and begin() still reads the PIR active
+    MotionSensor motion;
+    motion.start(true, 1000);
+    motion.recordWakeEvent(1000);
+    motion.onEdge(false, 4000);
+
+    MotionSummary summary = motion.takeSummary(10000);
+    TEST_ASSERT_EQUAL(1, summary.count);
+    TEST_ASSERT_EQUAL_UINT32(1000, summary.firstEventMs);
+    TEST_ASSERT_EQUAL_UINT32(3000, summary.activeMs);
+
+    // The PIR had already dropped out: the wake itself is the start
+    MotionSensor dropped;
+    dropped.start(false, 1000);
+    dropped.recordWakeEvent(1000);
+    summary = dropped.takeSummary(10000);
+    TEST_ASSERT_EQUAL(1, summary.count);
+    TEST_ASSERT_FALSE(dropped.isActive());
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_edges_are_counted_with_first_and_last_time);
+    RUN_TEST(test_bounces_are_filtered);
+    RUN_TEST(test_settled_level_is_applied_without_a_later_edge);
+    RUN_TEST(test_restored_summary_goes_out_with_the_next);
+    RUN_TEST(test_activity_carries_across_intervals);
+    RUN_TEST(test_full_queue_counts_dropped_edges);
+    RUN_TEST(test_wake_with_pir_still_active_counts_once);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <unity.h>
+#include <math.h>
+#include "ReportPolicy.h"
+
+static ReportPolicy policy;
+
+static void sendAt(const float* values, uint32_t nowMs) {
+    ReportReason reason = policy.evaluate(values, false, nowMs);
+    TEST_ASSERT_TRUE(ReportPolicy::shouldSend(reason));
+    policy.commit(values, reason, nowMs);
+}
+
+void setUp(void) {
+    policy = ReportPolicy();
+    policy.setMinSpacing(60000);
+    policy.setMaxSilence(3600000);
+}
+
+void tearDown(void) {
+}
+
+void test_first_reading_is_always_sent() {
+    const float values[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1013.0F, 3.9F };
+    TEST_ASSERT_EQUAL(REPORT_FIRST, policy.evaluate(values, false, 0));
+}
+
+void test_unchanged_readings_are_suppressed() {
+    const float sent[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1013.0F, 3.9F };
+    sendAt(sent, 0);
+
+    // Inside every default deadband
+    const float same[REPORT_FIELD_COUNT] = { 21.1F, 46.0F, 1013.3F, 3.88F };
+    for (uint32_t t = 120000; t < 3600000; t += 120000) {
+        TEST_ASSERT_EQUAL(REPORT_SUPPRESSED, policy.evaluate(same, false, t));
+    }
+    TEST_ASSERT_EQUAL_UINT32(29, policy.getStats().suppressed);
+    TEST_ASSERT_EQUAL_UINT32(1, policy.getStats().sent);
+
+    // Heartbeat once the maximum silence has passed
+    TEST_ASSERT_EQUAL(REPORT_HEARTBEAT, policy.evaluate(same, false, 3600000));
+    policy.commit(same, REPORT_HEARTBEAT, 3600000);
+    TEST_ASSERT_EQUAL_UINT32(1, policy.getStats().heartbeats);
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 14.5F, policy.getStats().suppressionRatio());
+}
+
+void test_absolute_and_relative_deadbands() {
+    policy.setDeadband(REPORT_FIELD_PRESSURE, 0.0F, 0.001F);  // 0.1 %, about 1 hPa
+    const float sent[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1000.0F, 3.9F };
+    sendAt(sent, 0);
+
+    float values[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1000.9F, 3.9F };
+    TEST_ASSERT_EQUAL_UINT8(0, policy.changedFields(values));
+
+    values[REPORT_FIELD_PRESSURE] = 1001.1F;
+    TEST_ASSERT_EQUAL_UINT8(1 << REPORT_FIELD_PRESSURE, policy.changedFields(values));
+
+    values[REPORT_FIELD_TEMPERATURE] = 20.7F;
+    TEST_ASSERT_EQUAL_UINT8((1 << REPORT_FIELD_PRESSURE) | (1 << REPORT_FIELD_TEMPERATURE),
+                            policy.changedFields(values));
+    TEST_ASSERT_EQUAL(REPORT_CHANGED, policy.evaluate(values, false, 60000));
+
+    // A channel dropping out is a change too
+    values[REPORT_FIELD_PRESSURE] = 1000.0F;
+    values[REPORT_FIELD_TEMPERATURE] = 21.0F;
+    values[REPORT_FIELD_HUMIDITY] = NAN;
+    TEST_ASSERT_EQUAL_UINT8(1 << REPORT_FIELD_HUMIDITY, policy.changedFields(values));
+}
+
+void test_spacing_defers_changes_and_events() {
+    const float sent[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1013.0F, 3.9F };
+    sendAt(sent, 0);
+
+    // Motion 10 s after an uplink waits for the spacing, then goes out
+    TEST_ASSERT_EQUAL(REPORT_DEFERRED, policy.evaluate(sent, true, 10000));
+    TEST_ASSERT_EQUAL(REPORT_DEFERRED, policy.evaluate(sent, false, 30000));
+    TEST_ASSERT_EQUAL(REPORT_EVENT, policy.evaluate(sent, false, 60000));
+    policy.commit(sent, REPORT_EVENT, 60000);
+    TEST_ASSERT_EQUAL_UINT32(2, policy.getStats().deferred);
+
+    // The event was consumed by the commit
+    TEST_ASSERT_EQUAL(REPORT_SUPPRESSED, policy.evaluate(sent, false, 200000));
+}
+
+void test_spacing_factor_stretches_spacing() {
+    const float sent[REPORT_FIELD_COUNT] = { 21.0F, 45.0F, 1013.0F, 3.9F };
+    sendAt(sent, 0);
+
+    policy.setSpacingFactor(4);  // Critical battery
+    TEST_ASSERT_EQUAL_UINT32(240000, policy.getMinSpacingMs());
+    TEST_ASSERT_EQUAL(REPORT_DEFERRED, policy.evaluate(sent, true, 120000));
+    TEST_ASSERT_EQUAL(REPORT_EVENT, policy.evaluate(sent, false, 240000));
+}
+
+void test_downlink_updates_configuration() {
+    // Temperature: 0.50 °C absolute, 1.0 % relative
+    const uint8_t deadband[] = { REPORT_DOWNLINK_CONFIG, REPORT_CONFIG_DEADBAND, REPORT_FIELD_TEMPERATURE,
+                                 0x00, 0x32, 10 };
+    TEST_ASSERT_TRUE(policy.applyDownlink(deadband, sizeof(deadband)));
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 0.5F, policy.getConfig().deadband[REPORT_FIELD_TEMPERATURE].absolute);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001F, 0.01F, policy.getConfig().deadband[REPORT_FIELD_TEMPERATURE].relative);
+
+    const uint8_t silence[] = { REPORT_DOWNLINK_CONFIG, REPORT_CONFIG_MAX_SILENCE, 0x00, 0x1C, 0x20 };
+    TEST_ASSERT_TRUE(policy.applyDownlink(silence, sizeof(silence)));
+    TEST_ASSERT_EQUAL_UINT32(7200000, policy.getConfig().maxSilenceMs);
+
+    const uint8_t spacing[] = { REPORT_DOWNLINK_CONFIG, REPORT_CONFIG_MIN_SPACING, 0x00, 0x00, 0x1E };
+    TEST_ASSERT_TRUE(policy.applyDownlink(spacing, sizeof(spacing)));
+    TEST_ASSERT_EQUAL_UINT32(30000, policy.getConfig().minSpacingMs);
+
+    // The largest u24 is clamped instead of wrapping the milliseconds
+    const uint8_t longest[] = { REPORT_DOWNLINK_CONFIG, REPORT_CONFIG_MAX_SILENCE, 0xFF, 0xFF, 0xFF };
+    TEST_ASSERT_TRUE(policy.applyDownlink(longest, sizeof(longest)));
+    TEST_ASSERT_EQUAL_UINT32(4294967000UL, policy.getConfig().maxSilenceMs);
+
+    // Unknown field, truncated payload and other downlink types are rejected
+    const uint8_t badField[] = { REPORT_DOWNLINK_CONFIG, REPORT_CONFIG_DEADBAND, REPORT_FIELD_COUNT, 0, 1, 0 };
+    const uint8_t truncated[] = { REPORT_DOWNLINK_CONFIG, REPORT_CONFIG_MAX_SILENCE, 0x00 };
+    const uint8_t command[] = { 0x02, 0x01 };
+    TEST_ASSERT_FALSE(policy.applyDownlink(badField, sizeof(badField)));
+    TEST_ASSERT_FALSE(policy.applyDownlink(truncated, sizeof(truncated)));
+    TEST_ASSERT_FALSE(policy.applyDownlink(command, sizeof(command)));
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_reading_is_always_sent);
+    RUN_TEST(test_unchanged_readings_are_suppressed);
+    RUN_TEST(test_absolute_and_relative_deadbands);
+    RUN_TEST(test_spacing_defers_changes_and_events);
+    RUN_TEST(test_spacing_factor_stretches_spacing);
+    RUN_TEST(test_downlink_updates_configuration);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,318 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "SampleArchive.h"
+#include "FakeFlash.h"
+
+// The 256 KB archive partition of partitions.csv
+#define ARCHIVE_BYTES (SAMPLE_ARCHIVE_MAX_SECTORS * ARCHIVE_FLASH_SECTOR_SIZE)
+#define PERIOD 60
+
+static FakeFlash* flash;
+
+// Hundredths of °C, %RH and hPa drifting slowly, with a little noise
+static void sampleAt(uint32_t i, int32_t* values) {
+    uint32_t noise = (i * 2654435761u) >> 30;
+    values[0] = 2500 + (int32_t)((i / 30) % 200) - 100 + (int32_t)(noise & 1);
+    values[1] = 4000 + (int32_t)((i / 45) % 300) - 150;
+    values[2] = 101325 + (int32_t)((i / 20) % 100) + (int32_t)noise - 2;
+}
+
+static double secondsSince(const struct timespec& start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+// Decode a record and check every sample against the trace
+static bool checkRecord(const ArchiveRecord& record, uint32_t start, uint32_t* samples) {
+    int32_t decoded[255 * SERIES_MAX_CHANNELS];
+    uint8_t channels;
+    uint16_t period;
+    int count = SeriesDecoder::decode(record.frame, record.size, decoded, sizeof(decoded) / sizeof(decoded[0]),
+                                      &channels, &period);
+    if (count <= 0 || channels != 4 || period != PERIOD) return false;
+    if ((uint32_t)decoded[0] != record.firstTime || (uint32_t)decoded[(count - 1) * 4] != record.lastTime) return false;
+
+    for (int s = 0; s < count; s++) {
+        int32_t expected[3];
+        uint32_t i = ((uint32_t)decoded[s * 4] - start) / PERIOD;
+        sampleAt(i, expected);
+        if (memcmp(expected, &decoded[s * 4 + 1], sizeof(expected)) != 0) return false;
+    }
+    *samples += count;
+    return true;
+}
+
+void setUp(void) {
+    flash = new FakeFlash(ARCHIVE_BYTES);
+}
+
+void tearDown(void) {
+    delete flash;
+}
+
+void test_append_query_and_remount() {
+    SampleArchive archive(3, PERIOD);
+    TEST_ASSERT_TRUE(archive.begin(flash));
+
+    const uint32_t start = 1000000;
+    int32_t values[3];
+    for (uint32_t i = 0; i < 1440; i++) {
+        sampleAt(i, values);
+        TEST_ASSERT_TRUE(archive.append(start + i * PERIOD, values));
+    }
+    TEST_ASSERT_TRUE(archive.flush());
+    TEST_ASSERT_EQUAL_UINT32(0, flash->violations);
+
+    // Times cannot go backwards
+    TEST_ASSERT_FALSE(archive.append(start, values));
+
+    // Every record of the day decodes to the original samples, through flash pointers
+    ArchiveRecord records[256];
+    size_t count = archive.query(start, start + 1440 * PERIOD, records, 256);
+    uint32_t samples = 0;
+    TEST_ASSERT_GREATER_THAN(0, count);
+    for (size_t r = 0; r < count; r++) {
+        TEST_ASSERT_TRUE(checkRecord(records[r], start, &samples));
+        TEST_ASSERT_TRUE(records[r].frame >= flash->data() && records[r].frame < flash->data() + flash->size());
+    }
+    TEST_ASSERT_EQUAL_UINT32(1440, samples);
+
+    // An hour in the afternoon: only the overlapping records
+    uint32_t from = start + 900 * PERIOD;
+    uint32_t to = from + 60 * PERIOD;
+    count = archive.query(from, to, records, 256);
+    TEST_ASSERT_GREATER_THAN(0, count);
+    TEST_ASSERT_TRUE(records[0].firstTime <= from && records[0].lastTime >= from);
+    TEST_ASSERT_TRUE(records[count - 1].firstTime <= to && records[count - 1].lastTime >= to);
+
+    // Outside the archive
+    TEST_ASSERT_EQUAL_UINT32(0, archive.query(start + 2000 * PERIOD, start + 3000 * PERIOD, records, 256));
+    TEST_ASSERT_EQUAL_UINT32(0, archive.query(0, start - 1, records, 256));
+
+    // A reboot rebuilds the same index from flash
+    ArchiveStats before = archive.getStats();
+    SampleArchive rebooted(3, PERIOD);
+    TEST_ASSERT_TRUE(rebooted.begin(flash));
+    ArchiveStats after = rebooted.getStats();
+    TEST_ASSERT_EQUAL_UINT32(before.records, after.records);
+    TEST_ASSERT_EQUAL_UINT32(before.bytes, after.bytes);
+    TEST_ASSERT_EQUAL_UINT32(start, after.oldestTime);
+    TEST_ASSERT_EQUAL_UINT32(start + 1439 * PERIOD, rebooted.getNewestTime());
+    TEST_ASSERT_EQUAL_UINT32(count, rebooted.query(from, to, records, 256));
+
+    // And keeps appending where the last run stopped
+    sampleAt(1440, values);
+    TEST_ASSERT_TRUE(rebooted.append(start + 1440 * PERIOD, values));
+    TEST_ASSERT_TRUE(rebooted.flush());
+    TEST_ASSERT_EQUAL_UINT32(before.records + 1, rebooted.getStats().records);
+    TEST_ASSERT_EQUAL_UINT32(0, flash->violations);
+}
+
+void test_wraps_and_drops_the_oldest_sector() {
+    SampleArchive archive(3, PERIOD);
+    archive.begin(flash);
+
+    // Far more than fits: only the newest weeks remain
+    const uint32_t total = 120000;
+    int32_t values[3];
+    for (uint32_t i = 0; i < total; i++) {
+        sampleAt(i, values);
+        TEST_ASSERT_TRUE(archive.append(i * PERIOD, values));
+    }
+    archive.flush();
+
+    ArchiveStats stats = archive.getStats();
+    TEST_ASSERT_EQUAL_UINT32(SAMPLE_ARCHIVE_MAX_SECTORS, stats.sectors);
+    TEST_ASSERT_GREATER_THAN(0, stats.recycled);
+    TEST_ASSERT_GREATER_THAN(0, stats.oldestTime);
+    TEST_ASSERT_EQUAL_UINT32(0, flash->violations);
+
+    // Everything still held decodes, oldest first, up to the newest sample
+    ArchiveCursor cursor;
+    ArchiveRecord record;
+    TEST_ASSERT_TRUE(archive.seek(0, UINT32_MAX, cursor));
+    uint32_t samples = 0;
+    uint32_t lastTime = 0;
+    while (archive.next(cursor, record)) {
+        TEST_ASSERT_TRUE(checkRecord(record, 0, &samples));
+        TEST_ASSERT_TRUE(record.firstTime >= lastTime);
+        lastTime = record.lastTime;
+    }
+    TEST_ASSERT_EQUAL_UINT32((total - 1) * PERIOD, lastTime);
+    TEST_ASSERT_EQUAL_UINT32(total - stats.oldestTime / PERIOD, samples);
+
+    // Remount after the wrap finds the same head and oldest sector
+    SampleArchive rebooted(3, PERIOD);
+    rebooted.begin(flash);
+    TEST_ASSERT_EQUAL_UINT32(stats.oldestTime, rebooted.getStats().oldestTime);
+    TEST_ASSERT_EQUAL_UINT32(stats.records, rebooted.getStats().records);
+}
+
+void test_torn_record_is_skipped() {
+    SampleArchive archive(3, PERIOD);
+    archive.begin(flash);
+
+    int32_t values[3];
+    for (uint32_t i = 0; i < 100; i++) {
+        sampleAt(i, values);
+        archive.append(i * PERIOD, values);
+    }
+    archive.flush();
+    uint32_t records = archive.getStats().records;
+
+    // Power fails while the next record is written
+    sampleAt(100, values);
+    archive.append(100 * PERIOD, values);
+    flash->setFailWrites(true);
+    TEST_ASSERT_FALSE(archive.flush());
+    flash->setFailWrites(false);
+
+    SampleArchive rebooted(3, PERIOD);
+    rebooted.begin(flash);
+    TEST_ASSERT_EQUAL_UINT32(records, rebooted.getStats().records);
+    TEST_ASSERT_EQUAL_UINT32(99 * PERIOD, rebooted.getNewestTime());
+
+    // The failed sector is closed; writing continues in the next one
+    TEST_ASSERT_TRUE(archive.append(101 * PERIOD, values));
+    TEST_ASSERT_TRUE(archive.flush());
+    TEST_ASSERT_EQUAL_UINT32(0, flash->violations);
+    ArchiveRecord found[64];
+    uint32_t samples = 0;
+    size_t count = archive.query(0, UINT32_MAX, found, 64);
+    for (size_t r = 0; r < count; r++) {
+        samples += found[r].frame[2];
+    }
+    TEST_ASSERT_EQUAL_UINT32(102, samples);
+}
+
+void test_pending_age_bounds_a_reset() {
+    SampleArchive archive(3, PERIOD);
+    archive.setMaxPendingAge(15 * PERIOD);
+    TEST_ASSERT_TRUE(archive.begin(flash));
+
+    // A reset after 40 minutes without flush()
+    int32_t values[3];
+    for (uint32_t i = 0; i < 40; i++) {
+        sampleAt(i, values);
+        TEST_ASSERT_TRUE(archive.append(i * PERIOD, values));
+    }
+
+    // Every quarter hour reached flash; only the last 8 samples are lost
+    SampleArchive rebooted(3, PERIOD);
+    TEST_ASSERT_TRUE(rebooted.begin(flash));
+    TEST_ASSERT_EQUAL_UINT32(2, rebooted.getStats().records);
+    TEST_ASSERT_EQUAL_UINT32(31 * PERIOD, rebooted.getNewestTime());
+
+    ArchiveRecord records[4];
+    uint32_t samples = 0;
+    size_t count = rebooted.query(0, 40 * PERIOD, records, 4);
+    for (size_t r = 0; r < count; r++) {
+        TEST_ASSERT_TRUE(checkRecord(records[r], 0, &samples));
+    }
+    TEST_ASSERT_EQUAL_UINT32(32, samples);
+}
+
+void test_downlink_replays_a_range() {
+    SampleArchive archive(3, PERIOD);
+    archive.begin(flash);
+
+    int32_t values[3];
+    for (uint32_t i = 0; i < 600; i++) {
+        sampleAt(i, values);
+        archive.append(i * PERIOD, values);
+    }
+
+    // Not a range request
+    const uint8_t reset[] = { 0x02, 0x01 };
+    TEST_ASSERT_FALSE(archive.applyDownlink(reset, sizeof(reset)));
+    TEST_ASSERT_FALSE(archive.isReplaying());
+
+    // 02 03 from to: minutes 500..599, still partly in the frame buffer
+    const uint8_t request[] = { 0x02, 0x03, 0x00, 0x00, 0x75, 0x30, 0x00, 0x00, 0x8C, 0x64 };
+    TEST_ASSERT_TRUE(archive.applyDownlink(request, sizeof(request)));
+    TEST_ASSERT_TRUE(archive.isReplaying());
+
+    // Streamed a few frames per uplink; the cursor survives "deep sleep"
+    ArchiveRecord record;
+    uint32_t samples = 0;
+    uint32_t uplinks = 0;
+    while (archive.isReplaying()) {
+        ArchiveCursor saved = archive.getReplay();
+        SampleArchive woken(3, PERIOD);
+        woken.begin(flash);
+        woken.restoreReplay(saved);
+        for (int frame = 0; frame < 2 && woken.nextReplay(record); frame++) {
+            TEST_ASSERT_TRUE(checkRecord(record, 0, &samples));
+            TEST_ASSERT_TRUE(record.size <= SERIES_MAX_BYTES);
+            uplinks++;
+        }
+        archive.restoreReplay(woken.getReplay());
+    }
+    TEST_ASSERT_GREATER_THAN(0, uplinks);
+    TEST_ASSERT_EQUAL_UINT32(599 * PERIOD, record.lastTime);
+    TEST_ASSERT_TRUE(samples >= 100);
+}
+
+void test_append_and_query_throughput() {
+    SampleArchive archive(3, PERIOD);
+    archive.begin(flash);
+
+    // Eight weeks at one sample per minute
+    const uint32_t total = 8 * 7 * 1440;
+    int32_t values[3];
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t i = 0; i < total; i++) {
+        sampleAt(i, values);
+        archive.append(i * PERIOD, values);
+    }
+    archive.flush();
+    double appendSeconds = secondsSince(start);
+    ArchiveStats stats = archive.getStats();
+    uint32_t held = total - stats.oldestTime / PERIOD;
+    TEST_ASSERT_EQUAL_UINT32(0, flash->violations);
+
+    // One-hour ranges at random points of the retained history
+    const int queries = 20000;
+    uint32_t seed = 7;
+    size_t found = 0;
+    ArchiveRecord records[16];
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int q = 0; q < queries; q++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t from = stats.oldestTime + (seed >> 8) % (stats.newestTime - stats.oldestTime);
+        found += archive.query(from, from + 3600, records, 16);
+    }
+    double querySeconds = secondsSince(start);
+    TEST_ASSERT_GREATER_THAN(queries, found);
+
+    printf("\n  %u samples kept of %u (%.1f days in %u KB), %.2f bytes/sample",
+           (unsigned)held, (unsigned)total, held / 1440.0, (unsigned)(stats.bytes / 1024),
+           (double)stats.bytes / held);
+    printf("\n  append: %.0f ns/sample CPU, %.1f us/sample flash (%u erases, %u writes)",
+           appendSeconds * 1e9 / total, (double)flash->busyUs / total,
+           (unsigned)flash->erases, (unsigned)flash->writes);
+    printf("\n  query:  %.2f us per one-hour range, %.1f records each\n",
+           querySeconds * 1e6 / queries, (double)found / queries);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_append_query_and_remount);
+    RUN_TEST(test_wraps_and_drops_the_oldest_sector);
+    RUN_TEST(test_torn_record_is_skipped);
+    RUN_TEST(test_pending_age_bounds_a_reset);
+    RUN_TEST(test_downlink_replays_a_range);
+    RUN_TEST(test_append_and_query_throughput);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
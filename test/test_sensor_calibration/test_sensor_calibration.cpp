@@ -0,0 +1,125 @@
+#include <unity.h>
+#include <math.h>
+#include "SensorManager.h"
+#include "SensorCalibration.h"
+#include "FakeBME280.h"
+
+static SensorCalibration calibration;
+
+void setUp(void) {
+    calibration.clear();
+}
+
+void tearDown(void) {
+}
+
+void test_unset_table_is_inactive() {
+    TEST_ASSERT_FALSE(calibration.isActive());
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 1013.25F, calibration.getSeaLevelHpa());
+
+    // Setting a channel back to identity switches the correction off again
+    calibration.setChannel(SENSOR_CHANNEL_HUMIDITY, 1.0F, 1.0F);
+    TEST_ASSERT_TRUE(calibration.isActive());
+    calibration.setChannel(SENSOR_CHANNEL_HUMIDITY, 0.0F, 1.0F);
+    TEST_ASSERT_FALSE(calibration.isActive());
+
+    // Identity leaves samples bit-exact
+    BME280Sample sample = { 2508, 100653 * 256, 40 * 1024 };
+    BME280Sample copy = sample;
+    calibration.apply(sample);
+    TEST_ASSERT_EQUAL_MEMORY(&copy, &sample, sizeof(sample));
+}
+
+void test_fixed_point_offsets_and_gains() {
+    calibration.setChannel(SENSOR_CHANNEL_TEMPERATURE, -1.5F);
+    calibration.setChannel(SENSOR_CHANNEL_HUMIDITY, 0.0F, 1.05F);
+    calibration.setChannel(SENSOR_CHANNEL_PRESSURE, 0.5F);
+    TEST_ASSERT_EQUAL_INT32(-150, calibration.getChannel(SENSOR_CHANNEL_TEMPERATURE).offset);
+    TEST_ASSERT_EQUAL_UINT16(34406, calibration.getChannel(SENSOR_CHANNEL_HUMIDITY).gain);
+    TEST_ASSERT_EQUAL_INT32(12800, calibration.getChannel(SENSOR_CHANNEL_PRESSURE).offset);
+
+    BME280Sample sample = { 2508, 100653 * 256, 40 * 1024 };
+    calibration.apply(sample);
+    TEST_ASSERT_EQUAL_INT32(2358, sample.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 42.0F, sample.humidity / 1024.0F);
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 1007.03F, sample.pressure / 25600.0F);
+
+    // Humidity stays within 0-100 %RH
+    sample.humidity = 98 * 1024;
+    calibration.apply(sample);
+    TEST_ASSERT_EQUAL_UINT32(100 * 1024, sample.humidity);
+}
+
+void test_downlink_updates() {
+    // Temperature -1.50 °C, gain 1.0
+    const uint8_t temperature[] = { 0x01, 0x05, 0x00, 0xFF, 0x6A, 0x80, 0x00 };
+    TEST_ASSERT_TRUE(calibration.applyDownlink(temperature, sizeof(temperature)));
+    TEST_ASSERT_EQUAL_INT32(-150, calibration.getChannel(SENSOR_CHANNEL_TEMPERATURE).offset);
+
+    // Humidity +2.50 %RH, pressure +0.50 hPa
+    const uint8_t humidity[] = { 0x01, 0x05, 0x01, 0x00, 0xFA, 0x80, 0x00 };
+    TEST_ASSERT_TRUE(calibration.applyDownlink(humidity, sizeof(humidity)));
+    TEST_ASSERT_EQUAL_INT32(2560, calibration.getChannel(SENSOR_CHANNEL_HUMIDITY).offset);
+    const uint8_t pressure[] = { 0x01, 0x05, 0x02, 0x00, 0x32, 0x80, 0x00 };
+    TEST_ASSERT_TRUE(calibration.applyDownlink(pressure, sizeof(pressure)));
+    TEST_ASSERT_EQUAL_INT32(12800, calibration.getChannel(SENSOR_CHANNEL_PRESSURE).offset);
+
+    // Sea level 1012.12 hPa, then back to the default
+    const uint8_t seaLevel[] = { 0x01, 0x06, 0x01, 0x8B, 0x5C };
+    TEST_ASSERT_TRUE(calibration.applyDownlink(seaLevel, sizeof(seaLevel)));
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 1012.12F, calibration.getSeaLevelHpa());
+    const uint8_t defaultSeaLevel[] = { 0x01, 0x06, 0x00, 0x00, 0x00 };
+    TEST_ASSERT_TRUE(calibration.applyDownlink(defaultSeaLevel, sizeof(defaultSeaLevel)));
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, 1013.25F, calibration.getSeaLevelHpa());
+
+    // Other keys, bad channels and short payloads are left to other handlers
+    const uint8_t deadband[] = { 0x01, 0x02, 0x00, 0x00, 0x32, 0x00 };
+    const uint8_t badChannel[] = { 0x01, 0x05, 0x03, 0x00, 0x00, 0x80, 0x00 };
+    const uint8_t shortPayload[] = { 0x01, 0x05, 0x00, 0x00 };
+    const uint8_t command[] = { 0x02, 0x05, 0x00, 0x00, 0x00, 0x80, 0x00 };
+    TEST_ASSERT_FALSE(calibration.applyDownlink(deadband, sizeof(deadband)));
+    TEST_ASSERT_FALSE(calibration.applyDownlink(badChannel, sizeof(badChannel)));
+    TEST_ASSERT_FALSE(calibration.applyDownlink(shortPayload, sizeof(shortPayload)));
+    TEST_ASSERT_FALSE(calibration.applyDownlink(command, sizeof(command)));
+}
+
+void test_applied_in_acquisition_path() {
+    I2CEngine::setClock(FakeI2CBus::now);
+    static FakeI2CBus bus;
+    static FakeBME280 sensor;
+    bus.attach(BME_ADDRESS, &sensor);
+    const BME280RawData raw = { 526024, 422493, 26689 };  // 27.00 °C, 36.17 %RH, 996.78 hPa
+    sensor.setRaw(raw);
+
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    SensorReading plain;
+    TEST_ASSERT_TRUE(sensors.read(plain));
+
+    // Self-heating offset, and the local pressure as sea-level reference
+    sensors.getCalibration().setChannel(SENSOR_CHANNEL_TEMPERATURE, -2.0F);
+    sensors.getCalibration().setSeaLevel((uint32_t)lroundf(plain.pressure * 100.0F));
+    sensors.getFilter().reset();
+    SensorReading corrected;
+    TEST_ASSERT_TRUE(sensors.read(corrected));
+    TEST_ASSERT_FLOAT_WITHIN(0.001F, plain.temperature - 2.0F, corrected.temperature);
+    TEST_ASSERT_EQUAL_FLOAT(plain.humidity, corrected.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.5F, 0.0F, corrected.altitude);
+    TEST_ASSERT_GREATER_THAN(100.0F, plain.altitude);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_unset_table_is_inactive);
+    RUN_TEST(test_fixed_point_offsets_and_gains);
+    RUN_TEST(test_downlink_updates);
+    RUN_TEST(test_applied_in_acquisition_path);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <math.h>
+#include "SensorFilter.h"
+
+static SensorFilter filter;
+
+static SensorReading makeReading(float temperature, float humidity, float pressure) {
+    SensorReading reading = { temperature, humidity, pressure, 0.0f, 0 };
+    return reading;
+}
+
+void setUp(void) {
+    filter = SensorFilter();
+}
+
+void tearDown(void) {
+}
+
+void test_first_valid_sample_passes_through() {
+    SensorReading reading = makeReading(21.5f, 45.0f, 1001.0f);
+    uint8_t quality = filter.apply(reading, true, 0);
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 21.5f, reading.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1001.0f, reading.pressure);
+    TEST_ASSERT_EQUAL_HEX8(SENSOR_QUALITY_WARMING_UP, quality);
+    TEST_ASSERT_TRUE(SensorFilter::isUsable(quality));
+}
+
+void test_all_zero_reading_is_rejected() {
+    SensorReading reading = makeReading(0.0f, 0.0f, 0.0f);
+    uint8_t quality = filter.apply(reading, true, 0);
+
+    // Zero pressure is outside the BME280 range; there is nothing to hold yet
+    TEST_ASSERT_TRUE(quality & SENSOR_QUALITY_OUT_OF_RANGE);
+    TEST_ASSERT_TRUE(quality & SENSOR_QUALITY_PRESSURE_HELD);
+    TEST_ASSERT_TRUE(quality & SENSOR_QUALITY_NO_DATA);
+    TEST_ASSERT_FALSE(SensorFilter::isUsable(quality));
+    TEST_ASSERT_TRUE(isnan(reading.pressure));
+
+    // A good sample afterwards is used immediately
+    reading = makeReading(20.0f, 40.0f, 1000.0f);
+    quality = filter.apply(reading, true, 5000);
+    TEST_ASSERT_TRUE(SensorFilter::isUsable(quality));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1000.0f, reading.pressure);
+}
+
+void test_read_error_holds_last_good_values() {
+    SensorReading reading = makeReading(20.0f, 40.0f, 1000.0f);
+    filter.apply(reading, true, 0);
+
+    reading = makeReading(NAN, NAN, NAN);
+    uint8_t quality = filter.apply(reading, false, 5000);
+
+    TEST_ASSERT_TRUE(quality & SENSOR_QUALITY_READ_ERROR);
+    TEST_ASSERT_EQUAL_HEX8(SENSOR_QUALITY_TEMPERATURE_HELD | SENSOR_QUALITY_HUMIDITY_HELD |
+                           SENSOR_QUALITY_PRESSURE_HELD,
+                           quality & 0x07);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, reading.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1000.0f, reading.pressure);
+}
+
+void test_spike_is_rejected_by_rate_limit() {
+    uint32_t now = 0;
+    for (int i = 0; i < SENSOR_FILTER_WINDOW; i++, now += 5000) {
+        SensorReading reading = makeReading(20.0f, 40.0f, 1000.0f);
+        filter.apply(reading, true, now);
+    }
+
+    // 15 °C in 5 s is far beyond the default 0.5 °C/s
+    SensorReading reading = makeReading(35.0f, 40.0f, 1000.0f);
+    uint8_t quality = filter.apply(reading, true, now);
+
+    TEST_ASSERT_EQUAL_HEX8(SENSOR_QUALITY_RATE_LIMITED | SENSOR_QUALITY_TEMPERATURE_HELD, quality);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.0f, reading.temperature);
+}
+
+void test_persistent_step_is_accepted() {
+    SensorReading reading = makeReading(20.0f, 40.0f, 1000.0f);
+    filter.apply(reading, true, 0);
+
+    uint8_t quality = 0;
+    for (int i = 1; i <= SENSOR_FILTER_MAX_REJECTS; i++) {
+        reading = makeReading(20.0f, 40.0f, 990.0f);
+        quality = filter.apply(reading, true, i * 100);
+    }
+
+    // The last repetition restarts the channel at the new level
+    TEST_ASSERT_FALSE(quality & SENSOR_QUALITY_RATE_LIMITED);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 990.0f, reading.pressure);
+}
+
+void test_median_removes_small_glitch() {
+    SensorChannelLimits wide = { -40.0f, 85.0f, 100.0f, 100.0f };
+    filter.setLimits(SENSOR_CHANNEL_TEMPERATURE, wide);
+
+    const float samples[] = { 20.0f, 20.2f, 24.0f, 20.1f };
+    SensorReading reading;
+    for (int i = 0; i < 4; i++) {
+        reading = makeReading(samples[i], 40.0f, 1000.0f);
+        filter.apply(reading, true, i * 1000);
+    }
+
+    // Window {20.2, 24.0, 20.1}: the glitch never reaches the output
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 20.2f, reading.temperature);
+    TEST_ASSERT_EQUAL_HEX8(0, reading.quality);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_first_valid_sample_passes_through);
+    RUN_TEST(test_all_zero_reading_is_rejected);
+    RUN_TEST(test_read_error_holds_last_good_values);
+    RUN_TEST(test_spike_is_rejected_by_rate_limit);
+    RUN_TEST(test_persistent_step_is_accepted);
+    RUN_TEST(test_median_removes_small_glitch);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,462 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "SensorManager.h"
+#include "FakeBME280.h"
+#include "DisplayManager.h"
+
+// Runs the whole sensing stack on the host: SensorManager builds against the
+// Arduino shim in test/host, talks to a FakeBME280 over FakeI2CBus and all
+// delays and bus transfers advance the same virtual clock.
+
+// Five minutes indoors at 10 s intervals, raw values for the datasheet example
+// calibration (27.00-27.14 °C, 36.2-35.9 %RH, 996.8 hPa)
+static const char INDOOR_TRACE[] =
+    "time_ms,adc_T,adc_P,adc_H\n"
+    "0,526024,422493,26689\n"
+    "10000,526072,422537,26695\n"
+    "20000,526072,422536,26693\n"
+    "30000,526088,422507,26683\n"
+    "40000,526104,422543,26689\n"
+    "50000,526096,422523,26683\n"
+    "60000,526120,422513,26678\n"
+    "70000,526136,422548,26684\n"
+    "80000,526168,422555,26682\n"
+    "90000,526160,422536,26676\n"
+    "100000,526168,422553,26678\n"
+    "110000,526184,422524,26668\n"
+    "120000,526200,422560,26676\n"
+    "130000,526224,422549,26670\n"
+    "140000,526224,422548,26668\n"
+    "150000,526224,422547,26666\n"
+    "160000,526256,422554,26664\n"
+    "170000,526264,422571,26666\n"
+    "180000,526280,422543,26656\n"
+    "190000,526288,422560,26658\n"
+    "200000,526296,422577,26660\n"
+    "210000,526328,422584,26659\n"
+    "220000,526312,422547,26648\n"
+    "230000,526360,422591,26655\n"
+    "240000,526352,422572,26651\n"
+    "250000,526392,422598,26653\n"
+    "260000,526384,422578,26647\n"
+    "270000,526392,422595,26649\n"
+    "280000,526416,422584,26643\n"
+    "290000,526416,422583,26641\n"
+    "300000,526448,422591,26639\n";
+
+static FakeI2CBus bus;
+static FakeBME280 sensor;
+
+// Compensates trace rows for comparison with what SensorManager reports
+static I2CEngine referenceEngine(nullptr);
+static BME280Driver reference(referenceEngine);
+
+// Level that switches the emulated VEXT on, and the level last written
+static bool vextActiveHigh;
+static uint8_t vextLevel;
+
+// Bit-banged SCL clocks reach the bus, VEXT switches the sensor supply
+static void pinHook(uint8_t pin, uint8_t level) {
+    if (pin == I2C_SCL) bus.clockScl(level);
+    if (pin == VEXT_PIN) {
+        vextLevel = level;
+        sensor.setPowered(level == (vextActiveHigh ? HIGH : LOW));
+    }
+}
+
+// A slave stuck mid-byte holds SDA low
+static uint8_t pinReadHook(uint8_t pin) {
+    return pin == I2C_SDA && bus.isStuck() ? LOW : HIGH;
+}
+
+static float channel(const BME280RawData& raw, int index) {
+    BME280Sample sample = {};
+    reference.compensate(raw, sample);
+    switch (index) {
+        case 0:  return sample.temperature / 100.0F;
+        case 1:  return sample.humidity / 1024.0F;
+        default: return sample.pressure / 25600.0F;
+    }
+}
+
+// The 3-sample median reports one of the last three conversions
+static bool withinRecentRows(const SensorReading& reading, size_t row) {
+    const float values[3] = { reading.temperature, reading.humidity, reading.pressure };
+    for (int c = 0; c < 3; c++) {
+        float low = INFINITY;
+        float high = -INFINITY;
+        for (size_t r = row >= 2 ? row - 2 : 0; r <= row; r++) {
+            float value = channel(sensor.getTraceRow(r).raw, c);
+            low = fminf(low, value);
+            high = fmaxf(high, value);
+        }
+        if (values[c] < low - 0.01F || values[c] > high + 0.01F) return false;
+    }
+    return true;
+}
+
+void setUp(void) {
+    I2CEngine::setClock(FakeI2CBus::now);
+    bus = FakeI2CBus();
+    sensor = FakeBME280();
+    bus.attach(BME_ADDRESS, &sensor);
+    sensor.loadTrace(INDOOR_TRACE);
+    vextActiveHigh = VEXT_ACTIVE_HIGH;
+    hostSetPinHook(pinHook);
+    hostSetPinReadHook(pinReadHook);
+    hostSetWakeupCause(ESP_SLEEP_WAKEUP_UNDEFINED);
+
+    BME280Calibration calib;
+    BME280Driver::parseCalibration(&sensor.regs[BME280_REG_CALIB_TP], &sensor.regs[BME280_REG_CALIB_H], calib);
+    reference.restore(BME_ADDRESS, calib);
+}
+
+void tearDown(void) {
+    hostSetPinHook(nullptr);
+    hostSetPinReadHook(nullptr);
+}
+
+void test_trace_parsing() {
+    TEST_ASSERT_EQUAL(31, sensor.getTraceLength());
+    TEST_ASSERT_EQUAL_UINT32(300000, sensor.getTraceRow(30).timeMs);
+    TEST_ASSERT_EQUAL_INT32(526448, sensor.getTraceRow(30).raw.adcT);
+    TEST_ASSERT_EQUAL_INT32(26639, sensor.getTraceRow(30).raw.adcH);
+    TEST_ASSERT_EQUAL_UINT32(10000, sensor.rowAt(19999)->timeMs);
+
+    static FakeBME280 other;
+    TEST_ASSERT_EQUAL(2, other.loadTrace("# comment\n0,1,2,3\r\n  500, 4, 5, 6"));
+    TEST_ASSERT_EQUAL(0, other.loadTrace("0,1,2\n"));
+    TEST_ASSERT_EQUAL(0, other.loadTrace("0,1,2,-3\n"));
+
+    // X2/X16/X1 oversampling, the high-precision profile
+    TEST_ASSERT_EQUAL_UINT32(46100, FakeBME280::measurementTimeUs(0x01, (2 << 5) | (5 << 2) | 3));
+}
+
+void test_cold_start_replays_trace() {
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_FALSE(sensors.isWarmStart());
+    TEST_ASSERT_EQUAL_HEX8(BME_ADDRESS, sensors.getBME280().getAddress());
+    TEST_ASSERT_EQUAL_UINT8(BME280Driver::MODE_NORMAL, sensor.getMode());
+    TEST_ASSERT_EQUAL_UINT32(1, sensor.getResetCount());
+
+    // The verification read in begin() latched the first row
+    SensorReading reading;
+    TEST_ASSERT_TRUE(sensors.read(reading));
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, channel(sensor.getTraceRow(0).raw, 0), reading.temperature);
+
+    // One read per recorded row, in step with the recording
+    size_t checked = 0;
+    for (size_t row = 1; row < sensor.getTraceLength(); row++) {
+        FakeI2CBus::advance(10000 * 1000);
+        TEST_ASSERT_TRUE(sensors.read(reading));
+        TEST_ASSERT_EQUAL_HEX8(0, reading.quality & ~SENSOR_QUALITY_WARMING_UP);
+        TEST_ASSERT_TRUE(withinRecentRows(reading, row));
+        checked++;
+    }
+    TEST_ASSERT_EQUAL(30, checked);
+    TEST_ASSERT_EQUAL_UINT32(32, sensor.getConversionCount());
+
+    printf("\n  cold start: %u ms, %u transfers\n", (unsigned)(sensors.getBeginDurationUs() / 1000),
+           (unsigned)bus.getTransferCount());
+}
+
+void test_nacks_are_retried() {
+    // The first two detection attempts are NACKed
+    sensor.injectNack(2);
+    SensorManager sensors(bus);
+    uint32_t start = micros();
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    uint32_t retried = micros() - start;
+    TEST_ASSERT_EQUAL_HEX8(BME_ADDRESS, sensors.getBME280().getAddress());
+
+    // Two retry pauses (and two probes of the alternate address) on top of a clean start
+    start = micros();
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    uint32_t clean = micros() - start;
+    TEST_ASSERT_UINT32_WITHIN(2000, 2 * I2C_RECOVERY_RETRY_MS * 1000, retried - clean);
+
+    const I2CDeviceHealth* device = sensors.getHealth().getDevice(BME_ADDRESS);
+    TEST_ASSERT_NOT_NULL(device);
+    TEST_ASSERT_EQUAL_UINT32(2, device->nacks);
+    TEST_ASSERT_EQUAL_UINT32(0, device->timeouts);
+    TEST_ASSERT_EQUAL_UINT16(2, device->maxConsecutiveFailures);
+    TEST_ASSERT_EQUAL_UINT32(2, sensors.getHealth().getBusHealth().steps[I2C_RECOVERY_RETRY]);
+    TEST_ASSERT_EQUAL_UINT32(0, sensors.getHealth().getBusHealth().steps[I2C_RECOVERY_CLOCK_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.getHealth().getBusHealth().recovered);
+
+    // NACKs on every attempt: the whole ladder is tried, then begin gives up
+    sensor.injectNack(1000);
+    TEST_ASSERT_FALSE(sensors.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_FALSE(sensors.isBME280Available());
+    const I2CBusHealth& health = sensors.getHealth().getBusHealth();
+    TEST_ASSERT_EQUAL_UINT32(4, health.steps[I2C_RECOVERY_RETRY]);
+    TEST_ASSERT_EQUAL_UINT32(1, health.steps[I2C_RECOVERY_CLOCK_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(1, health.steps[I2C_RECOVERY_REINIT]);
+    TEST_ASSERT_EQUAL_UINT32(1, health.steps[I2C_RECOVERY_POWER_CYCLE]);
+    TEST_ASSERT_EQUAL_UINT32(1, health.abandoned);
+    TEST_ASSERT_EQUAL_UINT32(2, sensor.getPowerUpCount());
+
+    SensorReading reading;
+    TEST_ASSERT_FALSE(sensors.read(reading));
+    TEST_ASSERT_BITS_HIGH(SENSOR_QUALITY_READ_ERROR | SENSOR_QUALITY_NO_DATA, reading.quality);
+}
+
+void test_alternate_address() {
+    bus.attach(BME_ADDRESS, nullptr);
+    bus.attach(0x77, &sensor);
+
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_EQUAL_HEX8(0x77, sensors.getBME280().getAddress());
+}
+
+void test_stuck_bus_is_clocked_out() {
+    // Left stuck by a reset in the middle of a read: detection times out,
+    // SDA reads low and the clock-out releases the slave without retries
+    bus.injectStuckBus();
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_FALSE(bus.isStuck());
+
+    const I2CDeviceHealth* device = sensors.getHealth().getDevice(BME_ADDRESS);
+    TEST_ASSERT_EQUAL_UINT32(1, device->timeouts);
+    TEST_ASSERT_EQUAL_UINT32(1, device->stuckDetections);
+    TEST_ASSERT_EQUAL_UINT32(0, sensors.getHealth().getBusHealth().steps[I2C_RECOVERY_RETRY]);
+    TEST_ASSERT_EQUAL_UINT32(1, sensors.getHealth().getBusHealth().steps[I2C_RECOVERY_CLOCK_OUT]);
+    TEST_ASSERT_EQUAL_UINT32(1, sensor.getPowerUpCount());
+
+    // Stuck while running: reads time out and report the held values
+    SensorReading good;
+    TEST_ASSERT_TRUE(sensors.read(good));
+    bus.injectStuckBus();
+    uint32_t start = micros();
+    SensorReading reading;
+    TEST_ASSERT_TRUE(sensors.read(reading));
+    uint32_t elapsed = micros() - start;
+    TEST_ASSERT_UINT32_WITHIN(2000, I2C_ENGINE_TIMEOUT_MS * 1000, elapsed);
+    TEST_ASSERT_BITS_HIGH(SENSOR_QUALITY_READ_ERROR, reading.quality);
+    TEST_ASSERT_EQUAL_FLOAT(good.temperature, reading.temperature);
+
+    // One recovery step per failed read
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_CLOCK_OUT, sensors.recoverBus(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_FALSE(bus.isStuck());
+    FakeI2CBus::advance(1000 * 1000);
+    TEST_ASSERT_TRUE(sensors.read(reading));
+    TEST_ASSERT_EQUAL_HEX8(0, reading.quality & SENSOR_QUALITY_READ_ERROR);
+    TEST_ASSERT_EQUAL_UINT32(2, device->stuckDetections);
+    TEST_ASSERT_EQUAL_UINT32(2, sensors.getHealth().getBusHealth().recovered);
+    TEST_ASSERT_EQUAL(I2C_RECOVERY_NONE, sensors.recoverBus(I2C_SDA, I2C_SCL));
+}
+
+void test_stuck_bus_without_clock_out_fails() {
+    // Without the bit-banged clocks (and VEXT) every step fails; the bus
+    // scan is skipped because each of its probes would time out too
+    hostSetPinHook(nullptr);
+    bus.injectStuckBus();
+    SensorManager sensors(bus);
+    TEST_ASSERT_FALSE(sensors.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_TRUE(bus.isStuck());
+    TEST_ASSERT_LESS_THAN(10 * I2C_ENGINE_TIMEOUT_MS * 1000 + 1000000, sensors.getBeginDurationUs());
+    TEST_ASSERT_LESS_THAN(10, bus.getTransferCount());
+
+    const I2CBusHealth& health = sensors.getHealth().getBusHealth();
+    TEST_ASSERT_EQUAL_UINT32(0, health.steps[I2C_RECOVERY_RETRY]);
+    TEST_ASSERT_EQUAL_UINT32(1, health.steps[I2C_RECOVERY_POWER_CYCLE]);
+    TEST_ASSERT_EQUAL_UINT32(1, health.abandoned);
+    TEST_ASSERT_EQUAL_UINT32(4, sensors.getHealth().getDevice(BME_ADDRESS)->timeouts);
+    TEST_ASSERT_EQUAL_UINT32(4, sensors.getHealth().getDevice(0x77)->timeouts);
+}
+
+static uint32_t asyncCount;
+
+static void countReading(bool success, const SensorReading& reading, void* context) {
+    (void)reading;
+    (void)context;
+    if (success) asyncCount++;
+}
+
+void test_forced_profile_waits_exactly() {
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.setProfile(SENSOR_PROFILE_LOW_POWER));
+    TEST_ASSERT_EQUAL_UINT32(9300, sensors.getMeasurementUs());
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_EQUAL_UINT8(BME280Driver::MODE_SLEEP, sensor.getMode());
+    TEST_ASSERT_EQUAL_UINT32(1, sensor.getConversionCount());
+
+    // Each read starts one conversion and waits its worst-case time, no longer
+    SensorReading reading;
+    for (size_t row = 1; row < sensor.getTraceLength(); row++) {
+        FakeI2CBus::advance(10000 * 1000);
+        uint32_t start = micros();
+        TEST_ASSERT_TRUE(sensors.read(reading));
+        uint32_t elapsed = micros() - start;
+        TEST_ASSERT_EQUAL_UINT32(row + 1, sensor.getConversionCount());
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(9300, elapsed);
+        TEST_ASSERT_LESS_THAN(9300 + 2000, elapsed);
+        TEST_ASSERT_TRUE(withinRecentRows(reading, row));
+        TEST_ASSERT_EQUAL_UINT8(BME280Driver::MODE_SLEEP, sensor.getMode());
+    }
+
+    // Queued reads return the conversion started by the previous request
+    asyncCount = 0;
+    uint32_t conversions = sensor.getConversionCount();
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(sensors.requestReading(countReading));
+        sensors.poll();
+        FakeI2CBus::advance(sensors.getMeasurementUs());
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, asyncCount);
+    TEST_ASSERT_EQUAL_UINT32(conversions + 2, sensor.getConversionCount());
+
+    // A read right after a request only waits for the rest of that conversion
+    TEST_ASSERT_TRUE(sensors.requestReading(countReading));
+    sensors.poll();
+    uint32_t start = micros();
+    TEST_ASSERT_TRUE(sensors.read(reading));
+    TEST_ASSERT_LESS_THAN(9300 + 2000, micros() - start);
+    TEST_ASSERT_EQUAL_UINT32(conversions + 4, sensor.getConversionCount());
+
+    // Switching back to normal mode while running
+    TEST_ASSERT_TRUE(sensors.setProfile(SENSOR_PROFILE_HIGH_PRECISION));
+    TEST_ASSERT_EQUAL_UINT8(BME280Driver::MODE_NORMAL, sensor.getMode());
+    TEST_ASSERT_EQUAL_UINT32(46100, sensors.getMeasurementUs());
+}
+
+void test_zero_readings_are_rejected() {
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    SensorReading good;
+    for (int i = 0; i < SENSOR_FILTER_WINDOW; i++) {
+        FakeI2CBus::advance(1000 * 1000);
+        TEST_ASSERT_TRUE(sensors.read(good));
+    }
+
+    // An all-zero burst compensates to about -140 °C
+    sensor.injectZeros(1);
+    FakeI2CBus::advance(1000 * 1000);
+    SensorReading reading;
+    TEST_ASSERT_TRUE(sensors.read(reading));
+    TEST_ASSERT_BITS_HIGH(SENSOR_QUALITY_OUT_OF_RANGE | SENSOR_QUALITY_TEMPERATURE_HELD, reading.quality);
+    TEST_ASSERT_EQUAL_FLOAT(good.temperature, reading.temperature);
+
+    FakeI2CBus::advance(1000 * 1000);
+    TEST_ASSERT_TRUE(sensors.read(reading));
+    TEST_ASSERT_EQUAL_HEX8(0, reading.quality);
+}
+
+void test_warm_wake_and_power_cycle() {
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    uint32_t coldUs = sensors.getBeginDurationUs();
+    uint32_t coldTransfers = bus.getTransferCount();
+
+    // VEXT is off during deep sleep; the wake reuses address and calibration
+    sensors.powerCycleBME280();
+    TEST_ASSERT_TRUE(sensor.isPowered());
+    TEST_ASSERT_EQUAL_UINT32(2, sensor.getPowerUpCount());
+    TEST_ASSERT_EQUAL_UINT8(BME280Driver::MODE_SLEEP, sensor.getMode());
+
+    hostSetWakeupCause(ESP_SLEEP_WAKEUP_TIMER);
+    SensorManager woken(bus);
+    uint32_t before = bus.getTransferCount();
+    TEST_ASSERT_TRUE(woken.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_TRUE(woken.isWarmStart());
+    TEST_ASSERT_EQUAL_UINT32(1, sensor.getResetCount());  // No soft reset or detection
+    uint32_t warmTransfers = bus.getTransferCount() - before;
+
+    printf("\n  cold start %u ms / %u transfers, warm start %u ms / %u transfers\n",
+           (unsigned)(coldUs / 1000), (unsigned)coldTransfers,
+           (unsigned)(woken.getBeginDurationUs() / 1000), (unsigned)warmTransfers);
+    // Both wait for the first conversion; the warm start skips the reset and trim read
+    TEST_ASSERT_LESS_THAN(coldUs, woken.getBeginDurationUs());
+    TEST_ASSERT_LESS_THAN(coldTransfers / 2, warmTransfers);
+}
+
+void test_power_cycle_with_inverted_vext() {
+    // A board where LOW switches VEXT on
+    vextActiveHigh = !VEXT_ACTIVE_HIGH;
+    SensorManager sensors(bus);
+    sensors.setVextActiveHigh(vextActiveHigh);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+
+    sensors.powerCycleBME280();
+    TEST_ASSERT_TRUE(sensor.isPowered());
+    TEST_ASSERT_EQUAL_UINT32(2, sensor.getPowerUpCount());
+
+    // Without the setting the cycle ends with the sensor unpowered
+    SensorManager mismatched(bus);
+    mismatched.powerCycleBME280();
+    TEST_ASSERT_FALSE(sensor.isPowered());
+}
+
+void test_vext_stays_on_in_setup_order() {
+    const uint8_t on = VEXT_ACTIVE_HIGH ? HIGH : LOW;
+
+    // setup(): VEXT on, sensor begin, then display begin on the same rail
+    digitalWrite(VEXT_PIN, on);
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    DisplayManager display;
+    display.begin();
+    TEST_ASSERT_EQUAL_UINT8(on, vextLevel);
+    TEST_ASSERT_TRUE(sensor.isPowered());
+
+    // readSensors(): the last recovery step, then the panel it also reset
+    sensors.powerCycleBME280();
+    display.restartController();
+    TEST_ASSERT_EQUAL_UINT8(on, vextLevel);
+    TEST_ASSERT_TRUE(sensor.isPowered());
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+}
+
+void test_warm_wake_with_sensor_still_configured() {
+    SensorManager sensors(bus);
+    TEST_ASSERT_TRUE(sensors.begin(I2C_SDA, I2C_SCL));
+    uint32_t coldUs = sensors.getBeginDurationUs();
+
+    // VEXT stayed on: the sensor is still converting with the profile
+    hostSetWakeupCause(ESP_SLEEP_WAKEUP_TIMER);
+    SensorManager woken(bus);
+    uint32_t before = bus.getTransferCount();
+    uint32_t conversions = sensor.getConversionCount();
+    TEST_ASSERT_TRUE(woken.begin(I2C_SDA, I2C_SCL));
+    TEST_ASSERT_TRUE(woken.isWarmStart());
+    TEST_ASSERT_EQUAL_UINT32(1, bus.getTransferCount() - before);
+    TEST_ASSERT_EQUAL_UINT8(BME280Driver::MODE_NORMAL, sensor.getMode());
+    printf("\n  cold start %u ms, warm start with the sensor configured %u us\n",
+           (unsigned)(coldUs / 1000), (unsigned)woken.getBeginDurationUs());
+    TEST_ASSERT_LESS_THAN(coldUs / 10, woken.getBeginDurationUs());
+
+    // Its first reading is the conversion the sensor already finished
+    FakeI2CBus::advance(10 * 1000);
+    SensorReading reading;
+    TEST_ASSERT_TRUE(woken.read(reading));
+    TEST_ASSERT_EQUAL_HEX8(SENSOR_QUALITY_WARMING_UP, reading.quality);
+    TEST_ASSERT_TRUE(sensor.getConversionCount() > conversions);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_trace_parsing);
+    RUN_TEST(test_cold_start_replays_trace);
+    RUN_TEST(test_nacks_are_retried);
+    RUN_TEST(test_alternate_address);
+    RUN_TEST(test_stuck_bus_is_clocked_out);
+    RUN_TEST(test_stuck_bus_without_clock_out_fails);
+    RUN_TEST(test_forced_profile_waits_exactly);
+    RUN_TEST(test_zero_readings_are_rejected);
+    RUN_TEST(test_warm_wake_and_power_cycle);
+    RUN_TEST(test_power_cycle_with_inverted_vext);
+    RUN_TEST(test_vext_stays_on_in_setup_order);
+    RUN_TEST(test_warm_wake_with_sensor_still_configured);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "SeriesCodec.h"
+
+// A day at the 60 s ULP period: temperature, humidity and pressure in hundredths
+#define TRACE_SAMPLES 1440
+#define TRACE_CHANNELS 3
+
+static int32_t trace[TRACE_SAMPLES][TRACE_CHANNELS];
+
+// Indoor day starting from the reading in logs/device-monitor-250410-133157.log
+// (27.01 °C, 36.18 %RH, 996.75 hPa), with BME280 noise after oversampling and
+// the IIR filter (about one LSB of the hundredths; pressure a little more)
+static void buildTrace() {
+    uint32_t seed = 42;
+    for (int i = 0; i < TRACE_SAMPLES; i++) {
+        double hours = i / 60.0;
+        double temperature = 27.01 - 2.0 * (1.0 - cos(hours * M_PI / 12.0)) / 2.0;
+        double humidity = 36.18 + 4.0 * (1.0 - cos(hours * M_PI / 12.0)) / 2.0;
+        double pressure = 996.75 + 1.5 * sin(hours * M_PI / 24.0);
+
+        seed = seed * 1103515245 + 12345;
+        int noise = (int)((seed >> 16) % 5) - 2;
+
+        trace[i][0] = (int32_t)lround(temperature * 100.0) + noise / 2;  // ±0.01 °C
+        trace[i][1] = (int32_t)lround(humidity * 100.0) + noise / 2;     // ±0.01 %RH
+        trace[i][2] = (int32_t)lround(pressure * 100.0) + noise;         // ±2 Pa
+    }
+}
+
+struct CodecResult {
+    size_t frames;
+    size_t bytes;
+    double encodeNs;  // Per sample
+    int decodedSamples;
+    bool roundTrip;
+};
+
+// Encode the whole trace into as many frames as needed, checking each round trip
+static CodecResult encodeTrace(uint8_t orderMask) {
+    SeriesEncoder encoder(TRACE_CHANNELS, 60, orderMask);
+    CodecResult result = { 0, 0, 0.0, 0, true };
+    int32_t decoded[255 * TRACE_CHANNELS];
+    int first = 0;
+
+    struct timespec start, end;
+    double encodeSeconds = 0.0;
+
+    for (int i = 0; i <= TRACE_SAMPLES; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool added = i < TRACE_SAMPLES && encoder.append(trace[i]);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        encodeSeconds += (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        if (added) continue;
+
+        // Frame full (or trace done): "send" it and decode it like the backend would
+        uint8_t channels = 0;
+        uint16_t period = 0;
+        int samples = SeriesDecoder::decode(encoder.data(), encoder.size(), decoded,
+                                            sizeof(decoded) / sizeof(decoded[0]), &channels, &period);
+        result.roundTrip = result.roundTrip && samples == encoder.count() && channels == TRACE_CHANNELS && period == 60 &&
+                    memcmp(decoded, trace[first], samples * TRACE_CHANNELS * sizeof(int32_t)) == 0;
+
+        result.frames++;
+        result.bytes += encoder.size();
+        first += encoder.count();
+        encoder.reset();
+        if (i < TRACE_SAMPLES) {
+            encoder.append(trace[i]);
+        }
+    }
+
+    result.decodedSamples = first;
+    result.encodeNs = encodeSeconds * 1e9 / TRACE_SAMPLES;
+    return result;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_zigzag_and_code_lengths() {
+    TEST_ASSERT_EQUAL_UINT32(0, SeriesEncoder::zigzag(0));
+    TEST_ASSERT_EQUAL_UINT32(1, SeriesEncoder::zigzag(-1));
+    TEST_ASSERT_EQUAL_UINT32(2, SeriesEncoder::zigzag(1));
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFF, SeriesEncoder::zigzag(INT32_MIN));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, SeriesEncoder::unzigzag(0xFFFFFFFF));
+    TEST_ASSERT_EQUAL_INT32(-3, SeriesEncoder::unzigzag(SeriesEncoder::zigzag(-3)));
+
+    TEST_ASSERT_EQUAL_UINT8(1, SeriesEncoder::codeLength(0));
+    TEST_ASSERT_EQUAL_UINT8(4, SeriesEncoder::codeLength(4));
+    TEST_ASSERT_EQUAL_UINT8(7, SeriesEncoder::codeLength(5));
+    TEST_ASSERT_EQUAL_UINT8(14, SeriesEncoder::codeLength(1044));
+    TEST_ASSERT_EQUAL_UINT8(4 + 5 + 11, SeriesEncoder::codeLength(1045));
+    TEST_ASSERT_EQUAL_UINT8(4 + 5 + 32, SeriesEncoder::codeLength(0xFFFFFFFF));
+}
+
+void test_frame_layout_and_extremes_round_trip() {
+    SeriesEncoder encoder(2, 300, 0x02);
+    const int32_t samples[][2] = {
+        { 2701, 99675 }, { 2701, 99676 }, { 2702, 99678 }, { INT32_MIN, INT32_MAX }, { INT32_MAX, INT32_MIN }, { 0, 0 }
+    };
+    for (const int32_t* sample : samples) {
+        TEST_ASSERT_TRUE(encoder.append(sample));
+    }
+
+    const uint8_t header[] = { 0x12, 0x02, 6, 0x01, 0x2C };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(header, encoder.data(), sizeof(header));
+
+    int32_t decoded[12];
+    uint8_t channels = 0;
+    uint16_t period = 0;
+    TEST_ASSERT_EQUAL(6, SeriesDecoder::decode(encoder.data(), encoder.size(), decoded, 12, &channels, &period));
+    TEST_ASSERT_EQUAL_UINT8(2, channels);
+    TEST_ASSERT_EQUAL_UINT16(300, period);
+    TEST_ASSERT_EQUAL_MEMORY(samples, decoded, sizeof(decoded));
+
+    // Truncated frames and small output buffers are rejected
+    TEST_ASSERT_EQUAL(-1, SeriesDecoder::decode(encoder.data(), encoder.size() - 4, decoded, 12, &channels, &period));
+    TEST_ASSERT_EQUAL(-1, SeriesDecoder::decode(encoder.data(), encoder.size(), decoded, 10, &channels, &period));
+}
+
+void test_full_frame_rejects_sample_unchanged() {
+    SeriesEncoder encoder(3, 60);
+    int32_t noisy[3] = { 0, 0, 0 };
+    uint32_t seed = 7;
+    int appended = 0;
+    while (true) {
+        for (int c = 0; c < 3; c++) {
+            seed = seed * 1103515245 + 12345;
+            noisy[c] = (int32_t)(seed >> 8);
+        }
+        if (!encoder.append(noisy)) break;
+        appended++;
+    }
+
+    // Random 24-bit values escape at up to 33 bits per channel
+    TEST_ASSERT_GREATER_OR_EQUAL((SERIES_MAX_BYTES - SERIES_HEADER_BYTES) * 8 / (3 * 33), appended);
+    size_t size = encoder.size();
+    TEST_ASSERT_FALSE(encoder.append(noisy));
+    TEST_ASSERT_EQUAL(size, encoder.size());
+    TEST_ASSERT_EQUAL(appended, encoder.count());
+
+    encoder.reset();
+    TEST_ASSERT_TRUE(encoder.isEmpty());
+    TEST_ASSERT_EQUAL(SERIES_HEADER_BYTES, encoder.size());
+}
+
+void test_benchmark_compression() {
+    buildTrace();
+
+    // Uncompressed: 2 bytes per channel, as in the single-reading uplink
+    const size_t rawBytes = TRACE_SAMPLES * TRACE_CHANNELS * 2;
+    const size_t rawFrames = (TRACE_SAMPLES + (SERIES_MAX_BYTES / 6) - 1) / (SERIES_MAX_BYTES / 6);
+
+    CodecResult delta = encodeTrace(0x00);
+    CodecResult deltaOfDelta = encodeTrace(0x07);
+    CodecResult mixed = encodeTrace(0x04);  // Delta-of-delta only for the smooth pressure
+
+    printf("\n  raw            %5u bytes  %3u frames\n", (unsigned)rawBytes, (unsigned)rawFrames);
+    const char* names[] = { "delta", "delta-of-delta", "mixed" };
+    const CodecResult* results[] = { &delta, &deltaOfDelta, &mixed };
+    for (int i = 0; i < 3; i++) {
+        printf("  %-14s %5u bytes  %3u frames  ratio %.2f  %.2f bits/sample  %.0f ns/sample\n", names[i],
+               (unsigned)results[i]->bytes, (unsigned)results[i]->frames, (double)rawBytes / results[i]->bytes,
+               results[i]->bytes * 8.0 / TRACE_SAMPLES, results[i]->encodeNs);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(results[i]->roundTrip);
+        TEST_ASSERT_EQUAL(TRACE_SAMPLES, results[i]->decodedSamples);
+    }
+    TEST_ASSERT_LESS_THAN(rawBytes / 3, delta.bytes);
+    TEST_ASSERT_LESS_THAN(rawFrames / 3, delta.frames);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_zigzag_and_code_lengths);
+    RUN_TEST(test_frame_layout_and_extremes_round_trip);
+    RUN_TEST(test_full_frame_rejects_sample_unchanged);
+    RUN_TEST(test_benchmark_compression);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
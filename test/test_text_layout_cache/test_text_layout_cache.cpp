@@ -0,0 +1,80 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "TextLayoutCache.h"
+
+static TextLayoutCache cache;
+static int measured;
+
+static const uint8_t fontA[] = { 6 };
+static const uint8_t fontB[] = { 5 };
+
+// Monospace stand-in for U8G2::getStrWidth() that counts its calls
+static int measure(const char* text, void* context) {
+    measured++;
+    return (int)strlen(text) * ((const uint8_t*)context)[0];
+}
+
+static int width(const uint8_t* font, const char* text) {
+    return cache.width(font, text, measure, (void*)font);
+}
+
+void setUp(void) {
+    cache.clear();
+    measured = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_repeated_text_is_measured_once() {
+    TEST_ASSERT_EQUAL_INT(84, width(fontA, "LoRaWAN Status"));
+    TEST_ASSERT_EQUAL_INT(84, width(fontA, "LoRaWAN Status"));
+    TEST_ASSERT_EQUAL_INT(84, width(fontA, "LoRaWAN Status"));
+    TEST_ASSERT_EQUAL_INT(1, measured);
+    TEST_ASSERT_EQUAL_UINT32(2, cache.getHits());
+    TEST_ASSERT_EQUAL_UINT32(1, cache.getMisses());
+
+    // Empty text is never measured
+    TEST_ASSERT_EQUAL_INT(0, width(fontA, ""));
+    TEST_ASSERT_EQUAL_INT(0, width(fontA, nullptr));
+    TEST_ASSERT_EQUAL_INT(1, measured);
+}
+
+void test_font_is_part_of_the_key() {
+    TEST_ASSERT_EQUAL_INT(60, width(fontA, "Humidity:0"));
+    TEST_ASSERT_EQUAL_INT(50, width(fontB, "Humidity:0"));
+    TEST_ASSERT_EQUAL_INT(2, measured);
+    TEST_ASSERT_EQUAL_UINT8(2, cache.size());
+}
+
+void test_full_cache_replaces_oldest() {
+    char text[8];
+    for (int i = 0; i < TextLayoutCache::ENTRIES + 1; i++) {
+        snprintf(text, sizeof(text), "v%d", i);
+        width(fontA, text);
+    }
+    TEST_ASSERT_EQUAL_UINT8(TextLayoutCache::ENTRIES, cache.size());
+
+    // "v0" was replaced by the last one, "v1" is still there
+    measured = 0;
+    width(fontA, "v1");
+    TEST_ASSERT_EQUAL_INT(0, measured);
+    width(fontA, "v0");
+    TEST_ASSERT_EQUAL_INT(1, measured);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_repeated_text_is_measured_once);
+    RUN_TEST(test_font_is_part_of_the_key);
+    RUN_TEST(test_full_cache_replaces_oldest);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <unity.h>
+#include <math.h>
+#include "UlpSampler.h"
+#include "FakeI2CBus.h"
+
+// Bosch datasheet example calibration (see test_i2c_engine.cpp)
+static const uint8_t EXAMPLE_CALIB_TP[BME280_CALIB_TP_LEN] = {
+    0x70, 0x6B, 0x43, 0x67, 0x18, 0xFC,
+    0x7D, 0x8E, 0x43, 0xD6, 0xD0, 0x0B, 0x27, 0x0B,
+    0x8C, 0x00, 0xF9, 0xFF, 0x8C, 0x3C, 0xF8, 0xC6,
+    0x70, 0x17, 0x00, 0x4B
+};
+static const uint8_t EXAMPLE_CALIB_H[BME280_CALIB_H_LEN] = {
+    0x6A, 0x01, 0x00, 0x13, 0x2A, 0x03, 0x1E
+};
+
+static const BME280RawData REFERENCE = { 519888, 415148, 30000 };
+
+static FakeI2CBus bus;
+static I2CEngine engine(&bus);
+static BME280Driver driver(engine);
+
+static float compensated(const BME280RawData& raw, SensorChannel channel) {
+    BME280Sample sample;
+    if (!driver.compensate(raw, sample)) {
+        return NAN;
+    }
+    switch (channel) {
+        case SENSOR_CHANNEL_TEMPERATURE: return sample.temperature / 100.0F;
+        case SENSOR_CHANNEL_HUMIDITY:    return sample.humidity / 1024.0F;
+        default:                         return sample.pressure / 25600.0F;
+    }
+}
+
+void setUp(void) {
+    BME280Calibration calib;
+    BME280Driver::parseCalibration(EXAMPLE_CALIB_TP, EXAMPLE_CALIB_H, calib);
+    driver.restore(0x76, calib);
+}
+
+void tearDown(void) {
+}
+
+void test_truncated_samples_keep_useful_resolution() {
+    UlpRawSample sample = UlpSampler::truncate(REFERENCE);
+    BME280RawData expanded = UlpSampler::expand(sample);
+
+    TEST_ASSERT_EQUAL(REFERENCE.adcH, expanded.adcH);
+    TEST_ASSERT_FLOAT_WITHIN(0.02F, compensated(REFERENCE, SENSOR_CHANNEL_TEMPERATURE),
+                             compensated(expanded, SENSOR_CHANNEL_TEMPERATURE));
+    TEST_ASSERT_FLOAT_WITHIN(0.05F, compensated(REFERENCE, SENSOR_CHANNEL_PRESSURE),
+                             compensated(expanded, SENSOR_CHANNEL_PRESSURE));
+}
+
+void test_threshold_counts_match_physical_change() {
+    struct Case {
+        SensorChannel channel;
+        float delta;
+        int32_t scale;  // ADC LSBs per ULP count
+    };
+    const Case cases[] = {
+        { SENSOR_CHANNEL_TEMPERATURE, 0.5F, 16 },
+        { SENSOR_CHANNEL_HUMIDITY, 3.0F, 1 },
+        { SENSOR_CHANNEL_PRESSURE, 1.0F, 16 },
+    };
+
+    for (const Case& c : cases) {
+        uint16_t counts = UlpSampler::thresholdCounts(driver, REFERENCE, c.channel, c.delta);
+        TEST_ASSERT_GREATER_OR_EQUAL(1, counts);
+
+        // Moving the ADC value by the threshold moves the reading by about delta
+        BME280RawData moved = REFERENCE;
+        switch (c.channel) {
+            case SENSOR_CHANNEL_TEMPERATURE: moved.adcT += counts * c.scale; break;
+            case SENSOR_CHANNEL_HUMIDITY:    moved.adcH += counts * c.scale; break;
+            default:                         moved.adcP += counts * c.scale; break;
+        }
+        float change = fabsf(compensated(moved, c.channel) - compensated(REFERENCE, c.channel));
+        TEST_ASSERT_FLOAT_WITHIN(c.delta * 0.05F, c.delta, change);
+    }
+}
+
+void test_unreachable_threshold_saturates() {
+    TEST_ASSERT_EQUAL_UINT16(0x7FFF,
+        UlpSampler::thresholdCounts(driver, REFERENCE, SENSOR_CHANNEL_PRESSURE, 5000.0F));
+    TEST_ASSERT_EQUAL_UINT16(1,
+        UlpSampler::thresholdCounts(driver, REFERENCE, SENSOR_CHANNEL_TEMPERATURE, 0.0F));
+}
+
+void test_no_batch_without_ulp() {
+    UlpSampler ulp(driver);
+    ulp.stop();
+
+    SensorReading reading;
+    TEST_ASSERT_FALSE(ulp.wasActive());
+    TEST_ASSERT_EQUAL(0, ulp.getSampleCount());
+    TEST_ASSERT_EQUAL(ULP_WAKE_NONE, ulp.getWakeReason());
+    TEST_ASSERT_FALSE(ulp.getSample(0, reading));
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_truncated_samples_keep_useful_resolution);
+    RUN_TEST(test_threshold_counts_match_physical_change);
+    RUN_TEST(test_unreachable_threshold_saturates);
+    RUN_TEST(test_no_batch_without_ulp);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "VibrationAnalyzer.h"
+
+#define SAMPLE_RATE 3200.0F
+#define COUNTS_PER_G 400.0F
+#define MID_SCALE 2048
+
+static VibrationAnalyzer analyzer;
+static int16_t block[VIBRATION_FFT_SIZE];
+
+// Sum of sines in g around mid-scale, with optional deterministic noise
+static void synthesize(const float* frequencies, const float* amplitudes, int count, float noiseG) {
+    uint32_t seed = 1;
+    for (int n = 0; n < VIBRATION_FFT_SIZE; n++) {
+        double g = 0.0;
+        for (int i = 0; i < count; i++) {
+            g += amplitudes[i] * sin(2.0 * M_PI * frequencies[i] * n / SAMPLE_RATE);
+        }
+        seed = seed * 1103515245 + 12345;
+        g += noiseG * (((int)((seed >> 16) % 2001) - 1000) / 1000.0);
+        block[n] = (int16_t)lround(MID_SCALE + g * COUNTS_PER_G);
+    }
+}
+
+static double elapsedUs(const struct timespec& start, const struct timespec& end) {
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+void setUp(void) {
+    analyzer.begin(SAMPLE_RATE, 1.0F / COUNTS_PER_G);
+}
+
+void tearDown(void) {
+}
+
+void test_fft_matches_reference_dft() {
+    const float frequencies[] = { 73.0F, 410.5F, 1234.0F };
+    const float amplitudes[] = { 0.3F, 0.1F, 0.05F };
+    synthesize(frequencies, amplitudes, 3, 0.02F);
+
+    VibrationFeatures features;
+    analyzer.analyze(block, features);
+    const float* spectrum = analyzer.getSpectrum();
+
+    // Double-precision DFT of the same mean-removed, Hann-windowed block
+    double mean = 0.0;
+    for (int n = 0; n < VIBRATION_FFT_SIZE; n++) mean += block[n];
+    mean /= VIBRATION_FFT_SIZE;
+
+    double largest = 0.0;
+    double worst = 0.0;
+    for (int k = 0; k <= VIBRATION_FFT_SIZE / 2; k++) {
+        double re = 0.0;
+        double im = 0.0;
+        for (int n = 0; n < VIBRATION_FFT_SIZE; n++) {
+            double w = 0.5 - 0.5 * cos(2.0 * M_PI * n / VIBRATION_FFT_SIZE);
+            double x = (block[n] - mean) / COUNTS_PER_G * w;
+            re += x * cos(2.0 * M_PI * k * n / VIBRATION_FFT_SIZE);
+            im -= x * sin(2.0 * M_PI * k * n / VIBRATION_FFT_SIZE);
+        }
+        double reference = sqrt(re * re + im * im);
+        if (reference > largest) largest = reference;
+        double error = fabs(reference - spectrum[k]);
+        if (error > worst) worst = error;
+    }
+    TEST_ASSERT_LESS_THAN(largest * 1e-4, worst);
+}
+
+void test_peaks_and_rms() {
+    // 50 Hz and 312.5 Hz fall on bins 16 and 100
+    const float frequencies[] = { 312.5F, 50.0F };
+    const float amplitudes[] = { 0.2F, 0.5F };
+    synthesize(frequencies, amplitudes, 2, 0.0F);
+
+    VibrationFeatures features;
+    analyzer.analyze(block, features);
+
+    TEST_ASSERT_EQUAL_UINT8(VIBRATION_PEAKS, features.peakCount);
+    TEST_ASSERT_FLOAT_WITHIN(0.1F, 50.0F, features.peaks[0].frequency);
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.5F, features.peaks[0].amplitude);
+    TEST_ASSERT_FLOAT_WITHIN(0.1F, 312.5F, features.peaks[1].frequency);
+    TEST_ASSERT_FLOAT_WITHIN(0.01F, 0.2F, features.peaks[1].amplitude);
+
+    // Quantization leaves only tiny third peaks
+    TEST_ASSERT_LESS_THAN(0.01F, features.peaks[2].amplitude);
+
+    float rms = sqrtf((0.5F * 0.5F + 0.2F * 0.2F) / 2.0F);
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, rms, features.rms);
+}
+
+void test_off_bin_frequency_is_interpolated() {
+    const float frequencies[] = { 123.4F };
+    const float amplitudes[] = { 0.4F };
+    synthesize(frequencies, amplitudes, 1, 0.0F);
+
+    VibrationFeatures features;
+    analyzer.analyze(block, features);
+
+    // Bins are 3.125 Hz wide
+    TEST_ASSERT_FLOAT_WITHIN(0.5F, 123.4F, features.peaks[0].frequency);
+    TEST_ASSERT_FLOAT_WITHIN(0.4F * 0.1F, 0.4F, features.peaks[0].amplitude);
+}
+
+void test_band_energies_add_up_to_variance() {
+    // Default bands at 3.2 kHz: 1-20, 20-100, 100-400, 400-1600 Hz
+    const float frequencies[] = { 50.0F, 250.0F, 900.0F };
+    const float amplitudes[] = { 0.3F, 0.2F, 0.1F };
+    synthesize(frequencies, amplitudes, 3, 0.0F);
+
+    VibrationFeatures features;
+    analyzer.analyze(block, features);
+
+    TEST_ASSERT_LESS_THAN(0.01F, features.bandRms[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 0.3F / sqrtf(2.0F), features.bandRms[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 0.2F / sqrtf(2.0F), features.bandRms[2]);
+    TEST_ASSERT_FLOAT_WITHIN(0.005F, 0.1F / sqrtf(2.0F), features.bandRms[3]);
+
+    float total = 0.0F;
+    for (int b = 0; b < VIBRATION_BANDS; b++) {
+        total += features.bandRms[b] * features.bandRms[b];
+    }
+    TEST_ASSERT_FLOAT_WITHIN(features.rms * features.rms * 0.02F, features.rms * features.rms, total);
+}
+
+void test_encode_payload() {
+    VibrationFeatures features = {};
+    features.rms = 0.123F;
+    features.peaks[0] = { 50.04F, 0.5F };
+    features.peaks[1] = { 312.5F, 70.0F };  // Saturates
+    features.peakCount = 2;
+    features.bandRms[1] = 0.35F;
+
+    uint8_t payload[VIBRATION_PAYLOAD_SIZE];
+    TEST_ASSERT_EQUAL(VIBRATION_PAYLOAD_SIZE, VibrationAnalyzer::encode(features, payload));
+    TEST_ASSERT_EQUAL(22, VIBRATION_PAYLOAD_SIZE);
+
+    const uint8_t expected[] = {
+        0x00, 0x7B,                          // 123 mg
+        0x01, 0xF4, 0x01, 0xF4,              // 50.0 Hz, 500 mg
+        0x0C, 0x35, 0xFF, 0xFF,              // 312.5 Hz, saturated
+        0x00, 0x00, 0x00, 0x00,              // No third peak
+        0x00, 0x00, 0x01, 0x5E, 0x00, 0x00, 0x00, 0x00
+    };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, payload, sizeof(expected));
+}
+
+void test_benchmark() {
+    const float frequencies[] = { 50.0F, 312.5F };
+    const float amplitudes[] = { 0.5F, 0.2F };
+    synthesize(frequencies, amplitudes, 2, 0.05F);
+
+    const int runs = 200;
+    static float data[2 * VIBRATION_FFT_SIZE];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < runs; r++) {
+        for (int n = 0; n < VIBRATION_FFT_SIZE; n++) {
+            data[2 * n] = block[n];
+            data[2 * n + 1] = 0.0F;
+        }
+        analyzer.fftScalar(data);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double fftUs = elapsedUs(start, end) / runs;
+
+    VibrationFeatures features;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int r = 0; r < runs; r++) {
+        analyzer.analyze(block, features);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double analyzeUs = elapsedUs(start, end) / runs;
+
+    printf("\n  %d-point FFT (scalar): %.1f us, full analysis: %.1f us, block period: %.0f us\n",
+           VIBRATION_FFT_SIZE, fftUs, analyzeUs, VIBRATION_FFT_SIZE * 1e6 / SAMPLE_RATE);
+
+    // The analysis has to keep up with the capture for gap-free blocks
+    TEST_ASSERT_LESS_THAN(VIBRATION_FFT_SIZE * 1e6 / SAMPLE_RATE, analyzeUs);
+}
+
+void RUN_UNITY_TESTS() {
+    UNITY_BEGIN();
+
+    RUN_TEST(test_fft_matches_reference_dft);
+    RUN_TEST(test_peaks_and_rms);
+    RUN_TEST(test_off_bin_frequency_is_interpolated);
+    RUN_TEST(test_band_energies_add_up_to_variance);
+    RUN_TEST(test_encode_payload);
+    RUN_TEST(test_benchmark);
+
+    UNITY_END();
+}
+
+int main(void) {
+    RUN_UNITY_TESTS();
+    return 0;
+}